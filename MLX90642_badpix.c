@@ -0,0 +1,320 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "MLX90642_badpix.h"
+#include "spiflash_itf.h"
+#include "xprintf.h"
+
+#define MLX90642_CCM __attribute__((section(".ccm")))
+
+#define BADPIX_MAGIC        0x58495042ul   /* "BPIX" */
+#define BADPIX_ROWS_ALL     0xFFFFFFul
+#define BADPIX_RES_MAX      4095           /* 残差限幅, 64帧的平方和不溢出 */
+#define BADPIX_MEAN_MIN     (5*50)         /* 残差均值至少5℃才算卡死/死点 */
+#define BADPIX_MEAN_K       6              /* 且超过全帧平均的6倍 */
+#define BADPIX_VAR_MIN      (50*50)        /* 残差标准差至少1℃才算闪烁 */
+#define BADPIX_VAR_K        16             /* 且方差超过全帧平均的16倍(标准差4倍) */
+#define BADPIX_VAR_SUM_MAX  (1ul << 22)    /* 求平均时单点方差限幅, 768点之和不溢出 */
+
+/* flash中的记录, 按从机地址保存每个传感器的位图 */
+typedef struct{
+    uint32_t magic;
+    uint8_t addr[MLX90642_BADPIX_SENSOR_MAX];            /* 0未使用 */
+    uint32_t map[MLX90642_BADPIX_SENSOR_MAX][24];        /* map[y]的bitx对应(x,y) */
+    uint32_t sum;                                        /* 前面各字之和取反 */
+} mlx90642_badpix_rec_st;
+
+/* 一个坏点的校正: 用有效的8邻域的均值代替 */
+typedef struct{
+    uint16_t idx;       /* y*32+x */
+    uint8_t num;        /* 有效邻点数, 0不校正 */
+    uint16_t nb[8];
+} mlx90642_badpix_fix_st;
+
+static struct{
+    uint8_t addr;
+    uint8_t num;        /* 校正列表长度 */
+    uint16_t bad;       /* 位图中的坏点数 */
+    uint32_t map[24];
+    mlx90642_badpix_fix_st fix[MLX90642_BADPIX_LIST_MAX];
+} s_badpix[MLX90642_BADPIX_SENSOR_MAX];
+
+/* 检测状态, 同时只检测一个传感器 */
+static struct{
+    int8_t id;          /* -1未检测 */
+    uint8_t frames;     /* 需要统计的帧数 */
+    uint8_t done;       /* 已统计的帧数 */
+} s_detect = {
+    .id = -1,
+};
+
+/* 每点残差的和与平方和, 只有CPU访问 */
+static int32_t s_res_sum[32*24] MLX90642_CCM;
+static uint32_t s_res_sq[32*24] MLX90642_CCM;
+
+static mlx90642_badpix_rec_st s_rec;
+static uint8_t s_rec_valid = 0;
+
+static uint32_t badpix_rec_sum(const mlx90642_badpix_rec_st* rec){
+    const uint32_t* p = (const uint32_t*)rec;
+    uint32_t sum = 0;
+    for(uint32_t i=0; i<(sizeof(*rec) - sizeof(rec->sum))/4; i++){
+        sum += p[i];
+    }
+    return ~sum;
+}
+
+static void badpix_rec_load(void){
+    if(s_rec_valid){
+        return;
+    }
+    flash_itf_read((uint8_t*)&s_rec, MLX90642_BADPIX_FLASH_ADDR, sizeof(s_rec));
+    if((s_rec.magic != BADPIX_MAGIC) || (s_rec.sum != badpix_rec_sum(&s_rec))){
+        memset(&s_rec, 0, sizeof(s_rec));
+        s_rec.magic = BADPIX_MAGIC;
+    }
+    s_rec_valid = 1;
+}
+
+/* 更新该传感器的记录并写flash, 没有空位时覆盖id对应的位置 */
+static void badpix_rec_save(int id){
+    int slot = -1;
+    badpix_rec_load();
+    for(int i=0; i<MLX90642_BADPIX_SENSOR_MAX; i++){
+        if(s_rec.addr[i] == s_badpix[id].addr){
+            slot = i;
+            break;
+        }
+        if((slot < 0) && (s_rec.addr[i] == 0)){
+            slot = i;
+        }
+    }
+    if(slot < 0){
+        slot = id;
+    }
+    s_rec.addr[slot] = s_badpix[id].addr;
+    memcpy(s_rec.map[slot], s_badpix[id].map, sizeof(s_rec.map[slot]));
+    s_rec.sum = badpix_rec_sum(&s_rec);
+    flash_itf_write((uint8_t*)&s_rec, MLX90642_BADPIX_FLASH_ADDR, sizeof(s_rec));
+}
+
+static int badpix_is_bad(int id, int x, int y){
+    return (s_badpix[id].map[y] >> x) & 1u;
+}
+
+/* 由位图生成校正列表 */
+static void badpix_build(int id){
+    mlx90642_badpix_fix_st* fix;
+    int bad = 0;
+    int num = 0;
+    for(int y=0; y<24; y++){
+        if(s_badpix[id].map[y] == 0){
+            continue;
+        }
+        for(int x=0; x<32; x++){
+            if(badpix_is_bad(id, x, y) == 0){
+                continue;
+            }
+            bad++;
+            if(num >= MLX90642_BADPIX_LIST_MAX){
+                continue;
+            }
+            fix = &s_badpix[id].fix[num++];
+            fix->idx = (uint16_t)(y*32 + x);
+            fix->num = 0;
+            for(int dy=-1; dy<=1; dy++){
+                for(int dx=-1; dx<=1; dx++){
+                    if(((dx == 0) && (dy == 0)) || (x+dx < 0) || (x+dx >= 32) || (y+dy < 0) || (y+dy >= 24)){
+                        continue;
+                    }
+                    if(badpix_is_bad(id, x+dx, y+dy) == 0){
+                        fix->nb[fix->num++] = (uint16_t)((y+dy)*32 + x+dx);
+                    }
+                }
+            }
+        }
+    }
+    s_badpix[id].num = (uint8_t)num;
+    s_badpix[id].bad = (uint16_t)bad;
+}
+
+/* 4邻域的中值(2个时取均值), 一个异常的邻点不影响结果 */
+static int32_t badpix_nb_median(const int16_t* temp, int x, int y){
+    int32_t v[4];
+    int32_t t;
+    int n = 0;
+    if(x > 0){
+        v[n++] = temp[y*32 + x-1];
+    }
+    if(x < 31){
+        v[n++] = temp[y*32 + x+1];
+    }
+    if(y > 0){
+        v[n++] = temp[(y-1)*32 + x];
+    }
+    if(y < 23){
+        v[n++] = temp[(y+1)*32 + x];
+    }
+    for(int i=1; i<n; i++){
+        t = v[i];
+        int j = i;
+        while((j > 0) && (v[j-1] > t)){
+            v[j] = v[j-1];
+            j--;
+        }
+        v[j] = t;
+    }
+    if(n == 3){
+        return v[1];
+    }
+    return (v[n/2-1] + v[n/2]) / 2;
+}
+
+/* 残差的方差, 截断误差可能使差值为负 */
+static uint32_t badpix_var(int i, int n, int32_t mu){
+    uint32_t sq = s_res_sq[i] / n;
+    uint32_t m2 = (uint32_t)(mu*mu);
+    return (sq > m2) ? sq - m2 : 0;
+}
+
+/* 检测结束: 残差均值或方差明显偏离全帧平均的点加入位图 */
+static void badpix_detect_finish(int id){
+    int n = s_detect.frames;
+    int32_t mu;
+    uint32_t var;
+    uint32_t mu_avg = 0;
+    uint32_t var_avg = 0;
+    uint32_t mu_th;
+    uint32_t var_th;
+    int good = 0;
+    int found = 0;
+    for(int i=0; i<32*24; i++){
+        if(badpix_is_bad(id, i%32, i/32)){
+            continue;
+        }
+        mu = s_res_sum[i] / n;
+        mu_avg += (mu < 0) ? -mu : mu;
+        var = badpix_var(i, n, mu);
+        var_avg += (var < BADPIX_VAR_SUM_MAX) ? var : BADPIX_VAR_SUM_MAX;
+        good++;
+    }
+    if(good == 0){
+        return;
+    }
+    mu_avg /= good;
+    var_avg /= good;
+    mu_th = (mu_avg*BADPIX_MEAN_K > BADPIX_MEAN_MIN) ? mu_avg*BADPIX_MEAN_K : BADPIX_MEAN_MIN;
+    var_th = (var_avg*BADPIX_VAR_K > BADPIX_VAR_MIN) ? var_avg*BADPIX_VAR_K : BADPIX_VAR_MIN;
+    for(int i=0; i<32*24; i++){
+        if(badpix_is_bad(id, i%32, i/32)){
+            continue;
+        }
+        mu = s_res_sum[i] / n;
+        var = badpix_var(i, n, mu);
+        if(((uint32_t)((mu < 0) ? -mu : mu) > mu_th) || (var > var_th)){
+            s_badpix[id].map[i/32] |= (1ul << (i%32));
+            found++;
+        }
+    }
+    xprintf("0x%02X badpix detect: %d new, mean |res| %u, var %u\r\n", s_badpix[id].addr, found, mu_avg, var_avg);
+    badpix_build(id);
+    badpix_rec_save(id);
+}
+
+int mlx90642_badpix_load(int id, uint8_t addr){
+    if((id < 0) || (id >= MLX90642_BADPIX_SENSOR_MAX)){
+        return -1;
+    }
+    badpix_rec_load();
+    s_badpix[id].addr = addr;
+    memset(s_badpix[id].map, 0, sizeof(s_badpix[id].map));
+    for(int i=0; i<MLX90642_BADPIX_SENSOR_MAX; i++){
+        if(s_rec.addr[i] == addr){
+            memcpy(s_badpix[id].map, s_rec.map[i], sizeof(s_badpix[id].map));
+            break;
+        }
+    }
+    badpix_build(id);
+    return s_badpix[id].bad;
+}
+
+void mlx90642_badpix_run(int id, int16_t* temp, uint32_t rows){
+    const mlx90642_badpix_fix_st* fix;
+    int32_t sum;
+    int32_t r;
+    if((id < 0) || (id >= MLX90642_BADPIX_SENSOR_MAX)){
+        return;
+    }
+    /* 校正: 只访问坏点和它的邻点 */
+    for(int i=0; i<s_badpix[id].num; i++){
+        fix = &s_badpix[id].fix[i];
+        if((fix->num == 0) || ((rows & (1ul << (fix->idx/32))) == 0)){
+            continue;
+        }
+        sum = 0;
+        for(int k=0; k<fix->num; k++){
+            sum += temp[fix->nb[k]];
+        }
+        temp[fix->idx] = (int16_t)(sum / fix->num);
+    }
+    /* 检测: 只用整帧, 已知坏点已校正不影响邻点 */
+    if((s_detect.id != id) || ((rows & BADPIX_ROWS_ALL) != BADPIX_ROWS_ALL)){
+        return;
+    }
+    for(int y=0; y<24; y++){
+        for(int x=0; x<32; x++){
+            r = temp[y*32 + x] - badpix_nb_median(temp, x, y);
+            if(r > BADPIX_RES_MAX){
+                r = BADPIX_RES_MAX;
+            }else if(r < -BADPIX_RES_MAX){
+                r = -BADPIX_RES_MAX;
+            }
+            s_res_sum[y*32 + x] += r;
+            s_res_sq[y*32 + x] += (uint32_t)(r*r);
+        }
+    }
+    if(++s_detect.done >= s_detect.frames){
+        s_detect.id = -1;
+        badpix_detect_finish(id);
+    }
+}
+
+int mlx90642_badpix_detect(int id, int frames){
+    if((id < 0) || (id >= MLX90642_BADPIX_SENSOR_MAX) || (frames < 4) || (frames > 64)){
+        return -1;
+    }
+    memset(s_res_sum, 0, sizeof(s_res_sum));
+    memset(s_res_sq, 0, sizeof(s_res_sq));
+    s_detect.frames = (uint8_t)frames;
+    s_detect.done = 0;
+    s_detect.id = (int8_t)id;
+    return 0;
+}
+
+int mlx90642_badpix_clear(int id){
+    if((id < 0) || (id >= MLX90642_BADPIX_SENSOR_MAX)){
+        return -1;
+    }
+    memset(s_badpix[id].map, 0, sizeof(s_badpix[id].map));
+    badpix_build(id);
+    badpix_rec_save(id);
+    return 0;
+}
+
+void mlx90642_badpix_print(void){
+    const mlx90642_badpix_fix_st* fix;
+    for(int id=0; id<MLX90642_BADPIX_SENSOR_MAX; id++){
+        if(s_badpix[id].addr == 0){
+            continue;
+        }
+        xprintf("%d 0x%02X: %d bad", id, s_badpix[id].addr, s_badpix[id].bad);
+        for(int i=0; i<s_badpix[id].num; i++){
+            fix = &s_badpix[id].fix[i];
+            xprintf(" (%d,%d)", fix->idx%32, fix->idx/32);
+        }
+        xprintf("\r\n");
+    }
+    if(s_detect.id >= 0){
+        xprintf("detecting %d: %d/%d frames\r\n", s_detect.id, s_detect.done, s_detect.frames);
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef MLX90642_BADPIX_H
+#define MLX90642_BADPIX_H
+
+#ifdef __cplusplus
+    extern "C"{
+#endif
+
+#include <stdint.h>
+
+/**
+ * 坏点检测和校正
+ * 检测: 连续若干帧统计每点与4邻域中值之差(残差)的均值和方差,
+ *       均值偏离(卡死/死点)或方差过大(闪烁)的点标记为坏点, 位图保存到SPI flash.
+ *       检测时应对着均匀的场景(如墙面), 静止的热源的角点也会偏离邻域.
+ * 校正: 坏点用有效的8邻域的均值代替, 只处理坏点列表, 在统计/告警/显示之前进行.
+ */
+
+#define MLX90642_BADPIX_SENSOR_MAX  4       /* 最多4个传感器 */
+#define MLX90642_BADPIX_LIST_MAX    32      /* 每个传感器最多校正的坏点数 */
+
+#ifndef MLX90642_BADPIX_FLASH_ADDR
+#define MLX90642_BADPIX_FLASH_ADDR  0x7FF000ul  /* 位图在SPI flash中的地址, 独占一个扇区 */
+#endif
+
+/**
+ * \fn mlx90642_badpix_load
+ * 从flash读取该地址传感器的坏点位图并生成校正列表
+ * \param[in] id 传感器 0~MLX90642_BADPIX_SENSOR_MAX-1
+ * \param[in] addr 7位从机地址
+ * \retval >=0 坏点数
+ * \retval -1 参数错误
+*/
+int mlx90642_badpix_load(int id, uint8_t addr);
+
+/**
+ * \fn mlx90642_badpix_run
+ * 每帧(行带)调用: 检测期间累计残差, 然后原地校正rows中的坏点
+ * \param[in] id 传感器
+ * \param[in,out] temp 温度,1/50℃
+ * \param[in] rows 有效行, bit0对应第0行
+*/
+void mlx90642_badpix_run(int id, int16_t* temp, uint32_t rows);
+
+/**
+ * \fn mlx90642_badpix_detect
+ * 启动检测, 同时只能检测一个传感器, 结束时新检测到的坏点加入位图并保存
+ * \param[in] id 传感器
+ * \param[in] frames 统计的帧数 4~64
+ * \retval 0 成功
+ * \retval -1 参数错误
+*/
+int mlx90642_badpix_detect(int id, int frames);
+
+/**
+ * \fn mlx90642_badpix_clear
+ * 清除坏点位图并保存
+ * \param[in] id 传感器
+ * \retval 0 成功
+ * \retval -1 参数错误
+*/
+int mlx90642_badpix_clear(int id);
+
+/**
+ * \fn mlx90642_badpix_print
+ * 打印各传感器的坏点坐标和检测进度
+*/
+void mlx90642_badpix_print(void);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
@@ -0,0 +1,369 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "xprintf.h"
+#include "MLX90642_blob.h"
+
+#define BLOB_W            32
+#define BLOB_H            24
+#define BLOB_RUN_MAX      (BLOB_W/2*BLOB_H)   /* 每行最多16个游程 */
+#define BLOB_LABEL_MAX    (BLOB_W/2*BLOB_H/2) /* 8邻接时最多的连通域数 */
+#define BLOB_TRACK_MAX    (2*MLX90642_BLOB_MAX)
+#define BLOB_MISS_MAX     3                   /* 目标丢失超过3帧删除 */
+
+#define MLX90642_CCM __attribute__((section(".ccm")))
+
+/* 游程 [xs,xe], 并查集父节点总是编号更小的游程 */
+typedef struct{
+    uint8_t y;
+    uint8_t xs;
+    uint8_t xe;
+    uint16_t parent;
+    int16_t peak;
+    uint8_t peak_x;
+} blob_run_st;
+
+/* 连通域累计 */
+typedef struct{
+    uint16_t area;
+    int16_t peak;
+    uint16_t peak_idx;
+    uint32_t sum2x;         /* 2倍的x之和 */
+    uint32_t sum2y;
+    uint8_t x0;
+    uint8_t y0;
+    uint8_t x1;
+    uint8_t y1;
+} blob_acc_st;
+
+typedef struct{
+    uint16_t id;
+    uint16_t age;
+    uint8_t miss;
+    uint16_t cx;
+    uint16_t cy;
+} blob_track_st;
+
+/* 只有CPU访问, 放CCM */
+static blob_run_st s_run[BLOB_RUN_MAX] MLX90642_CCM;
+static blob_acc_st s_acc[BLOB_LABEL_MAX] MLX90642_CCM;
+static uint16_t s_lab[BLOB_RUN_MAX] MLX90642_CCM;
+
+static mlx90642_blob_list_st s_blob_list[MLX90642_BLOB_SENSOR_MAX];
+static blob_track_st s_track[MLX90642_BLOB_SENSOR_MAX][BLOB_TRACK_MAX];
+static uint8_t s_track_num[MLX90642_BLOB_SENSOR_MAX];
+static uint16_t s_track_id[MLX90642_BLOB_SENSOR_MAX];   /* 上一个分配的ID */
+
+static uint16_t s_blob_min_area = 2;
+static uint8_t s_blob_gate = 4;
+
+static uint16_t blob_find(uint16_t i){
+    while(s_run[i].parent != i){
+        s_run[i].parent = s_run[s_run[i].parent].parent;   /* 路径减半 */
+        i = s_run[i].parent;
+    }
+    return i;
+}
+
+static void blob_union(uint16_t a, uint16_t b){
+    a = blob_find(a);
+    b = blob_find(b);
+    if(a < b){
+        s_run[b].parent = a;
+    }else if(b < a){
+        s_run[a].parent = b;
+    }
+}
+
+/* 按面积(相同时按峰值)插入有序列表, 列表满时丢掉最小的 */
+static void blob_insert(mlx90642_blob_list_st* list, const mlx90642_blob_st* blob){
+    int n = list->num;
+    int i;
+    if(n == MLX90642_BLOB_MAX){
+        if((blob->area < list->blob[n-1].area) ||
+           ((blob->area == list->blob[n-1].area) && (blob->peak <= list->blob[n-1].peak))){
+            return;
+        }
+        n--;
+    }else{
+        list->num++;
+    }
+    for(i=n; i>0; i--){
+        if((list->blob[i-1].area > blob->area) ||
+           ((list->blob[i-1].area == blob->area) && (list->blob[i-1].peak >= blob->peak))){
+            break;
+        }
+        list->blob[i] = list->blob[i-1];
+    }
+    list->blob[i] = *blob;
+}
+
+void mlx90642_blob_label(const int16_t* temp, uint32_t rows, int16_t th, uint16_t min_area, mlx90642_blob_list_st* list){
+    const int16_t* p;
+    uint16_t nrun = 0;
+    uint16_t prev0 = 0;      /* 上一行的游程 [prev0,prev1) */
+    uint16_t prev1 = 0;
+    uint16_t cur0;
+    uint16_t k;
+    uint16_t nlab = 0;
+    int x;
+    blob_run_st* r;
+    blob_acc_st* a;
+    mlx90642_blob_st blob;
+
+    list->num = 0;
+    list->area_max = 0;
+
+    /* 第一遍: 提取游程, 与上一行重叠或对角相邻的游程合并 */
+    for(int y=0; y<BLOB_H; y++){
+        cur0 = nrun;
+        if((rows & (1ul<<y)) == 0){
+            prev0 = prev1 = nrun;
+            continue;
+        }
+        p = temp + y*BLOB_W;
+        x = 0;
+        while(x < BLOB_W){
+            if(p[x] < th){
+                x++;
+                continue;
+            }
+            r = &s_run[nrun];
+            r->y = (uint8_t)y;
+            r->xs = (uint8_t)x;
+            r->parent = nrun;
+            r->peak = p[x];
+            r->peak_x = (uint8_t)x;
+            while((x < BLOB_W) && (p[x] >= th)){
+                if(p[x] > r->peak){
+                    r->peak = p[x];
+                    r->peak_x = (uint8_t)x;
+                }
+                x++;
+            }
+            r->xe = (uint8_t)(x - 1);
+            /* 上一行游程有序, 跳过在左边的, 合并相交的 */
+            while((prev0 < prev1) && (s_run[prev0].xe + 1 < r->xs)){
+                prev0++;
+            }
+            for(k=prev0; (k<prev1) && (s_run[k].xs <= r->xe + 1); k++){
+                blob_union(k, nrun);
+            }
+            /* 最后一个相交的游程可能也和本行下一个游程相交 */
+            if((k > prev0) && (s_run[k-1].xe > r->xe)){
+                prev0 = k - 1;
+            }else{
+                prev0 = k;
+            }
+            nrun++;
+        }
+        prev0 = cur0;
+        prev1 = nrun;
+    }
+    list->runs = nrun;
+
+    /* 第二遍: 根的编号最小, 按顺序给根分配标签并累计 */
+    for(k=0; k<nrun; k++){
+        r = &s_run[k];
+        uint16_t root = blob_find(k);
+        uint16_t len = r->xe - r->xs + 1;
+        if(root == k){
+            s_lab[k] = nlab;
+            a = &s_acc[nlab++];
+            a->area = 0;
+            a->peak = r->peak;
+            a->peak_idx = (uint16_t)(r->y*BLOB_W + r->peak_x);
+            a->sum2x = 0;
+            a->sum2y = 0;
+            a->x0 = r->xs;
+            a->x1 = r->xe;
+            a->y0 = r->y;
+            a->y1 = r->y;
+        }else{
+            s_lab[k] = s_lab[root];
+            a = &s_acc[s_lab[k]];
+            if(r->peak > a->peak){
+                a->peak = r->peak;
+                a->peak_idx = (uint16_t)(r->y*BLOB_W + r->peak_x);
+            }
+            if(r->xs < a->x0){
+                a->x0 = r->xs;
+            }
+            if(r->xe > a->x1){
+                a->x1 = r->xe;
+            }
+            a->y1 = r->y;   /* 游程按行顺序 */
+        }
+        a->area += len;
+        a->sum2x += (uint32_t)(r->xs + r->xe)*len;
+        a->sum2y += 2u*r->y*len;
+    }
+
+    for(k=0; k<nlab; k++){
+        a = &s_acc[k];
+        if(a->area > list->area_max){
+            list->area_max = a->area;
+        }
+        if(a->area < min_area){
+            continue;
+        }
+        blob.id = 0;
+        blob.age = 0;
+        blob.area = a->area;
+        blob.peak = a->peak;
+        blob.peak_idx = a->peak_idx;
+        /* 2倍和左移3位即Q4 */
+        blob.cx = (uint16_t)(((a->sum2x << (MLX90642_BLOB_Q - 1)) + a->area/2) / a->area);
+        blob.cy = (uint16_t)(((a->sum2y << (MLX90642_BLOB_Q - 1)) + a->area/2) / a->area);
+        blob.x0 = a->x0;
+        blob.y0 = a->y0;
+        blob.x1 = a->x1;
+        blob.y1 = a->y1;
+        blob_insert(list, &blob);
+    }
+}
+
+/* 分配新ID, 跳过0和该传感器正在使用的ID */
+static uint16_t blob_new_id(int id){
+    uint16_t v = s_track_id[id];
+    int used;
+    do{
+        v++;
+        if(v == 0){
+            v = 1;
+        }
+        used = 0;
+        for(int i=0; i<s_track_num[id]; i++){
+            if(s_track[id][i].id == v){
+                used = 1;
+                break;
+            }
+        }
+    }while(used);
+    s_track_id[id] = v;
+    return v;
+}
+
+const mlx90642_blob_list_st* mlx90642_blob_run(int id, const int16_t* temp, uint32_t rows, int16_t th){
+    mlx90642_blob_list_st* list;
+    blob_track_st* track;
+    blob_track_st next[BLOB_TRACK_MAX];
+    uint8_t t_match[BLOB_TRACK_MAX];
+    uint8_t b_match[MLX90642_BLOB_MAX];
+    uint32_t gate2 = ((uint32_t)s_blob_gate << MLX90642_BLOB_Q)*((uint32_t)s_blob_gate << MLX90642_BLOB_Q);
+    uint32_t d2;
+    uint32_t best;
+    int32_t dx;
+    int32_t dy;
+    int bt;
+    int bb;
+    int n = 0;
+    int ntrack;
+
+    if((id < 0) || (id >= MLX90642_BLOB_SENSOR_MAX)){
+        return 0;
+    }
+    list = &s_blob_list[id];
+    track = s_track[id];
+    ntrack = s_track_num[id];
+    mlx90642_blob_label(temp, rows, th, s_blob_min_area, list);
+    list->frames++;
+
+    /* 贪心关联: 每次取距离最近的一对, 最多MLX90642_BLOB_MAX次 */
+    memset(t_match, 0, sizeof(t_match));
+    memset(b_match, 0, sizeof(b_match));
+    for(;;){
+        best = gate2 + 1;
+        bt = -1;
+        bb = -1;
+        for(int t=0; t<ntrack; t++){
+            if(t_match[t]){
+                continue;
+            }
+            for(int b=0; b<list->num; b++){
+                if(b_match[b]){
+                    continue;
+                }
+                dx = (int32_t)list->blob[b].cx - track[t].cx;
+                dy = (int32_t)list->blob[b].cy - track[t].cy;
+                d2 = (uint32_t)(dx*dx + dy*dy);
+                if(d2 < best){
+                    best = d2;
+                    bt = t;
+                    bb = b;
+                }
+            }
+        }
+        if(bt < 0){
+            break;
+        }
+        t_match[bt] = 1;
+        b_match[bb] = 1;
+        list->blob[bb].id = track[bt].id;
+        list->blob[bb].age = (track[bt].age < 0xFFFF) ? track[bt].age + 1 : 0xFFFF;
+    }
+
+    /* 新的跟踪表: 本帧的目标在前, 丢失不久的目标在后 */
+    for(int b=0; b<list->num; b++){
+        if(b_match[b] == 0){
+            list->blob[b].id = blob_new_id(id);
+            list->blob[b].age = 1;
+        }
+        next[n].id = list->blob[b].id;
+        next[n].age = list->blob[b].age;
+        next[n].miss = 0;
+        next[n].cx = list->blob[b].cx;
+        next[n].cy = list->blob[b].cy;
+        n++;
+    }
+    list->lost = 0;
+    for(int t=0; (t<ntrack) && (n<BLOB_TRACK_MAX); t++){
+        if(t_match[t] || (track[t].miss >= BLOB_MISS_MAX)){
+            continue;
+        }
+        next[n] = track[t];
+        next[n].miss++;
+        n++;
+        list->lost++;
+    }
+    memcpy(track, next, n*sizeof(next[0]));
+    s_track_num[id] = (uint8_t)n;
+    return list;
+}
+
+const mlx90642_blob_list_st* mlx90642_blob_get(int id){
+    if((id < 0) || (id >= MLX90642_BLOB_SENSOR_MAX)){
+        return 0;
+    }
+    return &s_blob_list[id];
+}
+
+int mlx90642_blob_config(uint16_t min_area, uint8_t gate){
+    if((min_area < 1) || (min_area > BLOB_W*BLOB_H) || (gate < 1)){
+        return -1;
+    }
+    s_blob_min_area = min_area;
+    s_blob_gate = gate;
+    memset(s_track_num, 0, sizeof(s_track_num));
+    return 0;
+}
+
+void mlx90642_blob_print(void){
+    const mlx90642_blob_st* b;
+    xprintf("min_area:%d gate:%d\r\n", s_blob_min_area, s_blob_gate);
+    for(int i=0; i<MLX90642_BLOB_SENSOR_MAX; i++){
+        if(s_blob_list[i].frames == 0){
+            continue;
+        }
+        xprintf("sensor %d frames:%u blobs:%d lost:%d runs:%d\r\n", i, s_blob_list[i].frames,
+            s_blob_list[i].num, s_blob_list[i].lost, s_blob_list[i].runs);
+        for(int k=0; k<s_blob_list[i].num; k++){
+            b = &s_blob_list[i].blob[k];
+            xprintf("  id:%d age:%d area:%d peak:%d(1/50C)@(%d,%d) c:(%d.%d,%d.%d) box:(%d,%d)-(%d,%d)\r\n",
+                b->id, b->age, b->area, b->peak, b->peak_idx%32, b->peak_idx/32,
+                b->cx >> MLX90642_BLOB_Q, ((b->cx & 0x0F)*10) >> MLX90642_BLOB_Q,
+                b->cy >> MLX90642_BLOB_Q, ((b->cy & 0x0F)*10) >> MLX90642_BLOB_Q,
+                b->x0, b->y0, b->x1, b->y1);
+        }
+    }
+}
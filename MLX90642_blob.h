@@ -0,0 +1,100 @@
+#ifndef MLX90642_BLOB_H
+#define MLX90642_BLOB_H
+
+#ifdef __cplusplus
+    extern "C"{
+#endif
+
+#include <stdint.h>
+
+/**
+ * 热点(连通域)检测和跨帧跟踪
+ * 标记: 逐行提取超过阈值的游程, 与上一行8邻接的游程用并查集合并, 再按根累计面积/峰值/质心/外接框,
+ *       每帧最多处理768个点/384个游程, 不需要逐点的标签图.
+ * 跟踪: 按质心距离从近到远贪心匹配上一帧的目标, 匹配上的沿用ID, 丢失的目标保留几帧以免闪烁换ID.
+ */
+
+#define MLX90642_BLOB_SENSOR_MAX  4     /* 最多4个传感器 */
+#define MLX90642_BLOB_MAX         8     /* 每帧最多报告的热点数, 超过时保留面积大的 */
+#define MLX90642_BLOB_Q           4     /* 质心小数位 */
+
+/**
+ * 一个热点
+ */
+typedef struct{
+    uint16_t id;            /**< 跟踪ID, 1开始, 目标存在期间不变 */
+    uint16_t area;          /**< 点数                            */
+    uint16_t age;           /**< 已跟踪的帧数, 新目标为1          */
+    int16_t peak;           /**< 最高温度,1/50℃                  */
+    uint16_t peak_idx;      /**< 最高温度的点 y*32+x              */
+    uint16_t cx;            /**< 质心x, Q4                        */
+    uint16_t cy;            /**< 质心y, Q4                        */
+    uint8_t x0;             /**< 外接框 [x0,x1] [y0,y1]           */
+    uint8_t y0;
+    uint8_t x1;
+    uint8_t y1;
+} mlx90642_blob_st;
+
+/**
+ * 一帧的检测结果
+ */
+typedef struct{
+    uint8_t num;                            /**< 热点数                      */
+    uint8_t lost;                           /**< 本帧丢失(保留中)的目标数     */
+    uint16_t area_max;                      /**< 最大热点的点数               */
+    uint16_t runs;                          /**< 游程数                      */
+    uint32_t frames;                        /**< 检测的帧数                   */
+    mlx90642_blob_st blob[MLX90642_BLOB_MAX];
+} mlx90642_blob_list_st;
+
+/**
+ * \fn mlx90642_blob_label
+ * 连通域标记, 不跟踪, 结果的id为0
+ * \param[in] temp 温度,1/50℃
+ * \param[in] rows 有效行, bit0对应第0行, 其余行不参与
+ * \param[in] th 阈值, 不低于th的点为热点
+ * \param[in] min_area 点数少于min_area的热点丢弃
+ * \param[out] list 检测结果, 按面积从大到小
+*/
+void mlx90642_blob_label(const int16_t* temp, uint32_t rows, int16_t th, uint16_t min_area, mlx90642_blob_list_st* list);
+
+/**
+ * \fn mlx90642_blob_run
+ * 检测并和该传感器上一帧的目标关联
+ * \param[in] id 传感器 0~MLX90642_BLOB_SENSOR_MAX-1
+ * \param[in] temp 温度,1/50℃
+ * \param[in] rows 有效行, bit0对应第0行
+ * \param[in] th 阈值,1/50℃
+ * \return 检测结果, id无效时返回0
+*/
+const mlx90642_blob_list_st* mlx90642_blob_run(int id, const int16_t* temp, uint32_t rows, int16_t th);
+
+/**
+ * \fn mlx90642_blob_get
+ * 获取传感器最近一帧的结果
+ * \param[in] id 传感器
+ * \return 检测结果, id无效时返回0
+*/
+const mlx90642_blob_list_st* mlx90642_blob_get(int id);
+
+/**
+ * \fn mlx90642_blob_config
+ * 设置最小面积和关联距离, 清除跟踪状态
+ * \param[in] min_area 最小点数 1~768
+ * \param[in] gate 前后帧质心最大距离, 点
+ * \retval 0 成功
+ * \retval -1 参数错误
+*/
+int mlx90642_blob_config(uint16_t min_area, uint8_t gate);
+
+/**
+ * \fn mlx90642_blob_print
+ * 打印各传感器的热点
+*/
+void mlx90642_blob_print(void);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
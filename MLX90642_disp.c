@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <string.h>
 #include <math.h>
 
 #include "stm32f4_regs.h"
@@ -8,30 +9,464 @@
 #include "xprintf.h"
 #include "clock.h"
 #include "lcd_itf.h"
+#include "MLX90642_sched.h"
+#include "MLX90642_palette.h"
+#include "MLX90642_disp.h"
+#include "MLX90642_scale.h"
+#include "MLX90642_filter.h"
+#include "MLX90642_badpix.h"
+#include "MLX90642_blob.h"
 
-static uint16_t s_temp[MLX90642_TOTAL_NUMBER_OF_PIXELS + 1];
-static uint8_t s_r[32*24];
-static uint8_t s_g[32*24];
-static uint8_t s_b[32*24];
+#define MLX90642_DISP_SENSOR_MAX 4
+/* 默认注册的传感器, 多个传感器需先用MLX90642_SetI2CSlaveAddress修改成不同地址 */
+static const uint8_t s_sensor_addr_default[] = {SA_90642_DEFAULT};
 
-void temp2rgb(int16_t* temp)
+/* 自动增益状态, 每个传感器按自己的场景平滑 */
+typedef struct{
+    uint8_t valid;
+    int32_t lo_q;     /* 平滑后的下限 <<AGC_Q */
+    int32_t hi_q;     /* 平滑后的上限 <<AGC_Q */
+    mlx90642_agc_map_st map;
+    mlx90642_stat_st stat;   /* 最近一帧统计 */
+} mlx90642_agc_st;
+
+/* 直方图均衡状态, 每个传感器各自的直方图和LUT, 轮流显示时不用重建 */
+typedef struct{
+    uint8_t valid;      /* hist.lo/shift已确定 */
+    uint8_t gray[MLX90642_HIST_BINS];   /* lut当前对应的映射 */
+    const uint16_t* pal;                /* lut当前对应的调色板 */
+    uint16_t lut[MLX90642_HIST_BINS];   /* bin->RGB565 */
+    uint32_t regen;     /* lut生成次数 */
+    mlx90642_hist_st hist;
+} mlx90642_heq_st;
+
+/* 传感器注册表, 每个传感器双缓存: 一帧显示时另一帧在后台接收 */
+typedef struct{
+    uint8_t addr;
+    uint8_t rx_idx;            /* 正在/下次接收的缓存 */
+    int8_t disp_idx;           /* 待显示的缓存,-1无新数据 */
+    uint32_t fresh[2];         /* 每个缓存本帧读到的行, bit0对应第0行 */
+    uint32_t t_open[2];        /* 读窗口打开时刻, DWT周期 */
+    uint32_t stale_drawn;      /* 已按过期颜色显示的行 */
+    uint32_t cell_drawn;       /* 色块模式下已显示且颜色记在s_drawn中的行, 颜色不变的点不再写显存 */
+    uint16_t temp[2][MLX90642_TOTAL_NUMBER_OF_PIXELS + 2];  /* 多1个点使temp[1]也4字节对齐 */
+    mlx90642_agc_st agc;
+    mlx90642_heq_st heq;
+} mlx90642_sensor_st;
+
+static mlx90642_sensor_st s_sensor[MLX90642_DISP_SENSOR_MAX];
+static int s_sensor_num = 0;
+static int s_bus_owner = -1;   /* 正在后台接收的传感器,-1总线空闲 */
+static int s_sensor_next = 0;  /* 下次优先查询的传感器, 轮流启动接收 */
+
+/* ROI: 只读取配置的行带, 其余行标记为过期 */
+#define ROW_MASK_ALL ((1ul<<MLX90642_NUMBER_OF_ROWS)-1)
+static MLX90642_RowBand_t s_roi[MLX90642_MAX_ROW_BANDS];
+static uint8_t s_roi_num = 0;             /* 0读整帧 */
+static uint32_t s_roi_mask = ROW_MASK_ALL;
+
+/* 流模式状态, 只用第一个传感器 */
+static uint8_t s_stream = 0;              /* 1流模式 */
+static uint8_t s_st_row = 0;              /* 本帧已读的行数 */
+static uint8_t s_st_final = 0;            /* 1正在读本帧剩余的行 */
+static int s_st_prog_pre = 0;             /* 上次读到的进度 */
+static uint32_t s_st_t_prog;              /* 上次读进度的时刻mS */
+static MLX90642_RowBand_t s_st_band;      /* 正在读的行带 */
+
+/* 延迟统计 */
+static struct{
+    uint32_t frames;
+    uint32_t last_us;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t sum_us;
+    uint8_t pending;         /* DMA刷新未完成, 完成后再记录 */
+    uint32_t t_open;
+} s_lat;
+/**
+ * 显存为本机字节序的RGB565, 像素数据按16位帧发送
+ * D15~D11  D10~D5  D4~D0
+ * R       |  G    |  B
+ */
+#define LCD_RGB(r,g,b) ((uint16_t)((((uint16_t)(r)&0xF8)<<8) | (((uint16_t)(g)&0xFC)<<3) | ((uint16_t)(b)>>3)))
+#define STALE_RGB LCD_RGB(64,64,64)  /* 过期的行显示为灰色 */
+
+/**
+ * 只给temp2rgb_ref用, 保持原来的颜色: G的低3位仍取g的高3位, B取b的低5位, 与classic调色板相同
+ * D15~D11  D10~D8  D7~D5  D4~D0
+ * R       |    G          |  B
+ */
+#define RGB(r,g,b) ((uint16_t)(((((uint16_t)(r)&0xF8) | ((uint16_t)(g)>>5))<<8) | ((uint16_t)(g)&0xE0) | ((uint16_t)(b)&0x1F)))
+
+/**
+ * 温度->灰度: gray = (uint8_t)(255*(t+40)/300), t = (temp*2+50)/100
+ * 与原来逐点除法的结果相同(含超出-40~260℃时的回绕), 除法用乘法移位代替:
+ * 除以50对0~32792精确, 除以20(255/300=17/20)对0~11815精确
+ */
+#define TEMP_DIV50_MUL     5243u
+#define TEMP_DIV50_SHIFT   18
+#define GRAY_DIV20_MUL     3277u
+#define GRAY_DIV20_SHIFT   16
+
+static uint16_t s_rgb[32*24];   /* RGB565 */
+
+#define MLX90642_CCM __attribute__((section(".ccm")))
+
+/* 只有颜色变化的点/行写显存, 显存只标记写过的区域, 刷新时只发送这些区域 */
+static uint16_t s_drawn[MLX90642_DISP_SENSOR_MAX][32*24] MLX90642_CCM;  /* 色块模式下已显示的颜色 */
+#if !LCD_ITF_LTDC
+static uint32_t s_line[LCD_HSIZE/2] MLX90642_CCM;                       /* 放大模式的一行, 与显存不同时才复制 */
+#endif
+
+#if LCD_ITF_LTDC
+/* LTDC时放大结果存为调色板索引, 一个热像行由DMA2D查表写入显存; DMA2D不能读CCM, 放SRAM, 两个轮流用 */
+static uint8_t s_l8[2][LCD_HSIZE*MLX90642_SCALE_MAX] __attribute__((aligned(4)));
+static uint8_t s_l8_idx = 0;
+#endif
+
+/* 双线性放大: 在32x24的Q4灰度网格上插值, 代替每点填充cell*cell的色块 */
+static uint8_t s_scale_enable = 1;
+static int16_t s_gray[32*24] __attribute__((aligned(4)));    /* 放大按字读相邻两列 */
+
+/* 3x3中值滤波, 结果只用于显示 */
+static uint8_t s_median_enable = 0;
+static int16_t s_med[32*24] __attribute__((aligned(4)));
+static mlx90642_scale_st s_scale;
+
+#define WARN_TH           (100*50)  /* 告警温度100℃ */
+#define WARN_CNT          2         /* 超过告警温度的点数 */
+
+/* 1行带显示: 在内部SRAM中逐条绘制并直接发送, 不经过SDRAM显存 */
+static uint8_t s_band_enable = 0;
+
+/* 热点外接框叠加显示, 只在整帧模式下 */
+static uint8_t s_blob_overlay = 1;
+/* 告警附加条件: 最大热点的点数不少于此值, 0不检查(只按超过告警温度的点数) */
+static uint16_t s_blob_alarm_area = 0;
+#define BLOB_RGB LCD_RGB(0,255,0)
+
+#define AGC_Q             4         /* 范围定点小数位 */
+#define AGC_IIR_SHIFT     2         /* 范围平滑系数1/4, 避免闪烁 */
+#define AGC_SPAN_MIN      (2*50)    /* 最小显示范围2℃, 避免放大噪声 */
+
+/* 自动增益: 平滑后的场景范围映射到整个调色板, 开关对所有传感器 */
+static uint8_t s_agc_enable = 1;
+
+#define HEQ_GRAY_DELTA    3         /* 映射变化超过3级灰度才重新生成LUT */
+#define HEQ_PLATEAU(num)  (((num)/64 > 0) ? (num)/64 : 1)   /* 每个bin最多计入1/64的点 */
+
+/* 直方图均衡: 开启时优先于自动增益, 开关对所有传感器 */
+static uint8_t s_heq_enable = 0;
+
+static inline uint8_t temp2gray(int16_t temp)
+{
+    int32_t x = (int32_t)temp + 25;
+    int32_t t;
+    if(x >= 0){
+        t = (int32_t)(((uint32_t)x*TEMP_DIV50_MUL) >> TEMP_DIV50_SHIFT);
+    }else{
+        t = -(int32_t)(((uint32_t)(-x)*TEMP_DIV50_MUL) >> TEMP_DIV50_SHIFT);
+    }
+    x = 17*(t+40);
+    if(x >= 0){
+        return (uint8_t)(((uint32_t)x*GRAY_DIV20_MUL) >> GRAY_DIV20_SHIFT);
+    }
+    return (uint8_t)(-(int32_t)(((uint32_t)(-x)*GRAY_DIV20_MUL) >> GRAY_DIV20_SHIFT));
+}
+
+/**
+ * temp 输入原始温度数据
+ * rgb 输出RGB565, 可直接写LCD
+ * start end 转换的点[start,end)
+ */
+void temp2rgb(const int16_t* temp, uint16_t* rgb, int start, int end)
 {
-    int16_t maxtemp = 0;
+    const uint16_t* lut = mlx90642_palette_lut();   /* 每次转换只取一次,切换调色板不影响正在转换的帧 */
+    for(int i=start;i<end;i++){
+        rgb[i] = lut[temp2gray(temp[i])];
+    }
+}
+
+/**
+ * temp 输入原始温度数据
+ * rgb 输出RGB565
+ * start end 转换的点[start,end)
+ * map [lo,lo+span)线性映射到灰度0~255, 超出范围取两端颜色
+ */
+void temp2rgb_agc(const int16_t* temp, uint16_t* rgb, int start, int end, const mlx90642_agc_map_st* map)
+{
+    const uint16_t* lut = mlx90642_palette_lut();
+    int16_t lo = map->lo;
+    int32_t span = map->span;
+    uint32_t scale = map->scale;
+    int32_t x;
+    for(int i=start;i<end;i++){
+        x = (int32_t)temp[i] - lo;
+        if(x <= 0){
+            rgb[i] = lut[0];
+        }else if(x >= span){
+            rgb[i] = lut[255];
+        }else{
+            rgb[i] = lut[((uint32_t)x*scale) >> 16];
+        }
+    }
+}
+
+/**
+ * temp 输入原始温度数据
+ * rgb 输出RGB565
+ * start end 转换的点[start,end)
+ * hist 温度->bin, 与统计时的划分相同
+ * lut bin->RGB565, 每点一次查表
+ */
+void temp2rgb_heq(const int16_t* temp, uint16_t* rgb, int start, int end, const mlx90642_hist_st* hist, const uint16_t* lut)
+{
+    int32_t lo = hist->lo;
+    int shift = hist->shift;
+    int32_t x;
+    for(int i=start;i<end;i++){
+        x = ((int32_t)temp[i] - lo) >> shift;
+        if(x <= 0){
+            rgb[i] = lut[0];
+        }else if(x >= MLX90642_HIST_BINS){
+            rgb[i] = lut[MLX90642_HIST_BINS-1];
+        }else{
+            rgb[i] = lut[x];
+        }
+    }
+}
+
+/**
+ * 统计的遍历, hist为0时不统计直方图(调用处为常量, 内联后没有额外判断)
+ * 直方图增量维护: 只有换了bin的点才修改计数, rebuild时清零重建
+ */
+static inline __attribute__((always_inline)) void mlx90642_stat_pass(const int16_t* temp, uint32_t rows, int16_t th, mlx90642_stat_st* stat, mlx90642_hist_st* hist)
+{
+    int16_t min = INT16_MAX;
+    int16_t max = INT16_MIN;
+    int32_t sum = 0;
+    int over = 0;
+    int num = 0;
+    int hot = 0;
+    int moved = 0;
+    int rebuild = 0;
+    int32_t lo = 0;
+    int shift = 0;
+    const int16_t* p;
+    uint8_t* idx = 0;
     int16_t t;
-    uint8_t gray;
-    uint8_t gray_max=255;
-    for(int i=0;i<32*24;i++){
-        if(temp[i]>maxtemp){
-            maxtemp = temp[i];
+    int32_t b;
+    if(hist){
+        lo = hist->lo;
+        shift = hist->shift;
+        rebuild = hist->rebuild;
+        if(rebuild){
+            memset(hist->bin, 0, sizeof(hist->bin));
         }
     }
-#if 0
-    t = ((int16_t)maxtemp*2+50) / 100;   /* 除以50对应温度,四舍五入 */
-    gray_max = (uint8_t)(((int32_t)255*((int32_t)t+40))/(int32_t)300);
-#else
-    gray_max = 255;
-#endif
-	for(int i=0;i<32*24;i++){
+    for(int y=0; y<24; y++){
+        if((rows & (1ul<<y)) == 0){
+            continue;
+        }
+        p = temp + y*32;
+        if(hist){
+            idx = hist->idx + y*32;
+        }
+        for(int x=0; x<32; x++){
+            t = p[x];
+            if(t < min){
+                min = t;
+            }
+            if(t > max){
+                max = t;
+                hot = y*32 + x;
+            }
+            sum += t;
+            over += (t >= th);
+            if(hist){
+                b = ((int32_t)t - lo) >> shift;
+                if(b < 0){
+                    b = 0;
+                }else if(b >= MLX90642_HIST_BINS){
+                    b = MLX90642_HIST_BINS-1;
+                }
+                if(rebuild){
+                    hist->bin[b]++;
+                    idx[x] = (uint8_t)b;
+                }else if(idx[x] != b){
+                    hist->bin[idx[x]]--;
+                    hist->bin[b]++;
+                    idx[x] = (uint8_t)b;
+                    moved++;
+                }
+            }
+        }
+        num += 32;
+    }
+    if(hist){
+        if(rebuild){
+            hist->num = (uint16_t)num;
+            hist->rows = rows;
+            hist->rebuild = 0;
+            moved = num;
+        }
+        hist->moved = (uint16_t)moved;
+    }
+    if(num == 0){
+        memset(stat, 0, sizeof(*stat));
+        return;
+    }
+    stat->min = min;
+    stat->max = max;
+    stat->mean = (int16_t)(sum / num);
+    stat->hot_idx = (uint16_t)hot;
+    stat->over = (uint16_t)over;
+    stat->num = (uint16_t)num;
+}
+
+/**
+ * 一次遍历得到最小/最大/平均值, 最高温点和超过阈值的点数
+ * rows 有效行, 过期的行不参与统计
+ */
+void mlx90642_frame_stat(const int16_t* temp, uint32_t rows, int16_t th, mlx90642_stat_st* stat)
+{
+    mlx90642_stat_pass(temp, rows, th, stat, 0);
+}
+
+/**
+ * 同mlx90642_frame_stat, 同一次遍历中维护温度直方图
+ * rows与重建时不同时, 不在rows中的点仍按上次的bin计入, 调用者应置hist->rebuild
+ */
+void mlx90642_frame_stat_hist(const int16_t* temp, uint32_t rows, int16_t th, mlx90642_stat_st* stat, mlx90642_hist_st* hist)
+{
+    mlx90642_stat_pass(temp, rows, th, stat, hist);
+}
+
+/**
+ * 平台直方图均衡: 每个bin最多计入plateau个点, 累计分布映射到灰度0~255
+ * 取bin的中点, 空bin与前一个bin同灰度
+ */
+void mlx90642_heq_map(const mlx90642_hist_st* hist, uint16_t plateau, uint8_t* gray)
+{
+    uint32_t total = 0;
+    uint32_t cum = 0;
+    uint32_t c;
+    uint32_t scale;
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        total += (hist->bin[i] > plateau) ? plateau : hist->bin[i];
+    }
+    if(total == 0){
+        memset(gray, 0, MLX90642_HIST_BINS);
+        return;
+    }
+    scale = (255ul << 16) / (2*total);
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        c = (hist->bin[i] > plateau) ? plateau : hist->bin[i];
+        gray[i] = (uint8_t)(((2*cum + c)*scale) >> 16);
+        cum += c;
+    }
+}
+
+/**
+ * 按上一帧的温度范围确定bin划分, 范围仍在内且分辨率合适时保持不变,
+ * 避免每帧都要重建直方图和LUT
+ */
+static void mlx90642_heq_base(mlx90642_heq_st* heq, const mlx90642_stat_st* prev, uint32_t rows){
+    mlx90642_hist_st* hist = &heq->hist;
+    int32_t min = -40*50;
+    int32_t max = 260*50;
+    int32_t span;
+    int need = 0;
+    if(prev->num != 0){
+        min = prev->min;
+        max = prev->max;
+    }
+    span = max - min + 1;
+    while((span >> need) >= MLX90642_HIST_BINS){
+        need++;
+    }
+    if((heq->valid == 0) || (need > hist->shift) || (need + 1 < hist->shift) ||
+        (min < hist->lo) || (max >= hist->lo + ((int32_t)MLX90642_HIST_BINS << hist->shift))){
+        hist->shift = (uint8_t)need;
+        hist->lo = min - ((((int32_t)MLX90642_HIST_BINS << need) - span) >> 1);
+        hist->rebuild = 1;
+        heq->valid = 1;
+        heq->pal = 0;  /* bin变了, LUT必须重新生成 */
+    }
+    if(hist->rows != rows){
+        hist->rebuild = 1;
+    }
+}
+
+/* 映射变化明显(或调色板/bin划分变了)时才重新生成LUT */
+static void mlx90642_heq_update(mlx90642_heq_st* heq){
+    uint8_t gray[MLX90642_HIST_BINS];
+    const uint16_t* pal = mlx90642_palette_lut();
+    int diff = 0;
+    int d;
+    mlx90642_heq_map(&heq->hist, HEQ_PLATEAU(heq->hist.num), gray);
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        d = (int)gray[i] - (int)heq->gray[i];
+        if(d < 0){
+            d = -d;
+        }
+        if(d > diff){
+            diff = d;
+        }
+    }
+    if((pal == heq->pal) && (diff <= HEQ_GRAY_DELTA)){
+        return;
+    }
+    memcpy(heq->gray, gray, sizeof(gray));
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        heq->lut[i] = pal[gray[i]];
+    }
+    heq->pal = pal;
+    heq->regen++;
+}
+
+/* 用本帧统计更新显示范围, 作用于下一次转换 */
+static void mlx90642_agc_update(mlx90642_agc_st* agc){
+    const mlx90642_stat_st* stat = &agc->stat;
+    int32_t lo;
+    int32_t hi;
+    if(stat->num == 0){
+        return;
+    }
+    if(agc->valid == 0){
+        agc->lo_q = (int32_t)stat->min << AGC_Q;
+        agc->hi_q = (int32_t)stat->max << AGC_Q;
+        agc->valid = 1;
+    }else{
+        agc->lo_q += (((int32_t)stat->min << AGC_Q) - agc->lo_q) >> AGC_IIR_SHIFT;
+        agc->hi_q += (((int32_t)stat->max << AGC_Q) - agc->hi_q) >> AGC_IIR_SHIFT;
+    }
+    lo = agc->lo_q >> AGC_Q;
+    hi = agc->hi_q >> AGC_Q;
+    if(hi - lo < AGC_SPAN_MIN){
+        lo = (lo + hi)/2 - AGC_SPAN_MIN/2;
+        hi = lo + AGC_SPAN_MIN;
+    }
+    agc->map.lo = (int16_t)lo;
+    agc->map.span = (uint16_t)(hi - lo);
+    agc->map.scale = (255ul << 16) / agc->map.span;
+}
+
+/**
+ * 原来的逐点除法实现, 用于对比
+ * temp 输入原始温度数据
+ * rgb 输出RGB565
+ * start end 转换的点[start,end)
+ */
+void temp2rgb_ref(const int16_t* temp, uint16_t* rgb, int start, int end)
+{
+    int16_t t;
+    uint8_t gray;
+    uint8_t gray_max=255;
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+	for(int i=start;i<end;i++){
 		/* 转温度为灰度 
         * -40 0
         * x   y
@@ -44,90 +479,283 @@ void temp2rgb(int16_t* temp)
         gray = (uint8_t)(((int32_t)255*((int32_t)t+40))/(int32_t)300);
 		/* 计算 */
         if(gray<=(gray_max/8)){
-            s_r[i]=0;
-            s_g[i]=0;
-            s_b[i]=(gray*255)/64;
+            r=0;
+            g=0;
+            b=(gray*255)/64;
         }
         else if(gray<=(gray_max*3/8)){
-            s_r[i]=0;
-            s_g[i]=((gray-64)*255)/64;
-            s_b[i]=((127-gray)*255)/64;
+            r=0;
+            g=((gray-64)*255)/64;
+            b=((127-gray)*255)/64;
         }
         else if(gray<=(gray_max*5)/8){
-            s_r[i]=((gray-128)*255)/64;
-            s_g[i]=255;
-            s_b[i]=0;
+            r=((gray-128)*255)/64;
+            g=255;
+            b=0;
         }
         else{
-            s_r[i]=255;
-            s_g[i]=((255-gray)*255)/64;
-            s_b[i]=0;
+            r=255;
+            g=((255-gray)*255)/64;
+            b=0;
         }
+        rgb[i] = RGB(r,g,b);
 	}	
 }
 
+int mlx90642_disp_roi(const MLX90642_RowBand_t* bands, int num){
+    uint32_t mask = 0;
+    if((num < 0) || (num > MLX90642_MAX_ROW_BANDS)){
+        return -1;
+    }
+    for(int i=0; i<num; i++){
+        if((bands[i].numberOfRows == 0) || (bands[i].startRow + bands[i].numberOfRows > MLX90642_NUMBER_OF_ROWS)){
+            return -1;
+        }
+        mask |= ((1ul<<bands[i].numberOfRows)-1) << bands[i].startRow;
+    }
+    for(int i=0; i<num; i++){
+        s_roi[i] = bands[i];
+    }
+    s_roi_num = num;
+    s_roi_mask = (num > 0) ? mask : ROW_MASK_ALL;
+    return 0;
+}
+
+/* 多个传感器横向排列, 每个点显示为cell*cell */
+static int mlx90642_disp_cell(void){
+    return (s_sensor_num > 1) ? 10/s_sensor_num : 10;
+}
+
 /**
+ * id 传感器, 按它的直方图/自动增益范围映射
  * temp 输入原始温度数据
- * cnt 输入超过阈值的点数
- * th 输入阈值温度
+ * gray 输出当前映射(直方图均衡/自动增益/固定范围)下的灰度, Q4
+ * start end 转换的点[start,end)
  */
-static  int mlx90642_warn(int16_t* temp, int cnt, int th){
-    int n = 0;
-    for(int i=0; i<32*24; i++){
-        if(temp[i] >= th){
-            n++;
+void mlx90642_disp_gray(int id, const int16_t* temp, int16_t* gray, int start, int end)
+{
+    const mlx90642_agc_st* agc = &s_sensor[id].agc;
+    const mlx90642_heq_st* heq = &s_sensor[id].heq;
+    int32_t x;
+    if(s_heq_enable && (heq->pal != 0)){
+        int32_t lo = heq->hist.lo;
+        int shift = heq->hist.shift;
+        for(int i=start;i<end;i++){
+            x = ((int32_t)temp[i] - lo) >> shift;
+            if(x < 0){
+                x = 0;
+            }else if(x >= MLX90642_HIST_BINS){
+                x = MLX90642_HIST_BINS-1;
+            }
+            gray[i] = (int16_t)(heq->gray[x] << MLX90642_SCALE_Q);
+        }
+    }else if(s_agc_enable && agc->valid){
+        int16_t lo = agc->map.lo;
+        int32_t span = agc->map.span;
+        uint32_t scale = agc->map.scale;
+        for(int i=start;i<end;i++){
+            x = (int32_t)temp[i] - lo;
+            if(x <= 0){
+                gray[i] = 0;
+            }else if(x >= span){
+                gray[i] = 255 << MLX90642_SCALE_Q;
+            }else{
+                gray[i] = (int16_t)(((uint32_t)x*scale) >> (16 - MLX90642_SCALE_Q));
+            }
         }
-    }
-    if(n >= cnt){
-        return 1;
     }else{
+        for(int i=start;i<end;i++){
+            gray[i] = (int16_t)(temp2gray(temp[i]) << MLX90642_SCALE_Q);
+        }
+    }
+}
+
+#if !LCD_ITF_LTDC
+/* 从第一个不同的字开始复制一行, 返回1有变化 */
+static int mlx90642_disp_line_copy(uint32_t* dst, const uint32_t* src, int words){
+    int i = 0;
+    while((i < words) && (dst[i] == src[i])){
+        i++;
+    }
+    if(i == words){
         return 0;
     }
+    for(; i<words; i++){
+        dst[i] = src[i];
+    }
+    return 1;
 }
+#endif
 
+#if LCD_ITF_LTDC
 /**
- * Byte0         Byte1
- * D7~D3  D2~0   D7~5  D4~D0
- * R     |    G       |  B
+ * 双线性放大行[y0,y1)的L8版本: CPU只插值出索引, 查表和写SDRAM由DMA2D完成, 与下一行的插值重叠.
+ * 不需要和显存比较: LTDC刷新不用发送, 写显存也不占CPU
  */
-#define RGB(r,g,b) (((uint16_t)r&0xF8) | ((uint16_t)g>>5) | ((((uint16_t)g&0xE0) | ((uint16_t)b&0x1F))<<8))
+static void mlx90642_disp_rows_l8(mlx90642_sensor_st* sensor, int y0, int y1, uint32_t rows, int x0, const uint16_t* lut){
+    int cell = s_scale.k;
+    int w = s_scale.w;
+    uint8_t* l8;
+    int y;
+    int r0;
+    int r1;
+    for(int r=y0; r<y1; r++){
+        if((rows & (1ul<<r)) == 0){
+            if((sensor->stale_drawn & (1ul<<r)) == 0){
+                sensor->stale_drawn |= (1ul<<r);
+                lcd_itf_fill(x0, w, r*cell, cell, STALE_RGB);
+            }
+            continue;
+        }
+        sensor->stale_drawn &= ~(1ul<<r);
+        /* 上一次转换启动时, 再上一次(用这个缓存的)已完成 */
+        l8 = s_l8[s_l8_idx];
+        s_l8_idx ^= 1;
+        for(int k=0; k<cell; k++){
+            y = r*cell + k;
+            r0 = s_scale.row[y];
+            r1 = r0 + 1;
+            if((rows & (1ul<<r0)) == 0){
+                r0 = r1;
+            }
+            if((rows & (1ul<<r1)) == 0){
+                r1 = r0;
+            }
+            mlx90642_scale_line_l8(&s_scale, s_gray + r0*32, s_gray + r1*32, s_scale.roww[y], (uint32_t*)(l8 + k*w));
+        }
+        lcd_itf_blit_l8(x0, w, r*cell, cell, l8, w, lut);
+    }
+}
+#endif
 
-int mlx90642_disp(void){
-    int status;
-    int  idx = 0;
+/* 双线性放大显示行[y0,y1), 插值只用有效的行 */
+static void mlx90642_disp_rows_scaled(mlx90642_sensor_st* sensor, uint16_t* temp, int y0, int y1, uint32_t rows){
+    int cell = mlx90642_disp_cell();
+    int x0 = (int)(sensor - s_sensor)*32*cell;
+    const uint16_t* lut = mlx90642_palette_lut();
+    int g0 = (y0 > 0) ? y0-1 : 0;
+    int g1 = (y1 < 24) ? y1+1 : 24;
+    if(s_scale.k != cell){
+        mlx90642_scale_init(&s_scale, cell);
+    }
+    sensor->cell_drawn = 0;
+    /* 插值会用到相邻行 */
+    mlx90642_disp_gray((int)(sensor - s_sensor), (const int16_t*)temp, s_gray, g0*32, g1*32);
+#if LCD_ITF_LTDC
+    mlx90642_disp_rows_l8(sensor, y0, y1, rows, x0, lut);
+#else
+    uint16_t* fb = lcd_itf_buffer();
+    uint32_t* dst;
+    int r;
+    int r0;
+    int r1;
+    for(int y=y0*cell; y<y1*cell; y++){
+        dst = (uint32_t*)(fb + y*LCD_HSIZE + x0);
+        r = y/cell;
+        if((rows & (1ul<<r)) == 0){
+            if((sensor->stale_drawn & (1ul<<r)) == 0){
+                mlx90642_scale_fill(dst, s_scale.w, STALE_RGB);
+                lcd_itf_mark(x0, s_scale.w, y, 1);
+            }
+            if(y == (r+1)*cell-1){
+                sensor->stale_drawn |= (1ul<<r);
+            }
+            continue;
+        }
+        sensor->stale_drawn &= ~(1ul<<r);
+        r0 = s_scale.row[y];
+        r1 = r0 + 1;
+        if((rows & (1ul<<r0)) == 0){
+            r0 = r1;
+        }
+        if((rows & (1ul<<r1)) == 0){
+            r1 = r0;
+        }
+        mlx90642_scale_line(&s_scale, s_gray + r0*32, s_gray + r1*32, s_scale.roww[y], lut, s_line);
+        if(mlx90642_disp_line_copy(dst, s_line, s_scale.w/2)){
+            lcd_itf_mark(x0, s_scale.w, y, 1);
+        }
+    }
+#endif
+}
 
-    /* wait for new data */
-    status = MLX90642_NO; 
-    while(status == MLX90642_NO){
-        status = MLX90642_IsReadWindowOpen(SA_90642_DEFAULT);
-        if(status < 0){
-            xprintf("MLX90642_IsReadWindowOpen err %d\r\n",status);
-        }         
+/* 中值滤波开启时返回滤波后的帧, 统计和告警不经过这里 */
+static uint16_t* mlx90642_disp_median(uint16_t* temp, uint32_t rows){
+    if(s_median_enable == 0){
+        return temp;
     }
+    mlx90642_median_run((const int16_t*)temp, s_med, rows);
+    return (uint16_t*)s_med;
+}
 
-    //xprintf("Start GetImage\r\n");
-    /* Read out the image data */
-    status = MLX90642_GetImage(SA_90642_DEFAULT, s_temp);
-    if(status < 0){
-        xprintf("MLX90642_GetImage err %d\r\n",status);
-        return -1;
+/* 行[y0,y1)按当前映射转换为s_rgb */
+static void mlx90642_disp_colour(mlx90642_sensor_st* sensor, uint16_t* temp, int y0, int y1){
+    if(s_heq_enable && (sensor->heq.pal != 0)){
+        temp2rgb_heq((const int16_t*)temp, s_rgb, y0*32, y1*32, &sensor->heq.hist, sensor->heq.lut);
+    }else if(s_agc_enable && sensor->agc.valid){
+        temp2rgb_agc((const int16_t*)temp, s_rgb, y0*32, y1*32, &sensor->agc.map);
     }else{
-        //xprintf("MLX90642_GetImage ok\r\n");
+        temp2rgb((const int16_t*)temp, s_rgb, y0*32, y1*32);
     }
-    temp2rgb((int16_t*)s_temp);
-    for(int y=0; y<24; y++){
+}
+
+/* 显示行[y0,y1), rows中为0的行按过期显示, 在lcd_itf_frame_begin/lcd_itf_frame_end之间调用 */
+static void mlx90642_disp_rows(mlx90642_sensor_st* sensor, uint16_t* temp, int y0, int y1, uint32_t rows){
+    int idx = y0*32;
+    int cell = mlx90642_disp_cell();
+    int x0 = (int)(sensor - s_sensor)*32*cell;
+    uint16_t* drawn = s_drawn[sensor - s_sensor];
+    if(s_scale_enable && (cell >= 2)){
+        mlx90642_disp_rows_scaled(sensor, temp, y0, y1, rows);
+        return;
+    }
+    mlx90642_disp_colour(sensor, temp, y0, y1);
+    for(int y=y0; y<y1; y++){
         //xprintf("\r\n");
+        if((rows & (1ul<<y)) == 0){
+            /* 过期的行只需显示一次 */
+            if((sensor->stale_drawn & (1ul<<y)) == 0){
+                sensor->stale_drawn |= (1ul<<y);
+                sensor->cell_drawn &= ~(1ul<<y);
+                lcd_itf_fill(x0,32*cell,y*cell,cell,STALE_RGB);
+            }
+            idx += 32;
+            continue;
+        }
+        sensor->stale_drawn &= ~(1ul<<y);
+        if((sensor->cell_drawn & (1ul<<y)) == 0){
+            sensor->cell_drawn |= (1ul<<y);
+            for(int x=0; x<32; x++){
+                drawn[idx + x] = (uint16_t)~s_rgb[idx + x];  /* 整行重画 */
+            }
+        }
         for(int x=0; x<32; x++){
             //xprintf("%d ",s_temp[idx]);
-            lcd_itf_fill(x*10,10,y*10,10,RGB(s_r[idx],s_g[idx],s_b[idx]));
+            if(s_rgb[idx] != drawn[idx]){
+                drawn[idx] = s_rgb[idx];
+                lcd_itf_fill(x0+x*cell,cell,y*cell,cell,s_rgb[idx]);
+            }
             idx++;
         }
     }
-    lcd_itf_sync();
+}
 
+/* 一帧的统计: 告警判断, 并更新下一帧的自动增益范围 */
+static void mlx90642_disp_stat(mlx90642_sensor_st* sensor, uint16_t* temp, uint32_t rows){
     static int s_warn_time = 0;
     static int s_warn_state_pre = 0;
-    if(mlx90642_warn((int16_t*)s_temp,2,100*50)){
+    const mlx90642_blob_list_st* blobs;
+    if(s_heq_enable){
+        mlx90642_heq_base(&sensor->heq, &sensor->agc.stat, rows);
+        mlx90642_frame_stat_hist((const int16_t*)temp, rows, WARN_TH, &sensor->agc.stat, &sensor->heq.hist);
+        mlx90642_heq_update(&sensor->heq);
+    }else{
+        mlx90642_frame_stat((const int16_t*)temp, rows, WARN_TH, &sensor->agc.stat);
+    }
+    mlx90642_agc_update(&sensor->agc);
+    blobs = mlx90642_blob_run((int)(sensor - s_sensor), (const int16_t*)temp, rows, WARN_TH);
+    if((sensor->agc.stat.over >= WARN_CNT) &&
+       ((s_blob_alarm_area == 0) || ((blobs != 0) && (blobs->area_max >= s_blob_alarm_area)))){
         if(s_warn_state_pre==0){
             s_warn_state_pre = 1;
             xprintf("warn on!\r\n");
@@ -145,38 +773,564 @@ int mlx90642_disp(void){
             }
         }
     }
+}
+
+/* 画出传感器当前热点的外接框 */
+static void mlx90642_disp_blob(mlx90642_sensor_st* sensor){
+    const mlx90642_blob_list_st* blobs = mlx90642_blob_get((int)(sensor - s_sensor));
+    const mlx90642_blob_st* b;
+    int cell = mlx90642_disp_cell();
+    int x0 = (int)(sensor - s_sensor)*32*cell;
+    int x;
+    int y;
+    int w;
+    int h;
+    if((s_blob_overlay == 0) || (blobs == 0)){
+        return;
+    }
+    for(int i=0; i<blobs->num; i++){
+        b = &blobs->blob[i];
+        x = x0 + b->x0*cell;
+        y = b->y0*cell;
+        w = (b->x1 - b->x0 + 1)*cell;
+        h = (b->y1 - b->y0 + 1)*cell;
+        lcd_itf_fill(x, w, y, 1, BLOB_RGB);
+        lcd_itf_fill(x, w, y+h-1, 1, BLOB_RGB);
+        lcd_itf_fill(x, 1, y, h, BLOB_RGB);
+        lcd_itf_fill(x+w-1, 1, y, h, BLOB_RGB);
+        /* 框盖住的点下一帧重画 */
+        sensor->cell_drawn &= ~(((2ul << b->y1) - 1) & ~((1ul << b->y0) - 1));
+    }
+}
+
+/* 行带中画出热点外接框与第r行相交的部分, band一行w个点, 共cell行 */
+static void mlx90642_disp_blob_band(mlx90642_sensor_st* sensor, uint16_t* band, int r, int cell, int w){
+    const mlx90642_blob_list_st* blobs = mlx90642_blob_get((int)(sensor - s_sensor));
+    const mlx90642_blob_st* b;
+    int x0;
+    int x1;
+    if((s_blob_overlay == 0) || (blobs == 0)){
+        return;
+    }
+    for(int i=0; i<blobs->num; i++){
+        b = &blobs->blob[i];
+        if((r < b->y0) || (r > b->y1)){
+            continue;
+        }
+        x0 = b->x0*cell;
+        x1 = (b->x1 + 1)*cell - 1;
+        for(int x=x0; x<=x1; x++){
+            if(r == b->y0){
+                band[x] = BLOB_RGB;
+            }
+            if(r == b->y1){
+                band[(cell-1)*w + x] = BLOB_RGB;
+            }
+        }
+        for(int k=0; k<cell; k++){
+            band[k*w + x0] = BLOB_RGB;
+            band[k*w + x1] = BLOB_RGB;
+        }
+    }
+}
+
+/**
+ * 行带显示行[y0,y1): 每个热像行在内部SRAM的行带缓存中着色/放大后直接DMA到LCD, 不写SDRAM显存.
+ * 发送一条的同时绘制下一条. blob为1时叠加热点外接框
+ */
+static void mlx90642_disp_rows_band(mlx90642_sensor_st* sensor, uint16_t* temp, int y0, int y1, uint32_t rows, int blob){
+    int cell = mlx90642_disp_cell();
+    int w = 32*cell;
+    int x0 = (int)(sensor - s_sensor)*w;
+    int scaled = s_scale_enable && (cell >= 2);
+    const uint16_t* lut = mlx90642_palette_lut();
+    uint16_t* band;
+    uint32_t* line;
+    uint16_t rgb;
+    int y;
+    int r0;
+    int r1;
+    if(scaled){
+        if(s_scale.k != cell){
+            mlx90642_scale_init(&s_scale, cell);
+        }
+        mlx90642_disp_gray((int)(sensor - s_sensor), (const int16_t*)temp, s_gray, ((y0 > 0) ? y0-1 : 0)*32, ((y1 < 24) ? y1+1 : 24)*32);
+    }else{
+        mlx90642_disp_colour(sensor, temp, y0, y1);
+    }
+    for(int r=y0; r<y1; r++){
+        if((rows & (1ul<<r)) == 0){
+            /* 过期的行只需显示一次 */
+            if(sensor->stale_drawn & (1ul<<r)){
+                continue;
+            }
+            sensor->stale_drawn |= (1ul<<r);
+            band = lcd_itf_band_begin(x0, w, r*cell, cell);
+            mlx90642_scale_fill((uint32_t*)band, w*cell, STALE_RGB);
+            lcd_itf_band_end();
+            continue;
+        }
+        sensor->stale_drawn &= ~(1ul<<r);
+        band = lcd_itf_band_begin(x0, w, r*cell, cell);
+        if(scaled){
+            for(int k=0; k<cell; k++){
+                y = r*cell + k;
+                r0 = s_scale.row[y];
+                r1 = r0 + 1;
+                if((rows & (1ul<<r0)) == 0){
+                    r0 = r1;
+                }
+                if((rows & (1ul<<r1)) == 0){
+                    r1 = r0;
+                }
+                mlx90642_scale_line(&s_scale, s_gray + r0*32, s_gray + r1*32, s_scale.roww[y], lut, (uint32_t*)(band + k*w));
+            }
+        }else{
+            /* 第一行填色块, 其余行复制 */
+            for(int x=0; x<32; x++){
+                rgb = s_rgb[r*32 + x];
+                for(int j=0; j<cell; j++){
+                    band[x*cell + j] = rgb;
+                }
+            }
+            line = (uint32_t*)band;
+            for(int k=1; k<cell; k++){
+                for(int i=0; i<w/2; i++){
+                    line[k*w/2 + i] = line[i];
+                }
+            }
+        }
+        if(blob){
+            mlx90642_disp_blob_band(sensor, band, r, cell, w);
+        }
+        lcd_itf_band_end();
+    }
+    sensor->cell_drawn = 0;  /* 显存中的色块已和LCD不同 */
+}
+
+/* 记录一帧从读窗口打开到最后一个点显示的延迟 */
+static void mlx90642_disp_lat(uint32_t t_open){
+    uint32_t us = (clock_get_cycles() - t_open) / (clock_get_ahb() / 1000000);
+    s_lat.last_us = us;
+    if((s_lat.frames == 0) || (us < s_lat.min_us)){
+        s_lat.min_us = us;
+    }
+    if(us > s_lat.max_us){
+        s_lat.max_us = us;
+    }
+    s_lat.sum_us += us;
+    s_lat.frames++;
+}
+
+/* 刷新已启动, DMA发送完成后在mlx90642_disp中记录延迟 */
+static void mlx90642_disp_lat_start(uint32_t t_open){
+    if(s_lat.pending){
+        mlx90642_disp_lat(s_lat.t_open);
+    }
+    s_lat.t_open = t_open;
+    s_lat.pending = 1;
+}
+
+/**
+ * 整帧模式: 读窗口打开后后台读整帧(或ROI行带)到一个缓存, 同时显示另一个缓存
+ * 多个传感器共用总线, 哪个传感器的读窗口先打开就先读哪个
+ */
+static int mlx90642_disp_frame(void){
+    int status;
+    mlx90642_sensor_st* sensor;
+    uint16_t* temp;
+    uint32_t rows;
+
+    status = MLX90642_GetImageAsyncPoll();
+    if((status <= 0) && (s_bus_owner >= 0)){
+        sensor = &s_sensor[s_bus_owner];
+        s_bus_owner = -1;
+        if(status < 0){
+            xprintf("0x%02X MLX90642_GetImage err %d\r\n",sensor->addr,status);
+        }else{
+            sensor->disp_idx = sensor->rx_idx;
+            sensor->rx_idx ^= 1;
+        }
+    }
+
+    /* 总线空闲时启动下一个读窗口已打开的传感器, 接收期间显示其他帧 */
+    for(int k=0; (k<s_sensor_num) && (s_bus_owner < 0); k++){
+        int i = (s_sensor_next + k) % s_sensor_num;
+        sensor = &s_sensor[i];
+        status = mlx90642_sched_poll(sensor->addr);
+        if(status < 0){
+            xprintf("0x%02X mlx90642_sched_poll err %d\r\n",sensor->addr,status);
+        }else if(status == MLX90642_YES){
+            //xprintf("Start GetImage\r\n");
+            sensor->t_open[sensor->rx_idx] = clock_get_cycles();
+            if(s_roi_num > 0){
+                status = MLX90642_GetImageRowsAsync(sensor->addr, sensor->temp[sensor->rx_idx], s_roi, s_roi_num, 0);
+            }else{
+                status = MLX90642_GetImageAsync(sensor->addr, sensor->temp[sensor->rx_idx], 0);
+            }
+            if(status < 0){
+                xprintf("0x%02X MLX90642_GetImageAsync err %d\r\n",sensor->addr,status);
+                continue;
+            }
+            sensor->fresh[sensor->rx_idx] = s_roi_mask;
+            s_bus_owner = i;
+            s_sensor_next = (i + 1) % s_sensor_num;
+        }
+    }
+
+    /* 每次显示一个有新数据的传感器 */
+    for(int i=0; i<s_sensor_num; i++){
+        sensor = &s_sensor[i];
+        if(sensor->disp_idx < 0){
+            continue;
+        }
+        temp = sensor->temp[sensor->disp_idx];
+        rows = sensor->fresh[sensor->disp_idx];
+        /* 先校正坏点, 滤波和统计, 本帧按自己的范围显示 */
+        mlx90642_badpix_run(i, (int16_t*)temp, rows);
+        mlx90642_filter_run(i, (int16_t*)temp, rows);
+        mlx90642_disp_stat(sensor, temp, rows);
+        if(s_band_enable){
+            mlx90642_disp_rows_band(sensor, mlx90642_disp_median(temp, rows), 0, 24, rows, 1);
+        }else{
+            /* 绘制后缓存时前缓存仍在发送, 只发送修改过的块 */
+            lcd_itf_frame_begin();
+            mlx90642_disp_rows(sensor, mlx90642_disp_median(temp, rows), 0, 24, rows);
+            mlx90642_disp_blob(sensor);
+            lcd_itf_frame_end();
+        }
+        mlx90642_disp_lat_start(sensor->t_open[sensor->disp_idx]);
+        sensor->disp_idx = -1;
+        break;
+    }
     return 0;
 }
 
-int mlx90642_disp_init(void)
+/**
+ * 流模式: 根据测量进度读取已经更新的行并立即显示, 读窗口打开后只需再读剩余的行
+ * 进度按行顺序线性推进, 最后一行总是等读窗口打开再读
+ */
+static int mlx90642_disp_stream(void){
+    int status;
+    int rows;
+    mlx90642_sensor_st* sensor = &s_sensor[0];
+    uint16_t* temp = sensor->temp[0];
+    uint32_t now;
+
+    if(s_sensor_num == 0){
+        return 0;
+    }
+
+    status = MLX90642_GetImageAsyncPoll();
+    if(status > 0){
+        return 0;
+    }
+    if(s_bus_owner >= 0){
+        s_bus_owner = -1;
+        if(status < 0){
+            xprintf("MLX90642_GetImageRows err %d\r\n",status);
+            s_st_final = 0;
+        }else{
+            /* 行带读完立即校正坏点, 滤波并显示 */
+            mlx90642_badpix_run(0, (int16_t*)temp, ((1ul<<s_st_band.numberOfRows)-1) << s_st_band.startRow);
+            mlx90642_filter_run(0, (int16_t*)temp, ((1ul<<s_st_band.numberOfRows)-1) << s_st_band.startRow);
+            if(s_band_enable){
+                mlx90642_disp_rows_band(sensor, mlx90642_disp_median(temp, ((1ul<<s_st_band.numberOfRows)-1) << s_st_band.startRow),
+                    s_st_band.startRow, s_st_band.startRow + s_st_band.numberOfRows, ROW_MASK_ALL, 0);
+            }else{
+                lcd_itf_frame_begin();
+                mlx90642_disp_rows(sensor, mlx90642_disp_median(temp, ((1ul<<s_st_band.numberOfRows)-1) << s_st_band.startRow),
+                    s_st_band.startRow, s_st_band.startRow + s_st_band.numberOfRows, ROW_MASK_ALL);
+                lcd_itf_frame_end();
+            }
+            s_st_row = s_st_band.startRow + s_st_band.numberOfRows;
+            if(s_st_final){
+                s_st_final = 0;
+                mlx90642_disp_lat_start(sensor->t_open[0]);
+                mlx90642_disp_stat(sensor, temp, ROW_MASK_ALL);  /* 流模式下范围作用于下一帧 */
+                s_st_row = 0;
+            }
+        }
+    }
+
+    status = mlx90642_sched_poll(sensor->addr);
+    if(status < 0){
+        xprintf("mlx90642_sched_poll err %d\r\n",status);
+        return -1;
+    }
+    if(status == MLX90642_YES){
+        /* 读窗口打开,读剩余的行 */
+        sensor->t_open[0] = clock_get_cycles();
+        s_st_final = 1;
+        rows = MLX90642_NUMBER_OF_ROWS;
+    }else{
+        /* 每行的时间查询一次进度 */
+        now = get_ticks();
+        if((uint32_t)(now - s_st_t_prog) < mlx90642_sched_stat(sensor->addr)->period_ms / MLX90642_NUMBER_OF_ROWS){
+            return 0;
+        }
+        s_st_t_prog = now;
+        status = MLX90642_GetProgress(sensor->addr);
+        if(status < 0){
+            xprintf("MLX90642_GetProgress err %d\r\n",status);
+            return -1;
+        }
+        if(status < s_st_prog_pre){
+            s_st_row = 0;  /* 错过了读窗口,新的一帧已开始 */
+        }
+        s_st_prog_pre = status;
+        rows = status * MLX90642_NUMBER_OF_ROWS / 100;
+        if(rows > MLX90642_NUMBER_OF_ROWS - 1){
+            rows = MLX90642_NUMBER_OF_ROWS - 1;
+        }
+    }
+    if(rows <= s_st_row){
+        s_st_final = 0;
+        return 0;
+    }
+    s_st_band.startRow = s_st_row;
+    s_st_band.numberOfRows = rows - s_st_row;
+    status = MLX90642_GetImageRowsAsync(sensor->addr, temp, &s_st_band, 1, 0);
+    if(status < 0){
+        xprintf("MLX90642_GetImageRowsAsync err %d\r\n",status);
+        s_st_final = 0;
+        return -1;
+    }
+    s_bus_owner = 0;
+    return 0;
+}
+
+int mlx90642_disp(void){
+    if(s_lat.pending && (lcd_itf_sync_busy() == 0)){
+        s_lat.pending = 0;
+        mlx90642_disp_lat(s_lat.t_open);
+    }
+    if(s_stream){
+        return mlx90642_disp_stream();
+    }else{
+        return mlx90642_disp_frame();
+    }
+}
+
+int mlx90642_disp_set_stream(int enable){
+    /* 等待进行中的读完成后切换, 丢弃未显示的数据 */
+    while(MLX90642_GetImageAsyncPoll() > 0);
+    s_bus_owner = -1;
+    for(int i=0; i<s_sensor_num; i++){
+        s_sensor[i].disp_idx = -1;
+    }
+    s_st_row = 0;
+    s_st_final = 0;
+    s_st_prog_pre = 0;
+    s_stream = enable ? 1 : 0;
+    memset(&s_lat, 0, sizeof(s_lat));
+    return 0;
+}
+
+int mlx90642_disp_agc(int enable){
+    s_agc_enable = enable ? 1 : 0;
+    for(int i=0; i<MLX90642_DISP_SENSOR_MAX; i++){
+        s_sensor[i].agc.valid = 0;
+    }
+    return 0;
+}
+
+void mlx90642_disp_agc_print(void){
+    const mlx90642_agc_st* agc;
+    const mlx90642_stat_st* st;
+    xprintf("agc:%s\r\n", s_agc_enable ? "on" : "off");
+    for(int i=0; i<s_sensor_num; i++){
+        agc = &s_sensor[i].agc;
+        st = &agc->stat;
+        xprintf("[%d] range:%d~%d (1/50C)\r\n", i, agc->map.lo, agc->map.lo + agc->map.span);
+        xprintf("    min:%d max:%d mean:%d hot:(%d,%d) over:%d/%d\r\n", st->min, st->max, st->mean,
+            st->hot_idx%32, st->hot_idx/32, st->over, st->num);
+    }
+}
+
+int mlx90642_disp_scale(int enable){
+    s_scale_enable = enable ? 1 : 0;
+    return 0;
+}
+
+void mlx90642_disp_scale_print(void){
+    xprintf("scale:%s x%d\r\n", s_scale_enable ? "bilinear" : "block", mlx90642_disp_cell());
+}
+
+int mlx90642_disp_median_set(int enable){
+    s_median_enable = enable ? 1 : 0;
+    return 0;
+}
+
+void mlx90642_disp_median_print(void){
+    xprintf("median:%s\r\n", s_median_enable ? "on" : "off");
+}
+
+int mlx90642_disp_band(int enable){
+    lcd_itf_sync_wait();
+    s_band_enable = enable ? 1 : 0;
+    /* 切换后整个传感器区域重画 */
+    for(int i=0; i<s_sensor_num; i++){
+        s_sensor[i].stale_drawn = 0;
+        s_sensor[i].cell_drawn = 0;
+    }
+    return 0;
+}
+
+void mlx90642_disp_band_print(void){
+    xprintf("render:%s\r\n", s_band_enable ? "sram band" : "sdram framebuffer");
+    lcd_itf_sync_print();
+}
+
+int mlx90642_disp_blob_overlay(int enable){
+    s_blob_overlay = enable ? 1 : 0;
+    return 0;
+}
+
+int mlx90642_disp_blob_alarm(int area){
+    if((area < 0) || (area > 32*24)){
+        return -1;
+    }
+    s_blob_alarm_area = (uint16_t)area;
+    return 0;
+}
+
+void mlx90642_disp_blob_print(void){
+    xprintf("overlay:%s th:%d (1/50C) alarm cnt:%d area:%d\r\n", s_blob_overlay ? "on" : "off", WARN_TH, WARN_CNT, s_blob_alarm_area);
+    mlx90642_blob_print();
+}
+
+int mlx90642_disp_heq(int enable){
+    s_heq_enable = enable ? 1 : 0;
+    for(int i=0; i<MLX90642_DISP_SENSOR_MAX; i++){
+        s_sensor[i].heq.valid = 0;
+        s_sensor[i].heq.pal = 0;
+    }
+    return 0;
+}
+
+void mlx90642_disp_heq_print(void){
+    const mlx90642_heq_st* heq;
+    const mlx90642_hist_st* hist;
+    xprintf("heq:%s\r\n", s_heq_enable ? "on" : "off");
+    for(int i=0; i<s_sensor_num; i++){
+        heq = &s_sensor[i].heq;
+        hist = &heq->hist;
+        xprintf("[%d] bin:%d+%d*n (1/50C) plateau:%d\r\n", i, hist->lo, 1 << hist->shift, HEQ_PLATEAU(hist->num));
+        xprintf("    pixels:%d moved:%d lut regen:%u\r\n", hist->num, hist->moved, heq->regen);
+    }
+}
+
+void mlx90642_disp_lat_print(void){
+    xprintf("mode:%s frames:%d\r\n", s_stream ? "stream" : "frame", s_lat.frames);
+    xprintf("latency last:%duS min:%duS max:%duS avg:%duS\r\n", s_lat.last_us, s_lat.min_us, s_lat.max_us,
+        (s_lat.frames > 0) ? s_lat.sum_us/s_lat.frames : 0);
+}
+
+/* 低速下读版本并写入配置, 调用者负责切换I2C速率 */
+static int mlx90642_sensor_init(uint8_t addr)
 {
     int status = 0; 
     uint8_t version[3];
-    MLX90642_Set_Delay(1000ul);  /* 1000~25K 10~1.4M */
 
-    status = MLX90642_GetFWver(SA_90642_DEFAULT,version);
+    status = MLX90642_GetFWver(addr,version);
     if(status < 0){
-        xprintf("GetFWver err %d\r\n",status);
+        xprintf("0x%02X GetFWver err %d\r\n",addr,status);
+        return status;
     }else{
-        xprintf("ver:%d.%d.%d\r\n",version[0],version[1],version[2]);
+        xprintf("0x%02X ver:%d.%d.%d\r\n",addr,version[0],version[1],version[2]);
     }
-    MLX90642_SetMeasMode(SA_90642_DEFAULT, MLX90642_STEP_MEAS_MODE); 
+    status = MLX90642_SetMeasMode(addr, MLX90642_STEP_MEAS_MODE); 
     if(status < 0){
         xprintf("SetMeasMode err %d\r\n",status);
     }
-    status = MLX90642_Init(SA_90642_DEFAULT);
+    status = MLX90642_Init(addr);
     if(status < 0){
         xprintf("MLX90642_Init err %d\r\n",status);
     }else{
         xprintf("MLX90642_Init ok\r\n");
     }
-    MLX90642_SetRefreshRate(SA_90642_DEFAULT, MLX90642_REF_RATE_2HZ); 
-    MLX90642_SetOutputFormat(SA_90642_DEFAULT, MLX90642_TEMPERATURE_OUTPUT); 
+    /* 先修改影子寄存器,提交时每个寄存器最多写一次 */
+    MLX90642_StageConfig(addr);
+    MLX90642_SetRefreshRate(addr, MLX90642_REF_RATE_2HZ); 
+    MLX90642_SetOutputFormat(addr, MLX90642_TEMPERATURE_OUTPUT); 
+
+    MLX90642_SetI2CLevel(addr, MLX90642_I2C_LEVEL_VDD);
+    MLX90642_SetSDALimitState(addr, MLX90642_I2C_SDA_CUR_LIMIT_OFF);
+    MLX90642_SetI2CMode(addr, MLX90642_I2C_MODE_FM_PLUS); 
+    status = MLX90642_CommitConfig(addr);
+    if(status < 0){
+        xprintf("CommitConfig err %d\r\n",status);
+    }
+    return status;
+}
+
+static int mlx90642_sensor_register(uint8_t addr)
+{
+    mlx90642_sensor_st* sensor;
+    for(int i=0; i<s_sensor_num; i++){
+        if(s_sensor[i].addr == addr){
+            return i;
+        }
+    }
+    if(s_sensor_num >= MLX90642_DISP_SENSOR_MAX){
+        return -1;
+    }
+    sensor = &s_sensor[s_sensor_num];
+    memset(sensor, 0, sizeof(*sensor));
+    sensor->addr = addr;
+    sensor->disp_idx = -1;
+    mlx90642_badpix_load(s_sensor_num, addr);
+    s_sensor_num++;
+    /* 排列变化,整屏重画 */
+    for(int i=0; i<s_sensor_num; i++){
+        s_sensor[i].stale_drawn = 0;
+        s_sensor[i].cell_drawn = 0;
+    }
+    lcd_itf_fill(0,LCD_HSIZE,0,LCD_VSIZE,0);
+    return s_sensor_num - 1;
+}
+
+int mlx90642_disp_add(uint8_t addr)
+{
+    int status;
+    int id;
+    /* 等待后台接收完成 */
+    while(MLX90642_GetImageAsyncPoll() > 0);
+    MLX90642_Set_ClockHz(25000ul);  /* 新传感器可能还不是FM+ */
+    status = mlx90642_sensor_init(addr);
+    MLX90642_Set_ClockHz(1000000ul);
+    if(status < 0){
+        return status;
+    }
+    id = mlx90642_sensor_register(addr);
+    if(id < 0){
+        return -1;
+    }
+    mlx90642_filter_reset(id);
+    return mlx90642_sched_init(addr);
+}
+
+int mlx90642_disp_init(void)
+{
+    int status = 0; 
+    MLX90642_Set_ClockHz(25000ul);  /* 切换FM+之前先用低速 */
+
+    for(int i=0; i<(int)sizeof(s_sensor_addr_default); i++){
+        status = mlx90642_sensor_init(s_sensor_addr_default[i]);
+        if(status < 0){
+            continue;
+        }
+        mlx90642_sensor_register(s_sensor_addr_default[i]);
+    }
+    MLX90642_Set_ClockHz(1000000ul);
 
-    MLX90642_SetI2CLevel(SA_90642_DEFAULT, MLX90642_I2C_LEVEL_VDD);
-    MLX90642_SetSDALimitState(SA_90642_DEFAULT, MLX90642_I2C_SDA_CUR_LIMIT_OFF);
-    MLX90642_SetI2CMode(SA_90642_DEFAULT, MLX90642_I2C_MODE_FM_PLUS); 
-    MLX90642_Set_Delay(20ul);
+    for(int i=0; i<s_sensor_num; i++){
+        status = mlx90642_sched_init(s_sensor[i].addr);
+        if(status < 0){
+            xprintf("0x%02X mlx90642_sched_init err %d\r\n",s_sensor[i].addr,status);
+        }
+    }
 
     /* 蜂鸣器驱动引脚, 低使能 */
     /**
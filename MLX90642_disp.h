@@ -6,10 +6,256 @@
 #endif
 
 #include <stdint.h>
+#include "MLX90642.h"
+
+/**
+ * 一帧统计
+ */
+typedef struct{
+    int16_t min;        /**< 最低温度,1/50℃        */
+    int16_t max;        /**< 最高温度,1/50℃        */
+    int16_t mean;       /**< 平均温度,1/50℃        */
+    uint16_t hot_idx;   /**< 最高温度点, y*32+x     */
+    uint16_t over;      /**< 不低于阈值的点数       */
+    uint16_t num;       /**< 参与统计的点数         */
+} mlx90642_stat_st;
+
+/**
+ * 自动增益映射: [lo,lo+span)对应灰度0~255
+ */
+typedef struct{
+    int16_t lo;         /**< 下限,1/50℃            */
+    uint16_t span;      /**< 范围,1/50℃            */
+    uint32_t scale;     /**< (255<<16)/span         */
+} mlx90642_agc_map_st;
+
+#define MLX90642_HIST_BINS 256
+
+/**
+ * 温度直方图, bin i对应[lo+(i<<shift), lo+((i+1)<<shift)), 两端的bin包括范围外的点
+ */
+typedef struct{
+    int32_t lo;         /**< bin0下限,1/50℃          */
+    uint8_t shift;      /**< bin宽度1<<shift          */
+    uint8_t rebuild;    /**< 1:下一次统计清零重建      */
+    uint16_t num;       /**< 直方图中的点数            */
+    uint16_t moved;     /**< 上一次统计中换了bin的点数  */
+    uint32_t rows;      /**< 重建时的有效行            */
+    uint16_t bin[MLX90642_HIST_BINS];   /**< 各bin点数 */
+    uint8_t idx[32*24]; /**< 每点当前所在的bin         */
+} mlx90642_hist_st;
 
 int mlx90642_disp_init(void);
 int mlx90642_disp(void);
 
+/**
+ * \fn mlx90642_frame_stat
+ * 一次遍历统计最小/最大/平均值, 最高温点和超过阈值的点数
+ * \param[in] temp 温度,1/50℃
+ * \param[in] rows 参与统计的行, bit0对应第0行
+ * \param[in] th 阈值,1/50℃
+ * \param[out] stat \ref mlx90642_stat_st
+*/
+void mlx90642_frame_stat(const int16_t* temp, uint32_t rows, int16_t th, mlx90642_stat_st* stat);
+
+/**
+ * \fn mlx90642_frame_stat_hist
+ * 同\ref mlx90642_frame_stat, 同一次遍历中增量更新直方图
+ * \param[in] temp 温度,1/50℃
+ * \param[in] rows 参与统计的行, bit0对应第0行
+ * \param[in] th 阈值,1/50℃
+ * \param[out] stat \ref mlx90642_stat_st
+ * \param[in,out] hist \ref mlx90642_hist_st, lo/shift由调用者设置, 改变时需置rebuild
+*/
+void mlx90642_frame_stat_hist(const int16_t* temp, uint32_t rows, int16_t th, mlx90642_stat_st* stat, mlx90642_hist_st* hist);
+
+/**
+ * \fn mlx90642_heq_map
+ * 平台直方图均衡, 计算bin->灰度的映射
+ * \param[in] hist \ref mlx90642_hist_st
+ * \param[in] plateau 每个bin最多计入的点数
+ * \param[out] gray MLX90642_HIST_BINS个灰度0~255
+*/
+void mlx90642_heq_map(const mlx90642_hist_st* hist, uint16_t plateau, uint8_t* gray);
+
+/**
+ * \fn temp2rgb
+ * 用当前调色板转换温度为RGB565, 每点一次查表
+ * \param[in] temp 温度,1/50℃
+ * \param[out] rgb RGB565
+ * \param[in] start end 转换的点[start,end)
+*/
+void temp2rgb(const int16_t* temp, uint16_t* rgb, int start, int end);
+
+/**
+ * \fn temp2rgb_ref
+ * 原来逐点除法的实现, 输出与classic调色板的temp2rgb相同, 用于对比测试
+ * \param[in] temp 温度,1/50℃
+ * \param[out] rgb RGB565
+ * \param[in] start end 转换的点[start,end)
+*/
+void temp2rgb_ref(const int16_t* temp, uint16_t* rgb, int start, int end);
+
+/**
+ * \fn temp2rgb_agc
+ * 按自动增益范围转换温度为RGB565, 每点一次查表
+ * \param[in] temp 温度,1/50℃
+ * \param[out] rgb RGB565
+ * \param[in] start end 转换的点[start,end)
+ * \param[in] map \ref mlx90642_agc_map_st
+*/
+void temp2rgb_agc(const int16_t* temp, uint16_t* rgb, int start, int end, const mlx90642_agc_map_st* map);
+
+/**
+ * \fn temp2rgb_heq
+ * 按直方图的bin划分转换温度为RGB565, 每点一次查表
+ * \param[in] temp 温度,1/50℃
+ * \param[out] rgb RGB565
+ * \param[in] start end 转换的点[start,end)
+ * \param[in] hist \ref mlx90642_hist_st, 只用lo/shift
+ * \param[in] lut MLX90642_HIST_BINS个RGB565
+*/
+void temp2rgb_heq(const int16_t* temp, uint16_t* rgb, int start, int end, const mlx90642_hist_st* hist, const uint16_t* lut);
+
+/**
+ * \fn mlx90642_disp_agc
+ * 开关自动增益, 关闭时按固定的-40~260℃显示
+ * \param[in] enable 1开 0关
+ * \retval 0 成功
+*/
+int mlx90642_disp_agc(int enable);
+
+/**
+ * \fn mlx90642_disp_agc_print
+ * 打印各传感器的自动增益范围和最近一帧统计
+*/
+void mlx90642_disp_agc_print(void);
+
+/**
+ * \fn mlx90642_disp_gray
+ * 按当前映射(直方图均衡/自动增益/固定范围)把温度转换为灰度, 用于放大前的插值
+ * \param[in] id 传感器, 直方图和自动增益范围每个传感器各自维护
+ * \param[in] temp 温度,1/50℃
+ * \param[out] gray 灰度0~255, Q4
+ * \param[in] start end 转换的点[start,end)
+*/
+void mlx90642_disp_gray(int id, const int16_t* temp, int16_t* gray, int start, int end);
+
+/**
+ * \fn mlx90642_disp_scale
+ * 切换显示方式: 双线性放大或每点填充色块
+ * \param[in] enable 1双线性 0色块
+ * \retval 0 成功
+*/
+int mlx90642_disp_scale(int enable);
+
+/**
+ * \fn mlx90642_disp_scale_print
+ * 打印显示方式和放大倍数
+*/
+void mlx90642_disp_scale_print(void);
+
+/**
+ * \fn mlx90642_disp_median_set
+ * 开关3x3中值滤波, 只影响显示, 统计和告警不变
+ * \param[in] enable 1开 0关
+ * \retval 0 成功
+*/
+int mlx90642_disp_median_set(int enable);
+
+/**
+ * \fn mlx90642_disp_median_print
+ * 打印中值滤波状态
+*/
+void mlx90642_disp_median_print(void);
+
+/**
+ * \fn mlx90642_disp_band
+ * 切换绘制方式: 内部SRAM行带直接发送, 或SDRAM显存(双缓存, 只发送修改的块)
+ * \param[in] enable 1行带 0显存
+ * \retval 0 成功
+*/
+int mlx90642_disp_band(int enable);
+
+/**
+ * \fn mlx90642_disp_band_print
+ * 打印绘制方式和刷新统计
+*/
+void mlx90642_disp_band_print(void);
+
+/**
+ * \fn mlx90642_disp_blob_overlay
+ * 开关热点外接框叠加显示(整帧模式), 热点检测和告警不受影响
+ * \param[in] enable 1开 0关
+ * \retval 0 成功
+*/
+int mlx90642_disp_blob_overlay(int enable);
+
+/**
+ * \fn mlx90642_disp_blob_alarm
+ * 设置告警的附加条件: 超过告警温度的点数达到后, 还要求最大热点的点数不少于area,
+ * 用于不让零散的噪声点告警
+ * \param[in] area 0~768, 0不检查热点(默认)
+ * \retval 0 成功
+ * \retval -1 参数错误
+*/
+int mlx90642_disp_blob_alarm(int area);
+
+/**
+ * \fn mlx90642_disp_blob_print
+ * 打印叠加显示状态和各传感器的热点
+*/
+void mlx90642_disp_blob_print(void);
+
+/**
+ * \fn mlx90642_disp_heq
+ * 开关平台直方图均衡, 开启时优先于自动增益
+ * \param[in] enable 1开 0关
+ * \retval 0 成功
+*/
+int mlx90642_disp_heq(int enable);
+
+/**
+ * \fn mlx90642_disp_heq_print
+ * 打印各传感器的bin划分, 平台值和LUT生成次数
+*/
+void mlx90642_disp_heq_print(void);
+
+/**
+ * \fn mlx90642_disp_add
+ * 初始化并注册一个传感器, 最多4个, 多个传感器横向排列显示
+ * 传感器需已用MLX90642_SetI2CSlaveAddress设置为不同的地址
+ * \param[in] addr 7位从机地址
+ * \retval 0 成功
+ * \retval <0 失败
+*/
+int mlx90642_disp_add(uint8_t addr);
+
+/**
+ * \fn mlx90642_disp_roi
+ * 设置只读取的行带, 其余行显示为过期且不参与告警
+ * \param[in] bands 行带
+ * \param[in] num 行带数,0恢复读整帧
+ * \retval 0 成功
+ * \retval -1 参数错误
+*/
+int mlx90642_disp_roi(const MLX90642_RowBand_t* bands, int num);
+
+/**
+ * \fn mlx90642_disp_set_stream
+ * 切换流模式, 流模式下按测量进度逐行读取并显示, 不使用ROI
+ * 同时清除延迟统计
+ * \param[in] enable 1流模式 0整帧模式
+ * \retval 0 成功
+*/
+int mlx90642_disp_set_stream(int enable);
+
+/**
+ * \fn mlx90642_disp_lat_print
+ * 打印从读窗口打开到最后一个点显示完的延迟统计
+*/
+void mlx90642_disp_lat_print(void);
+
 #ifdef __cplusplus
     }
 #endif
@@ -0,0 +1,220 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "MLX90642_filter.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "cmsis_compiler.h"
+
+/* 两个有符号16位同时比较: SSUB16置GE标志, SEL按标志选择 */
+static inline uint32_t med_max2(uint32_t a, uint32_t b){
+    __SSUB16(a, b);
+    return __SEL(a, b);
+}
+static inline uint32_t med_min2(uint32_t a, uint32_t b){
+    __SSUB16(a, b);
+    return __SEL(b, a);
+}
+
+#else
+
+static inline uint32_t med_max2(uint32_t a, uint32_t b){
+    uint32_t lo = ((int16_t)a > (int16_t)b) ? (a & 0xFFFFu) : (b & 0xFFFFu);
+    uint32_t hi = ((int16_t)(a >> 16) > (int16_t)(b >> 16)) ? (a & 0xFFFF0000u) : (b & 0xFFFF0000u);
+    return lo | hi;
+}
+static inline uint32_t med_min2(uint32_t a, uint32_t b){
+    uint32_t lo = ((int16_t)a < (int16_t)b) ? (a & 0xFFFFu) : (b & 0xFFFFu);
+    uint32_t hi = ((int16_t)(a >> 16) < (int16_t)(b >> 16)) ? (a & 0xFFFF0000u) : (b & 0xFFFF0000u);
+    return lo | hi;
+}
+
+#endif
+
+#define MLX90642_FILTER_SHIFT_MAX 6
+
+#define MLX90642_CCM __attribute__((section(".ccm")))
+
+/* 每点状态 温度<<MLX90642_FILTER_Q, 只有CPU访问, 放CCM不占SRAM1也不和DMA争总线 */
+static int32_t s_filter_state[MLX90642_FILTER_MAX][32*24] MLX90642_CCM;
+
+/* 每个传感器已有状态的行, 没有状态的行直接取输入 */
+static uint32_t s_filter_rows[MLX90642_FILTER_MAX];
+
+static mlx90642_filter_stat_st s_filter_stat = {
+    .shift = 0,
+    .slew = 2*50,
+};
+
+int mlx90642_filter_config(uint8_t shift, uint16_t slew){
+    if(shift > MLX90642_FILTER_SHIFT_MAX){
+        return -1;
+    }
+    s_filter_stat.shift = shift;
+    s_filter_stat.slew = slew;
+    s_filter_stat.frames = 0;
+    s_filter_stat.resets = 0;
+    memset(s_filter_rows, 0, sizeof(s_filter_rows));
+    return 0;
+}
+
+void mlx90642_filter_reset(int id){
+    if((id >= 0) && (id < MLX90642_FILTER_MAX)){
+        s_filter_rows[id] = 0;
+    }
+}
+
+void mlx90642_filter_run(int id, int16_t* temp, uint32_t rows){
+    int shift = s_filter_stat.shift;
+    int32_t slew = (int32_t)s_filter_stat.slew << MLX90642_FILTER_Q;
+    int32_t* s;
+    int16_t* p;
+    int32_t in;
+    int32_t d;
+    uint32_t resets = 0;
+    if((shift == 0) || (id < 0) || (id >= MLX90642_FILTER_MAX)){
+        return;
+    }
+    for(int y=0; y<24; y++){
+        if((rows & (1ul<<y)) == 0){
+            continue;
+        }
+        s = s_filter_state[id] + y*32;
+        p = temp + y*32;
+        if((s_filter_rows[id] & (1ul<<y)) == 0){
+            for(int x=0; x<32; x++){
+                s[x] = (int32_t)p[x] << MLX90642_FILTER_Q;
+            }
+            continue;
+        }
+        for(int x=0; x<32; x++){
+            in = (int32_t)p[x] << MLX90642_FILTER_Q;
+            d = in - s[x];
+            if((d > slew) || (d < -slew)){
+                s[x] = in;
+                resets++;
+                continue;
+            }
+            s[x] += d >> shift;
+            p[x] = (int16_t)((s[x] + (1 << (MLX90642_FILTER_Q - 1))) >> MLX90642_FILTER_Q);
+        }
+    }
+    s_filter_rows[id] |= rows;
+    s_filter_stat.resets += resets;
+    s_filter_stat.frames++;
+}
+
+const mlx90642_filter_stat_st* mlx90642_filter_stat(void){
+    return &s_filter_stat;
+}
+
+/* 三个数的中值 */
+static inline uint32_t med_med3(uint32_t a, uint32_t b, uint32_t c){
+    return med_max2(med_min2(a, b), med_min2(med_max2(a, b), c));
+}
+
+/* (a的高16位, b的低16位), 即相邻两个字中间的两列 */
+#define MED_MID(a,b) (((a) >> 16) | ((b) << 16))
+
+void mlx90642_median_run(const int16_t* in, int16_t* out, uint32_t rows){
+    /* 每列排序后的最小/中/最大, 字1~16为第0~31列, 字0的高16位和字17的低16位为两端复制的列 */
+    uint32_t lo32[18];
+    uint32_t mid32[18];
+    uint32_t hi32[18];
+    const uint32_t* a;
+    const uint32_t* b;
+    const uint32_t* c;
+    uint32_t* d;
+    uint32_t x;
+    uint32_t y;
+    uint32_t z;
+    uint32_t t;
+    int ya;
+    int yc;
+    for(int r=0; r<24; r++){
+        if((rows & (1ul<<r)) == 0){
+            memcpy(out + r*32, in + r*32, 32*2);
+            continue;
+        }
+        ya = ((r > 0) && (rows & (1ul<<(r-1)))) ? r-1 : r;
+        yc = ((r < 23) && (rows & (1ul<<(r+1)))) ? r+1 : r;
+        a = (const uint32_t*)(in + ya*32);
+        b = (const uint32_t*)(in + r*32);
+        c = (const uint32_t*)(in + yc*32);
+        /* 列排序, 每次两列 */
+        for(int k=0; k<16; k++){
+            x = a[k];
+            y = b[k];
+            z = c[k];
+            t = med_min2(x, y);
+            y = med_max2(x, y);
+            x = t;
+            t = med_min2(y, z);
+            z = med_max2(y, z);
+            y = t;
+            t = med_min2(x, y);
+            y = med_max2(x, y);
+            x = t;
+            lo32[k+1] = x;
+            mid32[k+1] = y;
+            hi32[k+1] = z;
+        }
+        /* 两端复制: 第-1列=第0列, 第32列=第31列 */
+        lo32[0] = lo32[1] << 16;
+        mid32[0] = mid32[1] << 16;
+        hi32[0] = hi32[1] << 16;
+        lo32[17] = lo32[16] >> 16;
+        mid32[17] = mid32[16] >> 16;
+        hi32[17] = hi32[16] >> 16;
+        /* 每次两个点: 左/中/右三列分别为(2j-1,2j) (2j,2j+1) (2j+1,2j+2) */
+        d = (uint32_t*)(out + r*32);
+        for(int j=0; j<16; j++){
+            x = med_max2(med_max2(MED_MID(lo32[j], lo32[j+1]), lo32[j+1]), MED_MID(lo32[j+1], lo32[j+2]));
+            y = med_med3(MED_MID(mid32[j], mid32[j+1]), mid32[j+1], MED_MID(mid32[j+1], mid32[j+2]));
+            z = med_min2(med_min2(MED_MID(hi32[j], hi32[j+1]), hi32[j+1]), MED_MID(hi32[j+1], hi32[j+2]));
+            d[j] = med_med3(x, y, z);
+        }
+    }
+}
+
+void mlx90642_median_ref(const int16_t* in, int16_t* out, uint32_t rows){
+    int16_t v[9];
+    int16_t t;
+    int n;
+    int yy;
+    int xx;
+    for(int r=0; r<24; r++){
+        if((rows & (1ul<<r)) == 0){
+            memcpy(out + r*32, in + r*32, 32*2);
+            continue;
+        }
+        for(int x=0; x<32; x++){
+            n = 0;
+            for(int dy=-1; dy<=1; dy++){
+                yy = r + dy;
+                if((yy < 0) || (yy > 23) || ((rows & (1ul<<yy)) == 0)){
+                    yy = r;
+                }
+                for(int dx=-1; dx<=1; dx++){
+                    xx = x + dx;
+                    if(xx < 0){
+                        xx = 0;
+                    }else if(xx > 31){
+                        xx = 31;
+                    }
+                    v[n++] = in[yy*32 + xx];
+                }
+            }
+            for(int i=1; i<9; i++){
+                t = v[i];
+                int j = i;
+                while((j > 0) && (v[j-1] > t)){
+                    v[j] = v[j-1];
+                    j--;
+                }
+                v[j] = t;
+            }
+            out[r*32 + x] = v[4];
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef MLX90642_FILTER_H
+#define MLX90642_FILTER_H
+
+#ifdef __cplusplus
+    extern "C"{
+#endif
+
+#include <stdint.h>
+
+/**
+ * 逐点时域滤波(定点一阶IIR), 抑制帧间噪声引起的画面闪烁和告警抖动
+ * s += (t - s) >> shift, |t - s|超过slew时直接取t, 真实的温度突变不被拖尾
+ * 状态放在CCM
+ *
+ * 3x3中值滤波(空域), 先对每列3点排序, 再取 max(各列最小), med(各列中值), min(各列最大) 三者的中值,
+ * 相邻列共享排序结果, 每次处理两个点(M4上用SSUB16/SEL一条指令对做两个16位比较).
+ * 只用于显示: 统计和告警仍使用中值滤波前的数据, 1~2个点的热源不会被滤掉.
+ */
+
+#define MLX90642_FILTER_MAX     4     /* 最多4个传感器 */
+#define MLX90642_FILTER_Q       8     /* 状态小数位 */
+
+/**
+ * 滤波统计
+ */
+typedef struct{
+    uint8_t shift;          /**< 系数1/(1<<shift), 0不滤波      */
+    uint16_t slew;          /**< 突变阈值,1/50℃                 */
+    uint32_t frames;        /**< 已滤波的帧(行带)数              */
+    uint32_t resets;        /**< 因突变直接取输入的点数          */
+} mlx90642_filter_stat_st;
+
+/**
+ * \fn mlx90642_filter_config
+ * 设置滤波参数, 清除所有状态
+ * \param[in] shift 系数1/(1<<shift), 0关闭, 最大6
+ * \param[in] slew 突变阈值,1/50℃
+ * \retval 0 成功
+ * \retval -1 参数错误
+*/
+int mlx90642_filter_config(uint8_t shift, uint16_t slew);
+
+/**
+ * \fn mlx90642_filter_reset
+ * 清除一个传感器的状态, 下一帧直接取输入
+ * \param[in] id 传感器 0~MLX90642_FILTER_MAX-1
+*/
+void mlx90642_filter_reset(int id);
+
+/**
+ * \fn mlx90642_filter_run
+ * 原地滤波, 只处理rows中的行
+ * \param[in] id 传感器 0~MLX90642_FILTER_MAX-1
+ * \param[in,out] temp 温度,1/50℃
+ * \param[in] rows 有效行, bit0对应第0行
+*/
+void mlx90642_filter_run(int id, int16_t* temp, uint32_t rows);
+
+/**
+ * \fn mlx90642_filter_stat
+ * 获取滤波参数和统计
+ * \return \ref mlx90642_filter_stat_st
+*/
+const mlx90642_filter_stat_st* mlx90642_filter_stat(void);
+
+/**
+ * \fn mlx90642_median_run
+ * 3x3中值滤波, 过期的行不参与(用中心行代替), 图像边缘复制
+ * \param[in] in 温度,1/50℃, 需4字节对齐
+ * \param[out] out 结果, 需4字节对齐, 不在rows中的行原样复制
+ * \param[in] rows 有效行, bit0对应第0行
+*/
+void mlx90642_median_run(const int16_t* in, int16_t* out, uint32_t rows);
+
+/**
+ * \fn mlx90642_median_ref
+ * 每点9个值插入排序取中值, 与mlx90642_median_run结果相同, 用于对比
+ * \param[in] in 温度,1/50℃
+ * \param[out] out 结果
+ * \param[in] rows 有效行, bit0对应第0行
+*/
+void mlx90642_median_ref(const int16_t* in, int16_t* out, uint32_t rows);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
@@ -0,0 +1,158 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "MLX90642_palette.h"
+#include "xprintf.h"
+
+/**
+ * 调色板在编译期生成: 每项都是常量表达式, __builtin_pow的参数为常量时由gcc折叠,
+ * 不链接libm, 运行时不计算
+ */
+
+/**
+ * 本机字节序的RGB565, 像素数据按16位帧发送
+ * D15~D11  D10~D5  D4~D0
+ * R       |  G    |  B
+ */
+#define PAL_RGB(r,g,b) ((uint16_t)((((uint16_t)(r)&0xF8)<<8) | (((uint16_t)(g)&0xFC)<<3) | ((uint16_t)(b)>>3)))
+
+/* 原来显示用的RGB()宏, classic调色板用它以保持和原来完全相同的颜色 */
+#define PAL_RGB_CLASSIC(r,g,b) ((uint16_t)(((((uint16_t)(r)&0xF8) | ((uint16_t)(g)>>5))<<8) | ((uint16_t)(g)&0xE0) | ((uint16_t)(b)&0x1F)))
+
+/* 灰度i(0~255)归一化后做gamma */
+#define PAL_X(i,gamma) __builtin_pow((i)/255.0, (gamma))
+
+#define PAL_LERP(x,x0,x1,c0,c1) ((c0) + ((c1)-(c0))*((x)-(x0))/((x1)-(x0)))
+
+/* 7个色标(位置,分量)分段线性插值 */
+#define PAL_SEG(x,x0,c0,x1,c1,x2,c2,x3,c3,x4,c4,x5,c5,x6,c6) \
+    ((x)<=(x1) ? PAL_LERP(x,x0,x1,c0,c1) : \
+     (x)<=(x2) ? PAL_LERP(x,x1,x2,c1,c2) : \
+     (x)<=(x3) ? PAL_LERP(x,x2,x3,c2,c3) : \
+     (x)<=(x4) ? PAL_LERP(x,x3,x4,c3,c4) : \
+     (x)<=(x5) ? PAL_LERP(x,x4,x5,c4,c5) : \
+                 PAL_LERP(x,x5,x6,c5,c6))
+
+#define PAL_CH(x, ...) ((uint8_t)(PAL_SEG(x, __VA_ARGS__) + 0.5))
+
+#define PAL_E(P,i) PAL_RGB(PAL_CH(PAL_X(i,P##_GAMMA), P##_R), \
+                           PAL_CH(PAL_X(i,P##_GAMMA), P##_G), \
+                           PAL_CH(PAL_X(i,P##_GAMMA), P##_B))
+
+#define PAL_4(f,i)   f((i)), f((i)+1), f((i)+2), f((i)+3)
+#define PAL_16(f,i)  PAL_4(f,(i)), PAL_4(f,(i)+4), PAL_4(f,(i)+8), PAL_4(f,(i)+12)
+#define PAL_64(f,i)  PAL_16(f,(i)), PAL_16(f,(i)+16), PAL_16(f,(i)+32), PAL_16(f,(i)+48)
+#define PAL_256(f)   PAL_64(f,0), PAL_64(f,64), PAL_64(f,128), PAL_64(f,192)
+
+#define PAL_GAMMA_X100(g) ((uint16_t)((g)*100 + 0.5))
+
+/**
+ * classic: 原来temp2rgb的四段渐变(蓝-青-绿-黄-红), 包括分量计算时的uint8回绕
+ */
+#define CLASSIC_GAMMA 1.0
+#define CLASSIC_R(i) ((uint8_t)(((i)<=95) ? 0 : ((i)<=159) ? (((i)-128)*255)/64 : 255))
+#define CLASSIC_G(i) ((uint8_t)(((i)<=31) ? 0 : ((i)<=95) ? (((i)-64)*255)/64 : ((i)<=159) ? 255 : ((255-(i))*255)/64))
+#define CLASSIC_B(i) ((uint8_t)(((i)<=31) ? ((i)*255)/64 : ((i)<=95) ? ((127-(i))*255)/64 : 0))
+#define CLASSIC_E(i) PAL_RGB_CLASSIC(CLASSIC_R(i), CLASSIC_G(i), CLASSIC_B(i))
+
+/* ironbow: 黑-靛-紫红-橙-黄-白 */
+#define IRONBOW_GAMMA 1.0
+#define IRONBOW_R 0.0,0,  0.15,30,  0.35,140, 0.55,220, 0.75,250, 0.9,255, 1.0,255
+#define IRONBOW_G 0.0,0,  0.15,0,   0.35,0,   0.55,60,  0.75,150, 0.9,220, 1.0,255
+#define IRONBOW_B 0.0,0,  0.15,120, 0.35,160, 0.55,60,  0.75,0,   0.9,40,  1.0,255
+#define IRONBOW_E(i) PAL_E(IRONBOW, i)
+
+/* rainbow: 深蓝-蓝-青-绿-黄-红-白 */
+#define RAINBOW_GAMMA 1.0
+#define RAINBOW_R 0.0,0,   0.167,0,   0.333,0,   0.5,0,   0.667,255, 0.833,255, 1.0,255
+#define RAINBOW_G 0.0,0,   0.167,0,   0.333,255, 0.5,255, 0.667,255, 0.833,0,   1.0,255
+#define RAINBOW_B 0.0,96,  0.167,255, 0.333,255, 0.5,0,   0.667,0,   0.833,0,   1.0,255
+#define RAINBOW_E(i) PAL_E(RAINBOW, i)
+
+/* grey: 黑-白, gamma<1提亮暗部 */
+#define GREY_GAMMA 0.45
+#define GREY_C    0.0,0,   0.2,51,    0.4,102,   0.5,127.5, 0.6,153, 0.8,204, 1.0,255
+#define GREY_R    GREY_C
+#define GREY_G    GREY_C
+#define GREY_B    GREY_C
+#define GREY_E(i) PAL_E(GREY, i)
+
+/* hot-metal: 黑-暗红-红-橙-黄-白, gamma>1压暗背景突出热源 */
+#define HOTMETAL_GAMMA 1.5
+#define HOTMETAL_R 0.0,0,  0.2,100, 0.4,200, 0.55,255, 0.7,255, 0.85,255, 1.0,255
+#define HOTMETAL_G 0.0,0,  0.2,0,   0.4,20,  0.55,90,  0.7,170, 0.85,230, 1.0,255
+#define HOTMETAL_B 0.0,0,  0.2,0,   0.4,0,   0.55,0,   0.7,20,  0.85,120, 1.0,255
+#define HOTMETAL_E(i) PAL_E(HOTMETAL, i)
+
+/* high-contrast: 相邻色标亮度交替, 等温线明显 */
+#define HIGHCONTRAST_GAMMA 0.8
+#define HIGHCONTRAST_R 0.0,0, 0.167,0,   0.333,0,   0.5,255, 0.667,255, 0.833,255, 1.0,255
+#define HIGHCONTRAST_G 0.0,0, 0.167,0,   0.333,255, 0.5,255, 0.667,255, 0.833,0,   1.0,0
+#define HIGHCONTRAST_B 0.0,0, 0.167,255, 0.333,0,   0.5,255, 0.667,0,   0.833,0,   1.0,255
+#define HIGHCONTRAST_E(i) PAL_E(HIGHCONTRAST, i)
+
+static const uint16_t s_pal_classic[MLX90642_PALETTE_SIZE] = { PAL_256(CLASSIC_E) };
+static const uint16_t s_pal_ironbow[MLX90642_PALETTE_SIZE] = { PAL_256(IRONBOW_E) };
+static const uint16_t s_pal_rainbow[MLX90642_PALETTE_SIZE] = { PAL_256(RAINBOW_E) };
+static const uint16_t s_pal_grey[MLX90642_PALETTE_SIZE] = { PAL_256(GREY_E) };
+static const uint16_t s_pal_hotmetal[MLX90642_PALETTE_SIZE] = { PAL_256(HOTMETAL_E) };
+static const uint16_t s_pal_highcontrast[MLX90642_PALETTE_SIZE] = { PAL_256(HIGHCONTRAST_E) };
+
+static const mlx90642_palette_st s_palette[] =
+{
+    {"classic",      PAL_GAMMA_X100(CLASSIC_GAMMA),      s_pal_classic},
+    {"ironbow",      PAL_GAMMA_X100(IRONBOW_GAMMA),      s_pal_ironbow},
+    {"rainbow",      PAL_GAMMA_X100(RAINBOW_GAMMA),      s_pal_rainbow},
+    {"grey",         PAL_GAMMA_X100(GREY_GAMMA),         s_pal_grey},
+    {"hotmetal",     PAL_GAMMA_X100(HOTMETAL_GAMMA),     s_pal_hotmetal},
+    {"highcontrast", PAL_GAMMA_X100(HIGHCONTRAST_GAMMA), s_pal_highcontrast},
+};
+
+#define PAL_NUM ((int)(sizeof(s_palette)/sizeof(s_palette[0])))
+
+static const uint16_t* volatile s_palette_lut = s_pal_classic;
+static int s_palette_id = 0;
+
+const uint16_t* mlx90642_palette_lut(void){
+    return s_palette_lut;
+}
+
+int mlx90642_palette_set(int id){
+    if((id < 0) || (id >= PAL_NUM)){
+        return -1;
+    }
+    s_palette_id = id;
+    s_palette_lut = s_palette[id].lut;
+    return 0;
+}
+
+int mlx90642_palette_id(void){
+    return s_palette_id;
+}
+
+int mlx90642_palette_find(const char* name){
+    for(int i=0; i<PAL_NUM; i++){
+        if(strncmp(name, s_palette[i].name, strlen(s_palette[i].name)+1) == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+
+int mlx90642_palette_num(void){
+    return PAL_NUM;
+}
+
+const mlx90642_palette_st* mlx90642_palette_get(int id){
+    if((id < 0) || (id >= PAL_NUM)){
+        return 0;
+    }
+    return &s_palette[id];
+}
+
+void mlx90642_palette_print(void){
+    for(int i=0; i<PAL_NUM; i++){
+        xprintf("%c%d %-12s gamma %d.%02d\r\n", (i == s_palette_id) ? '*' : ' ', i, s_palette[i].name,
+            s_palette[i].gamma_x100/100, s_palette[i].gamma_x100%100);
+    }
+}
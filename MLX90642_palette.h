@@ -0,0 +1,75 @@
+#ifndef MLX90642_PALETTE_H
+#define MLX90642_PALETTE_H
+
+#ifdef __cplusplus
+    extern "C"{
+#endif
+
+#include <stdint.h>
+
+#define MLX90642_PALETTE_SIZE 256   /* 每个调色板的颜色数, 按灰度0~255索引 */
+
+/**
+ * 调色板, 表在编译期生成并存放在flash
+ */
+typedef struct{
+    const char* name;       /**< 名称                        */
+    uint16_t gamma_x100;    /**< 灰度先做x^gamma再查颜色, 乘100 */
+    const uint16_t* lut;    /**< 256个RGB565                   */
+} mlx90642_palette_st;
+
+/**
+ * \fn mlx90642_palette_lut
+ * 当前调色板, 显示时每个点直接用灰度索引
+ * \return 256个RGB565
+*/
+const uint16_t* mlx90642_palette_lut(void);
+
+/**
+ * \fn mlx90642_palette_set
+ * 切换调色板, 只替换指针, 下一次转换生效
+ * \param[in] id 0~mlx90642_palette_num()-1
+ * \retval 0 成功
+ * \retval -1 参数错误
+*/
+int mlx90642_palette_set(int id);
+
+/**
+ * \fn mlx90642_palette_id
+ * \return 当前调色板编号
+*/
+int mlx90642_palette_id(void);
+
+/**
+ * \fn mlx90642_palette_find
+ * 按名称查找调色板
+ * \param[in] name 名称
+ * \retval >=0 调色板编号
+ * \retval -1 没有该调色板
+*/
+int mlx90642_palette_find(const char* name);
+
+/**
+ * \fn mlx90642_palette_num
+ * \return 调色板个数
+*/
+int mlx90642_palette_num(void);
+
+/**
+ * \fn mlx90642_palette_get
+ * \param[in] id 0~mlx90642_palette_num()-1
+ * \return \ref mlx90642_palette_st, id错误时返回0
+*/
+const mlx90642_palette_st* mlx90642_palette_get(int id);
+
+/**
+ * \fn mlx90642_palette_print
+ * 打印调色板列表, *为当前使用的
+*/
+void mlx90642_palette_print(void);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+#include <stdint.h>
+
+#include "MLX90642_scale.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "cmsis_compiler.h"
+
+/* a[15:0] | b[15:0]<<16 */
+#define SCALE_PACK_LO(a,b)      __PKHBT((a), (b), 16)
+/* a[31:16] | b[31:16]<<16 */
+#define SCALE_PACK_HI(a,b)      __PKHTB((b), (a), 16)
+/* acc + p.lo*w.lo + p.hi*w.hi, 有符号16位 */
+#define SCALE_DOT(p,w,acc)      ((int32_t)__SMLAD((p), (w), (uint32_t)(acc)))
+
+#else
+
+#define SCALE_PACK_LO(a,b)      (((uint32_t)(a) & 0xFFFFu) | ((uint32_t)(b) << 16))
+#define SCALE_PACK_HI(a,b)      (((uint32_t)(a) >> 16) | ((uint32_t)(b) & 0xFFFF0000u))
+
+static inline int32_t scale_dot(uint32_t p, uint32_t w, int32_t acc){
+    return acc + (int32_t)(int16_t)p*(int16_t)w + (int32_t)(int16_t)(p >> 16)*(int16_t)(w >> 16);
+}
+#define SCALE_DOT(p,w,acc)      scale_dot((p), (w), (acc))
+
+#endif
+
+/**
+ * 一个方向的参数: 输出像素i的中心在源网格上的位置p(Q8),
+ * 取源像素idx和idx+1, 权重(256-w, w), 两端超出的部分复制边缘像素
+ */
+static void scale_axis(uint8_t* idx, uint32_t* wpair, int n, int k){
+    int32_t p;
+    int32_t w;
+    for(int i=0; i<n*k; i++){
+        p = ((2*i + 1)*256)/(2*k) - 128;
+        if(p < 0){
+            p = 0;
+        }
+        if(p >= (n - 1)*256){
+            idx[i] = (uint8_t)(n - 2);
+            w = 256;
+        }else{
+            idx[i] = (uint8_t)(p >> 8);
+            w = p & 0xFF;
+        }
+        wpair[i] = ((uint32_t)w << 16) | (uint32_t)(256 - w);
+    }
+}
+
+int mlx90642_scale_init(mlx90642_scale_st* scale, int k){
+    if((k < 2) || (k > MLX90642_SCALE_MAX)){
+        return -1;
+    }
+    scale->k = (uint8_t)k;
+    scale->w = (uint16_t)(MLX90642_SCALE_SRC_W*k);
+    scale->h = (uint16_t)(MLX90642_SCALE_SRC_H*k);
+    scale_axis(scale->col, scale->colw, MLX90642_SCALE_SRC_W, k);
+    scale_axis(scale->row, scale->roww, MLX90642_SCALE_SRC_H, k);
+    return 0;
+}
+
+/* 纵向: 每列一次SMLAD, (row0[c],row1[c])点乘(256-w,w), pair[c]为(c,c+1)列 */
+static void scale_vert(const int16_t* row0, const int16_t* row1, uint32_t wpair, uint32_t* pair)
+{
+    const uint32_t* a = (const uint32_t*)row0;    /* 每次取相邻两列 */
+    const uint32_t* b = (const uint32_t*)row1;
+    int16_t v[MLX90642_SCALE_SRC_W];
+    uint32_t x;
+    uint32_t y;
+
+    for(int c=0; c<MLX90642_SCALE_SRC_W/2; c++){
+        x = a[c];
+        y = b[c];
+        v[2*c] = (int16_t)(SCALE_DOT(SCALE_PACK_LO(x, y), wpair, 1 << 7) >> 8);
+        v[2*c+1] = (int16_t)(SCALE_DOT(SCALE_PACK_HI(x, y), wpair, 1 << 7) >> 8);
+    }
+    for(int c=0; c<MLX90642_SCALE_SRC_W-1; c++){
+        pair[c] = SCALE_PACK_LO((uint16_t)v[c], (uint16_t)v[c+1]);
+    }
+}
+
+/* 横向: 每点一次SMLAD, 去掉Q8权重和Q4小数后即为调色板索引 */
+#define SCALE_IDX(i)    (SCALE_DOT(pair[col[(i)]], colw[(i)], 1 << (7 + MLX90642_SCALE_Q)) >> (8 + MLX90642_SCALE_Q))
+
+void mlx90642_scale_line(const mlx90642_scale_st* scale, const int16_t* row0, const int16_t* row1,
+    uint32_t wpair, const uint16_t* lut, uint32_t* dst)
+{
+    const uint8_t* col = scale->col;
+    const uint32_t* colw = scale->colw;
+    uint32_t pair[MLX90642_SCALE_SRC_W];
+    int32_t i0;
+    int32_t i1;
+    int w = scale->w;
+
+    scale_vert(row0, row1, wpair, pair);
+    for(int i=0; i<w; i+=2){
+        i0 = SCALE_IDX(i);
+        i1 = SCALE_IDX(i+1);
+        *dst++ = (uint32_t)lut[i0] | ((uint32_t)lut[i1] << 16);
+    }
+}
+
+void mlx90642_scale_line_l8(const mlx90642_scale_st* scale, const int16_t* row0, const int16_t* row1,
+    uint32_t wpair, uint32_t* dst)
+{
+    const uint8_t* col = scale->col;
+    const uint32_t* colw = scale->colw;
+    uint32_t pair[MLX90642_SCALE_SRC_W];
+    int w = scale->w;
+
+    scale_vert(row0, row1, wpair, pair);
+    for(int i=0; i<w; i+=4){
+        *dst++ = (uint32_t)SCALE_IDX(i) | ((uint32_t)SCALE_IDX(i+1) << 8)
+               | ((uint32_t)SCALE_IDX(i+2) << 16) | ((uint32_t)SCALE_IDX(i+3) << 24);
+    }
+}
+
+void mlx90642_scale_fill(uint32_t* dst, int w, uint16_t rgb){
+    uint32_t v = (uint32_t)rgb | ((uint32_t)rgb << 16);
+    for(int i=0; i<w; i+=2){
+        *dst++ = v;
+    }
+}
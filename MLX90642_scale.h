@@ -0,0 +1,83 @@
+#ifndef MLX90642_SCALE_H
+#define MLX90642_SCALE_H
+
+#ifdef __cplusplus
+    extern "C"{
+#endif
+
+#include <stdint.h>
+
+/**
+ * 32x24网格定点双线性放大
+ * 源网格为int16(显示时为Q4灰度), 权重Q8, Cortex-M4上用SMLAD一次算两个乘加,
+ * 其他平台(主机)用等价的C实现, 结果逐位相同.
+ * 输出按像素对(2个RGB565)32位写入显存.
+ */
+
+#define MLX90642_SCALE_SRC_W   32
+#define MLX90642_SCALE_SRC_H   24
+#define MLX90642_SCALE_MAX     10   /* 最大放大倍数, 32*10=320 */
+#define MLX90642_SCALE_Q       4    /* 源网格的小数位 */
+
+/**
+ * 放大参数, 按倍数预先计算每个输出行/列对应的源行/列和权重
+ */
+typedef struct{
+    uint8_t k;              /**< 放大倍数                        */
+    uint16_t w;             /**< 输出宽度 32*k                   */
+    uint16_t h;             /**< 输出高度 24*k                   */
+    uint8_t col[MLX90642_SCALE_SRC_W*MLX90642_SCALE_MAX];      /**< 输出列左侧的源列   */
+    uint32_t colw[MLX90642_SCALE_SRC_W*MLX90642_SCALE_MAX];    /**< (w<<16)|(256-w)    */
+    uint8_t row[MLX90642_SCALE_SRC_H*MLX90642_SCALE_MAX];      /**< 输出行上方的源行   */
+    uint32_t roww[MLX90642_SCALE_SRC_H*MLX90642_SCALE_MAX];    /**< (w<<16)|(256-w)    */
+} mlx90642_scale_st;
+
+/**
+ * \fn mlx90642_scale_init
+ * 计算放大参数, 输出像素中心对齐源像素中心, 边缘复制
+ * \param[out] scale \ref mlx90642_scale_st
+ * \param[in] k 放大倍数 2~MLX90642_SCALE_MAX
+ * \retval 0 成功
+ * \retval -1 参数错误
+*/
+int mlx90642_scale_init(mlx90642_scale_st* scale, int k);
+
+/**
+ * \fn mlx90642_scale_line
+ * 插值输出一行: 先在row0/row1之间纵向插值32个点, 再横向插值w个点, 查表后成对写入
+ * \param[in] scale \ref mlx90642_scale_st
+ * \param[in] row0 上方源行, 32个Q4灰度, 需4字节对齐
+ * \param[in] row1 下方源行, 32个Q4灰度, 需4字节对齐
+ * \param[in] wpair 纵向权重 scale->roww[y]
+ * \param[in] lut 256个RGB565
+ * \param[out] dst 输出, w/2个32位, 需4字节对齐
+*/
+void mlx90642_scale_line(const mlx90642_scale_st* scale, const int16_t* row0, const int16_t* row1,
+    uint32_t wpair, const uint16_t* lut, uint32_t* dst);
+
+/**
+ * \fn mlx90642_scale_line_l8
+ * 与mlx90642_scale_line相同, 但不查表, 输出8位调色板索引, 由DMA2D转换颜色
+ * \param[in] scale \ref mlx90642_scale_st
+ * \param[in] row0 上方源行, 32个Q4灰度, 需4字节对齐
+ * \param[in] row1 下方源行, 32个Q4灰度, 需4字节对齐
+ * \param[in] wpair 纵向权重 scale->roww[y]
+ * \param[out] dst 输出, w/4个32位(每个4个索引), 需4字节对齐
+*/
+void mlx90642_scale_line_l8(const mlx90642_scale_st* scale, const int16_t* row0, const int16_t* row1,
+    uint32_t wpair, uint32_t* dst);
+
+/**
+ * \fn mlx90642_scale_fill
+ * 成对写入一行的同一颜色, 用于过期的行
+ * \param[out] dst 输出, 需4字节对齐
+ * \param[in] w 点数, 偶数
+ * \param[in] rgb 颜色
+*/
+void mlx90642_scale_fill(uint32_t* dst, int w, uint16_t rgb);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
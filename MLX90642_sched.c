@@ -0,0 +1,187 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "MLX90642.h"
+#include "MLX90642_sched.h"
+#include "xprintf.h"
+#include "clock.h"
+
+#define MLX90642_SCHED_GUARD_MS   2   /* 初始保护带mS */
+#define MLX90642_SCHED_IIR_SHIFT  3   /* 周期估计IIR系数1/8 */
+#define MLX90642_SCHED_Q          4   /* 周期定点小数位 */
+
+#define MLX90642_SCHED_MAX        4   /* 最多调度的传感器数 */
+
+/* 每个从机地址一个调度上下文 */
+typedef struct{
+    uint8_t addr;             /* 0未使用 */
+    uint8_t open_valid;
+    uint8_t init;
+    uint32_t period_q;        /* 周期估计 mS<<MLX90642_SCHED_Q */
+    uint32_t t_next;          /* 预测的下一次窗口打开时刻 */
+    uint32_t t_open;          /* 上一次窗口打开时刻 */
+    uint32_t t_wait;          /* 本帧开始等待的时刻 */
+    uint32_t polls;           /* 本帧已查询次数 */
+    mlx90642_sched_stat_st stat;
+} mlx90642_sched_ctx_st;
+
+static mlx90642_sched_ctx_st s_ctx[MLX90642_SCHED_MAX];
+
+static mlx90642_sched_ctx_st* sched_ctx(uint8_t slaveAddr){
+    mlx90642_sched_ctx_st* ctx = &s_ctx[MLX90642_SCHED_MAX-1];  /* 满了复用最后一个 */
+    for(int i=0; i<MLX90642_SCHED_MAX; i++){
+        if(s_ctx[i].addr == slaveAddr){
+            return &s_ctx[i];
+        }
+        if(s_ctx[i].addr == 0){
+            ctx = &s_ctx[i];
+            break;
+        }
+    }
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->addr = slaveAddr;
+    return ctx;
+}
+
+static int32_t ms_diff(uint32_t now, uint32_t pre){
+    return (int32_t)(now - pre);
+}
+
+/* 一次实际的I2C查询,顺便统计耗时 */
+static int sched_query(mlx90642_sched_ctx_st* ctx){
+    int status;
+    uint32_t us;
+    uint32_t t0 = clock_get_cycles();
+    status = MLX90642_IsReadWindowOpen(ctx->addr);
+    us = (clock_get_cycles() - t0) / (clock_get_ahb() / 1000000);
+    if(ctx->stat.poll_us == 0){
+        ctx->stat.poll_us = us;
+    }else{
+        ctx->stat.poll_us = (ctx->stat.poll_us*7 + us) / 8;
+    }
+    ctx->polls++;
+    return status;
+}
+
+/* 窗口打开: 更新抖动,周期估计和下一次预测 */
+static void sched_update(mlx90642_sched_ctx_st* ctx, uint32_t now){
+    int32_t jitter = ms_diff(now, ctx->t_next);
+    int32_t interval;
+    uint32_t period = ctx->period_q >> MLX90642_SCHED_Q;
+    uint32_t busy_polls;
+
+    ctx->stat.jitter_ms = jitter;
+    if(ctx->stat.frames == 0){
+        ctx->stat.jitter_min = jitter;
+        ctx->stat.jitter_max = jitter;
+    }else{
+        if(jitter < ctx->stat.jitter_min){
+            ctx->stat.jitter_min = jitter;
+        }
+        if(jitter > ctx->stat.jitter_max){
+            ctx->stat.jitter_max = jitter;
+        }
+    }
+
+    /* 跳帧的间隔不参与周期估计 */
+    if(ctx->open_valid){
+        interval = ms_diff(now, ctx->t_open);
+        if((interval > (int32_t)period/2) && (interval < (int32_t)period*3/2)){
+            ctx->period_q += ((interval << MLX90642_SCHED_Q) - (int32_t)ctx->period_q) >> MLX90642_SCHED_IIR_SHIFT;
+            period = ctx->period_q >> MLX90642_SCHED_Q;
+        }
+    }
+
+    /* 保护带内第一次查询就已打开,实际打开时刻可能更早,加宽保护带 */
+    if((ctx->polls == 1) && (ctx->stat.guard_ms < period/4)){
+        ctx->stat.guard_ms *= 2;
+    }
+
+    /* 原来的忙等方式在等待期间会连续查询 */
+    busy_polls = (ctx->stat.poll_us > 0) ? (uint32_t)ms_diff(now, ctx->t_wait)*1000 / ctx->stat.poll_us : 0;
+    ctx->stat.polls = ctx->polls;
+    ctx->stat.saved = (busy_polls > ctx->polls) ? (busy_polls - ctx->polls) : 0;
+    ctx->stat.saved_sum += ctx->stat.saved;
+    ctx->stat.period_ms = period;
+    ctx->stat.frames++;
+
+    ctx->t_open = now;
+    ctx->open_valid = 1;
+    ctx->t_next = now + period;
+    ctx->t_wait = now;
+    ctx->polls = 0;
+}
+
+int mlx90642_sched_init(uint8_t slaveAddr){
+    mlx90642_sched_ctx_st* ctx = sched_ctx(slaveAddr);
+    int status;
+    int progress;
+    uint32_t now;
+
+    status = MLX90642_GetRefreshTime(slaveAddr);
+    if(status < 0){
+        return status;
+    }
+    progress = MLX90642_GetProgress(slaveAddr);
+    if(progress < 0){
+        return progress;
+    }
+    if(progress > 100){
+        progress = 100;
+    }
+
+    memset(&ctx->stat, 0, sizeof(ctx->stat));
+    ctx->stat.period_ms = (uint32_t)status;
+    ctx->stat.guard_ms = MLX90642_SCHED_GUARD_MS;
+    ctx->period_q = (uint32_t)status << MLX90642_SCHED_Q;
+    now = get_ticks();
+    ctx->t_next = now + (uint32_t)status*(100 - progress)/100;
+    ctx->t_wait = now;
+    ctx->polls = 0;
+    ctx->open_valid = 0;
+    ctx->init = 1;
+    return 0;
+}
+
+int mlx90642_sched_poll(uint8_t slaveAddr){
+    mlx90642_sched_ctx_st* ctx = sched_ctx(slaveAddr);
+    int status;
+    uint32_t now;
+
+    if(ctx->init == 0){
+        status = mlx90642_sched_init(slaveAddr);
+        if(status < 0){
+            return status;
+        }
+    }
+    now = get_ticks();
+    if(ms_diff(now, ctx->t_next) < -(int32_t)ctx->stat.guard_ms){
+        return MLX90642_NO;
+    }
+    status = sched_query(ctx);
+    if(status == MLX90642_YES){
+        sched_update(ctx, now);
+    }
+    return status;
+}
+
+int mlx90642_sched_wait(uint8_t slaveAddr){
+    int status;
+    do{
+        status = mlx90642_sched_poll(slaveAddr);
+    }while(status == MLX90642_NO);
+    return status;
+}
+
+const mlx90642_sched_stat_st* mlx90642_sched_stat(uint8_t slaveAddr){
+    return &sched_ctx(slaveAddr)->stat;
+}
+
+void mlx90642_sched_print(uint8_t slaveAddr){
+    mlx90642_sched_ctx_st* ctx = sched_ctx(slaveAddr);
+    xprintf("sensor 0x%02X\r\n", slaveAddr);
+    xprintf("period:%dmS guard:%dmS frames:%d\r\n", ctx->stat.period_ms, ctx->stat.guard_ms, ctx->stat.frames);
+    xprintf("polls:%d saved:%d (avg %d/frame) poll:%duS\r\n", ctx->stat.polls, ctx->stat.saved,
+        (ctx->stat.frames > 0) ? ctx->stat.saved_sum/ctx->stat.frames : 0, ctx->stat.poll_us);
+    xprintf("jitter:%dmS min:%dmS max:%dmS\r\n", ctx->stat.jitter_ms, ctx->stat.jitter_min, ctx->stat.jitter_max);
+}
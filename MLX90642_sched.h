@@ -0,0 +1,74 @@
+#ifndef MLX90642_SCHED_H
+#define MLX90642_SCHED_H
+
+#ifdef __cplusplus
+    extern "C"{
+#endif
+
+#include <stdint.h>
+
+/**
+ * 读窗口调度统计
+ */
+typedef struct{
+    uint32_t period_ms;     /**< 估计的刷新周期mS            */
+    uint32_t guard_ms;      /**< 预测时刻前开始查询的保护带mS */
+    uint32_t frames;        /**< 已调度的帧数                */
+    uint32_t polls;         /**< 最近一帧实际查询次数         */
+    uint32_t saved;         /**< 最近一帧节省的查询次数(估算) */
+    uint32_t saved_sum;     /**< 累计节省的查询次数           */
+    uint32_t poll_us;       /**< 一次查询的I2C耗时uS          */
+    int32_t jitter_ms;      /**< 最近一帧窗口打开时刻-预测时刻 */
+    int32_t jitter_min;     /**< jitter_ms最小值              */
+    int32_t jitter_max;     /**< jitter_ms最大值              */
+} mlx90642_sched_stat_st;
+
+/**
+ * \fn mlx90642_sched_init
+ * 根据刷新周期和当前进度预测下一次读窗口打开的时刻
+ * 每个从机地址独立调度, 最多4个, 修改刷新率后需要重新调用
+ * \param[in] slaveAddr 7位从机地址
+ * \retval 0 成功
+ * \retval <0 I2C错误
+*/
+int mlx90642_sched_init(uint8_t slaveAddr);
+
+/**
+ * \fn mlx90642_sched_poll
+ * 非阻塞查询读窗口,预测时刻前的保护带之外直接返回不访问I2C
+ * \param[in] slaveAddr 7位从机地址
+ * \retval MLX90642_YES 读窗口打开
+ * \retval MLX90642_NO 读窗口未打开
+ * \retval <0 I2C错误
+*/
+int mlx90642_sched_poll(uint8_t slaveAddr);
+
+/**
+ * \fn mlx90642_sched_wait
+ * 阻塞等待读窗口打开
+ * \param[in] slaveAddr 7位从机地址
+ * \retval MLX90642_YES 读窗口打开
+ * \retval <0 I2C错误
+*/
+int mlx90642_sched_wait(uint8_t slaveAddr);
+
+/**
+ * \fn mlx90642_sched_stat
+ * 获取调度统计
+ * \param[in] slaveAddr 7位从机地址
+ * \return \ref mlx90642_sched_stat_st
+*/
+const mlx90642_sched_stat_st* mlx90642_sched_stat(uint8_t slaveAddr);
+
+/**
+ * \fn mlx90642_sched_print
+ * 打印调度统计
+ * \param[in] slaveAddr 7位从机地址
+*/
+void mlx90642_sched_print(uint8_t slaveAddr);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
@@ -0,0 +1,378 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "MLX90642.h"
+#include "MLX90642_sim.h"
+
+#define MLX90642_SIM_TA          1250   /* 环境温度25℃, 1/50℃ */
+#define MLX90642_SIM_SPOT        1850   /* 合成场景热点37℃     */
+#define MLX90642_SIM_SPOT_R2     9      /* 热点半径的平方       */
+#define MLX90642_SIM_BUSY_SHIFT  4      /* 周期最后1/16时间忙(写RAM) */
+#define MLX90642_SIM_IR_OFFSET   0x1000 /* IR原始数据相对TO的偏移 */
+
+#define MLX90642_SIM_CFG_NUM     6
+
+/* 总线状态 */
+enum{
+    SIM_IDLE = 0,   /* 等待START              */
+    SIM_ADDR,       /* 接收地址字节            */
+    SIM_WRITE,      /* 接收寄存器地址和数据     */
+    SIM_READ,       /* 发送数据                */
+    SIM_IGNORE,     /* 地址不匹配或主机NACK后, 等待STOP/START */
+};
+
+static const uint16_t s_sim_cfg_addr[MLX90642_SIM_CFG_NUM] =
+{
+    MLX90642_REFRESH_RATE_ADDRESS,
+    MLX90642_EMISSIVITY_ADDRESS,
+    MLX90642_APPLICATION_CONFIG_ADDRESS,
+    MLX90642_I2C_CONFIG_ADDRESS,
+    MLX90642_I2C_SA_ADDRESS,
+    MLX90642_REFLECTED_TEMP_ADDRESS,
+};
+
+typedef struct{
+    /* 总线 */
+    uint8_t scl;             /* 主机SCL                 */
+    uint8_t sda_m;           /* 主机SDA, 1释放          */
+    uint8_t sda_s;           /* 从机SDA, 1释放          */
+    uint8_t state;
+    uint8_t bit;             /* 当前字节已完成的时钟数0~8 */
+    uint8_t shift;           /* 接收移位寄存器/发送字节   */
+    uint8_t nbytes;          /* 写阶段收到的字节数        */
+    uint8_t rd;              /* 地址字节的读写位          */
+    uint8_t clocked;         /* START后已有SCL上升沿       */
+    uint8_t wbuf[4];         /* 寄存器地址+数据,高字节在前 */
+    uint8_t lo;              /* 1下一个发送低字节         */
+    uint16_t ptr;            /* 寄存器地址指针            */
+    uint16_t word;           /* 正在发送的字              */
+
+    /* 器件 */
+    uint8_t addr;            /* 当前从机地址              */
+    uint8_t ready;           /* 新数据标志                */
+    uint8_t busy;            /* 正在写输出RAM             */
+    uint8_t sleep;
+    uint8_t pending;         /* 单步模式已触发测量         */
+    uint8_t progress;        /* 0~100                   */
+    uint16_t cfg[MLX90642_SIM_CFG_NUM];
+    uint32_t t_frame;        /* 本周期开始时刻             */
+    uint32_t (*get_ms)(void);
+
+    /* 场景 */
+    const int16_t* scene;
+    uint32_t scene_num;
+    uint32_t scene_idx;
+
+    mlx90642_sim_stat_st stat;
+} mlx90642_sim_st;
+
+static mlx90642_sim_st s_sim;
+static int16_t s_sim_to[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+
+static uint16_t* sim_cfg(uint16_t addr){
+    for(int i=0; i<MLX90642_SIM_CFG_NUM; i++){
+        if(s_sim_cfg_addr[i] == addr){
+            return &s_sim.cfg[i];
+        }
+    }
+    return 0;
+}
+
+static uint32_t sim_period(void){
+    return (uint32_t)MLX90642_REF_TIME >> (*sim_cfg(MLX90642_REFRESH_RATE_ADDRESS) & MLX90642_REFRESH_RATE_MASK);
+}
+
+/* 合成场景: 上下有温度梯度的背景和一个逐帧移动的热点 */
+static void sim_scene_synth(uint32_t frame){
+    int cx = (int)(frame % MLX90642_NUMBER_OF_COLUMNS);
+    int cy = 8 + (int)((frame / 4) % 8);
+    int16_t* p = s_sim_to;
+    for(int y=0; y<MLX90642_NUMBER_OF_ROWS; y++){
+        for(int x=0; x<MLX90642_NUMBER_OF_COLUMNS; x++){
+            int d2 = (x-cx)*(x-cx) + (y-cy)*(y-cy);
+            if(d2 <= MLX90642_SIM_SPOT_R2){
+                *p++ = (int16_t)(MLX90642_SIM_SPOT - d2*40);
+            }else{
+                *p++ = (int16_t)(MLX90642_SIM_TA + y*4);
+            }
+        }
+    }
+}
+
+static void sim_new_frame(void){
+    if((s_sim.scene != 0) && (s_sim.scene_num > 0)){
+        memcpy(s_sim_to, s_sim.scene + s_sim.scene_idx*MLX90642_TOTAL_NUMBER_OF_PIXELS, sizeof(s_sim_to));
+        s_sim.scene_idx++;
+        if(s_sim.scene_idx >= s_sim.scene_num){
+            s_sim.scene_idx = 0;
+        }
+    }else{
+        sim_scene_synth(s_sim.stat.frames);
+    }
+    s_sim.ready = 1;
+    s_sim.stat.frames++;
+}
+
+/* 每次START时按时基推进测量状态, 主机看到的标志/进度只在传输之间变化 */
+static void sim_update(void){
+    uint32_t now;
+    uint32_t period = sim_period();
+    uint32_t elapsed;
+
+    if(s_sim.get_ms == 0){
+        return;
+    }
+    now = s_sim.get_ms();
+    elapsed = now - s_sim.t_frame;
+    if(s_sim.sleep){
+        s_sim.busy = 0;
+        return;
+    }
+    if(*sim_cfg(MLX90642_APPLICATION_CONFIG_ADDRESS) & MLX90642_MEAS_MODE_MASK){
+        /* 单步模式: START_SYNC_MEAS后测量一个周期 */
+        if(s_sim.pending == 0){
+            s_sim.busy = 0;
+            s_sim.progress = 0;
+            return;
+        }
+        if(elapsed >= period){
+            s_sim.pending = 0;
+            s_sim.busy = 0;
+            s_sim.progress = 100;
+            sim_new_frame();
+            return;
+        }
+    }else if(elapsed >= period){
+        /* 连续模式: 跨过多个周期只产生一帧,相当于主机漏读 */
+        s_sim.t_frame = now - elapsed % period;
+        elapsed = now - s_sim.t_frame;
+        sim_new_frame();
+    }
+    s_sim.progress = (uint8_t)(elapsed*100/period);
+    s_sim.busy = (elapsed >= period - (period >> MLX90642_SIM_BUSY_SHIFT)) ? 1 : 0;
+}
+
+static uint16_t sim_reg_read(uint16_t addr){
+    uint16_t* cfg;
+    uint16_t idx;
+
+    if((addr >= MLX90642_TO_DATA_ADDRESS) && (addr < MLX90642_TA_DATA_ADDRESS)){
+        /* 读TO数据清除新数据标志 */
+        s_sim.ready = 0;
+        s_sim.stat.to_reads++;
+        return (uint16_t)s_sim_to[(addr - MLX90642_TO_DATA_ADDRESS)/2];
+    }
+    if((addr >= MLX90642_IR_DATA_ADDRESS) && (addr < MLX90642_IR_DATA_ADDRESS + 2*MLX90642_TOTAL_NUMBER_OF_PIXELS)){
+        return (uint16_t)(s_sim_to[(addr - MLX90642_IR_DATA_ADDRESS)/2] + MLX90642_SIM_IR_OFFSET);
+    }
+    if((addr >= MLX90642_AUX_DATA_ADDRESS) && (addr < MLX90642_AUX_DATA_ADDRESS + 2*MLX90642_TOTAL_NUMBER_OF_AUX)){
+        idx = (addr - MLX90642_AUX_DATA_ADDRESS)/2;
+        return (uint16_t)(0xA000 + idx);
+    }
+    switch(addr){
+        case MLX90642_TA_DATA_ADDRESS:
+            return MLX90642_SIM_TA;
+        case MLX90642_PROGRESS_DATA_ADDRESS:
+            return s_sim.progress;
+        case MLX90642_FLAGS_ADDRESS:
+            return (uint16_t)((s_sim.ready << MLX90642_FLAGS_READY_SHIFT) | (s_sim.busy ? MLX90642_FLAGS_BUSY_MASK : 0));
+        case MLX90642_ID1_ADDR:
+        case MLX90642_ID2_ADDR:
+        case MLX90642_ID3_ADDR:
+        case MLX90642_ID4_ADDR:
+            return (uint16_t)(0x5100 + (addr - MLX90642_ID1_ADDR)/2);
+        case MLX90642_FW_VER_ADDRESS1:
+            return 0x0100;   /* 1.0.0 */
+        case MLX90642_FW_VER_ADDRESS2:
+            return 0x0000;
+        default:
+        break;
+    }
+    cfg = sim_cfg(addr);
+    return (cfg != 0) ? *cfg : 0;
+}
+
+static void sim_reg_write(uint16_t addr, uint16_t data){
+    uint16_t* cfg;
+    if(addr == MLX90642_CMD_OPCODE){
+        switch(data){
+            case MLX90642_START_SYNC_MEAS_CMD:
+                s_sim.sleep = 0;
+                s_sim.pending = 1;
+                s_sim.t_frame = (s_sim.get_ms != 0) ? s_sim.get_ms() : 0;
+            break;
+            case MLX90642_SLEEP_CMD:
+                s_sim.sleep = 1;
+            break;
+            case MLX90642_ADRESSED_RESET_CMD:
+                /* 新从机地址复位后生效 */
+                s_sim.addr = (uint8_t)(*sim_cfg(MLX90642_I2C_SA_ADDRESS) & MLX90642_I2C_SA_MASK);
+                s_sim.ready = 0;
+                s_sim.t_frame = (s_sim.get_ms != 0) ? s_sim.get_ms() : 0;
+            break;
+            default:
+            break;
+        }
+        return;
+    }
+    cfg = sim_cfg(addr);
+    if(cfg != 0){
+        *cfg = data;
+    }
+}
+
+/* 装载下一个字节并输出最高位 */
+static void sim_load_byte(void){
+    if(s_sim.lo == 0){
+        s_sim.word = sim_reg_read(s_sim.ptr);
+        s_sim.shift = (uint8_t)(s_sim.word >> 8);
+        s_sim.lo = 1;
+    }else{
+        s_sim.shift = (uint8_t)(s_sim.word & 0xFF);
+        s_sim.lo = 0;
+        s_sim.ptr += 2;
+    }
+    s_sim.sda_s = (s_sim.shift >> 7) & 0x01;
+}
+
+/* 收到一个完整字节, 返回1回ACK */
+static int sim_rx_byte(void){
+    if(s_sim.state == SIM_ADDR){
+        if((s_sim.shift >> 1) != s_sim.addr){
+            s_sim.stat.nacks++;
+            s_sim.state = SIM_IGNORE;
+            return 0;
+        }
+        /* ACK时钟结束后才切换为读/写 */
+        s_sim.rd = s_sim.shift & 0x01;
+        s_sim.lo = 0;
+        s_sim.nbytes = 0;
+        return 1;
+    }
+    if(s_sim.nbytes < sizeof(s_sim.wbuf)){
+        s_sim.wbuf[s_sim.nbytes] = s_sim.shift;
+    }
+    s_sim.nbytes++;
+    if(s_sim.nbytes == 2){
+        s_sim.ptr = (uint16_t)((s_sim.wbuf[0] << 8) | s_sim.wbuf[1]);
+    }
+    return 1;
+}
+
+static void sim_start(void){
+    /* 重复START前没有STOP, 未完成的写丢弃 */
+    sim_update();
+    s_sim.state = SIM_ADDR;
+    s_sim.bit = 0;
+    s_sim.shift = 0;
+    s_sim.sda_s = 1;
+    s_sim.clocked = 0;
+    s_sim.stat.xfers++;
+}
+
+static void sim_stop(void){
+    if((s_sim.state == SIM_WRITE) && (s_sim.nbytes == 4)){
+        sim_reg_write(s_sim.ptr, (uint16_t)((s_sim.wbuf[2] << 8) | s_sim.wbuf[3]));
+    }
+    s_sim.state = SIM_IDLE;
+    s_sim.sda_s = 1;
+}
+
+void mlx90642_sim_init(uint8_t slaveAddr, uint32_t (*get_ms)(void)){
+    memset(&s_sim, 0, sizeof(s_sim));
+    s_sim.scl = 1;
+    s_sim.sda_m = 1;
+    s_sim.sda_s = 1;
+    s_sim.addr = slaveAddr;
+    s_sim.get_ms = get_ms;
+    *sim_cfg(MLX90642_REFRESH_RATE_ADDRESS) = MLX90642_REF_RATE_2HZ;
+    *sim_cfg(MLX90642_EMISSIVITY_ADDRESS) = 0x4000;
+    *sim_cfg(MLX90642_I2C_SA_ADDRESS) = slaveAddr;
+    s_sim.t_frame = (get_ms != 0) ? get_ms() : 0;
+    sim_scene_synth(0);
+}
+
+void mlx90642_sim_scene(const int16_t* frames, uint32_t num){
+    s_sim.scene = frames;
+    s_sim.scene_num = num;
+    s_sim.scene_idx = 0;
+}
+
+void mlx90642_sim_scl_write(uint8_t val){
+    val = (val != 0);
+    if(val == s_sim.scl){
+        return;
+    }
+    s_sim.scl = val;
+    if((s_sim.state == SIM_IDLE) || (s_sim.state == SIM_IGNORE)){
+        return;
+    }
+    if(val){
+        /* 上升沿采样, 时钟数在下降沿统计: 重复START和STOP的SCL高电平不是数据位 */
+        s_sim.clocked = 1;
+        if(s_sim.state == SIM_READ){
+            if((s_sim.bit == 8) && (s_sim.sda_m != 0)){
+                s_sim.stat.bits++;         /* 之后不再处理下降沿, NACK位在这里统计 */
+                s_sim.state = SIM_IGNORE;  /* 主机NACK, 不再输出 */
+            }
+        }else if(s_sim.bit < 8){
+            s_sim.shift = (uint8_t)((s_sim.shift << 1) | (s_sim.sda_m & s_sim.sda_s));
+        }
+        return;
+    }
+    /* 下降沿推进, START之后的第一个下降沿不是数据位 */
+    if(s_sim.clocked == 0){
+        return;
+    }
+    s_sim.stat.bits++;
+    s_sim.bit++;
+    if(s_sim.state == SIM_READ){
+        if(s_sim.bit < 8){
+            s_sim.sda_s = (s_sim.shift >> (7 - s_sim.bit)) & 0x01;
+        }else if(s_sim.bit == 8){
+            s_sim.sda_s = 1;               /* 释放SDA等主机ACK */
+        }else{
+            s_sim.bit = 0;
+            sim_load_byte();
+        }
+        return;
+    }
+    if(s_sim.bit == 8){
+        s_sim.sda_s = sim_rx_byte() ? 0 : 1;
+    }else if(s_sim.bit > 8){
+        s_sim.bit = 0;
+        s_sim.shift = 0;
+        s_sim.sda_s = 1;
+        if(s_sim.state == SIM_ADDR){
+            s_sim.state = s_sim.rd ? SIM_READ : SIM_WRITE;
+        }
+        if(s_sim.state == SIM_READ){
+            sim_load_byte();
+        }
+    }
+}
+
+void mlx90642_sim_sda_write(uint8_t val){
+    uint8_t line = s_sim.sda_m & s_sim.sda_s;
+    s_sim.sda_m = (val != 0);
+    if(s_sim.scl == 0){
+        return;
+    }
+    if(line && ((s_sim.sda_m & s_sim.sda_s) == 0)){
+        sim_start();
+    }else if((line == 0) && (s_sim.sda_m & s_sim.sda_s)){
+        sim_stop();
+    }
+}
+
+void mlx90642_sim_sda_2read(void){
+    mlx90642_sim_sda_write(1);
+}
+
+uint8_t mlx90642_sim_sda_read(void){
+    return s_sim.sda_m & s_sim.sda_s;
+}
+
+const mlx90642_sim_stat_st* mlx90642_sim_stat(void){
+    return &s_sim.stat;
+}
@@ -0,0 +1,82 @@
+#ifndef MLX90642_SIM_H
+#define MLX90642_SIM_H
+
+#ifdef __cplusplus
+    extern "C"{
+#endif
+
+#include <stdint.h>
+
+/**
+ * MLX90642仿真器
+ * 在SCL/SDA电平上实现MLX90642从机, 直接挂到io_iic_dev_st的scl_write/sda_write/sda_2read/sda_read,
+ * MLX90642_depends.c和MLX90642.c无需修改即可在没有传感器时运行.
+ * 不访问任何寄存器,只依赖毫秒时基,可以在主机上编译.
+ */
+
+/**
+ * 仿真统计
+ */
+typedef struct{
+    uint32_t frames;        /**< 已产生的帧数                 */
+    uint32_t bits;          /**< 数据和ACK位的SCL时钟数(不含START/STOP) */
+    uint32_t xfers;         /**< START(含重复START)次数        */
+    uint32_t nacks;         /**< 回NACK的次数(地址不匹配)       */
+    uint32_t to_reads;      /**< 从TO数据区读出的字数           */
+} mlx90642_sim_stat_st;
+
+/**
+ * \fn mlx90642_sim_init
+ * 初始化仿真器, 寄存器恢复默认值(2Hz连续测量,温度输出)
+ * \param[in] slaveAddr 7位从机地址
+ * \param[in] get_ms 毫秒时基, 决定刷新周期/进度/忙标志
+*/
+void mlx90642_sim_init(uint8_t slaveAddr, uint32_t (*get_ms)(void));
+
+/**
+ * \fn mlx90642_sim_scene
+ * 设置录制的场景, 每产生一帧按顺序取下一帧, 循环使用
+ * \param[in] frames num帧, 每帧768个温度值(1/50℃), 0恢复内置的合成场景
+ * \param[in] num 帧数
+*/
+void mlx90642_sim_scene(const int16_t* frames, uint32_t num);
+
+/**
+ * \fn mlx90642_sim_scl_write
+ * io_iic_dev_st.scl_write
+ * \param[in] val 主机驱动的SCL电平
+*/
+void mlx90642_sim_scl_write(uint8_t val);
+
+/**
+ * \fn mlx90642_sim_sda_write
+ * io_iic_dev_st.sda_write, SCL高时SDA的边沿为START/STOP
+ * \param[in] val 主机驱动的SDA电平, 1为释放
+*/
+void mlx90642_sim_sda_write(uint8_t val);
+
+/**
+ * \fn mlx90642_sim_sda_2read
+ * io_iic_dev_st.sda_2read, 主机释放SDA
+*/
+void mlx90642_sim_sda_2read(void);
+
+/**
+ * \fn mlx90642_sim_sda_read
+ * io_iic_dev_st.sda_read
+ * \return 总线SDA电平(主机和从机线与)
+*/
+uint8_t mlx90642_sim_sda_read(void);
+
+/**
+ * \fn mlx90642_sim_stat
+ * 获取仿真统计
+ * \return \ref mlx90642_sim_stat_st
+*/
+const mlx90642_sim_stat_st* mlx90642_sim_stat(void);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
@@ -1,6 +1,16 @@
+#include <string.h>
 #include "MLX90642.h"
 #include "xprintf.h"
 #include "clock.h"
+#include "MLX90642_sched.h"
+#include "MLX90642_sim.h"
+#include "MLX90642_disp.h"
+#include "MLX90642_palette.h"
+#include "MLX90642_scale.h"
+#include "MLX90642_filter.h"
+#include "MLX90642_blob.h"
+#include "lcd_itf.h"
+#include "spi.h"
 static uint32_t u32_diff(uint32_t pre, uint32_t now){
     if(now >= pre){
         return now-pre;
@@ -16,7 +26,7 @@ int mlx90642_test(int n)
         n=1;
     }
     uint8_t version[3];
-    MLX90642_Set_Delay(1000ul);  /* 1000~25K 10~1.4M */
+    MLX90642_Set_ClockHz(25000ul);  /* 切换FM+之前先用低速 */
 
     status = MLX90642_GetFWver(SA_90642_DEFAULT,version);
     if(status < 0){
@@ -39,7 +49,7 @@ int mlx90642_test(int n)
     MLX90642_SetI2CLevel(SA_90642_DEFAULT, MLX90642_I2C_LEVEL_VDD);
     MLX90642_SetSDALimitState(SA_90642_DEFAULT, MLX90642_I2C_SDA_CUR_LIMIT_OFF);
     MLX90642_SetI2CMode(SA_90642_DEFAULT, MLX90642_I2C_MODE_FM_PLUS); 
-    MLX90642_Set_Delay(20ul);
+    MLX90642_Set_ClockHz(1000000ul);
 
     uint32_t t0;
     uint32_t t1;
@@ -65,13 +75,967 @@ int mlx90642_test(int n)
         }
         
         /* wait for new data */
-        status = MLX90642_NO; 
-        while(status == MLX90642_NO){
-            status = MLX90642_IsReadWindowOpen(SA_90642_DEFAULT);
+        status = mlx90642_sched_wait(SA_90642_DEFAULT);
+        if(status < 0){
+            xprintf("mlx90642_sched_wait err %d\r\n",status);
+        }
+    }
+    mlx90642_sched_print(SA_90642_DEFAULT);
+    return 0;
+}
+
+/**
+ * 读一帧768点的时间, 推挽端口(每次读写配置SDA) 对比 开漏快速端口
+ * 两者使用相同的delayus, 直接用MLX90642_I2CRead在当前上下文读, 不经过定时器分段的异步读
+ */
+static void mlx90642_bench_io(int n)
+{
+    static uint16_t buf[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    /* 地址写+2字节寄存器地址+地址读+1536字节数据, 每字节9个SCL */
+    uint32_t bits = (4 + MLX90642_TOTAL_NUMBER_OF_PIXELS*2)*9;
+    uint32_t mhz = clock_get_ahb()/1000000;
+    uint32_t t0;
+    uint32_t cycles;
+    uint32_t cycles_sum;
+    uint32_t sum_us;
+    int status;
+    for(int fast=0; fast<2; fast++){
+        MLX90642_Set_FastIO(fast);
+        sum_us = 0;
+        cycles_sum = 0;
+        for(int i=0; i<n; i++){
+            t0 = clock_get_cycles();
+            status = MLX90642_I2CRead(SA_90642_DEFAULT, MLX90642_TO_DATA_ADDRESS, MLX90642_TOTAL_NUMBER_OF_PIXELS, buf);
+            cycles = clock_get_cycles() - t0;
+            cycles_sum += cycles;
+            sum_us += cycles/mhz;
             if(status < 0){
-                xprintf("MLX90642_IsReadWindowOpen err %d\r\n",status);
-            }         
+                xprintf("MLX90642_I2CRead err %d\r\n",status);
+            }
+        }
+        sum_us /= n;
+        xprintf("%s: %u cycles/frame %uuS %ukbit/s\r\n", fast ? "od" : "pp", cycles_sum/n, sum_us, (sum_us > 0) ? bits*1000/sum_us : 0);
+    }
+    MLX90642_Set_FastIO(1);
+}
+
+/**
+ * 预测调度等待n帧读窗口, 打印节省的查询次数和窗口打开时刻抖动
+ */
+static void mlx90642_bench_sched(int n)
+{
+    static uint16_t buf[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    const mlx90642_sched_stat_st* stat = mlx90642_sched_stat(SA_90642_DEFAULT);
+    int status;
+    status = mlx90642_sched_init(SA_90642_DEFAULT);
+    if(status < 0){
+        xprintf("mlx90642_sched_init err %d\r\n",status);
+        return;
+    }
+    for(int i=0; i<n; i++){
+        status = mlx90642_sched_wait(SA_90642_DEFAULT);
+        if(status < 0){
+            xprintf("mlx90642_sched_wait err %d\r\n",status);
+            return;
+        }
+        /* 读数据清除ready标志 */
+        status = MLX90642_GetImage(SA_90642_DEFAULT, buf);
+        if(status < 0){
+            xprintf("MLX90642_GetImage err %d\r\n",status);
+        }
+        xprintf("frame %d polls:%d saved:%d jitter:%dmS\r\n", i, stat->polls, stat->saved, stat->jitter_ms);
+    }
+    mlx90642_sched_print(SA_90642_DEFAULT);
+}
+
+/* mlx90642_disp_init中的配置序列 */
+static void mlx90642_bench_cfg_set(void)
+{
+    MLX90642_SetRefreshRate(SA_90642_DEFAULT, MLX90642_REF_RATE_2HZ); 
+    MLX90642_SetOutputFormat(SA_90642_DEFAULT, MLX90642_TEMPERATURE_OUTPUT); 
+    MLX90642_SetI2CLevel(SA_90642_DEFAULT, MLX90642_I2C_LEVEL_VDD);
+    MLX90642_SetSDALimitState(SA_90642_DEFAULT, MLX90642_I2C_SDA_CUR_LIMIT_OFF);
+    MLX90642_SetI2CMode(SA_90642_DEFAULT, MLX90642_I2C_MODE_FM_PLUS); 
+    MLX90642_GetRefreshTime(SA_90642_DEFAULT);
+    MLX90642_GetOutputFormat(SA_90642_DEFAULT);
+}
+
+/**
+ * 配置序列的I2C传输次数和耗时
+ * nocache: 每次调用前清除影子寄存器, 相当于原来每个Set都读改写
+ * staged: 暂存后一次提交
+ */
+static void mlx90642_bench_cfg(int n)
+{
+    uint32_t c0;
+    uint32_t t0;
+    for(int i=0; i<n; i++){
+        c0 = MLX90642_I2CGetXferCount();
+        t0 = get_ticks();
+        MLX90642_InvalidateConfig(SA_90642_DEFAULT);
+        MLX90642_SetRefreshRate(SA_90642_DEFAULT, MLX90642_REF_RATE_2HZ); 
+        MLX90642_InvalidateConfig(SA_90642_DEFAULT);
+        MLX90642_SetOutputFormat(SA_90642_DEFAULT, MLX90642_TEMPERATURE_OUTPUT); 
+        MLX90642_InvalidateConfig(SA_90642_DEFAULT);
+        MLX90642_SetI2CLevel(SA_90642_DEFAULT, MLX90642_I2C_LEVEL_VDD);
+        MLX90642_InvalidateConfig(SA_90642_DEFAULT);
+        MLX90642_SetSDALimitState(SA_90642_DEFAULT, MLX90642_I2C_SDA_CUR_LIMIT_OFF);
+        MLX90642_InvalidateConfig(SA_90642_DEFAULT);
+        MLX90642_SetI2CMode(SA_90642_DEFAULT, MLX90642_I2C_MODE_FM_PLUS); 
+        MLX90642_InvalidateConfig(SA_90642_DEFAULT);
+        MLX90642_GetRefreshTime(SA_90642_DEFAULT);
+        MLX90642_InvalidateConfig(SA_90642_DEFAULT);
+        MLX90642_GetOutputFormat(SA_90642_DEFAULT);
+        xprintf("nocache: %d xfers %dmS\r\n", MLX90642_I2CGetXferCount()-c0, u32_diff(t0,get_ticks()));
+
+        c0 = MLX90642_I2CGetXferCount();
+        t0 = get_ticks();
+        MLX90642_InvalidateConfig(SA_90642_DEFAULT);
+        MLX90642_StageConfig(SA_90642_DEFAULT);
+        mlx90642_bench_cfg_set();
+        MLX90642_CommitConfig(SA_90642_DEFAULT);
+        xprintf("staged: %d xfers %dmS\r\n", MLX90642_I2CGetXferCount()-c0, u32_diff(t0,get_ticks()));
+
+        c0 = MLX90642_I2CGetXferCount();
+        t0 = get_ticks();
+        mlx90642_bench_cfg_set();
+        xprintf("cached: %d xfers %dmS\r\n", MLX90642_I2CGetXferCount()-c0, u32_diff(t0,get_ticks()));
+    }
+}
+
+/**
+ * 仿真器: 每帧等待窗口和读图像的SCL时钟数, 读图像的耗时和吞吐率
+ * 需要-DMLX90642_IIC_SIM=1编译, 否则仿真器没有接到总线上, 统计为0
+ */
+static void mlx90642_bench_sim(int n)
+{
+    static uint16_t buf[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    const mlx90642_sim_stat_st* stat = mlx90642_sim_stat();
+    uint32_t mhz = clock_get_ahb()/1000000;
+    uint32_t b0;
+    uint32_t b1;
+    uint32_t bits;
+    uint32_t t0;
+    uint32_t us;
+    int status;
+    for(int i=0; i<n; i++){
+        b0 = stat->bits;
+        status = mlx90642_sched_wait(SA_90642_DEFAULT);
+        if(status < 0){
+            xprintf("mlx90642_sched_wait err %d\r\n",status);
+            return;
+        }
+        b1 = stat->bits;
+        t0 = clock_get_cycles();
+        status = MLX90642_GetImage(SA_90642_DEFAULT, buf);
+        us = (clock_get_cycles() - t0)/mhz;
+        if(status < 0){
+            xprintf("MLX90642_GetImage err %d\r\n",status);
+        }
+        bits = stat->bits - b1;
+        xprintf("frame %d: wait %d bits, image %d bits %duS %dkbit/s\r\n", stat->frames, b1 - b0, bits, us,
+            (us > 0) ? bits*1000/us : 0);
+    }
+    if(stat->xfers == 0){
+        xprintf("simulator not attached, build with -DMLX90642_IIC_SIM=1\r\n");
+    }
+}
+
+/**
+ * 温度->RGB565: 原逐点除法实现 对比 查表实现
+ * 先遍历全部int16温度确认两者输出逐位相同(classic调色板), 再比较一帧的周期数
+ */
+static void mlx90642_bench_color(int n)
+{
+    static int16_t temp[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    static uint16_t rgb_ref[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    static uint16_t rgb[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    uint32_t t0;
+    uint32_t ref_cycles = 0;
+    uint32_t lut_cycles = 0;
+    int32_t v = -32768;
+    int diff = 0;
+    int pal = mlx90642_palette_id();
+
+    mlx90642_palette_set(mlx90642_palette_find("classic"));
+    while(v <= 32767){
+        for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            temp[i] = (int16_t)((v <= 32767) ? v : 32767);
+            v++;
+        }
+        temp2rgb_ref(temp, rgb_ref, 0, MLX90642_TOTAL_NUMBER_OF_PIXELS);
+        temp2rgb(temp, rgb, 0, MLX90642_TOTAL_NUMBER_OF_PIXELS);
+        for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            if(rgb[i] != rgb_ref[i]){
+                if(diff == 0){
+                    xprintf("mismatch temp %d: %04x != %04x\r\n", temp[i], rgb[i], rgb_ref[i]);
+                }
+                diff++;
+            }
+        }
+    }
+    xprintf("bit-identical: %s (%d diff)\r\n", (diff == 0) ? "yes" : "NO", diff);
+
+    /* 室温背景加热源, 与实际画面接近 */
+    for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+        temp[i] = (int16_t)(20*50 + (i%32)*20 + (i/32)*35);
+    }
+    for(int i=0; i<n; i++){
+        t0 = clock_get_cycles();
+        temp2rgb_ref(temp, rgb_ref, 0, MLX90642_TOTAL_NUMBER_OF_PIXELS);
+        ref_cycles += clock_get_cycles() - t0;
+        t0 = clock_get_cycles();
+        temp2rgb(temp, rgb, 0, MLX90642_TOTAL_NUMBER_OF_PIXELS);
+        lut_cycles += clock_get_cycles() - t0;
+    }
+    xprintf("ref: %u cycles/frame\r\n", ref_cycles/n);
+    xprintf("lut: %u cycles/frame\r\n", lut_cycles/n);
+    mlx90642_palette_set(pal);
+}
+
+/**
+ * 一帧统计: 分开的循环(原来的最大值循环+告警计数循环, 再加最小值/均值) 对比 一次遍历
+ */
+static void mlx90642_bench_stats(int n)
+{
+    static int16_t temp[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    mlx90642_stat_st ref;
+    mlx90642_stat_st st;
+    uint32_t t0;
+    uint32_t ref_cycles = 0;
+    uint32_t fused_cycles = 0;
+    int32_t sum;
+    int16_t th = 100*50;
+
+    /* 室温背景加两个热源, 一个超过告警温度 */
+    for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+        temp[i] = (int16_t)(20*50 + (i%32)*20 + (i/32)*35);
+    }
+    temp[5*32+7] = 120*50;
+    temp[18*32+25] = 105*50;
+    for(int k=0; k<n; k++){
+        t0 = clock_get_cycles();
+        ref.max = temp[0];
+        ref.hot_idx = 0;
+        for(int i=1; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            if(temp[i] > ref.max){
+                ref.max = temp[i];
+                ref.hot_idx = i;
+            }
+        }
+        ref.min = temp[0];
+        for(int i=1; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            if(temp[i] < ref.min){
+                ref.min = temp[i];
+            }
+        }
+        sum = 0;
+        for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            sum += temp[i];
+        }
+        ref.mean = (int16_t)(sum / MLX90642_TOTAL_NUMBER_OF_PIXELS);
+        ref.over = 0;
+        for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            if(temp[i] >= th){
+                ref.over++;
+            }
+        }
+        ref_cycles += clock_get_cycles() - t0;
+
+        t0 = clock_get_cycles();
+        mlx90642_frame_stat(temp, 0xFFFFFF, th, &st);
+        fused_cycles += clock_get_cycles() - t0;
+    }
+    xprintf("min:%d max:%d mean:%d hot:%d over:%d\r\n", st.min, st.max, st.mean, st.hot_idx, st.over);
+    xprintf("same: %s\r\n", ((st.min == ref.min) && (st.max == ref.max) && (st.mean == ref.mean) &&
+        (st.hot_idx == ref.hot_idx) && (st.over == ref.over)) ? "yes" : "NO");
+    xprintf("loops: %u cycles/frame\r\n", ref_cycles/n);
+    xprintf("fused: %u cycles/frame\r\n", fused_cycles/n);
+}
+
+/**
+ * 直方图均衡每帧的开销(768点): 统计中增量维护直方图/重建直方图, 计算映射, 生成LUT, 逐点查表
+ * 场景为室温背景加噪声, 每帧都变化
+ */
+static void mlx90642_bench_heq(int n)
+{
+    static int16_t temp[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    static uint16_t rgb[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    static mlx90642_hist_st hist;
+    static uint16_t lut[MLX90642_HIST_BINS];
+    uint8_t gray[MLX90642_HIST_BINS];
+    const uint16_t* pal = mlx90642_palette_lut();
+    mlx90642_stat_st st;
+    uint32_t seed = 1;
+    uint32_t t0;
+    uint32_t stat_cycles = 0;
+    uint32_t inc_cycles = 0;
+    uint32_t rebuild_cycles = 0;
+    uint32_t map_cycles = 0;
+    uint32_t lut_cycles = 0;
+    uint32_t rgb_cycles = 0;
+    uint32_t moved = 0;
+
+    hist.lo = 15*50;
+    hist.shift = 2;
+    hist.rebuild = 1;
+    for(int k=0; k<n; k++){
+        for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            seed = seed*1103515245ul + 12345ul;
+            temp[i] = (int16_t)(20*50 + (i%32)*10 + (i/32)*5 + (int)((seed >> 16) & 0x0F));
+        }
+        t0 = clock_get_cycles();
+        mlx90642_frame_stat(temp, 0xFFFFFF, 100*50, &st);
+        stat_cycles += clock_get_cycles() - t0;
+
+        t0 = clock_get_cycles();
+        mlx90642_frame_stat_hist(temp, 0xFFFFFF, 100*50, &st, &hist);
+        inc_cycles += clock_get_cycles() - t0;
+        moved += hist.moved;
+
+        hist.rebuild = 1;
+        t0 = clock_get_cycles();
+        mlx90642_frame_stat_hist(temp, 0xFFFFFF, 100*50, &st, &hist);
+        rebuild_cycles += clock_get_cycles() - t0;
+
+        t0 = clock_get_cycles();
+        mlx90642_heq_map(&hist, hist.num/64, gray);
+        map_cycles += clock_get_cycles() - t0;
+
+        t0 = clock_get_cycles();
+        for(int i=0; i<MLX90642_HIST_BINS; i++){
+            lut[i] = pal[gray[i]];
+        }
+        lut_cycles += clock_get_cycles() - t0;
+
+        t0 = clock_get_cycles();
+        temp2rgb_heq(temp, rgb, 0, MLX90642_TOTAL_NUMBER_OF_PIXELS, &hist, lut);
+        rgb_cycles += clock_get_cycles() - t0;
+    }
+    xprintf("stat:          %u cycles/frame\r\n", stat_cycles/n);
+    xprintf("stat+hist inc: %u cycles/frame (moved %u/frame)\r\n", inc_cycles/n, moved/n);
+    xprintf("stat+hist new: %u cycles/frame\r\n", rebuild_cycles/n);
+    xprintf("map:           %u cycles/frame\r\n", map_cycles/n);
+    xprintf("lut:           %u cycles/regen\r\n", lut_cycles/n);
+    xprintf("rgb:           %u cycles/frame\r\n", rgb_cycles/n);
+}
+
+/**
+ * 320x240显示: 原来每点填充10x10色块 对比 双线性放大(成对32位写显存)
+ * 直接写显存, 不刷新LCD
+ */
+static void mlx90642_bench_scale(int n)
+{
+    static int16_t temp[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    static uint16_t rgb[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    static int16_t gray[MLX90642_TOTAL_NUMBER_OF_PIXELS] __attribute__((aligned(4)));
+    static mlx90642_scale_st scale;
+    const uint16_t* lut = mlx90642_palette_lut();
+    uint16_t* fb = lcd_itf_buffer();
+    uint32_t t0;
+    uint32_t block_cycles = 0;
+    uint32_t gray_cycles = 0;
+    uint32_t scale_cycles = 0;
+    int r0;
+
+    for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+        temp[i] = (int16_t)(20*50 + (i%32)*20 + (i/32)*35);
+    }
+    mlx90642_scale_init(&scale, 10);
+    for(int k=0; k<n; k++){
+        t0 = clock_get_cycles();
+        temp2rgb(temp, rgb, 0, MLX90642_TOTAL_NUMBER_OF_PIXELS);
+        for(int y=0; y<24; y++){
+            for(int x=0; x<32; x++){
+                lcd_itf_fill(x*10, 10, y*10, 10, rgb[y*32+x]);
+            }
+        }
+        block_cycles += clock_get_cycles() - t0;
+
+        t0 = clock_get_cycles();
+        mlx90642_disp_gray(0, temp, gray, 0, MLX90642_TOTAL_NUMBER_OF_PIXELS);
+        gray_cycles += clock_get_cycles() - t0;
+        for(int y=0; y<scale.h; y++){
+            r0 = scale.row[y];
+            mlx90642_scale_line(&scale, gray + r0*32, gray + (r0+1)*32, scale.roww[y], lut, (uint32_t*)(fb + y*LCD_HSIZE));
+        }
+        scale_cycles += clock_get_cycles() - t0;
+    }
+    xprintf("block:    %u cycles/frame\r\n", block_cycles/n);
+    xprintf("bilinear: %u cycles/frame (gray %u)\r\n", scale_cycles/n, gray_cycles/n);
+}
+
+/* 4个均匀分布之和近似高斯噪声, 标准差约9(0.18℃) */
+static int bench_noise(uint32_t* seed){
+    int v = 0;
+    for(int i=0; i<4; i++){
+        *seed = *seed*1103515245ul + 12345ul;
+        v += (int)((*seed >> 16) & 0x0F);
+    }
+    return v - 30;
+}
+
+/* 一帧与真值的均方误差, (1/50℃)^2 */
+static uint32_t bench_mse(const int16_t* temp, int16_t truth){
+    uint32_t sum = 0;
+    int32_t d;
+    for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+        d = temp[i] - truth;
+        sum += (uint32_t)(d*d);
+    }
+    return sum / MLX90642_TOTAL_NUMBER_OF_PIXELS;
+}
+
+/* 一帧的平均值 */
+static int32_t bench_mean(const int16_t* temp){
+    int32_t sum = 0;
+    for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+        sum += temp[i];
+    }
+    return sum / MLX90642_TOTAL_NUMBER_OF_PIXELS;
+}
+
+/**
+ * 时域滤波: 合成噪声下的降噪比, 小阶跃(低于slew)和大阶跃(超过slew)的响应帧数, 每帧周期数
+ * 使用最后一个传感器的状态, 结束后恢复原参数(状态清零)
+ */
+static void mlx90642_bench_filter(int n)
+{
+    static int16_t temp[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    const mlx90642_filter_stat_st* stat = mlx90642_filter_stat();
+    uint8_t shift = stat->shift;
+    uint16_t slew = stat->slew;
+    int id = MLX90642_FILTER_MAX - 1;
+    uint32_t seed = 1;
+    uint32_t t0;
+    uint32_t cycles = 0;
+    uint32_t mse_in = 0;
+    uint32_t mse_out = 0;
+    int16_t base = 25*50;
+    int16_t level;
+    int frames;
+
+    mlx90642_filter_config(2, 2*50);
+    /* 降噪: 先收敛16帧, 再统计n帧 */
+    for(int k=0; k<16+n; k++){
+        for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            temp[i] = (int16_t)(base + bench_noise(&seed));
+        }
+        if(k >= 16){
+            mse_in += bench_mse(temp, base);
+        }
+        t0 = clock_get_cycles();
+        mlx90642_filter_run(id, temp, 0xFFFFFF);
+        if(k >= 16){
+            cycles += clock_get_cycles() - t0;
+            mse_out += bench_mse(temp, base);
+        }
+    }
+    xprintf("noise mse in:%u out:%u (1/50C)^2, reduced to %u%%\r\n", mse_in/n, mse_out/n, mse_out*100/mse_in);
+    xprintf("filter: %u cycles/frame\r\n", cycles/n);
+
+    /* 阶跃响应: 平均值到达阶跃90%的帧数 */
+    for(int step=1; step<=20; step+=19){
+        level = (int16_t)(base + step*50);
+        for(frames=1; frames<=64; frames++){
+            for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+                temp[i] = (int16_t)(level + bench_noise(&seed));
+            }
+            mlx90642_filter_run(id, temp, 0xFFFFFF);
+            if(bench_mean(temp) - base >= step*50*9/10){
+                break;
+            }
+        }
+        xprintf("step +%dC: %d frames to 90%%\r\n", step, frames);
+        /* 回到基准 */
+        for(int k=0; k<32; k++){
+            for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+                temp[i] = (int16_t)(base + bench_noise(&seed));
+            }
+            mlx90642_filter_run(id, temp, 0xFFFFFF);
+        }
+    }
+    xprintf("resets: %u\r\n", stat->resets);
+    mlx90642_filter_config(shift, slew);
+}
+
+/**
+ * 3x3中值滤波: 每点插入排序 对比 列排序网络, 先确认随机帧(含过期行)结果相同
+ */
+static void mlx90642_bench_median(int n)
+{
+    static int16_t temp[MLX90642_TOTAL_NUMBER_OF_PIXELS] __attribute__((aligned(4)));
+    static int16_t out_ref[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    static int16_t out[MLX90642_TOTAL_NUMBER_OF_PIXELS] __attribute__((aligned(4)));
+    uint32_t seed = 1;
+    uint32_t rows;
+    uint32_t t0;
+    uint32_t ref_cycles = 0;
+    uint32_t net_cycles = 0;
+    int diff = 0;
+
+    for(int k=0; k<n; k++){
+        for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            seed = seed*1103515245ul + 12345ul;
+            temp[i] = (int16_t)(seed >> 16);
+        }
+        rows = (k & 1) ? (seed & 0xFFFFFF) : 0xFFFFFF;
+        t0 = clock_get_cycles();
+        mlx90642_median_ref(temp, out_ref, rows);
+        ref_cycles += clock_get_cycles() - t0;
+        t0 = clock_get_cycles();
+        mlx90642_median_run(temp, out, rows);
+        net_cycles += clock_get_cycles() - t0;
+        for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            if(out[i] != out_ref[i]){
+                diff++;
+            }
+        }
+    }
+    xprintf("identical: %s (%d diff)\r\n", (diff == 0) ? "yes" : "NO", diff);
+    xprintf("sort:    %u cycles/frame\r\n", ref_cycles/n);
+    xprintf("network: %u cycles/frame\r\n", net_cycles/n);
+}
+
+/**
+ * 热点检测: 两个2x2热点相向移动, 每7帧有一帧漏检一个, 加噪声,
+ * 统计每帧周期数和跟踪ID变化次数(应为0), 用传感器3的跟踪状态, 结束后恢复默认参数
+ */
+static void mlx90642_bench_blob(int n)
+{
+    static int16_t temp[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    const mlx90642_blob_list_st* list;
+    uint32_t seed = 1;
+    uint32_t t0;
+    uint32_t cycles = 0;
+    uint32_t cycles_max = 0;
+    uint32_t dt;
+    uint16_t id_a = 0;
+    uint16_t id_b = 0;
+    int ax;
+    int bx;
+    int changes = 0;
+    int missed = 0;
+
+    mlx90642_blob_config(2, 4);
+    for(int k=0; k<n; k++){
+        for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+            temp[i] = (int16_t)(25*50 + bench_noise(&seed));
+        }
+        ax = 2 + (k/2)%28;
+        bx = 28 - (k/2)%28;
+        for(int dy=0; dy<2; dy++){
+            for(int dx=0; dx<2; dx++){
+                temp[(5+dy)*32 + ax+dx] = 120*50;
+                if((k%7) != 3){
+                    temp[(18+dy)*32 + bx+dx] = 130*50;
+                }
+            }
+        }
+        if((k > 0) && ((k/2)%28 == 0)){
+            mlx90642_blob_config(2, 4);   /* 热点跳回起点, 重新开始跟踪 */
+            id_a = 0;
+            id_b = 0;
+        }
+        t0 = clock_get_cycles();
+        list = mlx90642_blob_run(MLX90642_BLOB_SENSOR_MAX-1, temp, 0xFFFFFF, 100*50);
+        dt = clock_get_cycles() - t0;
+        cycles += dt;
+        if(dt > cycles_max){
+            cycles_max = dt;
+        }
+        for(int i=0; i<list->num; i++){
+            if(list->blob[i].cy < (12 << MLX90642_BLOB_Q)){
+                if((id_a != 0) && (list->blob[i].id != id_a)){
+                    changes++;
+                }
+                id_a = list->blob[i].id;
+            }else{
+                if((id_b != 0) && (list->blob[i].id != id_b)){
+                    changes++;
+                }
+                id_b = list->blob[i].id;
+            }
+        }
+        missed += list->lost;
+    }
+    mlx90642_blob_config(2, 4);
+    xprintf("id changes: %d (missed %d)\r\n", changes, missed);
+    xprintf("blob: %u cycles/frame max %u\r\n", cycles/n, cycles_max);
+}
+
+/**
+ * LCD刷新: 先检查8位/16位帧在各种长度和对齐下的分段(每段不超过NDTR, 按字的段对齐, 突发段16字节对齐, 首尾相接),
+ * 再对比8位/16位帧 查询/DMA刷新一整屏的时间
+ */
+static void mlx90642_bench_lcddma(int n)
+{
+    static const uint32_t lens[] = {1, 63, 64, 4096, 65532, 65535, 65536, 131071, 131072, LCD_HSIZE*LCD_VSIZE*2};
+    spi_dma_chunk_st chunk;
+    uint32_t addr;
+    uint32_t sum;
+    uint32_t cnt;
+    uint32_t chunks;
+    uint32_t t0;
+    uint32_t poll_cycles;
+    uint32_t ret_cycles;
+    uint32_t done_cycles;
+    uint32_t mhz = clock_get_ahb() / 1000000;
+    int err = 0;
+
+    for(uint8_t psize=0; psize<2; psize++){
+        for(uint32_t i=0; i<sizeof(lens)/sizeof(lens[0]); i++){
+            for(uint32_t off=0; off<4; off+=(1u<<psize)){
+                addr = (uint32_t)lcd_itf_buffer() + off;
+                sum = 0;
+                chunks = 0;
+                while((cnt = spi_dma_next(addr, lens[i] - sum, psize, &chunk)) != 0){
+                    if((chunk.cnt != (cnt >> psize)) || ((chunk.cnt << psize) != cnt) || (chunk.addr != addr)){
+                        err++;
+                    }
+                    if((chunk.msize == 2) && (((chunk.addr & 0x03) != 0) || ((cnt & 0x03) != 0))){
+                        err++;
+                    }
+                    if((chunk.msize < psize) || ((chunk.addr & ((1u << chunk.msize) - 1)) != 0)){
+                        err++;
+                    }
+                    if((chunk.mburst != 0) && ((chunk.msize != 2) || ((chunk.addr & 0x0F) != 0) || ((cnt & 0x0F) != 0))){
+                        err++;
+                    }
+                    addr += cnt;
+                    sum += cnt;
+                    chunks++;
+                }
+                if(sum != (lens[i] & ~((1u << psize) - 1))){
+                    err++;
+                }
+                if(off == 0){
+                    xprintf("%dbit len %u: %u chunks\r\n", 8 << psize, lens[i], chunks);
+                }
+            }
+        }
+    }
+    xprintf("chunking: %s (%d err)\r\n", (err == 0) ? "ok" : "FAIL", err);
+
+    for(int spi16=0; spi16<2; spi16++){
+        lcd_itf_spi16(spi16);
+        lcd_itf_dma(0);
+        poll_cycles = 0;
+        for(int k=0; k<n; k++){
+            lcd_itf_mark(0, LCD_HSIZE, 0, LCD_VSIZE);  /* 整屏发送 */
+            t0 = clock_get_cycles();
+            lcd_itf_sync();
+            poll_cycles += clock_get_cycles() - t0;
         }
+        lcd_itf_dma(1);
+        ret_cycles = 0;
+        done_cycles = 0;
+        for(int k=0; k<n; k++){
+            lcd_itf_mark(0, LCD_HSIZE, 0, LCD_VSIZE);
+            t0 = clock_get_cycles();
+            lcd_itf_sync();
+            ret_cycles += clock_get_cycles() - t0;
+            lcd_itf_sync_wait();
+            done_cycles += clock_get_cycles() - t0;
+        }
+        xprintf("%dbit poll: %u uS/frame\r\n", spi16 ? 16 : 8, poll_cycles/n/mhz);
+        xprintf("%dbit dma:  return %u uS done %u uS/frame\r\n", spi16 ? 16 : 8, ret_cycles/n/mhz, done_cycles/n/mhz);
+    }
+    lcd_itf_dma_print();
+}
+
+/* 脏块刷新: 几种典型的修改区域, 每种打印发送的字节数和耗时, 最后与整屏对比 */
+static void mlx90642_bench_dirty(int n)
+{
+    static const char* names[] = {"one tile", "hot spot", "two spots", "checker", "full"};
+    uint32_t t0;
+    uint32_t cycles;
+    uint32_t mhz = clock_get_ahb() / 1000000;
+    uint16_t rgb;
+
+    lcd_itf_dirty(1);
+    lcd_itf_sync();
+    lcd_itf_sync_wait();
+    for(int c=0; c<5; c++){
+        cycles = 0;
+        for(int k=0; k<n; k++){
+            rgb = (uint16_t)(k*0x0841u + c);
+            switch(c){
+            case 0:
+                lcd_itf_fill(150, 10, 110, 10, rgb);
+                break;
+            case 1:
+                lcd_itf_fill(100 + (k & 7)*10, 40, 80, 30, rgb);  /* 移动的4x3热点 */
+                break;
+            case 2:
+                lcd_itf_fill(20, 30, 20, 20, rgb);
+                lcd_itf_fill(250, 50, 190, 40, rgb);
+                break;
+            case 3:
+                for(int y=0; y<LCD_VSIZE; y+=10){
+                    for(int x=(y/10 & 1)*10; x<LCD_HSIZE; x+=20){
+                        lcd_itf_fill(x, 10, y, 10, rgb);  /* 一半的块, 与full对比检验窗口开销的估计 */
+                    }
+                }
+                break;
+            default:
+                lcd_itf_fill(0, LCD_HSIZE, 0, LCD_VSIZE, rgb);
+                break;
+            }
+            t0 = clock_get_cycles();
+            lcd_itf_sync();
+            lcd_itf_sync_wait();
+            cycles += clock_get_cycles() - t0;
+        }
+        xprintf("%s: %u uS/frame\r\n", names[c], cycles/n/mhz);
+        lcd_itf_sync_print();
+    }
+}
+
+/* 单缓存(绘制前等上一帧发完)和双缓存(绘制与发送重叠)的帧时间, 每帧所有色块都变化, 整屏发送 */
+static void mlx90642_bench_dbuf(int n)
+{
+    uint32_t t0;
+    uint32_t single_cycles;
+    uint32_t double_cycles;
+    uint32_t render_cycles = 0;
+    uint32_t t1;
+    uint32_t mhz = clock_get_ahb() / 1000000;
+
+    lcd_itf_dma(1);
+    lcd_itf_sync_wait();
+    t0 = clock_get_cycles();
+    for(int k=0; k<n; k++){
+        lcd_itf_sync_wait();
+        t1 = clock_get_cycles();
+        for(int i=0; i<32*24; i++){
+            lcd_itf_fill((i%32)*10, 10, (i/32)*10, 10, (uint16_t)(i*0x0841u + k));
+        }
+        render_cycles += clock_get_cycles() - t1;
+        lcd_itf_sync();
+    }
+    lcd_itf_sync_wait();
+    single_cycles = clock_get_cycles() - t0;
+
+    t0 = clock_get_cycles();
+    for(int k=0; k<n; k++){
+        lcd_itf_frame_begin();
+        for(int i=0; i<32*24; i++){
+            lcd_itf_fill((i%32)*10, 10, (i/32)*10, 10, (uint16_t)(i*0x0841u + k));
+        }
+        lcd_itf_frame_end();
+    }
+    lcd_itf_sync_wait();
+    double_cycles = clock_get_cycles() - t0;
+
+    xprintf("render %u uS/frame\r\n", render_cycles/n/mhz);
+    xprintf("single: %u uS/frame\r\n", single_cycles/n/mhz);
+    xprintf("double: %u uS/frame\r\n", double_cycles/n/mhz);
+    lcd_itf_sync_print();
+}
+
+/**
+ * 整屏32x24放大10倍: SDRAM显存(双缓存)对比内部SRAM行带直接发送, 双线性和色块两种方式.
+ * 每帧温度都变化, 显存方式每帧整屏发送; 打印每帧时间(含发送)和其中CPU绘制的时间
+ */
+static void mlx90642_bench_band(int n)
+{
+    static int16_t temp[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    static uint16_t rgb[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    static int16_t gray[MLX90642_TOTAL_NUMBER_OF_PIXELS] __attribute__((aligned(4)));
+    static mlx90642_scale_st scale;
+    static const char* names[] = {"sdram bilinear", "sram band bilinear", "sdram block", "sram band block"};
+    const uint16_t* lut = mlx90642_palette_lut();
+    uint16_t* buf;
+    uint32_t* line;
+    uint32_t t0;
+    uint32_t t1;
+    uint32_t cycles;
+    uint32_t cpu_cycles;
+    uint32_t mhz = clock_get_ahb() / 1000000;
+    int r0;
+
+    mlx90642_scale_init(&scale, 10);
+    lcd_itf_dma(1);
+    lcd_itf_sync_wait();
+    for(int c=0; c<4; c++){
+        cpu_cycles = 0;
+        t0 = clock_get_cycles();
+        for(int k=0; k<n; k++){
+            for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+                temp[i] = (int16_t)(20*50 + ((i%32 + k)%32)*20 + (i/32)*35);
+            }
+            t1 = clock_get_cycles();
+            if(c < 2){
+                mlx90642_disp_gray(0, temp, gray, 0, MLX90642_TOTAL_NUMBER_OF_PIXELS);
+            }else{
+                temp2rgb(temp, rgb, 0, MLX90642_TOTAL_NUMBER_OF_PIXELS);
+            }
+            if((c & 1) == 0){
+                buf = lcd_itf_frame_begin();
+                if(c == 0){
+                    for(int y=0; y<scale.h; y++){
+                        r0 = scale.row[y];
+                        mlx90642_scale_line(&scale, gray + r0*32, gray + (r0+1)*32, scale.roww[y], lut, (uint32_t*)(buf + y*LCD_HSIZE));
+                    }
+                    lcd_itf_mark(0, LCD_HSIZE, 0, LCD_VSIZE);
+                }else{
+                    for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+                        lcd_itf_fill((i%32)*10, 10, (i/32)*10, 10, rgb[i]);
+                    }
+                }
+                lcd_itf_frame_end();
+            }else{
+                for(int r=0; r<24; r++){
+                    buf = lcd_itf_band_begin(0, LCD_HSIZE, r*10, 10);
+                    if(c == 1){
+                        for(int j=0; j<10; j++){
+                            r0 = scale.row[r*10 + j];
+                            mlx90642_scale_line(&scale, gray + r0*32, gray + (r0+1)*32, scale.roww[r*10 + j], lut, (uint32_t*)(buf + j*LCD_HSIZE));
+                        }
+                    }else{
+                        for(int x=0; x<LCD_HSIZE; x++){
+                            buf[x] = rgb[r*32 + x/10];
+                        }
+                        line = (uint32_t*)buf;
+                        for(int i=LCD_HSIZE/2; i<LCD_HSIZE*10/2; i++){
+                            line[i] = line[i - LCD_HSIZE/2];
+                        }
+                    }
+                    lcd_itf_band_end();
+                }
+            }
+            cpu_cycles += clock_get_cycles() - t1;
+        }
+        lcd_itf_sync_wait();
+        cycles = clock_get_cycles() - t0;
+        xprintf("%s: %u uS/frame, render+submit %u uS/frame\r\n", names[c], cycles/n/mhz, cpu_cycles/n/mhz);
+    }
+    lcd_itf_sync_print();
+}
+
+/**
+ * 显示加速: 整屏填充, 整屏L8转换, 整屏叠加, 32x24放大10倍(CPU查表写显存/CPU只插值后L8转换).
+ * LCD_ITF_LTDC=1时由DMA2D完成, 否则为CPU的等价实现(SPI刷新). 打印每帧时间和其中CPU提交的时间
+ */
+static void mlx90642_bench_dma2d(int n)
+{
+    static int16_t temp[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+    static int16_t gray[MLX90642_TOTAL_NUMBER_OF_PIXELS] __attribute__((aligned(4)));
+    static mlx90642_scale_st scale;
+    static uint8_t l8[2][LCD_HSIZE*10] __attribute__((aligned(4)));   /* DMA2D不能读CCM */
+    static const char* names[] = {"fill", "l8", "blend", "scale rgb565", "scale l8"};
+    const uint16_t* lut = mlx90642_palette_lut();
+    uint16_t* buf;
+    uint8_t* src;
+    uint32_t t0;
+    uint32_t t1;
+    uint32_t cycles;
+    uint32_t cpu_cycles;
+    uint32_t mhz = clock_get_ahb() / 1000000;
+    int idx = 0;
+    int r0;
+
+    mlx90642_scale_init(&scale, 10);
+    for(int i=0; i<LCD_HSIZE*10; i++){
+        l8[0][i] = (uint8_t)(i % LCD_HSIZE);
+        l8[1][i] = (uint8_t)(255 - i % LCD_HSIZE);
+    }
+    lcd_itf_sync_wait();
+    for(int c=0; c<5; c++){
+        cpu_cycles = 0;
+        t0 = clock_get_cycles();
+        for(int k=0; k<n; k++){
+            for(int i=0; i<MLX90642_TOTAL_NUMBER_OF_PIXELS; i++){
+                temp[i] = (int16_t)(20*50 + ((i%32 + k)%32)*20 + (i/32)*35);
+            }
+            mlx90642_disp_gray(0, temp, gray, 0, MLX90642_TOTAL_NUMBER_OF_PIXELS);
+            buf = lcd_itf_frame_begin();
+            t1 = clock_get_cycles();
+            switch(c){
+                case 0:
+                    lcd_itf_fill(0, LCD_HSIZE, 0, LCD_VSIZE, (uint16_t)(k*0x0841u));
+                break;
+                case 1:
+                    for(int r=0; r<24; r++){
+                        lcd_itf_blit_l8(0, LCD_HSIZE, r*10, 10, l8[(r + k) & 1], LCD_HSIZE, lut);
+                    }
+                break;
+                case 2:
+                    for(int r=0; r<24; r++){
+                        lcd_itf_blend(0, LCD_HSIZE, r*10, 10, (const uint16_t*)l8, LCD_HSIZE, 128);
+                    }
+                break;
+                case 3:
+                    for(int y=0; y<scale.h; y++){
+                        r0 = scale.row[y];
+                        mlx90642_scale_line(&scale, gray + r0*32, gray + (r0+1)*32, scale.roww[y], lut, (uint32_t*)(buf + y*LCD_HSIZE));
+                    }
+                    lcd_itf_mark(0, LCD_HSIZE, 0, LCD_VSIZE);
+                break;
+                default:
+                    for(int r=0; r<24; r++){
+                        /* 两个缓存轮流用, 上一次转换启动时再上一次已完成 */
+                        src = l8[idx];
+                        idx ^= 1;
+                        for(int j=0; j<10; j++){
+                            r0 = scale.row[r*10 + j];
+                            mlx90642_scale_line_l8(&scale, gray + r0*32, gray + (r0+1)*32, scale.roww[r*10 + j], (uint32_t*)(src + j*LCD_HSIZE));
+                        }
+                        lcd_itf_blit_l8(0, LCD_HSIZE, r*10, 10, src, LCD_HSIZE, lut);
+                    }
+                break;
+            }
+            cpu_cycles += clock_get_cycles() - t1;
+            lcd_itf_frame_end();
+        }
+        lcd_itf_sync_wait();
+        cycles = clock_get_cycles() - t0;
+        xprintf("%s: %u uS/frame, submit %u uS/frame\r\n", names[c], cycles/n/mhz, cpu_cycles/n/mhz);
+    }
+    lcd_itf_sync_print();
+}
+
+int mlx90642_bench(const char* item, int n)
+{
+    if(n<=0){
+        n=1;
+    }
+    if(strncmp(item, "io", 2) == 0){
+        mlx90642_bench_io(n);
+    }else if(strncmp(item, "sched", 5) == 0){
+        mlx90642_bench_sched(n);
+    }else if(strncmp(item, "cfg", 3) == 0){
+        mlx90642_bench_cfg(n);
+    }else if(strncmp(item, "sim", 3) == 0){
+        mlx90642_bench_sim(n);
+    }else if(strncmp(item, "color", 5) == 0){
+        mlx90642_bench_color(n);
+    }else if(strncmp(item, "stats", 5) == 0){
+        mlx90642_bench_stats(n);
+    }else if(strncmp(item, "heq", 3) == 0){
+        mlx90642_bench_heq(n);
+    }else if(strncmp(item, "scale", 5) == 0){
+        mlx90642_bench_scale(n);
+    }else if(strncmp(item, "filter", 6) == 0){
+        mlx90642_bench_filter(n);
+    }else if(strncmp(item, "median", 6) == 0){
+        mlx90642_bench_median(n);
+    }else if(strncmp(item, "blob", 4) == 0){
+        mlx90642_bench_blob(n);
+    }else if(strncmp(item, "lcddma", 6) == 0){
+        mlx90642_bench_lcddma(n);
+    }else if(strncmp(item, "dirty", 5) == 0){
+        mlx90642_bench_dirty(n);
+    }else if(strncmp(item, "dbuf", 4) == 0){
+        mlx90642_bench_dbuf(n);
+    }else if(strncmp(item, "band", 4) == 0){
+        mlx90642_bench_band(n);
+    }else if(strncmp(item, "dma2d", 5) == 0){
+        mlx90642_bench_dma2d(n);
+    }else{
+        xprintf("unknown item %s\r\n",item);
+        return -1;
     }
     return 0;
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 int mlx90642_test(int n);
+int mlx90642_bench(const char* item, int n);
 
 #ifdef __cplusplus
     }
@@ -49,6 +49,22 @@ void systick_init(void){
 	*ctrl = (1u<<2) | (1u<<1) | (1u<<0);
 }
 
+/**
+ * DWT CYCCNT 内核时钟周期计数器,用于计时和周期级延时
+ */
+void clock_cycle_init(void){
+	volatile uint32_t* demcr = (volatile uint32_t*)0xE000EDFC;
+	volatile uint32_t* dwt_ctrl = (volatile uint32_t*)0xE0001000;
+	volatile uint32_t* dwt_cyccnt = (volatile uint32_t*)0xE0001004;
+	*demcr |= (1u<<24);   /* TRCENA */
+	*dwt_cyccnt = 0;
+	*dwt_ctrl |= (1u<<0); /* CYCCNTENA */
+}
+
+uint32_t clock_get_cycles(void){
+	return *(volatile uint32_t*)0xE0001004;
+}
+
 void systick_deinit(void){
 	volatile uint32_t* ctrl = (volatile uint32_t*)SYSTICK_BASE;
 	*ctrl = 0;
@@ -7,6 +7,8 @@ void tick(void);
 uint32_t get_ticks(void);
 void systick_init(void);
 void systick_deinit(void);
+void clock_cycle_init(void);
+uint32_t clock_get_cycles(void);
 uint32_t clock_get_apb1(void);
 uint32_t clock_get_apb2(void);
 uint32_t clock_get_ahb(void);
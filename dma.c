@@ -1,17 +1,34 @@
 #include <stdint.h>
 #include "dma.h"
+
+#if DMA_SIM
+/* 寄存器在内存中, [0]DMA1 [1]DMA2; 地址寄存器只有32位, 主机上的完整指针另外保存 */
+static uint32_t s_dma_sim_reg[2][0x100/4];
+static uintptr_t s_dma_sim_ptr[2][8];
+static uint32_t s_dma_sim_cnt[2][8];
+#define DMA_SIM_IDX(base)   (((base) >> 10) & 1)
+#define DMA_REG(base, off)  ((volatile uint32_t*)((uint8_t*)s_dma_sim_reg[DMA_SIM_IDX(base)] + (off)))
+#else
+#define DMA_REG(base, off)  ((volatile uint32_t*)((base) + (off)))
+#endif
+
 void dma_dis(uint32_t base, int stream){
-    volatile uint32_t* DMA_SxCR = (volatile uint32_t* )(base+0x10 + 0x18 * stream);
+    volatile uint32_t* DMA_SxCR = DMA_REG(base, 0x10 + 0x18 * stream);
 	*DMA_SxCR = 0;  /* EN=0 */
 }
 
+uint32_t dma_get_cnt(uint32_t base, int stream){
+    volatile uint32_t* DMA_SxNDTR = DMA_REG(base, 0x14 + 0x18 * stream);
+	return *DMA_SxNDTR;  /* 剩余传输数 */
+}
+
 void dma_cfg(uint32_t base, int stream, dma_st* dma_cfg){
-    volatile uint32_t* DMA_SxCR = (volatile uint32_t* )(base+0x10 + 0x18 * stream);
-    volatile uint32_t* DMA_SxNDTR = (volatile uint32_t* )(base+0x14 + 0x18 * stream);
-    volatile uint32_t* DMA_SxPAR = (volatile uint32_t* )(base+0x18 + 0x18 * stream);
-    volatile uint32_t* DMA_SxM0AR = (volatile uint32_t* )(base+0x1C + 0x18 * stream);
-    volatile uint32_t* DMA_SxM1AR = (volatile uint32_t* )(base+0x20 + 0x18 * stream);
-    volatile uint32_t* DMA_SxFCR = (volatile uint32_t* )(base+0x24 + 0x18 * stream);
+    volatile uint32_t* DMA_SxCR = DMA_REG(base, 0x10 + 0x18 * stream);
+    volatile uint32_t* DMA_SxNDTR = DMA_REG(base, 0x14 + 0x18 * stream);
+    volatile uint32_t* DMA_SxPAR = DMA_REG(base, 0x18 + 0x18 * stream);
+    volatile uint32_t* DMA_SxM0AR = DMA_REG(base, 0x1C + 0x18 * stream);
+    volatile uint32_t* DMA_SxM1AR = DMA_REG(base, 0x20 + 0x18 * stream);
+    volatile uint32_t* DMA_SxFCR = DMA_REG(base, 0x24 + 0x18 * stream);
     uint32_t tmp;
     *DMA_SxCR = 0;  /* EN=0 */
 
@@ -43,12 +60,16 @@ void dma_cfg(uint32_t base, int stream, dma_st* dma_cfg){
     ((uint32_t)(dma_cfg->cfg.teie) << 2) | 
     ((uint32_t)(dma_cfg->cfg.dmeie) << 1) | 0x01;
     *DMA_SxCR = tmp;
+#if DMA_SIM
+    s_dma_sim_ptr[DMA_SIM_IDX(base)][stream] = dma_cfg->m0addr;
+    s_dma_sim_cnt[DMA_SIM_IDX(base)][stream] = dma_cfg->cnt;
+#endif
     
 }
 
 void dma_int_flag_clr(uint32_t base, int stream, dma_int_e it){
-    volatile uint32_t* DMA_LIFCR = (volatile uint32_t* )(base+8);
-    volatile uint32_t* DMA_HIFCR = (volatile uint32_t* )(base+0x0C);
+    volatile uint32_t* DMA_LIFCR = DMA_REG(base, 0x08);
+    volatile uint32_t* DMA_HIFCR = DMA_REG(base, 0x0C);
     if(stream <= 3){
         if(stream <= 1){
             *DMA_LIFCR = (1u<<(it+stream*6));
@@ -63,13 +84,20 @@ void dma_int_flag_clr(uint32_t base, int stream, dma_int_e it){
             *DMA_HIFCR = (1u<<(16 + it+(stream-2)*6));
         }
     }
+#if DMA_SIM
+    /* 写IFCR清除ISR中的对应位 */
+    *DMA_REG(base, 0x00) &= ~*DMA_LIFCR;
+    *DMA_REG(base, 0x04) &= ~*DMA_HIFCR;
+    *DMA_LIFCR = 0;
+    *DMA_HIFCR = 0;
+#endif
 
 }
 
 int dma_int_is_set(uint32_t base, int stream, dma_int_e it){
     uint32_t ret;
-    volatile uint32_t* DMA_LISR = (volatile uint32_t* )base;
-    volatile uint32_t* DMA_HISR = (volatile uint32_t* )(base+4);
+    volatile uint32_t* DMA_LISR = DMA_REG(base, 0x00);
+    volatile uint32_t* DMA_HISR = DMA_REG(base, 0x04);
     if(stream <= 3){
         if(stream <= 1){
             ret = *DMA_LISR & (1u<<(it+stream*6));
@@ -90,3 +118,37 @@ int dma_int_is_set(uint32_t base, int stream, dma_int_e it){
         return 0;
     }
 }
+
+#if DMA_SIM
+
+void dma_sim_mem(uint32_t base, int stream, void* mem){
+    s_dma_sim_ptr[DMA_SIM_IDX(base)][stream] = (uintptr_t)mem;
+}
+
+int dma_sim_p2m(uint32_t base, int stream, uint32_t data){
+    volatile uint32_t* DMA_SxCR = DMA_REG(base, 0x10 + 0x18 * stream);
+    volatile uint32_t* DMA_SxNDTR = DMA_REG(base, 0x14 + 0x18 * stream);
+    volatile uint32_t* DMA_xISR = DMA_REG(base, (stream <= 3) ? 0x00 : 0x04);
+    uint32_t cr = *DMA_SxCR;
+    uint32_t msize = (cr >> 13) & 0x03;
+    uint32_t done;
+    uint8_t* mem;
+    int s = stream & 0x03;
+    if(((cr & 0x01) == 0) || (((cr >> 6) & 0x03) != DMA_DIR_P2M) || (*DMA_SxNDTR == 0)){
+        return -1;
+    }
+    done = s_dma_sim_cnt[DMA_SIM_IDX(base)][stream] - *DMA_SxNDTR;
+    mem = (uint8_t*)s_dma_sim_ptr[DMA_SIM_IDX(base)][stream] + (((cr >> 10) & 0x01) ? (done << msize) : 0);
+    for(uint32_t i=0; i<(1u << msize); i++){
+        mem[i] = (uint8_t)(data >> (8*i));
+    }
+    *DMA_SxNDTR -= 1;
+    if(*DMA_SxNDTR == 0){
+        /* 传输完成: EN清零, TCIF置位 */
+        *DMA_SxCR = cr & ~0x01u;
+        *DMA_xISR |= 1u << (DMA_INT_TC + ((s <= 1) ? s*6 : 16 + (s-2)*6));
+    }
+    return 0;
+}
+
+#endif
@@ -3,6 +3,14 @@
 
 #include <stdint.h>
 
+/**
+ * 用-DDMA_SIM=1编译时寄存器是内存中的数组, 不访问硬件, 可以在主机上编译:
+ * 外设的仿真用dma_sim_p2m代替硬件请求, 按数据流的配置写存储器, 完成时置位TCIF
+ */
+#ifndef DMA_SIM
+#define DMA_SIM 0
+#endif
+
 typedef enum{
     DMA_FIFO_FTH_1_4=0, /**<  00: 1/4 full FIFO */
     DMA_FIFO_FTH_1_2=1, /**<  01: 1/2 full FIFO */
@@ -117,7 +125,25 @@ typedef struct dma{
 
 void dma_cfg(uint32_t base, int stream, dma_st* dma_cfg);
 void dma_dis(uint32_t base, int stream);
+uint32_t dma_get_cnt(uint32_t base, int stream);
 void dma_int_flag_clr(uint32_t base, int stream, dma_int_e it);
 int dma_int_is_set(uint32_t base, int stream, dma_int_e it);
 
+#if DMA_SIM
+/**
+ * \fn dma_sim_mem
+ * 设置存储器0的完整地址, 在dma_cfg之后调用(主机上指针超过32位)
+*/
+void dma_sim_mem(uint32_t base, int stream, void* mem);
+
+/**
+ * \fn dma_sim_p2m
+ * 外设请求一次外设到存储器的传输
+ * \param[in] data 外设数据寄存器的值, 按MSIZE写入存储器
+ * \retval 0 已传输
+ * \retval -1 数据流未使能, 方向不对或已传输完
+*/
+int dma_sim_p2m(uint32_t base, int stream, uint32_t data);
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include <stdint.h>
+#include "dma2d.h"
+
+#if !DMA2D_SIM
+#include "stm32f4_regs.h"
+#endif
+
+#define DMA2D_CR        0x00
+#define DMA2D_ISR       0x04
+#define DMA2D_IFCR      0x08
+#define DMA2D_FGMAR     0x0C
+#define DMA2D_FGOR      0x10
+#define DMA2D_BGMAR     0x14
+#define DMA2D_BGOR      0x18
+#define DMA2D_FGPFCCR   0x1C
+#define DMA2D_FGCOLR    0x20
+#define DMA2D_BGPFCCR   0x24
+#define DMA2D_BGCOLR    0x28
+#define DMA2D_FGCMAR    0x2C
+#define DMA2D_BGCMAR    0x30
+#define DMA2D_OPFCCR    0x34
+#define DMA2D_OCOLR     0x38
+#define DMA2D_OMAR      0x3C
+#define DMA2D_OOR       0x40
+#define DMA2D_NLR       0x44
+
+#define DMA2D_CR_START        (1u<<0)
+#define DMA2D_CR_MODE_SHIFT   16
+#define DMA2D_ISR_TEIF        (1u<<0)
+#define DMA2D_ISR_TCIF        (1u<<1)
+#define DMA2D_ISR_CEIF        (1u<<5)
+#define DMA2D_IFCR_ALL        0x3Fu
+#define DMA2D_PFCCR_CCM_RGB888 (1u<<4)
+#define DMA2D_PFCCR_START     (1u<<5)
+#define DMA2D_PFCCR_CS_SHIFT  8
+#define DMA2D_PFCCR_AM_REPLACE (1u<<16)
+#define DMA2D_PFCCR_ALPHA_SHIFT 24
+
+#if DMA2D_SIM
+
+/* 寄存器在内存中, 地址寄存器只有32位, 主机上的完整指针另外保存 */
+static uint32_t s_dma2d_sim_reg[0x100/4];
+static uintptr_t s_dma2d_sim_ptr[0x100/4];
+static uint32_t s_dma2d_sim_clut[256];
+static dma2d_op_st s_dma2d_sim_log[DMA2D_SIM_LOG_MAX];
+static uint32_t s_dma2d_sim_num;
+static uint32_t s_dma2d_sim_clut_loads;
+
+#define DMA2D_REG(off)          (*(volatile uint32_t*)((uint8_t*)s_dma2d_sim_reg + (off)))
+#define DMA2D_ADDR(off, p)      do{ s_dma2d_sim_ptr[(off)/4] = (uintptr_t)(p); DMA2D_REG(off) = (uint32_t)(uintptr_t)(p); }while(0)
+
+static void dma2d_sim_start(void);
+static void dma2d_sim_clut_load(void);
+
+#else
+
+#define DMA2D_BASE      0x4002B000ul
+#define DMA2D_REG(off)          (*(volatile uint32_t*)(DMA2D_BASE + (off)))
+#define DMA2D_ADDR(off, p)      (DMA2D_REG(off) = (uint32_t)(p))
+
+#endif
+
+static const uint32_t* s_dma2d_clut;
+static uint32_t s_dma2d_ops;
+static uint32_t s_dma2d_pixels;
+static uint32_t s_dma2d_errs;
+
+int dma2d_busy(void){
+    return (DMA2D_REG(DMA2D_CR) & DMA2D_CR_START) ? 1 : 0;
+}
+
+void dma2d_wait(void){
+    while(DMA2D_REG(DMA2D_CR) & DMA2D_CR_START);
+    /* CLUT加载也要等完, 之后才能改调色板内容 */
+    while(DMA2D_REG(DMA2D_FGPFCCR) & DMA2D_PFCCR_START);
+    if(DMA2D_REG(DMA2D_ISR) & (DMA2D_ISR_TEIF | DMA2D_ISR_CEIF)){
+        s_dma2d_errs++;
+    }
+    DMA2D_REG(DMA2D_IFCR) = DMA2D_IFCR_ALL;
+}
+
+/* 设置尺寸和输出, 启动 */
+static void dma2d_start(uint32_t mode, uint16_t* dst, uint32_t dst_stride, uint32_t w, uint32_t h){
+    DMA2D_ADDR(DMA2D_OMAR, dst);
+    DMA2D_REG(DMA2D_OOR) = dst_stride - w;
+    DMA2D_REG(DMA2D_NLR) = (w << 16) | h;
+    DMA2D_REG(DMA2D_CR) = (mode << DMA2D_CR_MODE_SHIFT) | DMA2D_CR_START;
+    s_dma2d_ops++;
+    s_dma2d_pixels += w*h;
+#if DMA2D_SIM
+    dma2d_sim_start();
+#endif
+}
+
+void dma2d_init(void){
+#if !DMA2D_SIM
+    volatile uint32_t *RCC_AHB1ENR = (void *)(RCC_BASE + 0x30);
+    *RCC_AHB1ENR |= (1u<<23); /* DMA2D */
+    (void)*RCC_AHB1ENR;
+#endif
+    DMA2D_REG(DMA2D_CR) = 0;
+    DMA2D_REG(DMA2D_IFCR) = DMA2D_IFCR_ALL;
+    DMA2D_REG(DMA2D_OPFCCR) = DMA2D_CM_RGB565;
+    s_dma2d_clut = 0;
+}
+
+void dma2d_fill(uint16_t* dst, uint32_t stride, uint32_t w, uint32_t h, uint16_t rgb565){
+    if((w == 0) || (h == 0)){
+        return;
+    }
+    dma2d_wait();
+    DMA2D_REG(DMA2D_OCOLR) = rgb565;
+    dma2d_start(DMA2D_MODE_R2M, dst, stride, w, h);
+}
+
+void dma2d_copy(uint16_t* dst, uint32_t dst_stride, const uint16_t* src, uint32_t src_stride, uint32_t w, uint32_t h){
+    if((w == 0) || (h == 0)){
+        return;
+    }
+    dma2d_wait();
+    DMA2D_ADDR(DMA2D_FGMAR, src);
+    DMA2D_REG(DMA2D_FGOR) = src_stride - w;
+    DMA2D_REG(DMA2D_FGPFCCR) = DMA2D_CM_RGB565;
+    dma2d_start(DMA2D_MODE_M2M, dst, dst_stride, w, h);
+}
+
+void dma2d_clut(const uint32_t* clut, int reload){
+    if((clut == s_dma2d_clut) && !reload){
+        return;
+    }
+    dma2d_wait();
+    DMA2D_ADDR(DMA2D_FGCMAR, clut);
+    /* 自动加载256项RGB888, 与后续操作串行 */
+    DMA2D_REG(DMA2D_FGPFCCR) = DMA2D_CM_L8 | DMA2D_PFCCR_CCM_RGB888 | (255u << DMA2D_PFCCR_CS_SHIFT) | DMA2D_PFCCR_START;
+    s_dma2d_clut = clut;
+#if DMA2D_SIM
+    dma2d_sim_clut_load();
+#endif
+}
+
+void dma2d_l8(uint16_t* dst, uint32_t dst_stride, const uint8_t* src, uint32_t src_stride, uint32_t w, uint32_t h){
+    if((w == 0) || (h == 0)){
+        return;
+    }
+    dma2d_wait();
+    DMA2D_ADDR(DMA2D_FGMAR, src);
+    DMA2D_REG(DMA2D_FGOR) = src_stride - w;
+    DMA2D_REG(DMA2D_FGPFCCR) = DMA2D_CM_L8 | DMA2D_PFCCR_CCM_RGB888 | (255u << DMA2D_PFCCR_CS_SHIFT);
+    dma2d_start(DMA2D_MODE_M2M_PFC, dst, dst_stride, w, h);
+}
+
+void dma2d_blend(uint16_t* dst, uint32_t dst_stride, const uint16_t* fg, uint32_t fg_stride, uint32_t w, uint32_t h, uint8_t alpha){
+    if((w == 0) || (h == 0)){
+        return;
+    }
+    dma2d_wait();
+    DMA2D_ADDR(DMA2D_FGMAR, fg);
+    DMA2D_REG(DMA2D_FGOR) = fg_stride - w;
+    DMA2D_REG(DMA2D_FGPFCCR) = DMA2D_CM_RGB565 | DMA2D_PFCCR_AM_REPLACE | ((uint32_t)alpha << DMA2D_PFCCR_ALPHA_SHIFT);
+    DMA2D_ADDR(DMA2D_BGMAR, dst);
+    DMA2D_REG(DMA2D_BGOR) = dst_stride - w;
+    DMA2D_REG(DMA2D_BGPFCCR) = DMA2D_CM_RGB565;
+    dma2d_start(DMA2D_MODE_M2M_BLEND, dst, dst_stride, w, h);
+}
+
+void dma2d_stat(uint32_t* ops, uint32_t* pixels, uint32_t* errs){
+    if(ops){
+        *ops = s_dma2d_ops;
+    }
+    if(pixels){
+        *pixels = s_dma2d_pixels;
+    }
+    if(errs){
+        *errs = s_dma2d_errs;
+    }
+}
+
+#if DMA2D_SIM
+
+const dma2d_op_st* dma2d_sim_log(uint32_t* num){
+    if(num){
+        *num = s_dma2d_sim_num;
+    }
+    return s_dma2d_sim_log;
+}
+
+uint32_t dma2d_sim_clut_loads(void){
+    return s_dma2d_sim_clut_loads;
+}
+
+void dma2d_sim_clear(void){
+    s_dma2d_sim_num = 0;
+    s_dma2d_sim_clut_loads = 0;
+}
+
+static void dma2d_sim_clut_load(void){
+    const uint32_t* p = (const uint32_t*)s_dma2d_sim_ptr[DMA2D_FGCMAR/4];
+    uint32_t n = ((DMA2D_REG(DMA2D_FGPFCCR) >> DMA2D_PFCCR_CS_SHIFT) & 0xFF) + 1;
+    for(uint32_t i=0; i<n; i++){
+        s_dma2d_sim_clut[i] = p[i];
+    }
+    DMA2D_REG(DMA2D_FGPFCCR) &= ~DMA2D_PFCCR_START;
+    s_dma2d_sim_clut_loads++;
+}
+
+static uint16_t dma2d_sim_888to565(uint32_t c){
+    return (uint16_t)(((c >> 8) & 0xF800) | ((c >> 5) & 0x07E0) | ((c >> 3) & 0x001F));
+}
+
+/* RGB565一个分量按透明度混合, 硬件在8位上算, 结果可能差1 */
+static uint32_t dma2d_sim_mix(uint32_t f, uint32_t b, uint32_t a){
+    return (f*a + b*(255 - a) + 127) / 255;
+}
+
+/* 按寄存器的值解码, 记录, 用软件执行 */
+static void dma2d_sim_start(void){
+    dma2d_op_st* op = &s_dma2d_sim_log[s_dma2d_sim_num % DMA2D_SIM_LOG_MAX];
+    uint32_t fgpfccr = DMA2D_REG(DMA2D_FGPFCCR);
+    uint16_t* out;
+    const uint8_t* fg8;
+    const uint16_t* fg;
+    const uint16_t* bg;
+    uint32_t f;
+    uint32_t b;
+    uint32_t a;
+
+    op->mode = (DMA2D_REG(DMA2D_CR) >> DMA2D_CR_MODE_SHIFT) & 3;
+    op->fg_cm = fgpfccr & 0xF;
+    op->alpha = fgpfccr >> DMA2D_PFCCR_ALPHA_SHIFT;
+    op->w = DMA2D_REG(DMA2D_NLR) >> 16;
+    op->h = DMA2D_REG(DMA2D_NLR) & 0xFFFF;
+    op->fg_off = DMA2D_REG(DMA2D_FGOR);
+    op->bg_off = DMA2D_REG(DMA2D_BGOR);
+    op->out_off = DMA2D_REG(DMA2D_OOR);
+    op->color = DMA2D_REG(DMA2D_OCOLR);
+    op->fg = (op->mode == DMA2D_MODE_R2M) ? 0 : s_dma2d_sim_ptr[DMA2D_FGMAR/4];
+    op->bg = (op->mode == DMA2D_MODE_M2M_BLEND) ? s_dma2d_sim_ptr[DMA2D_BGMAR/4] : 0;
+    op->out = s_dma2d_sim_ptr[DMA2D_OMAR/4];
+    s_dma2d_sim_num++;
+
+    out = (uint16_t*)op->out;
+    fg = (const uint16_t*)op->fg;
+    fg8 = (const uint8_t*)op->fg;
+    bg = (const uint16_t*)op->bg;
+    for(uint32_t y=0; y<op->h; y++){
+        for(uint32_t x=0; x<op->w; x++){
+            switch(op->mode){
+                case DMA2D_MODE_R2M:
+                    *out = op->color;
+                break;
+                case DMA2D_MODE_M2M:
+                    *out = *fg++;
+                break;
+                case DMA2D_MODE_M2M_PFC:
+                    if(op->fg_cm == DMA2D_CM_L8){
+                        *out = dma2d_sim_888to565(s_dma2d_sim_clut[*fg8++]);
+                    }else{
+                        *out = *fg++;
+                    }
+                break;
+                default:
+                    f = *fg++;
+                    b = *bg++;
+                    a = op->alpha;
+                    *out = (uint16_t)((dma2d_sim_mix(f >> 11, b >> 11, a) << 11)
+                                    | (dma2d_sim_mix((f >> 5) & 0x3F, (b >> 5) & 0x3F, a) << 5)
+                                    | dma2d_sim_mix(f & 0x1F, b & 0x1F, a));
+                break;
+            }
+            out++;
+        }
+        out += op->out_off;
+        if(op->fg){
+            fg += op->fg_off;
+            fg8 += op->fg_off;
+        }
+        if(op->bg){
+            bg += op->bg_off;
+        }
+    }
+    DMA2D_REG(DMA2D_CR) &= ~DMA2D_CR_START;
+    DMA2D_REG(DMA2D_ISR) |= DMA2D_ISR_TCIF;
+}
+
+#endif
@@ -0,0 +1,163 @@
+#ifndef DMA2D_H
+#define DMA2D_H
+
+#ifdef __cplusplus
+    extern "C"{
+#endif
+
+#include <stdint.h>
+
+/**
+ * DMA2D(Chrom-ART)驱动, 只用于RGB565输出: 区域填充, 区域复制, L8查表转换, 恒定透明度叠加.
+ * 每次操作启动后立即返回, 下一次操作(或dma2d_wait)前等待上一次完成;
+ * CPU访问DMA2D正在写的区域前需调用dma2d_wait.
+ * DMA2D不能访问CCM, 源和目的都应在SRAM或SDRAM.
+ *
+ * 用-DDMA2D_SIM=1编译时寄存器是内存中的数组, 不访问硬件, 可以在主机上编译:
+ * 启动时按寄存器的值解码出操作记录下来, 并用软件执行, 用于在没有硬件时检查编程的操作.
+ */
+
+#ifndef DMA2D_SIM
+#define DMA2D_SIM 0
+#endif
+
+#define DMA2D_MODE_M2M        0   /**< 存储器到存储器          */
+#define DMA2D_MODE_M2M_PFC    1   /**< 存储器到存储器并转换格式  */
+#define DMA2D_MODE_M2M_BLEND  2   /**< 前景和背景混合           */
+#define DMA2D_MODE_R2M        3   /**< 寄存器(颜色)到存储器     */
+
+#define DMA2D_CM_ARGB8888     0
+#define DMA2D_CM_RGB888       1
+#define DMA2D_CM_RGB565       2
+#define DMA2D_CM_L8           5
+
+/**
+ * 一次操作(仿真时从寄存器解码)
+ */
+typedef struct{
+    uint8_t mode;           /**< DMA2D_MODE_xxx                */
+    uint8_t fg_cm;          /**< 前景格式 DMA2D_CM_xxx          */
+    uint8_t alpha;          /**< 前景恒定透明度(混合时)          */
+    uint16_t w;             /**< 每行点数                       */
+    uint16_t h;             /**< 行数                           */
+    uint16_t fg_off;        /**< 前景行尾跳过的点数             */
+    uint16_t bg_off;
+    uint16_t out_off;
+    uint16_t color;         /**< 填充颜色RGB565                 */
+    uintptr_t fg;           /**< 前景地址                       */
+    uintptr_t bg;           /**< 背景地址                       */
+    uintptr_t out;          /**< 输出地址                       */
+} dma2d_op_st;
+
+/**
+ * \fn dma2d_init
+ * 打开时钟, 输出格式设为RGB565
+*/
+void dma2d_init(void);
+
+/**
+ * \fn dma2d_fill
+ * 区域填充
+ * \param[out] dst 区域左上角
+ * \param[in] stride 目的一行的点数
+ * \param[in] w 宽度
+ * \param[in] h 高度
+ * \param[in] rgb565 颜色
+*/
+void dma2d_fill(uint16_t* dst, uint32_t stride, uint32_t w, uint32_t h, uint16_t rgb565);
+
+/**
+ * \fn dma2d_copy
+ * RGB565区域复制
+ * \param[out] dst 目的区域左上角
+ * \param[in] dst_stride 目的一行的点数
+ * \param[in] src 源区域左上角
+ * \param[in] src_stride 源一行的点数
+ * \param[in] w 宽度
+ * \param[in] h 高度
+*/
+void dma2d_copy(uint16_t* dst, uint32_t dst_stride, const uint16_t* src, uint32_t src_stride, uint32_t w, uint32_t h);
+
+/**
+ * \fn dma2d_clut
+ * 设置L8转换用的调色板, 与上次的地址相同时不重新加载
+ * \param[in] clut 256个RGB888(0x00RRGGBB), 在SRAM中, 操作完成前不能修改
+ * \param[in] reload 1内容已修改, 强制重新加载
+*/
+void dma2d_clut(const uint32_t* clut, int reload);
+
+/**
+ * \fn dma2d_l8
+ * L8索引按调色板转换为RGB565
+ * \param[out] dst 目的区域左上角
+ * \param[in] dst_stride 目的一行的点数
+ * \param[in] src 索引区域左上角
+ * \param[in] src_stride 源一行的点数
+ * \param[in] w 宽度
+ * \param[in] h 高度
+*/
+void dma2d_l8(uint16_t* dst, uint32_t dst_stride, const uint8_t* src, uint32_t src_stride, uint32_t w, uint32_t h);
+
+/**
+ * \fn dma2d_blend
+ * 前景RGB565以恒定透明度叠加到目的区域: dst = (fg*alpha + dst*(255-alpha))/255
+ * \param[in,out] dst 目的(背景)区域左上角
+ * \param[in] dst_stride 目的一行的点数
+ * \param[in] fg 前景区域左上角
+ * \param[in] fg_stride 前景一行的点数
+ * \param[in] w 宽度
+ * \param[in] h 高度
+ * \param[in] alpha 0~255
+*/
+void dma2d_blend(uint16_t* dst, uint32_t dst_stride, const uint16_t* fg, uint32_t fg_stride, uint32_t w, uint32_t h, uint8_t alpha);
+
+/**
+ * \fn dma2d_busy
+ * \retval 1 操作进行中
+ * \retval 0 空闲
+*/
+int dma2d_busy(void);
+
+/**
+ * \fn dma2d_wait
+ * 等待操作完成
+*/
+void dma2d_wait(void);
+
+/**
+ * \fn dma2d_stat
+ * 获取统计
+ * \param[out] ops 操作次数
+ * \param[out] pixels 输出的点数
+ * \param[out] errs 传输错误次数
+*/
+void dma2d_stat(uint32_t* ops, uint32_t* pixels, uint32_t* errs);
+
+#if DMA2D_SIM
+/**
+ * \fn dma2d_sim_log
+ * 获取仿真记录的操作
+ * \param[out] num 记录数, 超过记录长度后循环覆盖, 为总操作次数
+ * \return 记录数组, 第i次操作在[i % DMA2D_SIM_LOG_MAX]
+*/
+#define DMA2D_SIM_LOG_MAX 64
+const dma2d_op_st* dma2d_sim_log(uint32_t* num);
+
+/**
+ * \fn dma2d_sim_clut_loads
+ * \return 仿真执行的CLUT加载次数
+*/
+uint32_t dma2d_sim_clut_loads(void);
+
+/**
+ * \fn dma2d_sim_clear
+ * 清除记录和CLUT加载次数
+*/
+void dma2d_sim_clear(void);
+#endif
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
@@ -27,6 +27,23 @@ void gpio_set_alt(void *base, char bank, uint8_t port, uint8_t otype, uint8_t os
 void gpio_set_fmc(void *base, char bank, uint8_t port);
 void gpio_set_qspi(void *base, char bank, uint8_t port, uint8_t altfunc, uint8_t pupd);
 void gpio_set_usart(void *base, char bank, uint8_t port, uint8_t altfunc);
-void gpio_write(void *base, char bank, uint8_t port, uint8_t val);
-uint8_t gpio_read(void *base, char bank, uint8_t port);
+
+/* 参数为常量时编译期算出寄存器地址,内联后只有一次BSRR写/IDR读 */
+static inline void gpio_write(void *base, char bank, uint8_t port, uint8_t val)
+{
+	volatile uint32_t *GPIOx_base    = (base + (bank - 'A') * 0x400);
+	volatile uint32_t *GPIOx_BSRR    = (void *)GPIOx_base + 0x18;
+	if(val){
+		*GPIOx_BSRR = 1u<<port;
+	}else{
+		*GPIOx_BSRR = 1u<<(port+16);
+	}
+}
+
+static inline uint8_t gpio_read(void *base, char bank, uint8_t port)
+{
+	volatile uint32_t *GPIOx_base    = (base + (bank - 'A') * 0x400);
+	volatile uint32_t *GPIOx_IDR    = (void *)GPIOx_base + 0x10;
+	return (*GPIOx_IDR >>port);
+}
 #endif /* _GPIO_H */
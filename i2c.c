@@ -0,0 +1,628 @@
+#include "stm32f4_regs.h"
+#include "gpio.h"
+#include "clock.h"
+#include "dma.h"
+#include "i2c.h"
+#if I2C_SIM
+#include <string.h>
+#endif
+
+#define I2C_CR1       0x00
+#define I2C_CR2       0x04
+#define I2C_DR        0x10
+#define I2C_SR1       0x14
+#define I2C_SR2       0x18
+#define I2C_CCR       0x1C
+#define I2C_TRISE     0x20
+
+#define I2C_CR1_PE    (1u<<0)
+#define I2C_CR1_START (1u<<8)
+#define I2C_CR1_STOP  (1u<<9)
+#define I2C_CR1_ACK   (1u<<10)
+#define I2C_CR1_SWRST (1u<<15)
+#define I2C_CR2_DMAEN (1u<<11)
+#define I2C_CR2_LAST  (1u<<12)
+#define I2C_SR1_SB    (1u<<0)
+#define I2C_SR1_ADDR  (1u<<1)
+#define I2C_SR1_BTF   (1u<<2)
+#define I2C_SR1_RXNE  (1u<<6)
+#define I2C_SR1_TXE   (1u<<7)
+#define I2C_SR1_BERR  (1u<<8)
+#define I2C_SR1_ARLO  (1u<<9)
+#define I2C_SR1_AF    (1u<<10)
+#define I2C_CCR_FS    (1u<<15)
+#define I2C_CCR_DUTY  (1u<<14)
+
+#define I2C_DMA_BASE  0x40026000ul /* DMA1 */
+#define I2C_TIMEOUT   100000ul     /* 等待标志的最大查询次数 */
+
+static uint32_t reg_base[3]={0x40005400,0x40005800,0x40005C00};
+static const uint8_t s_dma_stream[3]={0,2,2};  /* I2Cx_RX对应的DMA1数据流 */
+static const uint8_t s_dma_chsel[3]={1,7,3};   /* I2Cx_RX对应的DMA1通道   */
+static uint32_t s_rx_len[3];                   /* 当前接收长度,>=2表示DMA进行中 */
+static uint32_t s_speed[3];                    /* 恢复总线后重新初始化用 */
+
+#if I2C_SIM
+#if !DMA_SIM
+#error "I2C_SIM需要DMA_SIM"
+#endif
+#define I2C_SIM_PCLK  45000000ul
+static uint32_t i2c_sim_rd(int id, uint32_t off);
+static void i2c_sim_wr(int id, uint32_t off, uint32_t val);
+static void i2c_sim_event(int id, uint8_t type, uint8_t data, uint8_t ack);
+#define I2C_RD(id, off)       i2c_sim_rd(id, off)
+#define I2C_WR(id, off, val)  i2c_sim_wr(id, off, val)
+#else
+#define I2C_REG(id, off)      (*(volatile uint32_t*)(reg_base[(id)-1] + (off)))
+#define I2C_RD(id, off)       I2C_REG(id, off)
+#define I2C_WR(id, off, val)  (I2C_REG(id, off) = (val))
+#endif
+#define I2C_SET(id, off, bits)  I2C_WR(id, off, I2C_RD(id, off) | (bits))
+#define I2C_CLR(id, off, bits)  I2C_WR(id, off, I2C_RD(id, off) & ~(bits))
+
+/**
+ * 等待SR1指定标志置位
+ * 收到NACK或者超时时产生STOP释放总线
+ */
+static int i2c_wait_sr1(int id, uint32_t mask)
+{
+	uint32_t timeout = I2C_TIMEOUT;
+	uint32_t sr;
+	while(timeout--){
+		sr = I2C_RD(id, I2C_SR1);
+		if(sr & mask){
+			return 0;
+		}
+		if(sr & I2C_SR1_AF){
+			I2C_WR(id, I2C_SR1, ~I2C_SR1_AF);  /* 写0清除 */
+			I2C_SET(id, I2C_CR1, I2C_CR1_STOP);
+			return -2;
+		}
+	}
+	I2C_SET(id, I2C_CR1, I2C_CR1_STOP);
+	return -3;
+}
+
+/**
+ * 产生START并发送地址,返回时已清除ADDR(clr_addr=1)
+ */
+static int i2c_start(int id, uint8_t addr_rw, int clr_addr)
+{
+	uint32_t timeout = I2C_TIMEOUT;
+	int res;
+	/* 上一次的STOP还未发出 */
+	while((I2C_RD(id, I2C_CR1) & I2C_CR1_STOP) && timeout){
+		timeout--;
+	}
+	I2C_SET(id, I2C_CR1, I2C_CR1_START);
+	res = i2c_wait_sr1(id, I2C_SR1_SB);  /* 读SR1后写DR清除SB */
+	if(res != 0){
+		return res;
+	}
+	I2C_WR(id, I2C_DR, addr_rw);
+	res = i2c_wait_sr1(id, I2C_SR1_ADDR);
+	if(res != 0){
+		return res;
+	}
+	if(clr_addr){
+		(void)I2C_RD(id, I2C_SR1);  /* 先读SR1再读SR2清除ADDR */
+		(void)I2C_RD(id, I2C_SR2);
+	}
+	return 0;
+}
+
+void i2c_init(int id, i2c_cfg_st* cfg)
+{
+#if I2C_SIM
+	uint32_t pclk = I2C_SIM_PCLK;
+#else
+	volatile uint32_t *RCC_AHB1ENR = (void *)(RCC_BASE + 0x30);
+	volatile uint32_t *RCC_APB1RSTR = (void *)(RCC_BASE + 0x20);
+	volatile uint32_t *RCC_APB1ENR = (void *)(RCC_BASE + 0x40);
+	uint32_t pclk = clock_get_apb1();
+#endif
+	uint32_t mhz = pclk / 1000000ul;
+	uint32_t div;
+
+	s_speed[id-1] = cfg->speed;
+#if !I2C_SIM
+	switch(id){
+		case 3:
+			/**
+			 * PA8 I2C3_SCL AF4 开漏
+			 * PC9 I2C3_SDA AF4 开漏
+			 */
+			*RCC_AHB1ENR |= (1u<<0); /* GPIOA */
+			*RCC_AHB1ENR |= (1u<<2); /* GPIOC */
+			gpio_set_alt((void*)GPIOA_BASE, 'A', 8, 1, GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP, 0x4);
+			gpio_set_alt((void*)GPIOA_BASE, 'C', 9, 1, GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP, 0x4);
+		break;
+	}
+
+	/* I2C时钟使能并复位 APB1ENR bit21~23 */
+	*RCC_APB1ENR |= (1u<<(20+id));
+	*RCC_APB1RSTR |= (1u<<(20+id));
+	*RCC_APB1RSTR &= ~(1u<<(20+id));
+	/* DMA1时钟 */
+	*RCC_AHB1ENR |= (1u<<21);
+#endif
+
+	I2C_WR(id, I2C_CR1, 0);
+	I2C_WR(id, I2C_CR2, mhz & 0x3F);  /* FREQ[5:0] PCLK1 MHz */
+	if(cfg->speed <= 100000ul){
+		/* 标准模式 Thigh=Tlow=CCR*Tpclk, tr(max)=1000nS */
+		div = (pclk + 2*cfg->speed - 1) / (2*cfg->speed);
+		if(div < 4){
+			div = 4;
+		}
+		I2C_WR(id, I2C_CCR, div);
+		I2C_WR(id, I2C_TRISE, mhz + 1);
+	}else if(cfg->speed <= 400000ul){
+		/* 快速模式 DUTY=0 Tlow/Thigh=2, tr(max)=300nS */
+		div = (pclk + 3*cfg->speed - 1) / (3*cfg->speed);
+		if(div < 1){
+			div = 1;
+		}
+		I2C_WR(id, I2C_CCR, I2C_CCR_FS | div);
+		I2C_WR(id, I2C_TRISE, mhz*300/1000 + 1);
+	}else{
+		/**
+		 * FM+ 手册规定F4的I2C最大400K,这里按DUTY=1 Tlow/Thigh=16/9分频,
+		 * PCLK1=45M时1M实际为900K, 需要足够强的上拉保证tr(max)=120nS
+		 */
+		div = (pclk + 25*cfg->speed - 1) / (25*cfg->speed);
+		if(div < 1){
+			div = 1;
+		}
+		I2C_WR(id, I2C_CCR, I2C_CCR_FS | I2C_CCR_DUTY | div);
+		I2C_WR(id, I2C_TRISE, mhz*120/1000 + 1);
+	}
+	I2C_WR(id, I2C_CR1, I2C_CR1_PE);
+}
+
+int i2c_write(int id, uint8_t addr, uint8_t* buffer, uint32_t len, int stop)
+{
+	int res;
+
+	res = i2c_start(id, (uint8_t)(addr<<1), 1);
+	if(res != 0){
+		return res;
+	}
+	for(uint32_t i=0; i<len; i++){
+		res = i2c_wait_sr1(id, I2C_SR1_TXE);
+		if(res != 0){
+			return res;
+		}
+		I2C_WR(id, I2C_DR, buffer[i]);
+	}
+	res = i2c_wait_sr1(id, I2C_SR1_BTF);  /* 最后一个字节发送完 */
+	if(res != 0){
+		return res;
+	}
+	if(stop){
+		I2C_SET(id, I2C_CR1, I2C_CR1_STOP);
+	}
+	return 0;
+}
+
+int i2c_read_dma(int id, uint8_t addr, uint8_t* buffer, uint32_t len)
+{
+	int stream = s_dma_stream[id-1];
+	int res;
+
+	s_rx_len[id-1] = 0;
+	if(len == 0){
+		return 0;
+	}
+	if(len == 1){
+		/* 单字节: 清ADDR前关ACK,清ADDR后立即STOP */
+		I2C_CLR(id, I2C_CR1, I2C_CR1_ACK);
+		res = i2c_start(id, (uint8_t)((addr<<1) | 0x01), 0);
+		if(res != 0){
+			return res;
+		}
+		(void)I2C_RD(id, I2C_SR1);
+		(void)I2C_RD(id, I2C_SR2);
+		I2C_SET(id, I2C_CR1, I2C_CR1_STOP);
+		res = i2c_wait_sr1(id, I2C_SR1_RXNE);
+		if(res != 0){
+			return res;
+		}
+		buffer[0] = (uint8_t)I2C_RD(id, I2C_DR);
+		return 0;
+	}
+
+	dma_int_flag_clr(I2C_DMA_BASE, stream, DMA_INT_TC);
+	dma_int_flag_clr(I2C_DMA_BASE, stream, DMA_INT_HT);
+	dma_int_flag_clr(I2C_DMA_BASE, stream, DMA_INT_TE);
+	dma_int_flag_clr(I2C_DMA_BASE, stream, DMA_INT_MDE);
+	dma_int_flag_clr(I2C_DMA_BASE, stream, DMA_INT_FE);
+	dma_st dma = {
+		.cfg = {
+			.chsel = s_dma_chsel[id-1],
+			.pl = DMA_PL_HIGH,
+			.psize = DMA_PSIZE_BYTE,
+			.msize = DMA_MSIZE_BYTE,
+			.minc = DMA_MINC_MSIZE,
+			.pinc = DMA_PINC_FIXED,
+			.dir = DMA_DIR_P2M,
+			.pfctrl = DMA_PFCTRL_DMA,
+		},
+		.cnt = len,
+		.paddr = reg_base[id-1] + 0x10,
+		.m0addr = (uint32_t)buffer,
+	};
+	dma_cfg(I2C_DMA_BASE, stream, &dma);
+#if I2C_SIM
+	dma_sim_mem(I2C_DMA_BASE, stream, buffer);
+#endif
+
+	/* 清ADDR之前设置好DMAEN和LAST, 最后一个字节硬件自动回NACK */
+	I2C_SET(id, I2C_CR1, I2C_CR1_ACK);
+	I2C_SET(id, I2C_CR2, I2C_CR2_DMAEN | I2C_CR2_LAST);
+	res = i2c_start(id, (uint8_t)((addr<<1) | 0x01), 1);
+	if(res != 0){
+		I2C_CLR(id, I2C_CR2, I2C_CR2_DMAEN | I2C_CR2_LAST);
+		dma_dis(I2C_DMA_BASE, stream);
+		return res;
+	}
+	s_rx_len[id-1] = len;
+	return 0;
+}
+
+int i2c_read_dma_poll(int id)
+{
+	int stream = s_dma_stream[id-1];
+	int res;
+
+	if(s_rx_len[id-1] < 2){
+		return 0;
+	}
+	if(dma_int_is_set(I2C_DMA_BASE, stream, DMA_INT_TC)){
+		dma_int_flag_clr(I2C_DMA_BASE, stream, DMA_INT_TC);
+		res = 0;
+	}else if(dma_int_is_set(I2C_DMA_BASE, stream, DMA_INT_TE)){
+		dma_int_flag_clr(I2C_DMA_BASE, stream, DMA_INT_TE);
+		dma_dis(I2C_DMA_BASE, stream);
+		res = -1;
+	}else if(I2C_RD(id, I2C_SR1) & (I2C_SR1_BERR | I2C_SR1_ARLO)){
+		/* 总线干扰: 停止DMA,剩余字节数保留在NDTR中 */
+		I2C_CLR(id, I2C_SR1, I2C_SR1_BERR | I2C_SR1_ARLO);
+		dma_dis(I2C_DMA_BASE, stream);
+		res = -4;
+	}else{
+		return 1;
+	}
+	I2C_CLR(id, I2C_CR2, I2C_CR2_DMAEN | I2C_CR2_LAST);
+	I2C_SET(id, I2C_CR1, I2C_CR1_STOP);
+	s_rx_len[id-1] = 0;
+	return res;
+}
+
+uint32_t i2c_read_dma_remain(int id)
+{
+	return dma_get_cnt(I2C_DMA_BASE, s_dma_stream[id-1]);
+}
+
+int i2c_recover(int id)
+{
+#if !I2C_SIM
+	uint32_t half = clock_get_ahb() / 200000ul;  /* 100K SCL半周期 */
+	uint32_t t0;
+#endif
+	int res = 0;
+	i2c_cfg_st cfg;
+
+	I2C_CLR(id, I2C_CR2, I2C_CR2_DMAEN | I2C_CR2_LAST);
+	dma_dis(I2C_DMA_BASE, s_dma_stream[id-1]);
+	s_rx_len[id-1] = 0;
+	I2C_WR(id, I2C_CR1, 0);  /* PE=0 */
+
+#if I2C_SIM
+	i2c_sim_event(id, I2C_SIM_RECOVER, 0, 0);
+#else
+	switch(id){
+		case 3:
+			/* 引脚切换为开漏GPIO, 释放SDA, 最多9个SCL直到从机释放SDA, 然后STOP */
+			gpio_write((void*)GPIOA_BASE, 'A', 8, 1);
+			gpio_write((void*)GPIOA_BASE, 'C', 9, 1);
+			gpio_set((void*)GPIOA_BASE, 'A', 8, 1, GPIOx_MODER_MODERy_GPOUTPUT, GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP);
+			gpio_set((void*)GPIOA_BASE, 'C', 9, 1, GPIOx_MODER_MODERy_GPOUTPUT, GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP);
+			for(int i=0; i<9; i++){
+				if(gpio_read((void*)GPIOA_BASE, 'C', 9)){
+					break;
+				}
+				gpio_write((void*)GPIOA_BASE, 'A', 8, 0);
+				t0 = clock_get_cycles();
+				while(clock_get_cycles() - t0 < half);
+				gpio_write((void*)GPIOA_BASE, 'A', 8, 1);
+				t0 = clock_get_cycles();
+				while(clock_get_cycles() - t0 < half);
+			}
+			/* STOP: SCL低时拉低SDA, SCL高后释放SDA */
+			gpio_write((void*)GPIOA_BASE, 'A', 8, 0);
+			gpio_write((void*)GPIOA_BASE, 'C', 9, 0);
+			t0 = clock_get_cycles();
+			while(clock_get_cycles() - t0 < half);
+			gpio_write((void*)GPIOA_BASE, 'A', 8, 1);
+			t0 = clock_get_cycles();
+			while(clock_get_cycles() - t0 < half);
+			gpio_write((void*)GPIOA_BASE, 'C', 9, 1);
+			t0 = clock_get_cycles();
+			while(clock_get_cycles() - t0 < half);
+			res = gpio_read((void*)GPIOA_BASE, 'C', 9) ? 0 : -3;
+		break;
+	}
+#endif
+
+	/* 复位外设后按原速率重新初始化,引脚恢复为复用功能 */
+	I2C_WR(id, I2C_CR1, I2C_CR1_SWRST);
+	I2C_WR(id, I2C_CR1, 0);
+	cfg.speed = s_speed[id-1];
+	i2c_init(id, &cfg);
+	return res;
+}
+
+#if I2C_SIM
+
+#define I2C_SR1_RC_W0 0xDF00u   /* SR1中写0清除的错误标志 */
+
+/* 仿真状态 */
+enum{
+	I2C_SIM_IDLE = 0,
+	I2C_SIM_SB,        /* START已发出, 等待写地址 */
+	I2C_SIM_WRITE,     /* 地址(写)已应答, 清ADDR后发送数据 */
+	I2C_SIM_READ,      /* 地址(读)已应答, 清ADDR后接收数据 */
+	I2C_SIM_NACKED,    /* 收到/发出NACK, 等待STOP */
+};
+
+static uint32_t s_i2c_sim_reg[3][0x24/4];
+static struct{
+	uint8_t state;
+	uint8_t busy;      /* START之后STOP之前 */
+	uint8_t sr1_read;  /* 读过SR1, SB/ADDR按先读SR1的顺序清除 */
+} s_i2c_sim[3];
+
+/* 从机: 先写的2字节为地址(高字节在前), 之后写入或读出的字节地址递增 */
+static struct{
+	uint8_t addr;
+	uint8_t* mem;
+	uint32_t size;
+	uint32_t ptr;
+	uint32_t wr_cnt;   /* 本次寻址后写入的字节数 */
+	int nack_addr;     /* 之后多少次寻址回NACK */
+	int berr_at;       /* 下次DMA接收第几个字节时总线错误, -1不注入 */
+} s_i2c_sim_slave = {.berr_at = -1};
+
+static i2c_sim_ev_st s_i2c_sim_log[I2C_SIM_LOG_MAX];
+static uint32_t s_i2c_sim_num;
+static uint32_t s_i2c_sim_errs;
+
+#define I2C_SIM_REG(id, off)  s_i2c_sim_reg[(id)-1][(off)/4]
+
+static void i2c_sim_event(int id, uint8_t type, uint8_t data, uint8_t ack)
+{
+	(void)id;
+	if(s_i2c_sim_num < I2C_SIM_LOG_MAX){
+		s_i2c_sim_log[s_i2c_sim_num].type = type;
+		s_i2c_sim_log[s_i2c_sim_num].data = data;
+		s_i2c_sim_log[s_i2c_sim_num].ack = ack;
+	}
+	s_i2c_sim_num++;
+}
+
+static uint8_t i2c_sim_slave_rd(void)
+{
+	uint8_t val = 0xFF;
+	if((s_i2c_sim_slave.mem != 0) && (s_i2c_sim_slave.size > 0)){
+		val = s_i2c_sim_slave.mem[s_i2c_sim_slave.ptr % s_i2c_sim_slave.size];
+	}
+	s_i2c_sim_slave.ptr++;
+	return val;
+}
+
+static void i2c_sim_slave_wr(uint8_t val)
+{
+	if(s_i2c_sim_slave.wr_cnt < 2){
+		s_i2c_sim_slave.ptr = (s_i2c_sim_slave.wr_cnt == 0) ? ((uint32_t)val << 8) : (s_i2c_sim_slave.ptr | val);
+	}else{
+		if((s_i2c_sim_slave.mem != 0) && (s_i2c_sim_slave.size > 0)){
+			s_i2c_sim_slave.mem[s_i2c_sim_slave.ptr % s_i2c_sim_slave.size] = val;
+		}
+		s_i2c_sim_slave.ptr++;
+	}
+	s_i2c_sim_slave.wr_cnt++;
+}
+
+/* ADDR已清除: 开始数据阶段, 接收时ACK/DMAEN/LAST按此刻的设置 */
+static void i2c_sim_data(int id)
+{
+	uint32_t cr1 = I2C_SIM_REG(id, I2C_CR1);
+	uint32_t cr2 = I2C_SIM_REG(id, I2C_CR2);
+	int stream = s_dma_stream[id-1];
+	uint8_t val;
+	uint8_t ack;
+	uint32_t i = 0;
+	if(s_i2c_sim[id-1].state != I2C_SIM_READ){
+		I2C_SIM_REG(id, I2C_SR1) |= I2C_SR1_TXE;
+		return;
+	}
+	if((cr2 & I2C_CR2_DMAEN) == 0){
+		/* 不用DMA只收一个字节 */
+		val = i2c_sim_slave_rd();
+		ack = (cr1 & I2C_CR1_ACK) ? 1 : 0;
+		I2C_SIM_REG(id, I2C_DR) = val;
+		I2C_SIM_REG(id, I2C_SR1) |= I2C_SR1_RXNE;
+		i2c_sim_event(id, I2C_SIM_RX, val, ack);
+		if(ack == 0){
+			s_i2c_sim[id-1].state = I2C_SIM_NACKED;
+		}
+		return;
+	}
+	/* DMA接收: LAST置位时DMA最后一项回NACK */
+	while(dma_get_cnt(I2C_DMA_BASE, stream) > 0){
+		if((s_i2c_sim_slave.berr_at >= 0) && (i == (uint32_t)s_i2c_sim_slave.berr_at)){
+			s_i2c_sim_slave.berr_at = -1;
+			I2C_SIM_REG(id, I2C_SR1) |= I2C_SR1_BERR;
+			i2c_sim_event(id, I2C_SIM_BERR, 0, 0);
+			return;
+		}
+		val = i2c_sim_slave_rd();
+		ack = (cr1 & I2C_CR1_ACK) ? 1 : 0;
+		if((cr2 & I2C_CR2_LAST) && (dma_get_cnt(I2C_DMA_BASE, stream) == 1)){
+			ack = 0;
+		}
+		if(dma_sim_p2m(I2C_DMA_BASE, stream, val) != 0){
+			s_i2c_sim_errs++;  /* DMA未准备好 */
+			return;
+		}
+		i2c_sim_event(id, I2C_SIM_RX, val, ack);
+		i++;
+		if(ack == 0){
+			break;
+		}
+	}
+	/* 最后一个字节必须回NACK从机才会释放SDA */
+	if((dma_get_cnt(I2C_DMA_BASE, stream) != 0) || (ack != 0)){
+		s_i2c_sim_errs++;
+	}
+	s_i2c_sim[id-1].state = I2C_SIM_NACKED;
+}
+
+static uint32_t i2c_sim_rd(int id, uint32_t off)
+{
+	uint32_t val = I2C_SIM_REG(id, off);
+	switch(off){
+		case I2C_SR1:
+			s_i2c_sim[id-1].sr1_read = 1;
+		break;
+		case I2C_SR2:
+			if(s_i2c_sim[id-1].sr1_read && (I2C_SIM_REG(id, I2C_SR1) & I2C_SR1_ADDR)){
+				I2C_SIM_REG(id, I2C_SR1) &= ~I2C_SR1_ADDR;
+				i2c_sim_data(id);
+			}
+			s_i2c_sim[id-1].sr1_read = 0;
+			val = s_i2c_sim[id-1].busy ? 0x03 : 0;  /* BUSY MSL */
+		break;
+		case I2C_DR:
+			I2C_SIM_REG(id, I2C_SR1) &= ~(I2C_SR1_RXNE | I2C_SR1_BTF);
+		break;
+	}
+	return val;
+}
+
+static void i2c_sim_wr(int id, uint32_t off, uint32_t val)
+{
+	uint8_t* state = &s_i2c_sim[id-1].state;
+	uint8_t ack;
+	switch(off){
+		case I2C_CR1:
+			if(val & I2C_CR1_SWRST){
+				memset(s_i2c_sim_reg[id-1], 0, sizeof(s_i2c_sim_reg[id-1]));
+				memset(&s_i2c_sim[id-1], 0, sizeof(s_i2c_sim[id-1]));
+				I2C_SIM_REG(id, I2C_CR1) = val;
+				return;
+			}
+			if((val & I2C_CR1_START) && (val & I2C_CR1_STOP)){
+				s_i2c_sim_errs++;
+			}
+			if(val & I2C_CR1_STOP){
+				/* STOP在当前字节之后发出, 硬件发出后清除STOP位 */
+				val &= ~I2C_CR1_STOP;
+				if(s_i2c_sim[id-1].busy){
+					i2c_sim_event(id, I2C_SIM_STOP, 0, 0);
+				}else{
+					s_i2c_sim_errs++;
+				}
+				s_i2c_sim[id-1].busy = 0;
+				*state = I2C_SIM_IDLE;
+				I2C_SIM_REG(id, I2C_SR1) &= I2C_SR1_RC_W0 | I2C_SR1_RXNE;
+			}
+			if(val & I2C_CR1_START){
+				val &= ~I2C_CR1_START;
+				i2c_sim_event(id, I2C_SIM_START, s_i2c_sim[id-1].busy, 0);
+				s_i2c_sim[id-1].busy = 1;
+				s_i2c_sim[id-1].sr1_read = 0;
+				*state = I2C_SIM_SB;
+				I2C_SIM_REG(id, I2C_SR1) = (I2C_SIM_REG(id, I2C_SR1) & I2C_SR1_RC_W0) | I2C_SR1_SB;
+			}
+			I2C_SIM_REG(id, I2C_CR1) = val;
+		break;
+		case I2C_SR1:
+			I2C_SIM_REG(id, I2C_SR1) &= val | ~I2C_SR1_RC_W0;
+		break;
+		case I2C_DR:
+			val &= 0xFF;
+			if(*state == I2C_SIM_SB){
+				/* 先读SR1再写DR清除SB */
+				if(s_i2c_sim[id-1].sr1_read == 0){
+					s_i2c_sim_errs++;
+				}
+				I2C_SIM_REG(id, I2C_SR1) &= ~I2C_SR1_SB;
+				ack = ((val >> 1) == s_i2c_sim_slave.addr) ? 1 : 0;
+				if(ack && (s_i2c_sim_slave.nack_addr > 0)){
+					s_i2c_sim_slave.nack_addr--;
+					ack = 0;
+				}
+				i2c_sim_event(id, I2C_SIM_ADDR, (uint8_t)val, ack);
+				if(ack){
+					I2C_SIM_REG(id, I2C_SR1) |= I2C_SR1_ADDR;
+					*state = (val & 0x01) ? I2C_SIM_READ : I2C_SIM_WRITE;
+					if((val & 0x01) == 0){
+						s_i2c_sim_slave.wr_cnt = 0;
+					}
+					s_i2c_sim[id-1].sr1_read = 0;
+				}else{
+					I2C_SIM_REG(id, I2C_SR1) |= I2C_SR1_AF;
+					*state = I2C_SIM_NACKED;
+				}
+			}else if((*state == I2C_SIM_WRITE) && ((I2C_SIM_REG(id, I2C_SR1) & I2C_SR1_ADDR) == 0)){
+				i2c_sim_slave_wr((uint8_t)val);
+				i2c_sim_event(id, I2C_SIM_TX, (uint8_t)val, 1);
+				I2C_SIM_REG(id, I2C_SR1) |= I2C_SR1_TXE | I2C_SR1_BTF;
+			}else{
+				s_i2c_sim_errs++;
+			}
+			I2C_SIM_REG(id, I2C_DR) = val;
+		break;
+		default:
+			I2C_SIM_REG(id, off) = val;
+		break;
+	}
+}
+
+void i2c_sim_slave(uint8_t addr, uint8_t* mem, uint32_t size)
+{
+	s_i2c_sim_slave.addr = addr;
+	s_i2c_sim_slave.mem = mem;
+	s_i2c_sim_slave.size = size;
+	s_i2c_sim_slave.ptr = 0;
+	s_i2c_sim_slave.wr_cnt = 0;
+}
+
+void i2c_sim_fault(int nack_addr, int berr_at)
+{
+	s_i2c_sim_slave.nack_addr = nack_addr;
+	s_i2c_sim_slave.berr_at = berr_at;
+}
+
+const i2c_sim_ev_st* i2c_sim_log(uint32_t* num)
+{
+	if(num){
+		*num = (s_i2c_sim_num < I2C_SIM_LOG_MAX) ? s_i2c_sim_num : I2C_SIM_LOG_MAX;
+	}
+	return s_i2c_sim_log;
+}
+
+uint32_t i2c_sim_errs(void)
+{
+	return s_i2c_sim_errs;
+}
+
+void i2c_sim_clear(void)
+{
+	s_i2c_sim_num = 0;
+	s_i2c_sim_errs = 0;
+}
+
+#endif
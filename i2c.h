@@ -0,0 +1,138 @@
+#ifndef I2C_H
+#define I2C_H
+
+#include <stdint.h>
+
+/**
+ * 用-DI2C_SIM=1(同时需要-DDMA_SIM=1)编译时寄存器是内存中的数组, 不访问硬件, 可以在主机上编译:
+ * 每次读写寄存器按硬件的规则更新标志(先读SR1再写DR清SB, 先读SR1再读SR2清ADDR等),
+ * 总线上挂一个仿真从机, 记录START/地址/数据/应答/STOP的顺序, 用于检查驱动的操作顺序
+ */
+#ifndef I2C_SIM
+#define I2C_SIM 0
+#endif
+
+typedef struct{
+	uint32_t speed;    /** SCL频率Hz, <=100K标准模式, >100K快速模式 */
+} i2c_cfg_st;
+
+/**
+ * \fn i2c_init
+ * 初始化I2C外设(主机模式)
+ * \param[in] id 1~3, 目前只实现了I2C3(PA8 SCL, PC9 SDA)的引脚配置
+ * \param[in] cfg \ref i2c_cfg_st
+*/
+void i2c_init(int id, i2c_cfg_st* cfg);
+
+/**
+ * \fn i2c_write
+ * 产生START,发送地址(写)和数据
+ * \param[in] id 1~3
+ * \param[in] addr 7位从机地址
+ * \param[in] buffer 待发送数据
+ * \param[in] len 待发送长度
+ * \param[in] stop 1发送完产生STOP 0不产生STOP(后面接重复START)
+ * \retval 0 成功
+ * \retval -2 未收到ACK
+ * \retval -3 超时
+*/
+int i2c_write(int id, uint8_t addr, uint8_t* buffer, uint32_t len, int stop);
+
+/**
+ * \fn i2c_read_dma
+ * 产生(重复)START,发送地址(读),启动DMA接收,不等待完成
+ * 最后一个字节由硬件自动回NACK(CR2.LAST)
+ * \param[in] id 1~3
+ * \param[in] addr 7位从机地址
+ * \param[out] buffer 接收缓存
+ * \param[in] len 接收长度,>=2时使用DMA
+ * \retval 0 成功启动
+ * \retval -2 未收到ACK
+ * \retval -3 超时
+*/
+int i2c_read_dma(int id, uint8_t addr, uint8_t* buffer, uint32_t len);
+
+/**
+ * \fn i2c_read_dma_poll
+ * 查询i2c_read_dma启动的接收是否完成,完成时产生STOP
+ * \param[in] id 1~3
+ * \retval 1 传输中
+ * \retval 0 完成
+ * \retval -1 DMA传输错误
+ * \retval -4 总线错误(BERR/ARLO)
+*/
+int i2c_read_dma_poll(int id);
+
+/**
+ * \fn i2c_read_dma_remain
+ * i2c_read_dma_poll返回错误后查询未接收的字节数,用于从断点重试
+ * \param[in] id 1~3
+ * \return 未接收的字节数
+*/
+uint32_t i2c_read_dma_remain(int id);
+
+/**
+ * \fn i2c_recover
+ * 总线恢复: 引脚切换为GPIO,最多9个SCL直到从机释放SDA,发送STOP,然后复位并重新初始化外设
+ * \param[in] id 1~3, 目前只实现了I2C3的引脚
+ * \retval 0 成功,SDA已释放
+ * \retval -3 SDA仍被拉低
+*/
+int i2c_recover(int id);
+
+#if I2C_SIM
+#define I2C_SIM_START    1   /** START, data为1时是重复START */
+#define I2C_SIM_ADDR     2   /** 地址字节data, ack为从机应答 */
+#define I2C_SIM_TX       3   /** 主机发送data, ack为从机应答 */
+#define I2C_SIM_RX       4   /** 从机发送data, ack为主机应答, 0为NACK */
+#define I2C_SIM_STOP     5
+#define I2C_SIM_BERR     6   /** 注入的总线错误 */
+#define I2C_SIM_RECOVER  7   /** i2c_recover */
+
+#define I2C_SIM_LOG_MAX  4096
+
+typedef struct{
+	uint8_t type;     /** I2C_SIM_xxx */
+	uint8_t data;
+	uint8_t ack;
+} i2c_sim_ev_st;
+
+/**
+ * \fn i2c_sim_slave
+ * 设置仿真从机: 写入的前2字节为地址(高字节在前), 之后读写mem[地址++]
+ * \param[in] addr 7位从机地址
+ * \param[in] mem 从机的存储器
+ * \param[in] size 存储器字节数
+*/
+void i2c_sim_slave(uint8_t addr, uint8_t* mem, uint32_t size);
+
+/**
+ * \fn i2c_sim_fault
+ * 注入错误
+ * \param[in] nack_addr 之后多少次寻址回NACK
+ * \param[in] berr_at 下次DMA接收到第几个字节(从0开始)时总线错误, -1不注入
+*/
+void i2c_sim_fault(int nack_addr, int berr_at);
+
+/**
+ * \fn i2c_sim_log
+ * 获取记录的总线事件
+ * \param[out] num 记录数, 最多I2C_SIM_LOG_MAX
+ * \return 记录数组
+*/
+const i2c_sim_ev_st* i2c_sim_log(uint32_t* num);
+
+/**
+ * \fn i2c_sim_errs
+ * \return 驱动违反寄存器操作顺序的次数
+*/
+uint32_t i2c_sim_errs(void);
+
+/**
+ * \fn i2c_sim_clear
+ * 清除记录和错误计数
+*/
+void i2c_sim_clear(void);
+#endif
+
+#endif
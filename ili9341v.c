@@ -152,7 +152,68 @@ int ili9341v_sync(ili9341v_dev_st* dev, uint16_t x0, uint16_t x1, uint16_t y0, u
     (void)dev;
     ili9341v_set_windows(dev, x0, x1, y0, y1);
     ili9341v_write_cmd(dev,ILI9341V_CMD_RAMWR);
-    ili9341v_write_data(dev, (uint8_t*)buffer, len);
+    if(dev->write16 != (ili9341v_spi_write16_pf)0)
+    {
+        /* 16位帧先发高字节, 显存为本机字节序的RGB565 */
+        dev->enable(1);
+        dev->set_dcx(1);
+        dev->write16(buffer, len/2);
+        dev->enable(0);
+    }
+    else
+    {
+        ili9341v_write_data(dev, (uint8_t*)buffer, len);
+    }
+    return 0;
+}
+
+/**
+ * \fn ili9341v_sync_rect
+ * 显存中的矩形区域写入ili9341v
+ * \param[in] dev \ref ili9341v_dev_st
+ * \paran[in] x0 列开始地址
+ * \paran[in] x1 列结束地址
+ * \paran[in] y0 行开始地址
+ * \paran[in] y1 行结束地址
+ * \paran[in] buffer 区域左上角的点
+ * \paran[in] stride 显存一行的点数
+ * \retval 0 成功
+ * \retval 其他值 失败
+*/
+int ili9341v_sync_rect(ili9341v_dev_st* dev, uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1, uint16_t* buffer, uint32_t stride)
+{
+    uint32_t w = (uint32_t)x1 - x0 + 1;
+    uint32_t h = (uint32_t)y1 - y0 + 1;
+    if((w == stride) || (h == 1))
+    {
+        /* 连续的区域 */
+        return ili9341v_sync(dev, x0, x1, y0, y1, buffer, w*h*2);
+    }
+    ili9341v_set_windows(dev, x0, x1, y0, y1);
+    ili9341v_write_cmd(dev,ILI9341V_CMD_RAMWR);
+    if(dev->write16_rect != (ili9341v_spi_write16_rect_pf)0)
+    {
+        dev->enable(1);
+        dev->set_dcx(1);
+        dev->write16_rect(buffer, w, stride, h);
+        dev->enable(0);
+        return 0;
+    }
+    /* RAMWR之后的数据连续写入窗口, 中间CS拉高不影响 */
+    for(uint32_t i=0; i<h; i++)
+    {
+        if(dev->write16 != (ili9341v_spi_write16_pf)0)
+        {
+            dev->enable(1);
+            dev->set_dcx(1);
+            dev->write16(buffer + i*stride, w);
+            dev->enable(0);
+        }
+        else
+        {
+            ili9341v_write_data(dev, (uint8_t*)(buffer + i*stride), w*2);
+        }
+    }
     return 0;
 }
 
@@ -208,6 +269,34 @@ int ili9341v_init(ili9341v_dev_st* dev)
     return 0;
 }
 
+/**
+ * \fn ili9341v_rgb_mode
+ * 切换到RGB接口
+ * \param[in] dev \ref ili9341v_dev_st
+ * \retval 0 成功
+ * \retval 其他值 失败
+*/
+int ili9341v_rgb_mode(ili9341v_dev_st* dev)
+{
+    uint8_t ifmode = 0xC2;                   /**< 同步信号低有效, DOTCLK上升沿采样, 使用DE */
+    uint8_t itf[3] = {0x01, 0x00, 0x06};     /**< DM=01 RGB接口, RM=1 经GRAM写入         */
+#if ILI9341V_CHECK_PARAM
+    if(dev == (ili9341v_dev_st*)0)
+    {
+        return -1;
+    }
+#endif
+    ili9341v_write_cmd(dev, ILI9341V_CMD_IFMODE);
+    ili9341v_write_data(dev, &ifmode, 1);
+    ili9341v_write_cmd(dev, ILI9341V_CMD_ITF_CTL);
+    ili9341v_write_data(dev, itf, 3);
+    /* 全屏窗口, 每个VSYNC从左上角重新开始写 */
+    ili9341v_set_windows(dev, 0, ILI9341V_HSIZE-1, 0, ILI9341V_VSIZE-1);
+    ili9341v_write_cmd(dev, ILI9341V_CMD_RAMWR);
+    dev->delay(20);
+    return 0;
+}
+
 /**
  * \fn ili9341v_deinit
  * 解除初始化
@@ -15,6 +15,8 @@
 typedef void    (*ili9341v_set_dcx_pf)(uint8_t val);                          /**< DCX引脚操作接口,val=1为数据和参数, val=0为命令   */
 typedef void    (*ili9341v_set_reset_pf)(uint8_t val);                        /**< 复位引脚操作,val=1输出高,val=0输出低            */
 typedef void    (*ili9341v_spi_write_pf)(uint8_t* buffer, uint32_t len);      /**< MOSI写接口接口,buffer为待写数据,len为待写长度    */
+typedef void    (*ili9341v_spi_write16_pf)(uint16_t* buffer, uint32_t len);   /**< 像素数据16位帧写接口,len为点数                 */
+typedef void    (*ili9341v_spi_write16_rect_pf)(uint16_t* buffer, uint32_t w, uint32_t stride, uint32_t h); /**< 矩形区域16位帧写接口,每行w点,行间隔stride点 */
 typedef void    (*ili9341v_spi_enable_pf)(uint8_t val);                       /**< 使能接口                                       */
 typedef void    (*ili9341v_spi_delay_ms_pf)(uint32_t t);                      /**< 延时接口                                       */
 typedef void    (*ili9341v_init_pf)(void);                                    /**< 初始化接口                                     */
@@ -31,6 +33,7 @@ typedef void    (*ili9341v_deinit_pf)(void);                                  /*
 #define ILI9341V_CMD_RAMWR  0x2C
 #define ILI9341V_CMD_MADCTL 0x36
 #define ILI9341V_CMD_COLMOD 0x3A
+#define ILI9341V_CMD_IFMODE  0xB0
 #define ILI9341V_CMD_PORCTRL 0xB2
 #define ILI9341V_CMD_GCTRL   0xB7
 #define ILI9341V_CMD_VCOMS   0xBB
@@ -53,6 +56,8 @@ typedef struct
     ili9341v_set_dcx_pf    set_dcx;      /**< DCX写接口        */
     ili9341v_set_reset_pf  set_reset;    /**< RESET写接口      */
     ili9341v_spi_write_pf  write;        /**< 数据写接口       */
+    ili9341v_spi_write16_pf write16;     /**< 像素数据写接口, 为0时按字节写, 显存需为交换字节的RGB565 */
+    ili9341v_spi_write16_rect_pf write16_rect; /**< 矩形区域写接口, 为0时逐行调用write16/write */
     ili9341v_spi_enable_pf enable;       /**< 使能接口         */
     ili9341v_spi_delay_ms_pf delay;      /**< 延时接口         */
     ili9341v_init_pf       init;         /**< 初始化接口       */
@@ -71,11 +76,28 @@ typedef struct
  * \paran[in] y1 行结束地址 
  * \paran[in] buffer 待写入数据 
  * \paran[in] len 待写入数据长度 
+ * \note write接口可以是异步的(如DMA), 此时返回后buffer仍在发送,
+ *       接口需在下一次set_dcx/write前等待上一次发送完成
  * \retval 0 成功
  * \retval 其他值 失败
 */
 int ili9341v_sync(ili9341v_dev_st* dev, uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1, uint16_t* buffer, uint32_t len);
 
+/**
+ * \fn ili9341v_sync_rect
+ * 显存中的矩形区域写入ili9341v
+ * \param[in] dev \ref ili9341v_dev_st
+ * \paran[in] x0 列开始地址
+ * \paran[in] x1 列结束地址
+ * \paran[in] y0 行开始地址
+ * \paran[in] y1 行结束地址
+ * \paran[in] buffer 区域左上角的点
+ * \paran[in] stride 显存一行的点数
+ * \retval 0 成功
+ * \retval 其他值 失败
+*/
+int ili9341v_sync_rect(ili9341v_dev_st* dev, uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1, uint16_t* buffer, uint32_t stride);
+
 /**
  * \fn ili9341v_init
  * 初始化
@@ -85,6 +107,16 @@ int ili9341v_sync(ili9341v_dev_st* dev, uint16_t x0, uint16_t x1, uint16_t y0, u
 */
 int ili9341v_init(ili9341v_dev_st* dev);
 
+/**
+ * \fn ili9341v_rgb_mode
+ * 切换到RGB接口: 像素数据由RGB接口(LTDC)按VSYNC/HSYNC/DE写入GRAM, 仍按MADCTL的方向显示,
+ * 之后不再使用ili9341v_sync/ili9341v_sync_rect
+ * \param[in] dev \ref ili9341v_dev_st
+ * \retval 0 成功
+ * \retval 其他值 失败
+*/
+int ili9341v_rgb_mode(ili9341v_dev_st* dev);
+
 /**
  * \fn ili9341v_deinit
  * 解除初始化
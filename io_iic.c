@@ -1,5 +1,41 @@
 #include "io_iic.h"
 
+/**
+ * 半周期延时
+ * 有周期计数时从上一次延时结束开始计时,期间的GPIO操作时间自动扣除,
+ * 否则调用delay_pf(delayus)
+ */
+static inline void io_iic_delay(io_iic_dev_st* dev)
+{
+    if((dev->get_cycles != 0) && (dev->half_cycles != 0))
+    {
+        uint32_t t_edge = dev->t_edge;
+        uint32_t now;
+        do
+        {
+            now = dev->get_cycles();
+        }while((now - t_edge) < dev->half_cycles);
+        dev->t_edge = now;
+    }
+    else if(dev->delay_pf != 0)
+    {
+        dev->delay_pf(dev->delayus);
+    }
+}
+
+/**
+ * 以当前时刻重新开始计时
+ * 总线空闲一段时间后t_edge已经过去很久,不重新计时则下一个半周期立即结束,
+ * 所以START和总线恢复这种空闲后的第一个操作要先调用
+ */
+static inline void io_iic_delay_restart(io_iic_dev_st* dev)
+{
+    if((dev->get_cycles != 0) && (dev->half_cycles != 0))
+    {
+        dev->t_edge = dev->get_cycles();
+    }
+}
+
 /**
 
  *                     _______________________   
@@ -15,17 +51,12 @@
 void io_iic_start(io_iic_dev_st* dev)
 {
     /* SCL高时,SDA下降沿 */
+    io_iic_delay_restart(dev);
     dev->sda_write(1);               /* (1) SDA拉高以便后面产生下降沿  */
     dev->scl_write(1);               /* (2) 拉高SCL                   */
-    if(dev->delay_pf != 0)           /* (3) SCL高保持*/
-    {
-        dev->delay_pf(dev->delayus);
-    }
+    io_iic_delay(dev);               /* (3) SCL高保持*/
     dev->sda_write(0);              /* (4)SCL高时SDA下降沿 启动    */
-    if(dev->delay_pf != 0)          /* (5)SCL高保持               */
-    {
-        dev->delay_pf(dev->delayus);
-    }
+    io_iic_delay(dev);              /* (5)SCL高保持               */
     dev->scl_write(0);             /* (6)SCL恢复                 */
 }
 
@@ -46,15 +77,9 @@ void io_iic_stop(io_iic_dev_st* dev)
     /* SCL高时,SDA上升沿 */
     dev->sda_write(0);               /* (1)SDA先输出低以便产生上升沿 */
     dev->scl_write(1);               /* (2)SCL高                   */
-    if(dev->delay_pf != 0)           /* (3)SCL高保持               */
-    {
-        dev->delay_pf(dev->delayus);
-    } 
+    io_iic_delay(dev);               /* (3)SCL高保持               */
     dev->sda_write(1);               /* (4)SCL高时SDA上升沿 停止    */
-    if(dev->delay_pf != 0)           /* (5)SCL高保持               */
-    {
-        dev->delay_pf(dev->delayus);
-    }
+    io_iic_delay(dev);               /* (5)SCL高保持               */
     //dev->scl_write(0);               /* (6)SCL恢复                 */
 }
 
@@ -92,29 +117,17 @@ int io_iic_write(io_iic_dev_st* dev, uint8_t val)
         {
             dev->sda_write(0);  
         }
-        if(dev->delay_pf != 0)
-        {
-            dev->delay_pf(dev->delayus); /* (3) SCL拉低时间即数据建立时间 */
-        }
+        io_iic_delay(dev);                /* (3) SCL拉低时间即数据建立时间 */
         dev->scl_write(1);                /*(4) SCL上升沿对方采样        */
-        if(dev->delay_pf != 0)
-        { 
-            dev->delay_pf(dev->delayus); /* (5) SCL高保持时间,数据保持时间 */
-        }
+        io_iic_delay(dev);                /* (5) SCL高保持时间,数据保持时间 */
         tmp <<= 1;                       /* 处理下一位           */
     }
     dev->scl_write(0);                   /* (6)SCL归0  完成8个CLK */
     dev->sda_2read();                    /* [7]SDA转为读          */
-    if(dev->delay_pf != 0)
-    { 
-        dev->delay_pf(dev->delayus);     /* (8)第九个时钟拉低时间  */
-    }
+    io_iic_delay(dev);                   /* (8)第九个时钟拉低时间  */
     dev->scl_write(1);                   /* (9)SCL上升沿          */
     ack = dev->sda_read();               /* [10]上升沿后读         */
-    if(dev->delay_pf != 0)
-    { 
-        dev->delay_pf(dev->delayus);     /* (11)第九个时钟高保持    */
-    }
+    io_iic_delay(dev);                   /* (11)第九个时钟高保持    */
     dev->scl_write(0);                   /* (12)恢复SCL到低        */
     return (ack==0) ? 0 : -2;
 }
@@ -146,37 +159,99 @@ int io_iic_read(io_iic_dev_st* dev, uint8_t* val, uint8_t ack)
         tmp <<= 1;                      /* 处理下一位,先移动后读取             */
         dev->scl_write(0);              /* (1)                               */
         dev->sda_2read();               /* [2]转为读输入高阻,以便对方能输出     */
-        if(dev->delay_pf != 0)           
-        {
-            dev->delay_pf(dev->delayus);/* (3)SCL低保持时间                    */
-        }
+        io_iic_delay(dev);              /* (3)SCL低保持时间                    */
         dev->scl_write(1);              /* (4)SCL上升沿                        */
         if(dev->sda_read())             /* (5)读数据(SCL低时对方已经准备好数据)  */
         { 
             tmp |= 0x01;                /* 高位在前,最后左移到高位              */
         }      
-        if(dev->delay_pf != 0)          
-        { 
-            dev->delay_pf(dev->delayus);/* (6)SCL高保持时间                     */
-        }
+        io_iic_delay(dev);              /* (6)SCL高保持时间                     */
     }
     dev->scl_write(0);                  /* (7)恢复SCL时钟为低                   */
     dev->sda_write(ack);                /* [8]准备ACK信号(SCL低才能更行SDL)      */
-    if(dev->delay_pf != 0)
-    { 
-        dev->delay_pf(dev->delayus);    /* (9)第九个SCL拉低时间                  */
-    }
+    io_iic_delay(dev);                  /* (9)第九个SCL拉低时间                  */
     dev->scl_write(1);                  /* (10)SCL上升沿发数据触发对方读          */
-    if(dev->delay_pf != 0)
-    { 
-        dev->delay_pf(dev->delayus);    /* (11)第九个SCL拉高保持时间              */
-    }
+    io_iic_delay(dev);                  /* (11)第九个SCL拉高保持时间              */
     dev->scl_write(0);                  /* (12)第九个SCL完成恢复低                */
     //dev->sda_write(1);                /* 这里无需驱动SDA,后面可能还是读),需要发送时再驱动 */
     *val = tmp;
     return 0;
 }
 
+/**
+ * 从机在读数据时被打断会一直拉低SDA,
+ * 释放SDA后最多输出9个SCL直到从机释放SDA,然后发送STOP
+ */
+int io_iic_recover(io_iic_dev_st* dev)
+{
+    if(dev == 0)
+    {
+        return -1;
+    }
+    if((dev->scl_write == 0) || (dev->sda_write == 0) || (dev->sda_read == 0) || (dev->sda_2read == 0))
+    {
+        return -1;
+    }
+    io_iic_delay_restart(dev);
+    dev->scl_write(0);
+    dev->sda_2read();                   /* 释放SDA                      */
+    io_iic_delay(dev);
+    for(uint8_t i=0; i<9; i++)
+    {
+        dev->scl_write(1);
+        io_iic_delay(dev);
+        if(dev->sda_read())             /* 从机已释放SDA                */
+        {
+            break;
+        }
+        dev->scl_write(0);
+        io_iic_delay(dev);
+    }
+    dev->scl_write(0);                  /* SCL低时才能拉低SDA,避免误产生START */
+    io_iic_delay(dev);
+    io_iic_stop(dev);
+    return (dev->sda_read() != 0) ? 0 : -3;
+}
+
+uint32_t io_iic_hz_to_half_cycles(uint32_t cycles_hz, uint32_t hz)
+{
+    uint32_t half;
+    if(hz == 0)
+    {
+        return 0;
+    }
+    /* 2*hz超过cycles_hz时半周期不到1个周期,向上取整为1;这样2*hz也不会溢出 */
+    if(hz > cycles_hz / 2)
+    {
+        return (cycles_hz != 0) ? 1 : 0;
+    }
+    /* 不用(cycles_hz + 2*hz - 1)/(2*hz),cycles_hz接近32位上限时会溢出 */
+    half = cycles_hz / (2*hz);
+    if((cycles_hz % (2*hz)) != 0)
+    {
+        half++;
+    }
+    return half;
+}
+
+int io_iic_set_clock_hz(io_iic_dev_st* dev, uint32_t hz)
+{
+    if(dev == 0)
+    {
+        return -1;
+    }
+    if((hz != 0) && ((dev->get_cycles == 0) || (dev->cycles_hz == 0)))
+    {
+        return -1;
+    }
+    dev->half_cycles = io_iic_hz_to_half_cycles(dev->cycles_hz, hz);
+    if(dev->get_cycles != 0)
+    {
+        dev->t_edge = dev->get_cycles();
+    }
+    return 0;
+}
+
 void io_iic_init(io_iic_dev_st* dev)
 {
     if((dev != 0) && (dev->init != 0))
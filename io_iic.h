@@ -14,6 +14,7 @@ typedef uint8_t (*io_iic_sda_read_pf)(void);           /**< SDA读接口     */
 typedef void    (*io_iic_delay_us_pf)(uint32_t delay); /**< 延时接口      */
 typedef void    (*io_iic_init_pf)(void);               /**< 初始化接口     */
 typedef void    (*io_iic_deinit_pf)(void);             /**< 解除初始化接口 */
+typedef uint32_t (*io_iic_get_cycles_pf)(void);        /**< 读周期计数接口 */
 
 /**
  * \struct io_iic_dev_st
@@ -29,6 +30,10 @@ typedef struct
     io_iic_init_pf      init;        /**< 初始化接口    */
     io_iic_deinit_pf    deinit;      /**< 解除初始化接口 */
     volatile uint32_t            delayus;     /**< 延迟时间      */
+    io_iic_get_cycles_pf get_cycles; /**< 读周期计数接口,非0且half_cycles非0时按周期精确延时 */
+    uint32_t            cycles_hz;   /**< 周期计数器频率 */
+    volatile uint32_t   half_cycles; /**< SCL半周期的周期数,0则使用delay_pf */
+    uint32_t            t_edge;      /**< 上一次延时结束时的周期计数 */
 } io_iic_dev_st;
 
 /**
@@ -67,6 +72,35 @@ int io_iic_write(io_iic_dev_st* dev, uint8_t val);
 */
 int io_iic_read(io_iic_dev_st* dev, uint8_t* val, uint8_t ack);
 
+/**
+ * \fn io_iic_recover
+ * 总线恢复,最多9个SCL时钟直到SDA释放,然后发送停止信号
+ * \param[in] dev \ref io_iic_dev_st
+ * \retval 0 成功,SDA已释放
+ * \retval -3 SDA仍被拉低
+ * \retval -1 参数错误
+*/
+int io_iic_recover(io_iic_dev_st* dev);
+
+/**
+ * \fn io_iic_hz_to_half_cycles
+ * 计算SCL半周期对应的周期数,向上取整保证不超过目标频率,最小为1
+ * \param[in] cycles_hz 周期计数器频率
+ * \param[in] hz 目标SCL频率
+ * \return 半周期的周期数,hz或cycles_hz为0时返回0
+*/
+uint32_t io_iic_hz_to_half_cycles(uint32_t cycles_hz, uint32_t hz);
+
+/**
+ * \fn io_iic_set_clock_hz
+ * 设置SCL频率,之后每个半周期由get_cycles计时,GPIO操作花掉的时间已包含在内
+ * \param[in] dev \ref io_iic_dev_st
+ * \param[in] hz 目标SCL频率,0表示恢复使用delay_pf(delayus)
+ * \retval 0 成功
+ * \retval -1 参数错误(未提供get_cycles或cycles_hz)
+*/
+int io_iic_set_clock_hz(io_iic_dev_st* dev, uint32_t hz);
+
 /**
  * \fn io_iic_init
  * 初始化
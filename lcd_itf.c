@@ -1,15 +1,137 @@
+#include <string.h>
 #include "stm32f4_regs.h"
 #include "gpio.h"
 #include "clock.h"
 #include "ili9341v.h"
 #include "lcd_itf.h"
 #include "spi.h"
+#include "xprintf.h"
+#if LCD_ITF_LTDC
+#include "ltdc.h"
+#include "dma2d.h"
+#endif
 
 #define LCD_SPI  5
+#define LCD_DMA_MIN  64   /* 不少于64字节的数据用DMA发送, 命令和参数仍查询发送 */
 
+static uint8_t s_lcd_dma = 1;   /* 1使能DMA发送 */
+static uint8_t s_lcd_spi16 = 1; /* 1像素数据用16位帧, 命令和参数总是8位帧 */
+
+/**
+ * 脏块: 显存按10x10分块(与10倍放大的热像点对齐), 写显存时标记, 刷新时只发送标记的块,
+ * 相邻的块合并成矩形窗口, 估计的开销不低于整屏时直接整屏发送
+ */
+#define LCD_TILE       10
+#define LCD_TILE_COLS  (LCD_HSIZE/LCD_TILE)   /* 32, 每行一个uint32 */
+#define LCD_TILE_ROWS  (LCD_VSIZE/LCD_TILE)
+#define LCD_WIN_COST   64   /* 每个窗口CASET/RASET/RAMWR和启动DMA的开销, 折合字节 */
+#define LCD_ROW_COST   8    /* 不是整行宽的窗口每行一次DMA中断, 折合字节 */
+
+static uint8_t s_lcd_dirty_enable = 1;
+static uint32_t s_lcd_dirty[LCD_TILE_ROWS];
+
+/**
+ * 窗口队列: 第一个窗口由调用者发送, 之后的窗口在DMA完成中断中发送, 刷新整个过程不占用CPU
+ * 窗口数超过LCD_WIN_MAX时整屏(整行带)发送
+ */
+#define LCD_WIN_MAX    64
+
+typedef struct{
+    uint16_t x0;
+    uint16_t x1;
+    uint16_t y0;
+    uint16_t y1;
+} lcd_win_st;
+
+static lcd_win_st s_lcd_win[LCD_WIN_MAX];
+static uint16_t* s_lcd_win_buf;               /* 正在发送的缓存, 对应LCD的(s_lcd_win_ox,s_lcd_win_oy) */
+static uint16_t s_lcd_win_ox;
+static uint16_t s_lcd_win_oy;
+static uint16_t s_lcd_win_stride;             /* 缓存一行的点数 */
+static uint8_t s_lcd_win_num;
+static volatile uint8_t s_lcd_win_idx;
+static volatile uint8_t s_lcd_win_busy;       /* 队列未发完 */
+static volatile uint32_t s_lcd_dma_starts;    /* 启动DMA的次数, 用于判断窗口是否转到后台发送 */
+
+/**
+ * 多显存: 绘制后缓存的同时DMA发送前缓存, lcd_itf_frame_end提交后交换.
+ * 后缓存比前缓存落后LCD_FB_NUM-1帧, lcd_itf_frame_begin时先把前缓存这几帧改过的块复制过来,
+ * 调用者看到的总是完整的画面, 只需重画变化的部分
+ */
+#ifndef LCD_FB_NUM
+#define LCD_FB_NUM     2
+#endif
+#if LCD_ITF_LTDC && DMA2D_SIM
+/* 仿真时没有SDRAM, 显存是内存中的数组 */
+static uint16_t s_lcd_sim_fb[LCD_FB_NUM][LCD_HSIZE*LCD_VSIZE] __attribute__((aligned(4)));
+#define LCD_FB(i)      (s_lcd_sim_fb[i])
+#else
+#define LCD_FB_ADDR    0x90000000ul
+#define LCD_FB_SIZE    (LCD_HSIZE*LCD_VSIZE*2)   /* 0x25800, 第二个显存在0x90025800 */
+#define LCD_FB(i)      ((uint16_t*)(LCD_FB_ADDR + (i)*LCD_FB_SIZE))
+#endif
+
+static uint8_t s_lcd_fb_front = 0;            /* 最近提交的显存, 帧外的绘制也在这里 */
+static uint8_t s_lcd_fb_back = 0;             /* 正在绘制的显存 */
+static uint8_t s_lcd_in_frame = 0;
+static uint32_t s_lcd_fwd[LCD_FB_NUM][LCD_TILE_ROWS];  /* 每个显存上次绘制之后, 其他显存改过的块 */
+static uint32_t s_lcd_changed[LCD_TILE_ROWS];          /* 当前显存改过的块, 与s_lcd_dirty不同, 刷新时不清除 */
+
+/**
+ * 行带: 不经过SDRAM显存, 在内部SRAM的行带缓存中绘制一条(最多LCD_BAND_ROWS行)后直接DMA发送,
+ * 两个缓存轮流使用, 发送一条的同时绘制下一条. DMA不能访问CCM, 行带缓存放在SRAM.
+ */
+#define LCD_BAND_ROWS  10
+static uint16_t s_lcd_band[2][LCD_HSIZE*LCD_BAND_ROWS] __attribute__((aligned(4)));
+static uint8_t s_lcd_band_idx = 0;
+static uint8_t s_lcd_in_band = 0;
+static uint16_t s_lcd_band_x;
+static uint16_t s_lcd_band_w;
+static uint16_t s_lcd_band_y;
+static uint16_t s_lcd_band_h;
+
+static struct{
+    uint32_t syncs;
+    uint32_t full;         /* 整屏(整行带)发送的次数 */
+    uint32_t windows;
+    uint32_t bytes_last;   /* 最近一次刷新发送的像素字节数 */
+    uint32_t bytes_sum;
+    uint32_t frames;       /* lcd_itf_frame_end次数 */
+    uint32_t stalls;       /* lcd_itf_frame_begin需等待后缓存发送完的次数 */
+    uint32_t stall_cycles;
+    uint32_t copy_bytes;   /* 复制到后缓存的字节数 */
+    uint32_t bands;        /* lcd_itf_band_end次数 */
+    uint32_t band_bytes;
+} s_lcd_stat;
+
+#if LCD_ITF_LTDC
+/**
+ * LTDC: 横屏320x240, 像素时钟192MHz/4/8=6MHz, (10+20+320+10)*(2+2+240+4)个时钟一帧, 约67Hz
+ */
+static const ltdc_cfg_st s_lcd_ltdc_cfg = {
+    .width = LCD_HSIZE,
+    .height = LCD_VSIZE,
+    .hsync = 10,
+    .hbp = 20,
+    .hfp = 10,
+    .vsync = 2,
+    .vbp = 2,
+    .vfp = 4,
+    .pllsai_r = 4,
+    .div = 8,
+};
+
+#define LCD_DMA2D_MIN  64   /* 不少于64点的填充用DMA2D, 更小的CPU直接写 */
+static uint8_t s_lcd_dma2d_pending = 0;        /* 启动过DMA2D操作, CPU访问显存前要等完 */
+static uint32_t s_lcd_clut[256];               /* s_lcd_clut_src转换成的RGB888, DMA2D从这里加载 */
+static const uint16_t* s_lcd_clut_src;
+#endif
+
+static void port_lcd_dma_done(int id);
 
 static void port_lcd_set_dcx(uint8_t val)
 {
+	spi_dma_wait(LCD_SPI);  /* 上一次DMA发送完才能切换DCX */
 	if(val){
 		gpio_write((void*)GPIOA_BASE, 'D', 13, 1);
 	}else{
@@ -29,9 +151,45 @@ static void port_lcd_set_reset(uint8_t val)
 
 static void port_lcd_spi_write(uint8_t* buffer, uint32_t len)
 {
+	spi_dma_wait(LCD_SPI);
+	spi_set_databits(LCD_SPI, 8);
+	if(s_lcd_dma && (len >= LCD_DMA_MIN)){
+		if(spi_transfer_dma(LCD_SPI, buffer, len, port_lcd_dma_done) == 0){
+			s_lcd_dma_starts++;
+			return;
+		}
+	}
 	spi_transfer(LCD_SPI,buffer,0,len,1);
 }    
 
+static void port_lcd_spi_write16(uint16_t* buffer, uint32_t len)
+{
+	spi_dma_wait(LCD_SPI);
+	spi_set_databits(LCD_SPI, 16);
+	if(s_lcd_dma && (len*2 >= LCD_DMA_MIN)){
+		if(spi_transfer_dma(LCD_SPI, (const uint8_t*)buffer, len*2, port_lcd_dma_done) == 0){
+			s_lcd_dma_starts++;
+			return;
+		}
+	}
+	spi_transfer16(LCD_SPI,buffer,len,1);
+}
+
+static void port_lcd_spi_write16_rect(uint16_t* buffer, uint32_t w, uint32_t stride, uint32_t h)
+{
+	spi_dma_wait(LCD_SPI);
+	spi_set_databits(LCD_SPI, 16);
+	if(s_lcd_dma && (w*h*2 >= LCD_DMA_MIN)){
+		if(spi_transfer_dma2d(LCD_SPI, (const uint8_t*)buffer, w*2, stride*2, h, port_lcd_dma_done) == 0){
+			s_lcd_dma_starts++;
+			return;
+		}
+	}
+	for(uint32_t i=0; i<h; i++){
+		spi_transfer16(LCD_SPI, buffer + i*stride, w, (i == h-1));  /* 最后一行才拉高CS */
+	}
+}
+
 static void port_lcd_spi_enable(uint8_t val)
 {
 	(void)val;
@@ -88,14 +246,251 @@ static ili9341v_dev_st s_lcd_itf_dev =
     .set_dcx = port_lcd_set_dcx,
     .set_reset = port_lcd_set_reset,
     .write = port_lcd_spi_write,
+    .write16 = port_lcd_spi_write16,
+    .write16_rect = port_lcd_spi_write16_rect,
     .enable = port_lcd_spi_enable,
     .delay = port_lcd_delay_ms,
     .init = port_lcd_init,
     .deinit = port_lcd_deinit,
 
-    .buffer = (uint16_t*)0x90000000,
+    .buffer = LCD_FB(0),
 };
 
+/* 发送队列中剩下的窗口, 某个窗口转为DMA发送时返回, 由DMA完成中断继续 */
+static void lcd_itf_win_next(void)
+{
+	lcd_win_st* w;
+	uint32_t starts;
+	while(s_lcd_win_idx < s_lcd_win_num){
+		w = &s_lcd_win[s_lcd_win_idx++];
+		starts = s_lcd_dma_starts;
+		ili9341v_sync_rect(&s_lcd_itf_dev, w->x0, w->x1, w->y0, w->y1,
+			s_lcd_win_buf + (w->y0 - s_lcd_win_oy)*s_lcd_win_stride + (w->x0 - s_lcd_win_ox), s_lcd_win_stride);
+		if(s_lcd_dma_starts != starts){
+			return;
+		}
+	}
+	s_lcd_win_busy = 0;
+}
+
+/* DMA完成中断中调用, SPI已空闲 */
+static void port_lcd_dma_done(int id)
+{
+	(void)id;
+	if(s_lcd_win_busy){
+		lcd_itf_win_next();
+	}
+}
+
+#if !LCD_ITF_LTDC
+static void lcd_itf_win_add(uint16_t x0, uint16_t x1, uint16_t y0, uint16_t y1)
+{
+	lcd_win_st* w = &s_lcd_win[s_lcd_win_num++];
+	w->x0 = x0;
+	w->x1 = x1;
+	w->y0 = y0;
+	w->y1 = y1;
+}
+
+/* 开始发送队列, 窗口在buffer中, buffer对应LCD的(ox,oy), 调用前上一次的队列需已发完 */
+static void lcd_itf_win_start_buf(uint16_t* buffer, uint16_t ox, uint16_t oy, uint16_t stride)
+{
+	if(s_lcd_win_num == 0){
+		return;
+	}
+	s_lcd_win_buf = buffer;
+	s_lcd_win_ox = ox;
+	s_lcd_win_oy = oy;
+	s_lcd_win_stride = stride;
+	s_lcd_win_idx = 0;
+	s_lcd_win_busy = 1;
+	lcd_itf_win_next();
+}
+
+/* 发送显存中的窗口 */
+static void lcd_itf_win_start(void)
+{
+	lcd_itf_win_start_buf(s_lcd_itf_dev.buffer, 0, 0, LCD_HSIZE);
+}
+#endif
+
+/* CPU访问显存前等待DMA2D写完 */
+static inline void lcd_itf_dma2d_wait(void)
+{
+#if LCD_ITF_LTDC
+	if(s_lcd_dma2d_pending){
+		dma2d_wait();
+		s_lcd_dma2d_pending = 0;
+	}
+#endif
+}
+
+/* 显存cur上改过的块记入其他显存的待复制块 */
+static void lcd_itf_fb_changed(int cur)
+{
+	for(int i=0; i<LCD_FB_NUM; i++){
+		if(i != cur){
+			for(uint32_t ty=0; ty<LCD_TILE_ROWS; ty++){
+				s_lcd_fwd[i][ty] |= s_lcd_changed[ty];
+			}
+		}
+	}
+	memset(s_lcd_changed, 0, sizeof(s_lcd_changed));
+}
+
+/* 把src中mask标记的块复制到dst, 块的行首4字节对齐, 按字复制; LTDC时每段连续的块一次DMA2D复制 */
+static uint32_t lcd_itf_fb_copy(uint16_t* dst, const uint16_t* src, const uint32_t* mask)
+{
+	uint32_t m;
+	uint32_t a;
+	uint32_t b;
+	uint32_t words;
+	uint32_t off;
+	uint32_t bytes = 0;
+#if !LCD_ITF_LTDC
+	uint32_t* d;
+	const uint32_t* s;
+#endif
+	for(uint32_t ty=0; ty<LCD_TILE_ROWS; ty++){
+		m = mask[ty];
+		while(m != 0){
+			a = (uint32_t)__builtin_ctz(m);
+			b = a;
+			while((b+1 < LCD_TILE_COLS) && (m & (1u<<(b+1)))){
+				b++;
+			}
+			m &= (b == 31) ? 0 : ~((1u << (b+1)) - 1);
+			words = (b - a + 1)*LCD_TILE/2;
+#if LCD_ITF_LTDC
+			off = ty*LCD_TILE*LCD_HSIZE + a*LCD_TILE;
+			dma2d_copy(dst + off, LCD_HSIZE, src + off, LCD_HSIZE, words*2, LCD_TILE);
+			s_lcd_dma2d_pending = 1;
+#else
+			for(uint32_t y=ty*LCD_TILE; y<(ty+1)*LCD_TILE; y++){
+				off = y*LCD_HSIZE + a*LCD_TILE;
+				d = (uint32_t*)(dst + off);
+				s = (const uint32_t*)(src + off);
+				for(uint32_t k=0; k<words; k++){
+					d[k] = s[k];
+				}
+			}
+#endif
+			bytes += words*4*LCD_TILE;
+		}
+	}
+	return bytes;
+}
+
+#if !LCD_ITF_LTDC
+/**
+ * 把[ty0,ty1]行中的脏块合并成矩形窗口: 取一行中连续的一段, 向下扩展到下面的行不完全包含这一段为止,
+ * send为1时加入发送队列并清除, 返回估计的开销(折合字节), bytes为像素字节数
+ */
+static uint32_t lcd_itf_windows(uint32_t* dirty, uint32_t ty0, uint32_t ty1, int send, uint32_t* bytes, uint32_t* num)
+{
+	uint32_t cost = 0;
+	uint32_t a;
+	uint32_t b;
+	uint32_t h;
+	uint32_t run;
+	uint32_t w_px;
+	uint32_t h_px;
+	for(uint32_t ty=ty0; ty<=ty1; ty++){
+		while(dirty[ty] != 0){
+			a = (uint32_t)__builtin_ctz(dirty[ty]);
+			b = a;
+			while((b+1 < LCD_TILE_COLS) && (dirty[ty] & (1u<<(b+1)))){
+				b++;
+			}
+			run = (b - a == 31) ? 0xFFFFFFFFu : (((1u << (b - a + 1)) - 1) << a);
+			h = 1;
+			while((ty + h <= ty1) && ((dirty[ty+h] & run) == run)){
+				h++;
+			}
+			for(uint32_t k=0; k<h; k++){
+				dirty[ty+k] &= ~run;
+			}
+			w_px = (b - a + 1)*LCD_TILE;
+			h_px = h*LCD_TILE;
+			*bytes += w_px*h_px*2;
+			cost += w_px*h_px*2 + LCD_WIN_COST + ((w_px < LCD_HSIZE) ? h_px*LCD_ROW_COST : 0);
+			(*num)++;
+			if(send){
+				lcd_itf_win_add(a*LCD_TILE, (b+1)*LCD_TILE-1, ty*LCD_TILE, ty*LCD_TILE+h_px-1);
+			}
+		}
+	}
+	return cost;
+}
+
+/* 刷新[ty0,ty1]行的脏块, 调用前上一次的刷新需已完成 */
+static int lcd_itf_sync_dirty(uint32_t ty0, uint32_t ty1)
+{
+	uint32_t tmp[LCD_TILE_ROWS];
+	uint32_t bytes = 0;
+	uint32_t num = 0;
+	uint32_t full = (ty1 - ty0 + 1)*LCD_TILE*LCD_HSIZE*2;
+	uint32_t cost;
+	memcpy(tmp, s_lcd_dirty, sizeof(tmp));
+	cost = lcd_itf_windows(tmp, ty0, ty1, 0, &bytes, &num);
+	s_lcd_stat.syncs++;
+	if(num == 0){
+		s_lcd_stat.bytes_last = 0;
+		return 0;
+	}
+	s_lcd_win_num = 0;
+	if((cost >= full + LCD_WIN_COST) || (num > LCD_WIN_MAX)){
+		/* 窗口太碎, 整个行带一次发完 */
+		for(uint32_t ty=ty0; ty<=ty1; ty++){
+			s_lcd_dirty[ty] = 0;
+		}
+		s_lcd_stat.full++;
+		s_lcd_stat.windows++;
+		s_lcd_stat.bytes_last = full;
+		s_lcd_stat.bytes_sum += full;
+		lcd_itf_win_add(0, LCD_HSIZE-1, ty0*LCD_TILE, (ty1+1)*LCD_TILE-1);
+		lcd_itf_win_start();
+		return 0;
+	}
+	bytes = 0;
+	num = 0;
+	lcd_itf_windows(s_lcd_dirty, ty0, ty1, 1, &bytes, &num);
+	s_lcd_stat.windows += num;
+	s_lcd_stat.bytes_last = bytes;
+	s_lcd_stat.bytes_sum += bytes;
+	lcd_itf_win_start();
+	return 0;
+}
+#endif
+
+#if LCD_ITF_LTDC
+/* LTDC持续扫描显存, 刷新不需要发送, 只清除脏块和计数 */
+static int lcd_itf_sync_ltdc(uint32_t ty0, uint32_t ty1)
+{
+	for(uint32_t ty=ty0; ty<=ty1; ty++){
+		s_lcd_dirty[ty] = 0;
+	}
+	s_lcd_stat.syncs++;
+	s_lcd_stat.bytes_last = 0;
+	return 0;
+}
+
+/* RGB565扩展为RGB888, 低位补高位, DMA2D转回RGB565时与原值相同 */
+static inline uint32_t lcd_itf_565to888(uint32_t c)
+{
+	uint32_t r = c >> 11;
+	uint32_t g = (c >> 5) & 0x3F;
+	uint32_t b = c & 0x1F;
+	return (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+}
+#else
+/* 一个分量按透明度混合 */
+static inline uint32_t lcd_itf_mix(uint32_t f, uint32_t b, uint32_t a)
+{
+	return (f*a + b*(255 - a) + 127) / 255;
+}
+#endif
+
 /******************************************************************************
  *                        以下是对外操作接口
  * 
@@ -110,7 +505,24 @@ static ili9341v_dev_st s_lcd_itf_dev =
 */
 int lcd_itf_init(void)
 {
-    return ili9341v_init(&s_lcd_itf_dev);
+    int ret;
+    lcd_itf_mark(0, LCD_HSIZE, 0, LCD_VSIZE);
+    ret = ili9341v_init(&s_lcd_itf_dev);
+#if LCD_ITF_LTDC
+    if(ret != 0){
+        return ret;
+    }
+    /* SPI只发初始化命令, 之后像素数据由LTDC从显存扫描输出 */
+    dma2d_init();
+    s_lcd_clut_src = 0;
+    dma2d_fill(s_lcd_itf_dev.buffer, LCD_HSIZE, LCD_HSIZE, LCD_VSIZE, 0);
+    dma2d_wait();
+    ret = ili9341v_rgb_mode(&s_lcd_itf_dev);
+    if(ret == 0){
+        ret = ltdc_init(&s_lcd_ltdc_cfg, s_lcd_itf_dev.buffer);
+    }
+#endif
+    return ret;
 }
 
 /**
@@ -126,13 +538,59 @@ int lcd_itf_deinit(void)
 
 /**
  * \fn lcd_itf_sync
- * 刷新显示
+ * 刷新显示, 使能脏块时只发送修改过的区域, 使能DMA时启动发送后立即返回; LTDC时不需要发送
  * \retval 0 成功
  * \retval 其他值 失败
 */
 int lcd_itf_sync(void)
 {
-    return ili9341v_sync(&s_lcd_itf_dev, 0, LCD_HSIZE-1, 0, LCD_VSIZE-1, s_lcd_itf_dev.buffer, LCD_HSIZE*LCD_VSIZE*2);
+#if LCD_ITF_LTDC
+    return lcd_itf_sync_ltdc(0, LCD_TILE_ROWS-1);
+#else
+    lcd_itf_sync_wait();
+    if(s_lcd_dirty_enable){
+        return lcd_itf_sync_dirty(0, LCD_TILE_ROWS-1);
+    }
+    memset(s_lcd_dirty, 0, sizeof(s_lcd_dirty));
+    s_lcd_stat.syncs++;
+    s_lcd_stat.full++;
+    s_lcd_stat.bytes_last = LCD_HSIZE*LCD_VSIZE*2;
+    s_lcd_stat.bytes_sum += LCD_HSIZE*LCD_VSIZE*2;
+    s_lcd_win_num = 0;
+    lcd_itf_win_add(0, LCD_HSIZE-1, 0, LCD_VSIZE-1);
+    lcd_itf_win_start();
+    return 0;
+#endif
+}
+
+/**
+ * \fn lcd_itf_sync_rows
+ * 刷新显示的行[y,y+h), 使能DMA时启动发送后立即返回
+ * \param[in] y 开始行
+ * \param[in] h 行数
+ * \retval 0 成功
+ * \retval 其他值 失败
+*/
+int lcd_itf_sync_rows(uint16_t y, uint16_t h)
+{
+#if LCD_ITF_LTDC
+    return lcd_itf_sync_ltdc(y/LCD_TILE, (y+h-1)/LCD_TILE);
+#else
+    lcd_itf_sync_wait();
+    if(s_lcd_dirty_enable){
+        return lcd_itf_sync_dirty(y/LCD_TILE, (y+h-1)/LCD_TILE);
+    }
+    for(uint32_t ty=y/LCD_TILE; ty<=(uint32_t)(y+h-1)/LCD_TILE; ty++){
+        s_lcd_dirty[ty] = 0;
+    }
+    s_lcd_stat.syncs++;
+    s_lcd_stat.bytes_last = LCD_HSIZE*h*2;
+    s_lcd_stat.bytes_sum += LCD_HSIZE*h*2;
+    s_lcd_win_num = 0;
+    lcd_itf_win_add(0, LCD_HSIZE-1, y, y+h-1);
+    lcd_itf_win_start();
+    return 0;
+#endif
 }
 
 /**
@@ -152,7 +610,10 @@ void lcd_itf_set_pixel(uint16_t x, uint16_t y, uint16_t rgb565)
     //{
     //    return -1;
     //}
+    lcd_itf_dma2d_wait();
     s_lcd_itf_dev.buffer[y*LCD_HSIZE + x] = rgb565;
+    s_lcd_dirty[y/LCD_TILE] |= 1u << (x/LCD_TILE);
+    s_lcd_changed[y/LCD_TILE] |= 1u << (x/LCD_TILE);
 }
 
 /**
@@ -163,7 +624,9 @@ void lcd_itf_set_pixel(uint16_t x, uint16_t y, uint16_t rgb565)
 */
 void lcd_itf_set_pixel_0(uint32_t offset, uint16_t rgb565)
 {
+    lcd_itf_dma2d_wait();
     s_lcd_itf_dev.buffer[offset] = rgb565;
+    lcd_itf_mark(offset % LCD_HSIZE, 1, offset / LCD_HSIZE, 1);
 }
 
 /**
@@ -175,6 +638,7 @@ void lcd_itf_set_pixel_0(uint32_t offset, uint16_t rgb565)
 */
 uint16_t lcd_itf_get_pixel(uint16_t x, uint16_t y)
 {
+    lcd_itf_dma2d_wait();
     uint16_t color = s_lcd_itf_dev.buffer[y*LCD_HSIZE + x]; 
     return color;
 }
@@ -190,12 +654,26 @@ uint16_t lcd_itf_get_pixel(uint16_t x, uint16_t y)
 */
 void lcd_itf_fill_direct(uint16_t x, uint16_t w, uint16_t y, uint16_t h, uint16_t* buffer)
 {
+#if LCD_ITF_LTDC
+		/* 直接写正在扫描的显存, 不标记, 和SPI时一样在下一次绘制该区域时被覆盖 */
+		uint16_t* p = LCD_FB(s_lcd_fb_front) + y*LCD_HSIZE + x;
+		lcd_itf_dma2d_wait();
+		for(int i=0; i<h; i++){
+			for(int j=0; j<w; j++){
+				p[j] = *buffer++;
+			}
+			p += LCD_HSIZE;
+		}
+#else
+		lcd_itf_sync_wait();
 		ili9341v_sync(&s_lcd_itf_dev, x, x+w-1, y, y+h-1, buffer, w*h*2);
+		spi_dma_wait(LCD_SPI);  /* buffer由调用者提供, 返回前发完 */
+#endif
 }
 
 /**
  * \fn lcd_itf_fill
- * 填充区域为指定颜色
+ * 填充区域为指定颜色, LTDC时大的区域由DMA2D填充, 启动后立即返回
  * \param[in] x x开始坐标位置
  * \param[in] w 宽度
  * \param[in] y y开始坐标位置
@@ -206,6 +684,15 @@ void lcd_itf_fill(uint16_t x, uint16_t w, uint16_t y, uint16_t h, uint16_t rgb)
 {
 	uint16_t* s = s_lcd_itf_dev.buffer; 
 	uint16_t* p;
+	lcd_itf_mark(x, w, y, h);
+#if LCD_ITF_LTDC
+	if((uint32_t)w*h >= LCD_DMA2D_MIN){
+		dma2d_fill(s + y*LCD_HSIZE + x, LCD_HSIZE, w, h, rgb);
+		s_lcd_dma2d_pending = 1;
+		return;
+	}
+#endif
+	lcd_itf_dma2d_wait();
 	for(int i=0; i<h; i++){
 		p = s + (y+i)*LCD_HSIZE + x;
 		for(int j=0; j<w; j++){
@@ -223,6 +710,364 @@ void lcd_itf_fill(uint16_t x, uint16_t w, uint16_t y, uint16_t h, uint16_t rgb)
 */
 void lcd_itf_set_pixel_direct(uint16_t x, uint16_t y, uint16_t rgb565)
 {
+#if LCD_ITF_LTDC
+		lcd_itf_dma2d_wait();
+		LCD_FB(s_lcd_fb_front)[y*LCD_HSIZE + x] = rgb565;
+#else
 		uint16_t tmp = rgb565;
+		lcd_itf_sync_wait();
 		ili9341v_sync(&s_lcd_itf_dev, x, x, y, y, &tmp, 2);
+#endif
+}
+
+/**
+ * \fn lcd_itf_buffer
+ * 获取显存, 一行LCD_HSIZE个点, lcd_itf_frame_begin和lcd_itf_frame_end之间为后缓存
+ * \return 显存地址
+*/
+uint16_t* lcd_itf_buffer(void)
+{
+	lcd_itf_dma2d_wait();
+	return s_lcd_itf_dev.buffer;
+}
+
+/**
+ * \fn lcd_itf_sync_busy
+ * 查询刷新是否进行中
+ * \retval 1 发送进行中, 不能修改正在发送的显存
+ * \retval 0 空闲
+*/
+int lcd_itf_sync_busy(void)
+{
+#if LCD_ITF_LTDC
+	if(s_lcd_dma2d_pending && dma2d_busy()){
+		return 1;
+	}
+#endif
+	return s_lcd_win_busy || spi_dma_busy(LCD_SPI);
+}
+
+/**
+ * \fn lcd_itf_sync_wait
+ * 等待刷新完成(包括队列中的窗口), LTDC时等待DMA2D完成
+*/
+void lcd_itf_sync_wait(void)
+{
+	lcd_itf_dma2d_wait();
+	while(s_lcd_win_busy);
+	spi_dma_wait(LCD_SPI);
+}
+
+/**
+ * \fn lcd_itf_dma
+ * 使能/禁止DMA刷新
+ * \param[in] enable 1使能 0禁止(查询发送)
+ * \return 总是返回0
+*/
+int lcd_itf_dma(int enable)
+{
+	lcd_itf_sync_wait();
+	s_lcd_dma = (enable != 0);
+	return 0;
+}
+
+/**
+ * \fn lcd_itf_spi16
+ * 像素数据使用16位/8位帧
+ * \param[in] enable 1:16位帧 0:8位帧, 显存是本机字节序, 8位帧时颜色高低字节颠倒, 只用于对比
+ * \return 总是返回0
+*/
+int lcd_itf_spi16(int enable)
+{
+	lcd_itf_sync_wait();
+	s_lcd_spi16 = (enable != 0);
+	s_lcd_itf_dev.write16 = s_lcd_spi16 ? port_lcd_spi_write16 : 0;
+	s_lcd_itf_dev.write16_rect = s_lcd_spi16 ? port_lcd_spi_write16_rect : 0;
+	return 0;
+}
+
+/**
+ * \fn lcd_itf_dma_print
+ * 打印DMA刷新状态和统计
+*/
+void lcd_itf_dma_print(void)
+{
+	uint32_t xfers;
+	uint32_t chunks;
+	uint32_t errs;
+	spi_dma_stat(LCD_SPI, &xfers, &chunks, &errs);
+	xprintf("lcd dma %s spi %dbit xfers %u chunks %u errs %u\r\n", s_lcd_dma ? "on" : "off", s_lcd_spi16 ? 16 : 8,
+		xfers, chunks, errs);
+}
+
+/**
+ * \fn lcd_itf_mark
+ * 标记显存区域已修改, 直接写lcd_itf_buffer()后调用, 下次刷新时发送
+ * \param[in] x x开始坐标位置
+ * \param[in] w 宽度
+ * \param[in] y y开始坐标位置
+ * \param[in] h 高度
+*/
+void lcd_itf_mark(uint16_t x, uint16_t w, uint16_t y, uint16_t h)
+{
+	uint32_t tx0;
+	uint32_t tx1;
+	uint32_t mask;
+	if((w == 0) || (h == 0) || (x >= LCD_HSIZE) || (y >= LCD_VSIZE)){
+		return;
+	}
+	if(x + w > LCD_HSIZE){
+		w = LCD_HSIZE - x;
+	}
+	if(y + h > LCD_VSIZE){
+		h = LCD_VSIZE - y;
+	}
+	tx0 = x/LCD_TILE;
+	tx1 = (x+w-1)/LCD_TILE;
+	mask = (tx1 - tx0 == 31) ? 0xFFFFFFFFu : (((1u << (tx1 - tx0 + 1)) - 1) << tx0);
+	for(uint32_t ty=y/LCD_TILE; ty<=(uint32_t)(y+h-1)/LCD_TILE; ty++){
+		s_lcd_dirty[ty] |= mask;
+		s_lcd_changed[ty] |= mask;
+	}
+}
+
+/**
+ * \fn lcd_itf_dirty
+ * 使能/禁止脏块刷新, 禁止时每次刷新发送整个区域
+ * \param[in] enable 1使能 0禁止
+ * \return 总是返回0
+*/
+int lcd_itf_dirty(int enable)
+{
+	lcd_itf_sync_wait();
+	s_lcd_dirty_enable = (enable != 0);
+	lcd_itf_mark(0, LCD_HSIZE, 0, LCD_VSIZE);
+	memset(&s_lcd_stat, 0, sizeof(s_lcd_stat));
+	return 0;
+}
+
+/**
+ * \fn lcd_itf_sync_print
+ * 打印刷新统计: 刷新次数, 整屏发送次数, 窗口数, 每次发送的字节数
+*/
+void lcd_itf_sync_print(void)
+{
+	xprintf("lcd dirty %s syncs %u full %u windows %u\r\n", s_lcd_dirty_enable ? "on" : "off",
+		s_lcd_stat.syncs, s_lcd_stat.full, s_lcd_stat.windows);
+	xprintf("bytes last %u avg %u (full %u)\r\n", s_lcd_stat.bytes_last,
+		(s_lcd_stat.syncs > 0) ? s_lcd_stat.bytes_sum/s_lcd_stat.syncs : 0, LCD_HSIZE*LCD_VSIZE*2);
+	xprintf("fb %d front %d frames %u stalls %u (%u uS) copy avg %u\r\n", LCD_FB_NUM, s_lcd_fb_front,
+		s_lcd_stat.frames, s_lcd_stat.stalls, s_lcd_stat.stall_cycles / (clock_get_ahb() / 1000000),
+		(s_lcd_stat.frames > 0) ? s_lcd_stat.copy_bytes/s_lcd_stat.frames : 0);
+	xprintf("bands %u bytes %u\r\n", s_lcd_stat.bands, s_lcd_stat.band_bytes);
+#if LCD_ITF_LTDC
+	uint32_t ops;
+	uint32_t pixels;
+	uint32_t errs;
+	dma2d_stat(&ops, &pixels, &errs);
+	xprintf("ltdc reloads %u dma2d ops %u pixels %u errs %u\r\n", ltdc_reloads(), ops, pixels, errs);
+#endif
+}
+
+/**
+ * \fn lcd_itf_frame_begin
+ * 开始绘制一帧: 等待后缓存不再被发送, 补上前缓存上一帧的修改, 之后的绘制接口都作用于后缓存
+ * LTDC时等待后缓存不再被扫描(上一次切换已生效), 由DMA2D复制
+ * \return 后缓存地址, 一行LCD_HSIZE个点
+*/
+uint16_t* lcd_itf_frame_begin(void)
+{
+	uint8_t back = (uint8_t)((s_lcd_fb_front + 1) % LCD_FB_NUM);
+	uint32_t t0;
+	if(s_lcd_in_frame){
+		return s_lcd_itf_dev.buffer;
+	}
+	if(lcd_itf_sync_busy() && (s_lcd_win_buf == LCD_FB(back))){
+		t0 = clock_get_cycles();
+		lcd_itf_sync_wait();
+		s_lcd_stat.stalls++;
+		s_lcd_stat.stall_cycles += clock_get_cycles() - t0;
+	}
+#if LCD_ITF_LTDC
+	/* 后缓存是上一次切换前扫描的显存(只有两个显存时), 切换在垂直消隐时才生效 */
+	if((back == (s_lcd_fb_front + LCD_FB_NUM - 1) % LCD_FB_NUM) && ltdc_pending()){
+		t0 = clock_get_cycles();
+		while(ltdc_pending());
+		s_lcd_stat.stalls++;
+		s_lcd_stat.stall_cycles += clock_get_cycles() - t0;
+	}
+#endif
+	/* 帧外在前缓存上的绘制也要复制到其他显存 */
+	lcd_itf_fb_changed(s_lcd_fb_front);
+	if(back != s_lcd_fb_front){
+		s_lcd_stat.copy_bytes += lcd_itf_fb_copy(LCD_FB(back), LCD_FB(s_lcd_fb_front), s_lcd_fwd[back]);
+	}
+	memset(s_lcd_fwd[back], 0, sizeof(s_lcd_fwd[back]));
+	s_lcd_fb_back = back;
+	s_lcd_itf_dev.buffer = LCD_FB(back);
+	s_lcd_in_frame = 1;
+	lcd_itf_dma2d_wait();
+	return s_lcd_itf_dev.buffer;
+}
+
+/**
+ * \fn lcd_itf_frame_end
+ * 提交后缓存: 等待上一帧发送完后启动发送(只发送修改过的块)并立即返回, 后缓存成为前缓存
+ * LTDC时等DMA2D写完后切换扫描的显存, 垂直消隐时生效
+ * 返回后不能再写这一帧的显存, 下一帧用lcd_itf_frame_begin获取新的后缓存
+ * \retval 0 成功
+ * \retval -1 没有调用lcd_itf_frame_begin
+*/
+int lcd_itf_frame_end(void)
+{
+	int ret;
+	if(s_lcd_in_frame == 0){
+		return -1;
+	}
+	s_lcd_in_frame = 0;
+	lcd_itf_fb_changed(s_lcd_fb_back);
+#if LCD_ITF_LTDC
+	lcd_itf_dma2d_wait();
+	ltdc_set_fb(LCD_FB(s_lcd_fb_back));
+#endif
+	ret = lcd_itf_sync();
+	s_lcd_fb_front = s_lcd_fb_back;
+	s_lcd_stat.frames++;
+	return ret;
+}
+
+/**
+ * \fn lcd_itf_band_begin
+ * 开始绘制一个行带: 返回内部SRAM中的行带缓存, 不经过显存, 等待该缓存不再被发送
+ * \param[in] x x开始坐标位置
+ * \param[in] w 宽度, 需为偶数
+ * \param[in] y y开始坐标位置
+ * \param[in] h 行数, 最多LCD_BAND_ROWS
+ * \return 行带缓存, 一行w个点, 4字节对齐; 参数错误返回0
+*/
+uint16_t* lcd_itf_band_begin(uint16_t x, uint16_t w, uint16_t y, uint16_t h)
+{
+	uint16_t* buf = s_lcd_band[s_lcd_band_idx];
+	uint32_t t0;
+	if(s_lcd_in_band || s_lcd_in_frame || (w == 0) || (h == 0) || (h > LCD_BAND_ROWS) || ((w & 1) != 0) ||
+		(x + w > LCD_HSIZE) || (y + h > LCD_VSIZE)){
+		return 0;
+	}
+	if(lcd_itf_sync_busy() && (s_lcd_win_buf == buf)){
+		t0 = clock_get_cycles();
+		lcd_itf_sync_wait();
+		s_lcd_stat.stalls++;
+		s_lcd_stat.stall_cycles += clock_get_cycles() - t0;
+	}
+	/* LTDC时DMA2D串行执行, 另一个行带的复制启动前这个行带的复制已完成, 不需等待 */
+	s_lcd_band_x = x;
+	s_lcd_band_w = w;
+	s_lcd_band_y = y;
+	s_lcd_band_h = h;
+	s_lcd_in_band = 1;
+	return buf;
+}
+
+/**
+ * \fn lcd_itf_band_end
+ * 提交行带: 等待上一个行带发送完后启动发送并立即返回, 下一个行带使用另一个缓存.
+ * 显存中的这块区域已和LCD不同, 标记为修改, 之后按显存刷新时重新发送
+ * \retval 0 成功
+ * \retval -1 没有调用lcd_itf_band_begin
+*/
+int lcd_itf_band_end(void)
+{
+	if(s_lcd_in_band == 0){
+		return -1;
+	}
+	s_lcd_in_band = 0;
+#if LCD_ITF_LTDC
+	/* 行带复制到正在扫描的显存 */
+	dma2d_copy(s_lcd_itf_dev.buffer + s_lcd_band_y*LCD_HSIZE + s_lcd_band_x, LCD_HSIZE,
+		s_lcd_band[s_lcd_band_idx], s_lcd_band_w, s_lcd_band_w, s_lcd_band_h);
+	s_lcd_dma2d_pending = 1;
+#else
+	lcd_itf_sync_wait();
+	s_lcd_win_num = 0;
+	lcd_itf_win_add(s_lcd_band_x, s_lcd_band_x + s_lcd_band_w - 1, s_lcd_band_y, s_lcd_band_y + s_lcd_band_h - 1);
+	lcd_itf_win_start_buf(s_lcd_band[s_lcd_band_idx], s_lcd_band_x, s_lcd_band_y, s_lcd_band_w);
+#endif
+	s_lcd_band_idx ^= 1;
+	lcd_itf_mark(s_lcd_band_x, s_lcd_band_w, s_lcd_band_y, s_lcd_band_h);
+	s_lcd_stat.bands++;
+	s_lcd_stat.band_bytes += (uint32_t)s_lcd_band_w*s_lcd_band_h*2;
+	return 0;
+}
+
+/**
+ * \fn lcd_itf_blit_l8
+ * 8位索引图按调色板转换为RGB565写入显存区域并标记, LTDC时由DMA2D转换, 启动后立即返回
+ * \param[in] x x开始坐标位置
+ * \param[in] w 宽度
+ * \param[in] y y开始坐标位置
+ * \param[in] h 高度
+ * \param[in] src 索引, 一行stride个点
+ * \param[in] stride 源一行的点数
+ * \param[in] lut 256个RGB565
+*/
+void lcd_itf_blit_l8(uint16_t x, uint16_t w, uint16_t y, uint16_t h, const uint8_t* src, uint32_t stride, const uint16_t* lut)
+{
+	uint16_t* dst = s_lcd_itf_dev.buffer + y*LCD_HSIZE + x;
+	lcd_itf_mark(x, w, y, h);
+#if LCD_ITF_LTDC
+	if(lut != s_lcd_clut_src){
+		/* 换调色板, 等用旧表的操作和加载完成后再改s_lcd_clut */
+		dma2d_wait();
+		for(int i=0; i<256; i++){
+			s_lcd_clut[i] = lcd_itf_565to888(lut[i]);
+		}
+		dma2d_clut(s_lcd_clut, 1);
+		s_lcd_clut_src = lut;
+	}
+	dma2d_l8(dst, LCD_HSIZE, src, stride, w, h);
+	s_lcd_dma2d_pending = 1;
+#else
+	for(int i=0; i<h; i++){
+		for(int j=0; j<w; j++){
+			dst[j] = lut[src[j]];
+		}
+		dst += LCD_HSIZE;
+		src += stride;
+	}
+#endif
+}
+
+/**
+ * \fn lcd_itf_blend
+ * RGB565图以恒定透明度叠加到显存区域并标记, LTDC时由DMA2D混合, 启动后立即返回
+ * \param[in] x x开始坐标位置
+ * \param[in] w 宽度
+ * \param[in] y y开始坐标位置
+ * \param[in] h 高度
+ * \param[in] src 前景, 一行stride个点
+ * \param[in] stride 前景一行的点数
+ * \param[in] alpha 前景透明度 0~255
+*/
+void lcd_itf_blend(uint16_t x, uint16_t w, uint16_t y, uint16_t h, const uint16_t* src, uint32_t stride, uint8_t alpha)
+{
+	uint16_t* dst = s_lcd_itf_dev.buffer + y*LCD_HSIZE + x;
+	lcd_itf_mark(x, w, y, h);
+#if LCD_ITF_LTDC
+	dma2d_blend(dst, LCD_HSIZE, src, stride, w, h, alpha);
+	s_lcd_dma2d_pending = 1;
+#else
+	uint32_t f;
+	uint32_t b;
+	for(int i=0; i<h; i++){
+		for(int j=0; j<w; j++){
+			f = src[j];
+			b = dst[j];
+			dst[j] = (uint16_t)((lcd_itf_mix(f >> 11, b >> 11, alpha) << 11)
+				| (lcd_itf_mix((f >> 5) & 0x3F, (b >> 5) & 0x3F, alpha) << 5)
+				| lcd_itf_mix(f & 0x1F, b & 0x1F, alpha));
+		}
+		dst += LCD_HSIZE;
+		src += stride;
+	}
+#endif
 }
@@ -10,6 +10,16 @@
 #define LCD_HSIZE ILI9341V_HSIZE
 #define LCD_VSIZE ILI9341V_VSIZE
 
+/**
+ * 显示后端, 编译时选择:
+ * 0 (默认) 显存经SPI发送到ILI9341V的GRAM, 脏块刷新, DMA发送
+ * 1 LTDC从SDRAM显存持续扫描输出到RGB接口, 刷新不需要发送; 填充/复制/L8转换/叠加由DMA2D完成,
+ *   双缓存提交时切换LTDC的显存地址(垂直消隐时生效). SPI只用于初始化命令
+ */
+#ifndef LCD_ITF_LTDC
+#define LCD_ITF_LTDC 0
+#endif
+
 /**
  * \fn lcd_itf_init
  * 初始化
@@ -28,12 +38,22 @@ int lcd_itf_deinit(void);
 
 /**
  * \fn lcd_itf_sync
- * 刷新显示
+ * 刷新显示, 使能DMA时启动发送后立即返回
  * \retval 0 成功
  * \retval 其他值 失败
 */
 int lcd_itf_sync(void);
 
+/**
+ * \fn lcd_itf_sync_rows
+ * 刷新显示的行[y,y+h), 使能DMA时启动发送后立即返回
+ * \param[in] y 开始行
+ * \param[in] h 行数
+ * \retval 0 成功
+ * \retval 其他值 失败
+*/
+int lcd_itf_sync_rows(uint16_t y, uint16_t h);
+
 /**
  * \fn lcd_itf_set_pixel
  * 写点
@@ -83,6 +103,138 @@ void lcd_itf_set_pixel_direct(uint16_t x, uint16_t y, uint16_t rgb565);
 
 void lcd_itf_fill(uint16_t x, uint16_t w, uint16_t y, uint16_t h, uint16_t rgb);
 
+/**
+ * \fn lcd_itf_buffer
+ * 获取显存, 一行LCD_HSIZE个点, lcd_itf_frame_begin和lcd_itf_frame_end之间为后缓存
+ * \return 显存地址
+*/
+uint16_t* lcd_itf_buffer(void);
+
+/**
+ * \fn lcd_itf_sync_busy
+ * 查询刷新是否进行中
+ * \retval 1 发送进行中, 不能修改正在发送的显存
+ * \retval 0 空闲
+*/
+int lcd_itf_sync_busy(void);
+
+/**
+ * \fn lcd_itf_sync_wait
+ * 等待刷新完成(包括队列中的窗口), LTDC时等待DMA2D完成
+*/
+void lcd_itf_sync_wait(void);
+
+/**
+ * \fn lcd_itf_dma
+ * 使能/禁止DMA刷新
+ * \param[in] enable 1使能 0禁止(查询发送)
+ * \return 总是返回0
+*/
+int lcd_itf_dma(int enable);
+
+/**
+ * \fn lcd_itf_spi16
+ * 像素数据使用16位/8位帧
+ * \param[in] enable 1:16位帧 0:8位帧, 显存是本机字节序, 8位帧时颜色高低字节颠倒, 只用于对比
+ * \return 总是返回0
+*/
+int lcd_itf_spi16(int enable);
+
+/**
+ * \fn lcd_itf_dma_print
+ * 打印DMA刷新状态和统计
+*/
+void lcd_itf_dma_print(void);
+
+/**
+ * \fn lcd_itf_mark
+ * 标记显存区域已修改, 直接写lcd_itf_buffer()后调用; lcd_itf_fill/lcd_itf_set_pixel自动标记
+ * 刷新时只发送标记过的10x10块, 相邻块合并成窗口, 窗口太碎时整屏发送
+ * \param[in] x x开始坐标位置
+ * \param[in] w 宽度
+ * \param[in] y y开始坐标位置
+ * \param[in] h 高度
+*/
+void lcd_itf_mark(uint16_t x, uint16_t w, uint16_t y, uint16_t h);
+
+/**
+ * \fn lcd_itf_dirty
+ * 使能/禁止脏块刷新, 禁止时每次刷新发送整个区域, 同时清除统计
+ * \param[in] enable 1使能 0禁止
+ * \return 总是返回0
+*/
+int lcd_itf_dirty(int enable);
+
+/**
+ * \fn lcd_itf_sync_print
+ * 打印刷新统计: 刷新次数, 整屏发送次数, 窗口数, 每次发送的字节数
+*/
+void lcd_itf_sync_print(void);
+
+/**
+ * \fn lcd_itf_frame_begin
+ * 开始绘制一帧: 等待后缓存不再被发送, 补上前缓存上一帧的修改, 之后的绘制接口都作用于后缓存
+ * 显存有LCD_FB_NUM个(默认2个, 0x90000000和0x90025800), 绘制后缓存的同时DMA发送前缓存
+ * \return 后缓存地址, 一行LCD_HSIZE个点
+*/
+uint16_t* lcd_itf_frame_begin(void);
+
+/**
+ * \fn lcd_itf_frame_end
+ * 提交后缓存: 等待上一帧发送完后启动发送(只发送修改过的块)并立即返回, 后缓存成为前缓存
+ * 返回后不能再写这一帧的显存, 下一帧用lcd_itf_frame_begin获取新的后缓存
+ * \retval 0 成功
+ * \retval -1 没有调用lcd_itf_frame_begin
+*/
+int lcd_itf_frame_end(void);
+
+/**
+ * \fn lcd_itf_band_begin
+ * 开始绘制一个行带: 返回内部SRAM中的行带缓存, 不经过显存, 等待该缓存不再被发送
+ * 两个行带缓存轮流使用, 绘制一条的同时DMA发送上一条
+ * \param[in] x x开始坐标位置
+ * \param[in] w 宽度, 需为偶数
+ * \param[in] y y开始坐标位置
+ * \param[in] h 行数, 最多10
+ * \return 行带缓存, 一行w个点, 4字节对齐; 参数错误返回0
+*/
+uint16_t* lcd_itf_band_begin(uint16_t x, uint16_t w, uint16_t y, uint16_t h);
+
+/**
+ * \fn lcd_itf_band_end
+ * 提交行带: 等待上一个行带发送完后启动发送并立即返回, 下一个行带使用另一个缓存.
+ * 显存中的这块区域已和LCD不同, 标记为修改, 之后按显存刷新时重新发送
+ * \retval 0 成功
+ * \retval -1 没有调用lcd_itf_band_begin
+*/
+int lcd_itf_band_end(void);
+
+/**
+ * \fn lcd_itf_blit_l8
+ * 8位索引图按调色板转换为RGB565写入显存区域并标记, LTDC时由DMA2D转换, 启动后立即返回
+ * \param[in] x x开始坐标位置
+ * \param[in] w 宽度
+ * \param[in] y y开始坐标位置
+ * \param[in] h 高度
+ * \param[in] src 索引, 一行stride个点, 不能在CCM; 下一次调用lcd_itf_blit_l8/lcd_itf_blend/lcd_itf_sync_wait返回前不能修改
+ * \param[in] stride 源一行的点数
+ * \param[in] lut 256个RGB565, 按地址缓存转换后的调色板, 内容不能改变(如调色板常量表)
+*/
+void lcd_itf_blit_l8(uint16_t x, uint16_t w, uint16_t y, uint16_t h, const uint8_t* src, uint32_t stride, const uint16_t* lut);
+
+/**
+ * \fn lcd_itf_blend
+ * RGB565图以恒定透明度叠加到显存区域并标记, LTDC时由DMA2D混合, 启动后立即返回
+ * \param[in] x x开始坐标位置
+ * \param[in] w 宽度
+ * \param[in] y y开始坐标位置
+ * \param[in] h 高度
+ * \param[in] src 前景, 一行stride个点, 不能在CCM; 修改前同lcd_itf_blit_l8
+ * \param[in] stride 前景一行的点数
+ * \param[in] alpha 前景透明度 0~255, 255只显示前景
+*/
+void lcd_itf_blend(uint16_t x, uint16_t w, uint16_t y, uint16_t h, const uint16_t* src, uint32_t stride, uint8_t alpha);
+
 #ifdef __cplusplus
     }
 #endif
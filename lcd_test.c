@@ -3,11 +3,11 @@
 #include "xprintf.h"
 
 /**
- * Byte0         Byte1
- * D7~D3  D2~0   D7~5  D4~D0
- * R     |    G       |  B
+ * 显存为本机字节序的RGB565, 像素数据按16位帧发送
+ * D15~D11  D10~D5  D4~D0
+ * R       |  G    |  B
  */
-#define RGB(r,g,b) (((uint16_t)r&0xF8) | ((uint16_t)g>>5) | ((((uint16_t)g&0xE0) | ((uint16_t)b&0x1F))<<8))
+#define RGB(r,g,b) ((uint16_t)((((uint16_t)(r)&0xF8)<<8) | (((uint16_t)(g)&0xFC)<<3) | ((uint16_t)(b)>>3)))
 
 static void rgb_test(void)
 {
@@ -0,0 +1,137 @@
+#include <stdint.h>
+#include "ltdc.h"
+
+#if !LTDC_SIM
+#include "stm32f4_regs.h"
+#include "gpio.h"
+#endif
+
+#define LTDC_SSCR       0x08
+#define LTDC_BPCR       0x0C
+#define LTDC_AWCR       0x10
+#define LTDC_TWCR       0x14
+#define LTDC_GCR        0x18
+#define LTDC_SRCR       0x24
+#define LTDC_BCCR       0x2C
+#define LTDC_L1CR       0x84
+#define LTDC_L1WHPCR    0x88
+#define LTDC_L1WVPCR    0x8C
+#define LTDC_L1PFCR     0x94
+#define LTDC_L1CACR     0x98
+#define LTDC_L1BFCR     0xA0
+#define LTDC_L1CFBAR    0xAC
+#define LTDC_L1CFBLR    0xB0
+#define LTDC_L1CFBLNR   0xB4
+
+#define LTDC_GCR_LTDCEN     (1u<<0)
+#define LTDC_SRCR_IMR       (1u<<0)
+#define LTDC_SRCR_VBR       (1u<<1)
+#define LTDC_LCR_LEN        (1u<<0)
+#define LTDC_PF_RGB565      2
+
+#if LTDC_SIM
+static uint32_t s_ltdc_sim_reg[0x100/4];
+#define LTDC_REG(off)   (*(volatile uint32_t*)((uint8_t*)s_ltdc_sim_reg + (off)))
+#else
+#define LTDC_BASE       0x40016800ul
+#define LTDC_REG(off)   (*(volatile uint32_t*)(LTDC_BASE + (off)))
+#endif
+
+static uint32_t s_ltdc_reloads;
+
+#if !LTDC_SIM
+/* F429I-DISCO的RGB接口引脚, {bank, port, AF} */
+static const uint8_t s_ltdc_pins[][3] = {
+    {'A', 3, 14}, {'A', 4, 14}, {'A', 6, 14}, {'A', 11, 14}, {'A', 12, 14},
+    {'B', 0, 9},  {'B', 1, 9},  {'B', 8, 14}, {'B', 9, 14},  {'B', 10, 14}, {'B', 11, 14},
+    {'C', 6, 14}, {'C', 7, 14}, {'C', 10, 14},
+    {'D', 3, 14}, {'D', 6, 14},
+    {'F', 10, 14},
+    {'G', 6, 14}, {'G', 7, 14}, {'G', 10, 9}, {'G', 11, 14}, {'G', 12, 9},
+};
+
+/* 像素时钟: PLLSAI, VCO输入1MHz(PLLM=8), N=192 */
+static int ltdc_clock_init(const ltdc_cfg_st* cfg){
+    volatile uint32_t *RCC_CR = (void *)(RCC_BASE + 0x00);
+    volatile uint32_t *RCC_PLLSAICFGR = (void *)(RCC_BASE + 0x88);
+    volatile uint32_t *RCC_DCKCFGR = (void *)(RCC_BASE + 0x8C);
+    uint32_t divr;
+    uint32_t timeout = 1000000;
+
+    switch(cfg->div){
+        case 2:  divr = 0; break;
+        case 4:  divr = 1; break;
+        case 8:  divr = 2; break;
+        default: divr = 3; break;
+    }
+    *RCC_CR &= ~RCC_CR_SAION;
+    while(*RCC_CR & RCC_CR_SAIRDY);
+    *RCC_PLLSAICFGR = ((uint32_t)(cfg->pllsai_r & 0x7) << 28) | (4u << 24) | (192u << 6);
+    *RCC_DCKCFGR = (*RCC_DCKCFGR & ~(3u << 16)) | (divr << 16);
+    *RCC_CR |= RCC_CR_SAION;
+    while((*RCC_CR & RCC_CR_SAIRDY) == 0){
+        if(--timeout == 0){
+            return -1;
+        }
+    }
+    return 0;
+}
+#endif
+
+int ltdc_init(const ltdc_cfg_st* cfg, const uint16_t* fb){
+    uint32_t ahbp = cfg->hsync + cfg->hbp - 1;
+    uint32_t avbp = cfg->vsync + cfg->vbp - 1;
+#if !LTDC_SIM
+    volatile uint32_t *RCC_AHB1ENR = (void *)(RCC_BASE + 0x30);
+    volatile uint32_t *RCC_APB2ENR = (void *)(RCC_BASE + 0x44);
+
+    *RCC_AHB1ENR |= 0x7Fu; /* GPIOA~GPIOG */
+    for(uint32_t i=0; i<sizeof(s_ltdc_pins)/sizeof(s_ltdc_pins[0]); i++){
+        gpio_set_alt((void*)GPIOA_BASE, s_ltdc_pins[i][0], s_ltdc_pins[i][1], 0, GPIOx_OSPEEDR_OSPEEDRy_FAST, 0, s_ltdc_pins[i][2]);
+    }
+    if(ltdc_clock_init(cfg) != 0){
+        return -1;
+    }
+    *RCC_APB2ENR |= (1u<<26); /* LTDC */
+    (void)*RCC_APB2ENR;
+#endif
+
+    /* 各段累计值减1, 同步信号和DE都低有效 */
+    LTDC_REG(LTDC_SSCR) = ((uint32_t)(cfg->hsync - 1) << 16) | (cfg->vsync - 1);
+    LTDC_REG(LTDC_BPCR) = (ahbp << 16) | avbp;
+    LTDC_REG(LTDC_AWCR) = ((ahbp + cfg->width) << 16) | (avbp + cfg->height);
+    LTDC_REG(LTDC_TWCR) = ((ahbp + cfg->width + cfg->hfp) << 16) | (avbp + cfg->height + cfg->vfp);
+    LTDC_REG(LTDC_BCCR) = 0;
+
+    /* 层1全屏 */
+    LTDC_REG(LTDC_L1WHPCR) = ((ahbp + cfg->width) << 16) | (ahbp + 1);
+    LTDC_REG(LTDC_L1WVPCR) = ((avbp + cfg->height) << 16) | (avbp + 1);
+    LTDC_REG(LTDC_L1PFCR) = LTDC_PF_RGB565;
+    LTDC_REG(LTDC_L1CACR) = 0xFF;
+    LTDC_REG(LTDC_L1BFCR) = (4u << 8) | 5u;
+    LTDC_REG(LTDC_L1CFBAR) = (uint32_t)(uintptr_t)fb;
+    LTDC_REG(LTDC_L1CFBLR) = ((uint32_t)cfg->width*2 << 16) | (cfg->width*2 + 3);
+    LTDC_REG(LTDC_L1CFBLNR) = cfg->height;
+    LTDC_REG(LTDC_L1CR) = LTDC_LCR_LEN;
+    LTDC_REG(LTDC_SRCR) = LTDC_SRCR_IMR;
+    LTDC_REG(LTDC_GCR) = LTDC_GCR_LTDCEN;
+    s_ltdc_reloads = 0;
+    return 0;
+}
+
+void ltdc_set_fb(const uint16_t* fb){
+    LTDC_REG(LTDC_L1CFBAR) = (uint32_t)(uintptr_t)fb;
+    LTDC_REG(LTDC_SRCR) = LTDC_SRCR_VBR;
+    s_ltdc_reloads++;
+#if LTDC_SIM
+    LTDC_REG(LTDC_SRCR) = 0;
+#endif
+}
+
+int ltdc_pending(void){
+    return (LTDC_REG(LTDC_SRCR) & LTDC_SRCR_VBR) ? 1 : 0;
+}
+
+uint32_t ltdc_reloads(void){
+    return s_ltdc_reloads;
+}
@@ -0,0 +1,70 @@
+#ifndef LTDC_H
+#define LTDC_H
+
+#ifdef __cplusplus
+    extern "C"{
+#endif
+
+#include <stdint.h>
+
+/**
+ * LTDC驱动, 只用层1, RGB565, 持续从显存(SDRAM)扫描输出到RGB接口.
+ * 切换显存地址在垂直消隐时生效, 不会撕裂.
+ * 用-DLTDC_SIM=1编译时寄存器在内存中, 地址切换立即生效, 可以在主机上编译.
+ */
+
+#ifndef LTDC_SIM
+#define LTDC_SIM 0
+#endif
+
+/**
+ * 时序, 单位像素时钟/行
+ */
+typedef struct{
+    uint16_t width;         /**< 有效宽度    */
+    uint16_t height;        /**< 有效高度    */
+    uint8_t hsync;          /**< 行同步宽度  */
+    uint8_t hbp;            /**< 行后沿      */
+    uint8_t hfp;            /**< 行前沿      */
+    uint8_t vsync;          /**< 场同步宽度  */
+    uint8_t vbp;            /**< 场后沿      */
+    uint8_t vfp;            /**< 场前沿      */
+    uint8_t pllsai_r;       /**< PLLSAI R分频 2~7, VCO=192MHz */
+    uint8_t div;            /**< PLLSAIDIVR 2,4,8,16, 像素时钟=192MHz/pllsai_r/div */
+} ltdc_cfg_st;
+
+/**
+ * \fn ltdc_init
+ * 初始化引脚, 像素时钟, 时序和层1, 打开输出
+ * \param[in] cfg 时序
+ * \param[in] fb 显存, RGB565, 一行width个点
+ * \retval 0 成功
+ * \retval -1 PLLSAI未锁定
+*/
+int ltdc_init(const ltdc_cfg_st* cfg, const uint16_t* fb);
+
+/**
+ * \fn ltdc_set_fb
+ * 切换层1的显存, 下一次垂直消隐时生效
+ * \param[in] fb 显存
+*/
+void ltdc_set_fb(const uint16_t* fb);
+
+/**
+ * \fn ltdc_pending
+ * \retval 1 上一次切换还未生效, 旧显存仍在扫描
+ * \retval 0 已生效
+*/
+int ltdc_pending(void);
+
+/**
+ * \fn ltdc_reloads
+ * \return 已请求的切换次数
+*/
+uint32_t ltdc_reloads(void);
+
+#ifdef __cplusplus
+    }
+#endif
+
+#endif
@@ -77,6 +77,9 @@
 
 #define MLX90642_TOTAL_NUMBER_OF_AUX 20
 #define MLX90642_TOTAL_NUMBER_OF_PIXELS 768
+#define MLX90642_NUMBER_OF_COLUMNS 32
+#define MLX90642_NUMBER_OF_ROWS 24
+#define MLX90642_MAX_ROW_BANDS 4
 
 #define MLX90642_POLL_TIME_MS 2
 #define MLX90642_MAX_POLL_TRIES 100
@@ -107,6 +110,13 @@
 #define MLX90642_MS_BYTE(reg)   (reg >> 8)
 #define MLX90642_LS_BYTE(reg)   (reg & 0x00FF)
 
+/** Band of consecutive image rows for the partial (ROI) read-out */
+typedef struct
+{
+    uint8_t startRow;       /**< First row of the band, 0..MLX90642_NUMBER_OF_ROWS-1 */
+    uint8_t numberOfRows;   /**< Number of rows in the band */
+} MLX90642_RowBand_t;
+
 /** Get the ID of the MLX90642 device
  *
  * @param[in] slaveAddr I2C slave address of the device
@@ -128,6 +138,36 @@ int MLX90642_GetID(uint8_t slaveAddr, uint16_t *mlxid);
  */
 int MLX90642_GetFWver(uint8_t slaveAddr, uint8_t *fwver);
 
+/** Start staging configuration changes of the MLX90642 device
+ * @note Until MLX90642_CommitConfig() is called the Set* functions of the config registers (refresh rate,
+ * emissivity, application and I2C config) only update the shadow copy, the Get* functions return the staged values
+ *
+ * @param[in] slaveAddr I2C slave address of the device
+ *
+ * @retval 0 Staging is started
+ *
+ */
+int MLX90642_StageConfig(uint8_t slaveAddr);
+
+/** Write the staged configuration changes to the MLX90642 device
+ * @note Each register is written at most once and only if the value differs from the device value
+ *
+ * @param[in] slaveAddr I2C slave address of the device
+ *
+ * @retval 0 The configuration is written successfully
+ * @retval <0 Error while writing the configuration
+ *
+ */
+int MLX90642_CommitConfig(uint8_t slaveAddr);
+
+/** Drop the shadow copy of the config registers of the MLX90642 device
+ * @note Needed when the registers are changed outside of this library, e.g. after a reset
+ *
+ * @param[in] slaveAddr I2C slave address of the device
+ *
+ */
+void MLX90642_InvalidateConfig(uint8_t slaveAddr);
+
 /** Get the measurement mode of the MLX90642 device
  *
  * @param[in] slaveAddr I2C slave address of the device
@@ -190,6 +230,16 @@ int MLX90642_SetOutputFormat(uint8_t slaveAddr, uint16_t output_format);
  */
 int MLX90642_GetRefreshRate(uint8_t slaveAddr);
 
+/** Get the refresh time of the MLX90642 device
+ *
+ * @param[in] slaveAddr I2C slave address of the device
+ *
+ * @retval >0 Refresh time in ms
+ * @retval <0 Error while getting the refresh rate
+ *
+ */
+int MLX90642_GetRefreshTime(uint8_t slaveAddr);
+
 /** Set the refresh rate of the MLX90642 device
  * @note Refresh rates < 2Hz are not allowed and the device will default to 2Hz
  * @note The current FW version supports refresh rates of up to 15Hz (at 16Hz and 32Hz settings) for the temperature data ouput and up to 20Hz (at 32Hz setting) for the normalized data output
@@ -424,6 +474,59 @@ int MLX90642_MeasureNow(uint8_t slaveAddr, uint16_t *pixVal);
  */
 int MLX90642_GetImage(uint8_t slaveAddr, uint16_t *pixVal);
 
+/** Start a non-blocking read of the image from the MLX90642 device
+ * @note The data phase is handled in the timer interrupt, pixVal must stay valid until the read is done.
+ * Poll for completion with MLX90642_GetImageAsyncPoll() or wait for the callback.
+ *
+ * @param[in] slaveAddr I2C slave address of the device
+ * @param[out] pixVal Pointer to where the image data is stored
+ * @param[in] done Callback called from the interrupt when the read is done, may be NULL
+ *
+ * @retval 0 The read-out is started
+ * @retval <0 Error while starting the read-out
+ *
+ */
+int MLX90642_GetImageAsync(uint8_t slaveAddr, uint16_t *pixVal, MLX90642_I2CDone_pf done);
+
+/** Get the state of the read-out started by MLX90642_GetImageAsync()
+ *
+ * @retval 1 The read-out is in progress
+ * @retval 0 The image is read-out successfully
+ * @retval <0 Error while getting the image
+ *
+ */
+int MLX90642_GetImageAsyncPoll(void);
+
+/** Read only the given row bands of the image from the MLX90642 device
+ * @note The data of each band is stored at its position in the full image, the other rows of pixVal are not touched
+ *
+ * @param[in] slaveAddr I2C slave address of the device
+ * @param[out] pixVal Pointer to the full size image buffer
+ * @param[in] bands Row bands to read
+ * @param[in] numberOfBands Number of row bands, up to @link MLX90642_MAX_ROW_BANDS @endlink
+ *
+ * @retval 0 The rows are read-out successfully
+ * @retval <0 Error while getting the rows
+ *
+ */
+int MLX90642_GetImageRows(uint8_t slaveAddr, uint16_t *pixVal, const MLX90642_RowBand_t *bands, uint8_t numberOfBands);
+
+/** Start a non-blocking read of the given row bands of the image from the MLX90642 device
+ * @note The bands are read one after another from the timer interrupt. Poll for completion with
+ * MLX90642_GetImageAsyncPoll() or wait for the callback.
+ *
+ * @param[in] slaveAddr I2C slave address of the device
+ * @param[out] pixVal Pointer to the full size image buffer
+ * @param[in] bands Row bands to read, copied by the function
+ * @param[in] numberOfBands Number of row bands, up to @link MLX90642_MAX_ROW_BANDS @endlink
+ * @param[in] done Callback called from the interrupt when all bands are read, may be NULL
+ *
+ * @retval 0 The read-out is started
+ * @retval <0 Error while starting the read-out
+ *
+ */
+int MLX90642_GetImageRowsAsync(uint8_t slaveAddr, uint16_t *pixVal, const MLX90642_RowBand_t *bands, uint8_t numberOfBands, MLX90642_I2CDone_pf done);
+
 /** Get the full frame data - raw IR data, aux data and calculated image from the MLX90642 device
  * @note The image will contain temperature data or normalized data depending on the output format set
  *
@@ -33,6 +33,69 @@
 
 int MLX90642_I2CRead(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *rData);
 
+/** Completion callback of an asynchronous block read
+ * @note Called from the timer interrupt
+ *
+ * @param[in] status 0 on success, <0 on I2C error
+ *
+ */
+typedef void (*MLX90642_I2CDone_pf)(int status);
+
+/** MLX90642 asynchronous block read I2C command
+ * @note Only the address phase runs in the caller context. The data phase is stepped by a timer interrupt and
+ * blocking I2C calls wait until it is finished. Use MLX90642_I2CAsyncPoll() or the callback to detect completion.
+ *
+ * @param[in] slaveAddr I2C slave address of the device
+ * @param[in] startAddress Start address for the block read
+ * @param[in] nMemAddressRead Number of words to read
+ * @param[out] rData Pointer to where the read data will be stored, must stay valid until completion
+ * @param[in] done Completion callback, may be NULL
+ *
+ * @retval  <0 Error while starting the read
+ *
+ */
+int MLX90642_I2CReadAsync(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *rData, MLX90642_I2CDone_pf done);
+
+/** Get the state of the last asynchronous block read
+ *
+ * @retval  1 Transfer in progress
+ * @retval  0 Done
+ * @retval  <0 Error of the last transfer
+ *
+ */
+int MLX90642_I2CAsyncPoll(void);
+
+/** Get the number of I2C transactions started since boot
+ * @note Each block read, configuration write and command counts as one transaction
+ *
+ * @retval Number of transactions
+ *
+ */
+uint32_t MLX90642_I2CGetXferCount(void);
+
+/** I2C bus health counters
+ * @note A failed transfer is recovered with 9 SCL pulses and a STOP, then retried from the first word not yet received
+ */
+typedef struct
+{
+    uint32_t nack;      /**< Address or data bytes not acknowledged by the slave */
+    uint32_t retry;     /**< Transfers resumed after a bus recovery */
+    uint32_t recover;   /**< Bus recoveries (9 SCL pulses + STOP) */
+    uint32_t abort;     /**< Transfers given up after the last retry */
+} MLX90642_I2CStat_t;
+
+/** Get the I2C bus health counters
+ *
+ * @retval Pointer to the counters
+ *
+ */
+const MLX90642_I2CStat_t* MLX90642_I2CGetStat(void);
+
+/** Clear the I2C bus health counters
+ *
+ */
+void MLX90642_I2CClearStat(void);
+
 /** MLX90642 configuration I2C command
  * @note For more information refer to the MLX90642 datasheet
  *
@@ -75,4 +138,21 @@ void MLX90642_Wait_ms(uint16_t time_ms);
 
 void MLX90642_Set_Delay(uint32_t delay);
 
+/** Set the I2C SCL frequency
+ * @note The bit-banged backend times every half period with the DWT cycle counter, MLX90642_Set_Delay() switches back to the delay loop
+ *
+ * @param[in] hz Target SCL frequency in Hz
+ *
+ * @retval  <0 Invalid frequency
+ *
+ */
+int MLX90642_Set_ClockHz(uint32_t hz);
+
+/** Select the SDA port of the bit-banged I2C
+ *
+ * @param[in] enable 1: open-drain SDA configured once (default), 0: push-pull SDA reconfigured on every access
+ *
+ */
+void MLX90642_Set_FastIO(uint8_t enable);
+
 #endif
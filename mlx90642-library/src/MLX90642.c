@@ -38,11 +38,182 @@ int MLX90642_GetFWver(uint8_t slaveAddr, uint8_t *fwver)
     return status;
 }
 
+#define MLX90642_CACHE_DEVICES 4
+#define MLX90642_CACHE_REGS 4
+
+static const uint16_t cacheRegAddr[MLX90642_CACHE_REGS] =
+{
+    MLX90642_REFRESH_RATE_ADDRESS,
+    MLX90642_EMISSIVITY_ADDRESS,
+    MLX90642_APPLICATION_CONFIG_ADDRESS,
+    MLX90642_I2C_CONFIG_ADDRESS,
+};
+
+/* Shadow copy of the config registers of one device */
+static struct
+{
+    uint8_t slaveAddr;      /* 0: entry not used */
+    uint8_t valid;          /* bit n: regs[n] holds the device value */
+    uint8_t dirty;          /* bit n: staged[n] is not written yet */
+    uint8_t staging;
+    uint16_t regs[MLX90642_CACHE_REGS];
+    uint16_t staged[MLX90642_CACHE_REGS];
+} configCache[MLX90642_CACHE_DEVICES];
+
+static int MLX90642_CacheEntry(uint8_t slaveAddr)
+{
+
+    int freeEntry = -1;
+
+    for(int i = 0; i < MLX90642_CACHE_DEVICES; i++)
+    {
+        if(configCache[i].slaveAddr == slaveAddr)
+            return i;
+        if((configCache[i].slaveAddr == 0) && (freeEntry < 0))
+            freeEntry = i;
+    }
+
+    /* No free entry, the last one is reused */
+    if(freeEntry < 0)
+        freeEntry = MLX90642_CACHE_DEVICES - 1;
+
+    configCache[freeEntry].slaveAddr = slaveAddr;
+    configCache[freeEntry].valid = 0;
+    configCache[freeEntry].dirty = 0;
+    configCache[freeEntry].staging = 0;
+
+    return freeEntry;
+
+}
+
+static int MLX90642_CacheReg(uint16_t regAddr)
+{
+
+    for(int i = 0; i < MLX90642_CACHE_REGS; i++)
+    {
+        if(cacheRegAddr[i] == regAddr)
+            return i;
+    }
+
+    return -1;
+
+}
+
+static int MLX90642_ReadConfigReg(uint8_t slaveAddr, uint16_t regAddr, uint16_t *data)
+{
+
+    int entry = MLX90642_CacheEntry(slaveAddr);
+    int reg = MLX90642_CacheReg(regAddr);
+    int status;
+
+    if(configCache[entry].dirty & (1u << reg))
+    {
+        *data = configCache[entry].staged[reg];
+        return 0;
+    }
+
+    if(configCache[entry].valid & (1u << reg))
+    {
+        *data = configCache[entry].regs[reg];
+        return 0;
+    }
+
+    status = MLX90642_I2CRead(slaveAddr, regAddr, 1, data);
+    if(status < 0)
+        return status;
+
+    configCache[entry].regs[reg] = *data;
+    configCache[entry].valid |= (1u << reg);
+
+    return status;
+
+}
+
+static int MLX90642_WriteConfigReg(uint8_t slaveAddr, uint16_t regAddr, uint16_t data)
+{
+
+    int entry = MLX90642_CacheEntry(slaveAddr);
+    int reg = MLX90642_CacheReg(regAddr);
+    int status;
+
+    if(configCache[entry].staging)
+    {
+        configCache[entry].staged[reg] = data;
+        configCache[entry].dirty |= (1u << reg);
+        return 0;
+    }
+
+    /* Skip the EEPROM write if the value does not change */
+    if((configCache[entry].valid & (1u << reg)) && (configCache[entry].regs[reg] == data))
+        return 0;
+
+    status = MLX90642_Config(slaveAddr, regAddr, data);
+    MLX90642_Wait_ms(MLX90642_EE_WRITE_TIME);
+
+    if(status < 0)
+    {
+        configCache[entry].valid &= ~(1u << reg);
+        return status;
+    }
+
+    configCache[entry].regs[reg] = data;
+    configCache[entry].valid |= (1u << reg);
+
+    return status;
+
+}
+
+int MLX90642_StageConfig(uint8_t slaveAddr)
+{
+
+    int entry = MLX90642_CacheEntry(slaveAddr);
+
+    configCache[entry].staging = 1;
+
+    return 0;
+
+}
+
+int MLX90642_CommitConfig(uint8_t slaveAddr)
+{
+
+    int entry = MLX90642_CacheEntry(slaveAddr);
+    uint8_t dirty = configCache[entry].dirty;
+    int status = 0;
+
+    configCache[entry].staging = 0;
+    configCache[entry].dirty = 0;
+
+    for(int reg = 0; reg < MLX90642_CACHE_REGS; reg++)
+    {
+        if((dirty & (1u << reg)) == 0)
+            continue;
+
+        status = MLX90642_WriteConfigReg(slaveAddr, cacheRegAddr[reg], configCache[entry].staged[reg]);
+        if(status < 0)
+            break;
+    }
+
+    return status;
+
+}
+
+void MLX90642_InvalidateConfig(uint8_t slaveAddr)
+{
+
+    int entry = MLX90642_CacheEntry(slaveAddr);
+
+    configCache[entry].valid = 0;
+    configCache[entry].dirty = 0;
+    configCache[entry].staging = 0;
+
+}
+
 int MLX90642_GetMeasMode(uint8_t slaveAddr)
 {
 
     uint16_t data;
-    int status = MLX90642_I2CRead(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, 1, &data);
+    int status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, &data);
     if(status < 0)
         return status;
 
@@ -60,16 +231,14 @@ int MLX90642_SetMeasMode(uint8_t slaveAddr, uint16_t meas_mode)
     if((meas_mode != MLX90642_CONT_MEAS_MODE) && (meas_mode != MLX90642_STEP_MEAS_MODE))
         return -MLX90642_INVAL_VAL_ERR;
 
-    status = MLX90642_I2CRead(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, 1, &data);
+    status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, &data);
     if(status < 0)
         return status;
 
     data &= ~MLX90642_MEAS_MODE_MASK;
     data |= meas_mode;
 
-    status = MLX90642_Config(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, data);
-
-    MLX90642_Wait_ms(MLX90642_EE_WRITE_TIME);
+    status = MLX90642_WriteConfigReg(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, data);
 
     return status;
 }
@@ -78,7 +247,7 @@ int MLX90642_GetOutputFormat(uint8_t slaveAddr)
 {
 
     uint16_t data;
-    int status = MLX90642_I2CRead(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, 1, &data);
+    int status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, &data);
     if(status < 0)
         return status;
 
@@ -96,16 +265,14 @@ int MLX90642_SetOutputFormat(uint8_t slaveAddr, uint16_t output_format)
     if((output_format != MLX90642_TEMPERATURE_OUTPUT) && (output_format != MLX90642_NORMALIZED_DATA_OUTPUT))
         return -MLX90642_INVAL_VAL_ERR;
 
-    status = MLX90642_I2CRead(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, 1, &data);
+    status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, &data);
     if(status < 0)
         return status;
 
     data &= ~MLX90642_OUTPUT_FORMAT_MASK;
     data |= output_format;
 
-    status = MLX90642_Config(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, data);
-
-    MLX90642_Wait_ms(MLX90642_EE_WRITE_TIME);
+    status = MLX90642_WriteConfigReg(slaveAddr, MLX90642_APPLICATION_CONFIG_ADDRESS, data);
 
     return status;
 }
@@ -114,7 +281,7 @@ int MLX90642_GetRefreshRate(uint8_t slaveAddr)
 {
 
     uint16_t data;
-    int status = MLX90642_I2CRead(slaveAddr, MLX90642_REFRESH_RATE_ADDRESS, 1, &data);
+    int status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_REFRESH_RATE_ADDRESS, &data);
     if(status < 0)
         return status;
 
@@ -135,15 +302,14 @@ int MLX90642_SetRefreshRate(uint8_t slaveAddr, uint16_t ref_rate)
     if((ref_rate < MLX90642_REF_RATE_2HZ) || (ref_rate > MLX90642_REF_RATE_32HZ))
         return -MLX90642_INVAL_VAL_ERR;
 
-    status = MLX90642_I2CRead(slaveAddr, MLX90642_REFRESH_RATE_ADDRESS, 1, &data);
+    status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_REFRESH_RATE_ADDRESS, &data);
     if(status < 0)
         return status;
 
     data &= ~MLX90642_REFRESH_RATE_MASK;
     data |= ref_rate;
 
-    status = MLX90642_Config(slaveAddr, MLX90642_REFRESH_RATE_ADDRESS, data);
-    MLX90642_Wait_ms(MLX90642_EE_WRITE_TIME);
+    status = MLX90642_WriteConfigReg(slaveAddr, MLX90642_REFRESH_RATE_ADDRESS, data);
 
     return status;
 }
@@ -179,7 +345,7 @@ int MLX90642_GetEmissivity(uint8_t slaveAddr, int16_t *emissivity)
     uint16_t data;
     int status;
 
-    status = MLX90642_I2CRead(slaveAddr, MLX90642_EMISSIVITY_ADDRESS, 1, &data);
+    status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_EMISSIVITY_ADDRESS, &data);
     if(data == 0)
         data = 0x4000;
 
@@ -191,8 +357,7 @@ int MLX90642_GetEmissivity(uint8_t slaveAddr, int16_t *emissivity)
 int MLX90642_SetEmissivity(uint8_t slaveAddr, int16_t emissivity)
 {
 
-    int status = MLX90642_Config(slaveAddr, MLX90642_EMISSIVITY_ADDRESS, (uint16_t)emissivity);
-    MLX90642_Wait_ms(MLX90642_EE_WRITE_TIME);
+    int status = MLX90642_WriteConfigReg(slaveAddr, MLX90642_EMISSIVITY_ADDRESS, (uint16_t)emissivity);
 
     return status;
 }
@@ -201,7 +366,7 @@ int MLX90642_GetI2CMode(uint8_t slaveAddr)
 {
 
     uint16_t data;
-    int status = MLX90642_I2CRead(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, 1, &data);
+    int status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, &data);
     if(status >= 0)
         status = data & MLX90642_I2C_MODE_MASK;
 
@@ -217,15 +382,14 @@ int MLX90642_SetI2CMode(uint8_t slaveAddr, uint8_t i2c_mode)
     if((i2c_mode != MLX90642_I2C_MODE_FM) && (i2c_mode != MLX90642_I2C_MODE_FM_PLUS))
         return -MLX90642_INVAL_VAL_ERR;
 
-    status = MLX90642_I2CRead(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, 1, &data);
+    status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, &data);
     if(status < 0)
         return status;
 
     data &= ~MLX90642_I2C_MODE_MASK;
     data |= i2c_mode;
 
-    status = MLX90642_Config(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, data);
-    MLX90642_Wait_ms(MLX90642_EE_WRITE_TIME);
+    status = MLX90642_WriteConfigReg(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, data);
 
     return status;
 
@@ -235,7 +399,7 @@ int MLX90642_GetSDALimitState(uint8_t slaveAddr)
 {
 
     uint16_t data;
-    int status = MLX90642_I2CRead(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, 1, &data);
+    int status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, &data);
     if(status >= 0)
         status = data & MLX90642_I2C_SDA_CUR_LIMIT_MASK;
 
@@ -251,15 +415,14 @@ int MLX90642_SetSDALimitState(uint8_t slaveAddr, uint8_t sda_limit_state)
     if((sda_limit_state != MLX90642_I2C_SDA_CUR_LIMIT_OFF) && (sda_limit_state != MLX90642_I2C_SDA_CUR_LIMIT_ON))
         return -MLX90642_INVAL_VAL_ERR;
 
-    status = MLX90642_I2CRead(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, 1, &data);
+    status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, &data);
     if(status < 0)
         return status;
 
     data &= ~MLX90642_I2C_SDA_CUR_LIMIT_MASK;
     data |= sda_limit_state;
 
-    status = MLX90642_Config(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, data);
-    MLX90642_Wait_ms(MLX90642_EE_WRITE_TIME);
+    status = MLX90642_WriteConfigReg(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, data);
 
     return status;
 
@@ -269,7 +432,7 @@ int MLX90642_GetI2CLevel(uint8_t slaveAddr)
 {
 
     uint16_t data;
-    int status = MLX90642_I2CRead(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, 1, &data);
+    int status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, &data);
     if(status >= 0)
         status = data & MLX90642_I2C_LEVEL_MASK;
 
@@ -285,15 +448,14 @@ int MLX90642_SetI2CLevel(uint8_t slaveAddr, uint8_t i2c_level)
     if((i2c_level != MLX90642_I2C_LEVEL_VDD) && (i2c_level != MLX90642_I2C_LEVEL_1P8))
         return -MLX90642_INVAL_VAL_ERR;
 
-    status = MLX90642_I2CRead(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, 1, &data);
+    status = MLX90642_ReadConfigReg(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, &data);
     if(status < 0)
         return status;
 
     data &= ~MLX90642_I2C_LEVEL_MASK;
     data |= i2c_level;
 
-    status = MLX90642_Config(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, data);
-    MLX90642_Wait_ms(MLX90642_EE_WRITE_TIME);
+    status = MLX90642_WriteConfigReg(slaveAddr, MLX90642_I2C_CONFIG_ADDRESS, data);
 
     return status;
 
@@ -313,6 +475,8 @@ int MLX90642_SetI2CSlaveAddress(uint8_t slaveAddr, uint8_t new_slaveAddr)
     status = MLX90642_Config(slaveAddr, MLX90642_I2C_SA_ADDRESS, data);
     MLX90642_Wait_ms(MLX90642_EE_WRITE_TIME);
 
+    MLX90642_InvalidateConfig(new_slaveAddr);
+
     return status;
 }
 
@@ -511,10 +675,121 @@ int MLX90642_MeasureNow(uint8_t slaveAddr, uint16_t *pixVal)
 int MLX90642_GetImage(uint8_t slaveAddr, uint16_t *pixVal)
 {
 
+    /* Blocking read runs on the bus in the caller's context, the timer paced path is only for the Async API */
     return MLX90642_I2CRead(slaveAddr, MLX90642_TO_DATA_ADDRESS, MLX90642_TOTAL_NUMBER_OF_PIXELS, pixVal);
 
 }
 
+int MLX90642_GetImageAsync(uint8_t slaveAddr, uint16_t *pixVal, MLX90642_I2CDone_pf done)
+{
+
+    return MLX90642_I2CReadAsync(slaveAddr, MLX90642_TO_DATA_ADDRESS, MLX90642_TOTAL_NUMBER_OF_PIXELS, pixVal, done);
+
+}
+
+int MLX90642_GetImageAsyncPoll(void)
+{
+
+    return MLX90642_I2CAsyncPoll();
+
+}
+
+static struct
+{
+    uint8_t slaveAddr;
+    uint16_t *pixVal;
+    MLX90642_RowBand_t bands[MLX90642_MAX_ROW_BANDS];
+    uint8_t numberOfBands;
+    uint8_t band;
+    MLX90642_I2CDone_pf done;
+} rowsRead;
+
+static void MLX90642_RowBandDone(int status);
+
+static int MLX90642_StartRowBand(void)
+{
+
+    const MLX90642_RowBand_t *band = &rowsRead.bands[rowsRead.band];
+    uint16_t offset = band->startRow * MLX90642_NUMBER_OF_COLUMNS;
+
+    return MLX90642_I2CReadAsync(rowsRead.slaveAddr, MLX90642_TO_DATA_ADDRESS + 2*offset,
+                                 band->numberOfRows * MLX90642_NUMBER_OF_COLUMNS, rowsRead.pixVal + offset, MLX90642_RowBandDone);
+
+}
+
+/* Called from the timer interrupt, chains the next band */
+static void MLX90642_RowBandDone(int status)
+{
+
+    rowsRead.band++;
+    if((status == 0) && (rowsRead.band < rowsRead.numberOfBands))
+    {
+        status = MLX90642_StartRowBand();
+        if(status == 0)
+            return;
+    }
+
+    if(rowsRead.done != 0)
+        rowsRead.done(status);
+
+}
+
+int MLX90642_GetImageRowsAsync(uint8_t slaveAddr, uint16_t *pixVal, const MLX90642_RowBand_t *bands, uint8_t numberOfBands, MLX90642_I2CDone_pf done)
+{
+
+    if((numberOfBands == 0) || (numberOfBands > MLX90642_MAX_ROW_BANDS))
+        return -MLX90642_INVAL_VAL_ERR;
+
+    for(uint8_t i = 0; i < numberOfBands; i++)
+    {
+        if((bands[i].numberOfRows == 0) || (bands[i].startRow + bands[i].numberOfRows > MLX90642_NUMBER_OF_ROWS))
+            return -MLX90642_INVAL_VAL_ERR;
+    }
+
+    /* Wait for a pending read, the band list is used from the interrupt */
+    while(MLX90642_I2CAsyncPoll() > 0);
+
+    rowsRead.slaveAddr = slaveAddr;
+    rowsRead.pixVal = pixVal;
+    for(uint8_t i = 0; i < numberOfBands; i++)
+        rowsRead.bands[i] = bands[i];
+    rowsRead.numberOfBands = numberOfBands;
+    rowsRead.band = 0;
+    rowsRead.done = done;
+
+    return MLX90642_StartRowBand();
+
+}
+
+int MLX90642_GetImageRows(uint8_t slaveAddr, uint16_t *pixVal, const MLX90642_RowBand_t *bands, uint8_t numberOfBands)
+{
+
+    int status;
+    uint16_t offset;
+
+    if((numberOfBands == 0) || (numberOfBands > MLX90642_MAX_ROW_BANDS))
+        return -MLX90642_INVAL_VAL_ERR;
+
+    for(uint8_t i = 0; i < numberOfBands; i++)
+    {
+        if((bands[i].numberOfRows == 0) || (bands[i].startRow + bands[i].numberOfRows > MLX90642_NUMBER_OF_ROWS))
+            return -MLX90642_INVAL_VAL_ERR;
+    }
+
+    /* Same as MLX90642_GetImage, each band is read on the bus in the caller's context */
+    for(uint8_t i = 0; i < numberOfBands; i++)
+    {
+        offset = bands[i].startRow * MLX90642_NUMBER_OF_COLUMNS;
+        status = MLX90642_I2CRead(slaveAddr, MLX90642_TO_DATA_ADDRESS + 2*offset,
+                                  bands[i].numberOfRows * MLX90642_NUMBER_OF_COLUMNS, pixVal + offset);
+        if(status < 0)
+            return status;
+    }
+
+    return 0;
+
+}
+
 int MLX90642_GetFrameData(uint8_t slaveAddr, uint16_t *aux, uint16_t *rawpix, uint16_t *pixVal)
 {
 
@@ -2,7 +2,103 @@
 #include "gpio.h"
 #include "clock.h"
 #include "io_iic.h"
+#include "i2c.h"
+#include "tim.h"
 #include "MLX90642.h"
+#include "MLX90642_sim.h"
+
+/**
+ * IIC后端选择
+ * 0: PA8/PC9 IO模拟IIC(io_iic_dev_st)
+ * 1: I2C3外设, 读数据使用DMA1 Stream2接收
+ */
+#ifndef MLX90642_IIC_HW
+#define MLX90642_IIC_HW 0
+#endif
+
+/**
+ * 1: IO模拟IIC的SCL/SDA接到MLX90642_sim.c仿真器, 没有传感器时运行整个采集流程
+ * 仅MLX90642_IIC_HW为0时有效
+ */
+#ifndef MLX90642_IIC_SIM
+#define MLX90642_IIC_SIM 0
+#endif
+
+#define MLX90642_IIC_HW_ID    3         /* I2C3 */
+#define MLX90642_IIC_HW_SPEED 1000000ul /* FM+ */
+
+#define MLX90642_ASYNC_TIM     7         /* 异步读由TIM7中断推进 */
+#define MLX90642_ASYNC_TICK_HZ 4000ul    /* 中断频率 */
+#define MLX90642_ASYNC_WORDS   8         /* IO模拟时每次中断读的字数 */
+
+#define MLX90642_IIC_RETRY     3         /* 一次传输出错后恢复总线重试的最大次数 */
+
+/**
+ * 异步读状态
+ */
+typedef struct{
+    volatile uint8_t busy;       /**< 1传输中           */
+    volatile int status;         /**< 最近一次传输结果   */
+    uint16_t* data;              /**< 接收缓存          */
+    uint16_t n;                  /**< 待读字数          */
+    uint16_t idx;                /**< 已读字数          */
+    uint8_t slaveAddr;           /**< 从机地址,重试用    */
+    uint8_t retry;               /**< 已重试次数         */
+    uint8_t restart;             /**< 1下次中断从idx处重新寻址 */
+    uint16_t startAddress;       /**< 起始地址,重试用    */
+    MLX90642_I2CDone_pf done;    /**< 完成回调          */
+} MLX90642_async_st;
+
+static MLX90642_async_st s_mlx90642_async;
+static uint32_t s_mlx90642_xfer_cnt = 0;   /* I2C传输次数 */
+static MLX90642_I2CStat_t s_mlx90642_stat; /* 总线健康统计 */
+
+static void MLX90642_I2CAsyncTick(void);
+static int MLX90642_I2CRecover(void);
+
+static void MLX90642_I2CAsyncInit(void){
+    static int s_async_init_flag = 0;
+    if(s_async_init_flag == 0){
+        s_async_init_flag = 1;
+        tim_init(MLX90642_ASYNC_TIM, MLX90642_ASYNC_TICK_HZ, MLX90642_I2CAsyncTick);
+    }
+}
+
+/* 中断中调用,先更新状态再回调 */
+static void MLX90642_I2CAsyncFinish(int status){
+    tim_stop(MLX90642_ASYNC_TIM);
+    s_mlx90642_async.status = status;
+    s_mlx90642_async.busy = 0;
+    if(s_mlx90642_async.done != 0){
+        s_mlx90642_async.done(status);
+    }
+}
+
+/* 阻塞读写前等待异步传输结束,避免打断总线 */
+static void MLX90642_I2CWaitIdle(void){
+    while(s_mlx90642_async.busy);
+}
+
+/**
+ * 传输出错: 统计,恢复总线(9个SCL+STOP)
+ * 返回1调用者从断点重试, 返回0重试次数用完放弃
+ */
+static int MLX90642_I2CFault(int res, uint8_t* retry){
+    if(res == -2){
+        s_mlx90642_stat.nack++;
+    }
+    MLX90642_I2CRecover();
+    s_mlx90642_stat.recover++;
+    if(*retry >= MLX90642_IIC_RETRY){
+        s_mlx90642_stat.abort++;
+        return 0;
+    }
+    (*retry)++;
+    s_mlx90642_stat.retry++;
+    return 1;
+}
+
+#if MLX90642_IIC_HW == 0
 
 /* IIC IO操作的移植 */
 static void io_iic_scl_write_port(uint8_t val)
@@ -10,6 +106,8 @@ static void io_iic_scl_write_port(uint8_t val)
 	gpio_write((void*)GPIOA_BASE, 'A', 8, val);
 }
 
+#if MLX90642_IIC_SIM == 0
+/* 原推挽端口, 只给MLX90642_Set_FastIO(0)用 */
 static void io_iic_sda_write_port(uint8_t val)
 {
 	gpio_set((void*)GPIOA_BASE, 'C', 9, 0, GPIOx_MODER_MODERy_GPOUTPUT,GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP);
@@ -21,12 +119,27 @@ static void io_iic_sda_2read_port(void)
 	gpio_set((void*)GPIOA_BASE, 'C', 9, 0, GPIOx_MODER_MODERy_INPUT,GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP);
 	gpio_write((void*)GPIOA_BASE, 'C', 9, 1);
 }
+#endif
 
 static uint8_t io_iic_sda_read_port(void)
 {
     return gpio_read((void*)GPIOA_BASE, 'C', 9)&0x01;
 }
 
+/**
+ * 快速端口: SDA初始化时配置为开漏上拉,之后写1即释放总线由对方驱动,
+ * 不再切换方向, 每个边沿只有一次BSRR写, 每次采样只有一次IDR读
+ */
+static void io_iic_sda_write_port_od(uint8_t val)
+{
+	gpio_write((void*)GPIOA_BASE, 'C', 9, val);
+}
+
+static void io_iic_sda_2read_port_od(void)
+{
+	gpio_write((void*)GPIOA_BASE, 'C', 9, 1);
+}
+
 static void io_iic_delay_us_port(uint32_t delay)
 {
 	uint32_t volatile t=delay;
@@ -45,7 +158,7 @@ static void io_iic_init_port(void)
 
 	gpio_set((void*)GPIOA_BASE, 'A', 8, 0, GPIOx_MODER_MODERy_GPOUTPUT,GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP);
 	gpio_write((void*)GPIOA_BASE, 'A', 8, 1);
-	gpio_set((void*)GPIOA_BASE, 'C', 9, 0, GPIOx_MODER_MODERy_GPOUTPUT,GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP);
+	gpio_set((void*)GPIOA_BASE, 'C', 9, 1, GPIOx_MODER_MODERy_GPOUTPUT,GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP);
 	gpio_write((void*)GPIOA_BASE, 'C', 9, 1);
 }
 
@@ -57,29 +170,40 @@ static void io_iic_deinit_port(void)
 static io_iic_dev_st iic_dev=
 {
 	.scl_write = io_iic_scl_write_port,
-	.sda_write = io_iic_sda_write_port,
-	.sda_2read = io_iic_sda_2read_port,
+	.sda_write = io_iic_sda_write_port_od,
+	.sda_2read = io_iic_sda_2read_port_od,
 	.sda_read = io_iic_sda_read_port,
 	.delay_pf = io_iic_delay_us_port,
 	.init = io_iic_init_port,
 	.deinit = io_iic_deinit_port,
 	.delayus = 1000000ul,
+	.get_cycles = clock_get_cycles,
 };
 
 static void MLX90642_I2CInit(void){
     static int s_mlx90642_init_flag = 0;
     if(s_mlx90642_init_flag == 0){
         s_mlx90642_init_flag = 1;
+#if MLX90642_IIC_SIM
+        /* 只替换电平端口, 时序和协议仍由io_iic完成 */
+        iic_dev.scl_write = mlx90642_sim_scl_write;
+        iic_dev.sda_write = mlx90642_sim_sda_write;
+        iic_dev.sda_2read = mlx90642_sim_sda_2read;
+        iic_dev.sda_read = mlx90642_sim_sda_read;
+        iic_dev.init = 0;
+        mlx90642_sim_init(SA_90642_DEFAULT, get_ticks);
+#endif
         io_iic_init(&iic_dev);
     }
 }
 
-int MLX90642_I2CRead(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *rData){
-    int res;
-    uint16_t tmp = 0;
-    uint8_t byte_tmp;
-    MLX90642_I2CInit();
+static int MLX90642_I2CRecover(void){
+    return io_iic_recover(&iic_dev);
+}
 
+/* 写寄存器地址后重复START切换为读 */
+static int MLX90642_I2CReadAddr(uint8_t slaveAddr, uint16_t startAddress){
+    int res;
     io_iic_start(&iic_dev);
     res = io_iic_write(&iic_dev, (slaveAddr<<1));
     if(res != 0){
@@ -94,59 +218,336 @@ int MLX90642_I2CRead(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddr
         return res;
     }
     io_iic_start(&iic_dev);
-    res = io_iic_write(&iic_dev, (slaveAddr<<1)|0x1); 
-    if(res != 0){
-        return res;
-    }
-    for(uint16_t i=0;i<nMemAddressRead;i++){
+    return io_iic_write(&iic_dev, (slaveAddr<<1)|0x1);
+}
+
+/**
+ * 从rData[*idx]开始读n个字,每读完一个字*idx加1,出错时*idx即为断点
+ * last为1时最后一个字节回NACK,通知从机停止输出
+ */
+static int MLX90642_I2CReadWords(uint16_t *rData, uint16_t *idx, uint16_t n, uint8_t last){
+    int res;
+    uint16_t tmp = 0;
+    uint8_t byte_tmp;
+    for(uint16_t i=0;i<n;i++){
         res = io_iic_read(&iic_dev,&byte_tmp,0);
         if(res != 0){
             return res;
         }
         tmp = (uint16_t)byte_tmp<<8;
-        res = io_iic_read(&iic_dev,&byte_tmp,0);
+        res = io_iic_read(&iic_dev,&byte_tmp,(last && (i == n-1)) ? 1 : 0);
         if(res != 0){
             return res;
         }
         tmp |= (uint16_t)byte_tmp;
-        rData[i] = tmp;
+        rData[*idx] = tmp;
+        (*idx)++;
     }
-    io_iic_stop(&iic_dev);
     return 0;
 }
 
-int MLX90642_Config(uint8_t slaveAddr, uint16_t writeAddress, uint16_t wData){
+/* 写地址和数据后STOP, 出错恢复总线后整体重发 */
+static int MLX90642_I2CWriteBytes(uint8_t slaveAddr, const uint8_t *data, uint8_t len){
+    int res;
+    uint8_t retry = 0;
+    do{
+        io_iic_start(&iic_dev);
+        res = io_iic_write(&iic_dev, (slaveAddr<<1));
+        for(uint8_t i=0; (res == 0) && (i<len); i++){
+            res = io_iic_write(&iic_dev, data[i]);
+        }
+        if(res == 0){
+            io_iic_stop(&iic_dev);
+            return 0;
+        }
+    }while(MLX90642_I2CFault(res, &retry));
+    return res;
+}
+
+int MLX90642_I2CRead(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *rData){
     int res;
+    uint16_t idx = 0;
+    uint8_t retry = 0;
     MLX90642_I2CInit();
+    MLX90642_I2CWaitIdle();
+    s_mlx90642_xfer_cnt++;
 
-    io_iic_start(&iic_dev);
-    res = io_iic_write(&iic_dev, (slaveAddr<<1));
+    /* 出错后从已读完的字处重新寻址,不从头重读 */
+    do{
+        res = MLX90642_I2CReadAddr(slaveAddr, startAddress + 2*idx);
+        if(res == 0){
+            res = MLX90642_I2CReadWords(rData, &idx, nMemAddressRead - idx, 1);
+        }
+        if(res == 0){
+            io_iic_stop(&iic_dev);
+            return 0;
+        }
+    }while(MLX90642_I2CFault(res, &retry));
+    return res;
+}
+
+int MLX90642_I2CReadAsync(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *rData, MLX90642_I2CDone_pf done){
+    int res;
+    uint8_t retry = 0;
+    MLX90642_I2CInit();
+    MLX90642_I2CAsyncInit();
+    MLX90642_I2CWaitIdle();
+    s_mlx90642_xfer_cnt++;
+
+    do{
+        res = MLX90642_I2CReadAddr(slaveAddr, startAddress);
+    }while((res != 0) && MLX90642_I2CFault(res, &retry));
     if(res != 0){
+        s_mlx90642_async.status = res;
         return res;
     }
-    res = io_iic_write(&iic_dev, writeAddress>>8); /* 高字节在前 */
-    if(res != 0){
-        return res;
+    s_mlx90642_async.data = rData;
+    s_mlx90642_async.n = nMemAddressRead;
+    s_mlx90642_async.idx = 0;
+    s_mlx90642_async.slaveAddr = slaveAddr;
+    s_mlx90642_async.startAddress = startAddress;
+    s_mlx90642_async.retry = retry;
+    s_mlx90642_async.restart = 0;
+    s_mlx90642_async.done = done;
+    s_mlx90642_async.status = 1;
+    s_mlx90642_async.busy = 1;
+    tim_start(MLX90642_ASYNC_TIM);
+    return 0;
+}
+
+/* 定时器中断: 每次读MLX90642_ASYNC_WORDS个字,其余时间交给主循环 */
+static void MLX90642_I2CAsyncTick(void){
+    int res = 0;
+    uint16_t n;
+    if(s_mlx90642_async.busy == 0){
+        tim_stop(MLX90642_ASYNC_TIM);
+        return;
+    }
+    if(s_mlx90642_async.restart){
+        res = MLX90642_I2CReadAddr(s_mlx90642_async.slaveAddr, s_mlx90642_async.startAddress + 2*s_mlx90642_async.idx);
+        if(res == 0){
+            s_mlx90642_async.restart = 0;
+        }
+    }
+    if(res == 0){
+        n = s_mlx90642_async.n - s_mlx90642_async.idx;
+        if(n > MLX90642_ASYNC_WORDS){
+            n = MLX90642_ASYNC_WORDS;
+        }
+        res = MLX90642_I2CReadWords(s_mlx90642_async.data, &s_mlx90642_async.idx, n,
+            (s_mlx90642_async.idx + n) >= s_mlx90642_async.n);
     }
-    res = io_iic_write(&iic_dev, writeAddress&0xFF);
     if(res != 0){
-        return res;
+        /* 恢复总线后下一次中断从断点重新寻址 */
+        if(MLX90642_I2CFault(res, &s_mlx90642_async.retry)){
+            s_mlx90642_async.restart = 1;
+        }else{
+            MLX90642_I2CAsyncFinish(res);
+        }
+        return;
+    }
+    if(s_mlx90642_async.idx >= s_mlx90642_async.n){
+        io_iic_stop(&iic_dev);
+        MLX90642_I2CAsyncFinish(0);
+    }
+}
+
+int MLX90642_Config(uint8_t slaveAddr, uint16_t writeAddress, uint16_t wData){
+    uint8_t data[4];
+    MLX90642_I2CInit();
+    MLX90642_I2CWaitIdle();
+    s_mlx90642_xfer_cnt++;
+
+    data[0] = writeAddress>>8; /* 高字节在前 */
+    data[1] = writeAddress&0xFF;
+    data[2] = wData>>8;
+    data[3] = wData&0xFF;
+    return MLX90642_I2CWriteBytes(slaveAddr, data, 4);
+}
+
+int MLX90642_WakeUp(uint8_t slaveAddr){
+    uint8_t cmd = 0x57;
+    MLX90642_I2CInit();
+    MLX90642_I2CWaitIdle();
+    s_mlx90642_xfer_cnt++;
+
+    return MLX90642_I2CWriteBytes(slaveAddr, &cmd, 1);
+}
+
+#else
+
+static void MLX90642_I2CInit(void){
+    static int s_mlx90642_init_flag = 0;
+    if(s_mlx90642_init_flag == 0){
+        s_mlx90642_init_flag = 1;
+        i2c_cfg_st cfg={
+            .speed = MLX90642_IIC_HW_SPEED,
+        };
+        i2c_init(MLX90642_IIC_HW_ID, &cfg);
+    }
+}
+
+static int MLX90642_I2CRecover(void){
+    return i2c_recover(MLX90642_IIC_HW_ID);
+}
+
+/* DMA接收出错时已完整收到的字数 */
+static uint16_t MLX90642_I2CWordsDone(uint16_t n){
+    uint32_t remain = i2c_read_dma_remain(MLX90642_IIC_HW_ID);
+    if(remain > (uint32_t)n*2){
+        return 0;
     }
-    res = io_iic_write(&iic_dev, wData>>8); /* 高字节在前 */
+    return (uint16_t)(((uint32_t)n*2 - remain)/2);
+}
+
+/* 写地址和数据后STOP, 出错恢复总线后整体重发 */
+static int MLX90642_I2CWriteBytes(uint8_t slaveAddr, uint8_t *data, uint8_t len){
+    int res;
+    uint8_t retry = 0;
+    do{
+        res = i2c_write(MLX90642_IIC_HW_ID, slaveAddr, data, len, 1);
+        if(res == 0){
+            return 0;
+        }
+    }while(MLX90642_I2CFault(res, &retry));
+    return res;
+}
+
+/* 写寄存器地址后重复START,启动DMA接收 */
+static int MLX90642_I2CReadStart(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *rData){
+    int res;
+    uint8_t addr[2];
+
+    addr[0] = startAddress>>8; /* 高字节在前 */
+    addr[1] = startAddress&0xFF;
+    res = i2c_write(MLX90642_IIC_HW_ID, slaveAddr, addr, 2, 0);
     if(res != 0){
         return res;
     }
-    res = io_iic_write(&iic_dev, wData&0xFF);
+    return i2c_read_dma(MLX90642_IIC_HW_ID, slaveAddr, (uint8_t*)rData, (uint32_t)nMemAddressRead*2);
+}
+
+/* 传感器高字节在前,转为小端 */
+static void MLX90642_I2CSwap(uint16_t *rData, uint16_t n){
+    for(uint16_t i=0;i<n;i++){
+        rData[i] = (uint16_t)((rData[i]>>8) | (rData[i]<<8));
+    }
+}
+
+int MLX90642_I2CRead(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *rData){
+    int res;
+    uint16_t idx = 0;
+    uint8_t retry = 0;
+    MLX90642_I2CInit();
+    MLX90642_I2CWaitIdle();
+    s_mlx90642_xfer_cnt++;
+
+    /* 出错后从DMA已收完的字处重新寻址,不从头重读 */
+    do{
+        res = MLX90642_I2CReadStart(slaveAddr, startAddress + 2*idx, nMemAddressRead - idx, rData + idx);
+        if(res == 0){
+            while((res = i2c_read_dma_poll(MLX90642_IIC_HW_ID)) > 0);
+            if(res != 0){
+                idx += MLX90642_I2CWordsDone(nMemAddressRead - idx);
+            }
+        }
+        if(res == 0){
+            MLX90642_I2CSwap(rData, nMemAddressRead);
+            return 0;
+        }
+    }while(MLX90642_I2CFault(res, &retry));
+    return res;
+}
+
+int MLX90642_I2CReadAsync(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *rData, MLX90642_I2CDone_pf done){
+    int res;
+    uint8_t retry = 0;
+    MLX90642_I2CInit();
+    MLX90642_I2CAsyncInit();
+    MLX90642_I2CWaitIdle();
+    s_mlx90642_xfer_cnt++;
+
+    do{
+        res = MLX90642_I2CReadStart(slaveAddr, startAddress, nMemAddressRead, rData);
+    }while((res != 0) && MLX90642_I2CFault(res, &retry));
     if(res != 0){
+        s_mlx90642_async.status = res;
         return res;
     }
-    io_iic_stop(&iic_dev);
+    s_mlx90642_async.data = rData;
+    s_mlx90642_async.n = nMemAddressRead;
+    s_mlx90642_async.idx = 0;
+    s_mlx90642_async.slaveAddr = slaveAddr;
+    s_mlx90642_async.startAddress = startAddress;
+    s_mlx90642_async.retry = retry;
+    s_mlx90642_async.restart = 0;
+    s_mlx90642_async.done = done;
+    s_mlx90642_async.status = 1;
+    s_mlx90642_async.busy = 1;
+    tim_start(MLX90642_ASYNC_TIM);
     return 0;
 }
 
-int MLX90642_I2CCmd(uint8_t slaveAddr, uint16_t i2c_cmd){
+/* 定时器中断: 查询DMA是否完成, 出错时恢复总线并从断点重新启动 */
+static void MLX90642_I2CAsyncTick(void){
     int res;
+    uint16_t idx = s_mlx90642_async.idx;
+    uint16_t n = s_mlx90642_async.n;
+    if(s_mlx90642_async.busy == 0){
+        tim_stop(MLX90642_ASYNC_TIM);
+        return;
+    }
+    if(s_mlx90642_async.restart){
+        res = MLX90642_I2CReadStart(s_mlx90642_async.slaveAddr, s_mlx90642_async.startAddress + 2*idx, n - idx, s_mlx90642_async.data + idx);
+        if(res == 0){
+            s_mlx90642_async.restart = 0;
+            return;
+        }
+    }else{
+        res = i2c_read_dma_poll(MLX90642_IIC_HW_ID);
+        if(res > 0){
+            return;
+        }
+        if(res == 0){
+            MLX90642_I2CSwap(s_mlx90642_async.data, n);
+            MLX90642_I2CAsyncFinish(0);
+            return;
+        }
+        s_mlx90642_async.idx += MLX90642_I2CWordsDone(n - idx);
+    }
+    if(MLX90642_I2CFault(res, &s_mlx90642_async.retry)){
+        s_mlx90642_async.restart = 1;
+    }else{
+        MLX90642_I2CAsyncFinish(res);
+    }
+}
+
+int MLX90642_Config(uint8_t slaveAddr, uint16_t writeAddress, uint16_t wData){
+    uint8_t data[4];
     MLX90642_I2CInit();
+    MLX90642_I2CWaitIdle();
+    s_mlx90642_xfer_cnt++;
+
+    data[0] = writeAddress>>8; /* 高字节在前 */
+    data[1] = writeAddress&0xFF;
+    data[2] = wData>>8;
+    data[3] = wData&0xFF;
+    return MLX90642_I2CWriteBytes(slaveAddr, data, 4);
+}
+
+int MLX90642_WakeUp(uint8_t slaveAddr){
+    uint8_t cmd = 0x57;
+    MLX90642_I2CInit();
+    MLX90642_I2CWaitIdle();
+    s_mlx90642_xfer_cnt++;
+
+    return MLX90642_I2CWriteBytes(slaveAddr, &cmd, 1);
+}
+
+#endif
+
+int MLX90642_I2CCmd(uint8_t slaveAddr, uint16_t i2c_cmd){
+    int res;
 
     switch(i2c_cmd){
         case MLX90642_START_SYNC_MEAS_CMD:
@@ -160,28 +561,67 @@ int MLX90642_I2CCmd(uint8_t slaveAddr, uint16_t i2c_cmd){
     return res;
 }
 
-int MLX90642_WakeUp(uint8_t slaveAddr){
-    int res;
-    MLX90642_I2CInit();
+int MLX90642_I2CAsyncPoll(void){
+    return s_mlx90642_async.busy ? 1 : s_mlx90642_async.status;
+}
 
-    io_iic_start(&iic_dev);
-    res = io_iic_write(&iic_dev, (slaveAddr<<1));
-    if(res != 0){
-        return res;
-    }
-    res = io_iic_write(&iic_dev, 0x57);
-    if(res != 0){
-        return res;
-    }
-    io_iic_stop(&iic_dev);
-    return 0;
+uint32_t MLX90642_I2CGetXferCount(void){
+    return s_mlx90642_xfer_cnt;
+}
+
+const MLX90642_I2CStat_t* MLX90642_I2CGetStat(void){
+    return &s_mlx90642_stat;
+}
+
+void MLX90642_I2CClearStat(void){
+    s_mlx90642_stat.nack = 0;
+    s_mlx90642_stat.retry = 0;
+    s_mlx90642_stat.recover = 0;
+    s_mlx90642_stat.abort = 0;
 }
 
 void MLX90642_Wait_ms(uint16_t time_ms){
     clock_delay(time_ms);
 }
 
+void MLX90642_Set_FastIO(uint8_t enable){
+#if (MLX90642_IIC_HW == 0) && (MLX90642_IIC_SIM == 0)
+    MLX90642_I2CInit();
+    if(enable){
+        iic_dev.sda_write = io_iic_sda_write_port_od;
+        iic_dev.sda_2read = io_iic_sda_2read_port_od;
+        gpio_set((void*)GPIOA_BASE, 'C', 9, 1, GPIOx_MODER_MODERy_GPOUTPUT,GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP);
+    }else{
+        /* 原推挽端口,每次读写都重新配置SDA方向 */
+        iic_dev.sda_write = io_iic_sda_write_port;
+        iic_dev.sda_2read = io_iic_sda_2read_port;
+        gpio_set((void*)GPIOA_BASE, 'C', 9, 0, GPIOx_MODER_MODERy_GPOUTPUT,GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP);
+    }
+    gpio_write((void*)GPIOA_BASE, 'C', 9, 1);
+#else
+    (void)enable;
+#endif
+}
+
 void MLX90642_Set_Delay(uint32_t delay){
+#if MLX90642_IIC_HW == 0
+    io_iic_set_clock_hz(&iic_dev, 0);
     iic_dev.delayus = delay;
+#else
+    (void)delay;  /* 硬件I2C的速率由MLX90642_IIC_HW_SPEED决定 */
+#endif
 }
 
+int MLX90642_Set_ClockHz(uint32_t hz){
+#if MLX90642_IIC_HW == 0
+    iic_dev.cycles_hz = clock_get_ahb();  /* DWT CYCCNT按内核时钟计数 */
+    return io_iic_set_clock_hz(&iic_dev, hz);
+#else
+    i2c_cfg_st cfg={
+        .speed = hz,
+    };
+    MLX90642_I2CInit();
+    i2c_init(MLX90642_IIC_HW_ID, &cfg);
+    return 0;
+#endif
+}
@@ -10,6 +10,14 @@
 #include "clock.h"
 #include "xmodem.h"
 #include "MLX90642_test.h"
+#include "MLX90642_disp.h"
+#include "MLX90642_depends.h"
+#include "MLX90642_sim.h"
+#include "MLX90642_palette.h"
+#include "MLX90642_filter.h"
+#include "MLX90642_badpix.h"
+#include "MLX90642_blob.h"
+#include "lcd_itf.h"
 
 static void helpfunc(uint8_t* param);
 
@@ -28,6 +36,23 @@ static void dumpspiflashfunc(uint8_t* param);
 static void setbaudfunc(uint8_t* param);
 
 static void mlx90642testfunc(uint8_t* param);
+static void mlx90642benchfunc(uint8_t* param);
+static void mlx90642roifunc(uint8_t* param);
+static void mlx90642streamfunc(uint8_t* param);
+static void mlx90642addfunc(uint8_t* param);
+static void mlx90642busfunc(uint8_t* param);
+static void mlx90642simfunc(uint8_t* param);
+static void mlx90642palfunc(uint8_t* param);
+static void mlx90642agcfunc(uint8_t* param);
+static void mlx90642heqfunc(uint8_t* param);
+static void mlx90642scalefunc(uint8_t* param);
+static void mlx90642filterfunc(uint8_t* param);
+static void mlx90642badpixfunc(uint8_t* param);
+static void mlx90642medianfunc(uint8_t* param);
+static void mlx90642blobfunc(uint8_t* param);
+static void mlx90642bandfunc(uint8_t* param);
+static void lcddmafunc(uint8_t* param);
+static void lcddirtyfunc(uint8_t* param);
 
 /**
  * 最后一行必须为0,用于结束判断
@@ -51,6 +76,23 @@ const shell_cmd_cfg g_shell_cmd_list_ast[ ] =
   { (uint8_t*)"setbaud",      setbaudfunc,      (uint8_t*)"setbaud baud"}, 
 
   { (uint8_t*)"mlx90642test",  mlx90642testfunc,  (uint8_t*)"mlx90642test num"}, 
+  { (uint8_t*)"mlx90642bench", mlx90642benchfunc, (uint8_t*)"mlx90642bench item[io|sched|cfg|sim|color|stats|heq|scale|filter|median|blob|lcddma|dirty|dbuf|band|dma2d] num"}, 
+  { (uint8_t*)"mlx90642roi",   mlx90642roifunc,   (uint8_t*)"mlx90642roi [startrow rows]... (none:full frame)"}, 
+  { (uint8_t*)"mlx90642stream",mlx90642streamfunc,(uint8_t*)"mlx90642stream [1/0] (none:print latency)"}, 
+  { (uint8_t*)"mlx90642add",   mlx90642addfunc,   (uint8_t*)"mlx90642add addr[hex]"}, 
+  { (uint8_t*)"mlx90642bus",   mlx90642busfunc,   (uint8_t*)"mlx90642bus [clr]"}, 
+  { (uint8_t*)"mlx90642sim",   mlx90642simfunc,   (uint8_t*)"mlx90642sim addr[hex] frames (none:synthetic scene)"}, 
+  { (uint8_t*)"mlx90642pal",   mlx90642palfunc,   (uint8_t*)"mlx90642pal [name|id] (none:list)"}, 
+  { (uint8_t*)"mlx90642agc",   mlx90642agcfunc,   (uint8_t*)"mlx90642agc [1/0] (none:print range and stats)"}, 
+  { (uint8_t*)"mlx90642heq",   mlx90642heqfunc,   (uint8_t*)"mlx90642heq [1/0] (none:print histogram state)"}, 
+  { (uint8_t*)"mlx90642scale", mlx90642scalefunc, (uint8_t*)"mlx90642scale [1/0] (1:bilinear 0:block)"}, 
+  { (uint8_t*)"mlx90642filter",mlx90642filterfunc,(uint8_t*)"mlx90642filter [shift(0:off) [slew]] (none:print)"}, 
+  { (uint8_t*)"mlx90642badpix",mlx90642badpixfunc,(uint8_t*)"mlx90642badpix [detect id frames|clr id] (none:list)"}, 
+  { (uint8_t*)"mlx90642median",mlx90642medianfunc,(uint8_t*)"mlx90642median [1/0] (3x3 median for display)"}, 
+  { (uint8_t*)"mlx90642blob",  mlx90642blobfunc,  (uint8_t*)"mlx90642blob [overlay[1/0] [min_area gate [alarm_area(0:off)]]] (none:list)"}, 
+  { (uint8_t*)"mlx90642band",  mlx90642bandfunc,  (uint8_t*)"mlx90642band [1/0] (1:sram band 0:sdram framebuffer)"}, 
+  { (uint8_t*)"lcddma",        lcddmafunc,        (uint8_t*)"lcddma [dma[1/0] [spi16[1/0]]] (none:print)"}, 
+  { (uint8_t*)"lcddirty",      lcddirtyfunc,      (uint8_t*)"lcddirty [1/0] (none:print bytes per frame)"}, 
 
   { (uint8_t*)0,		          0 ,               0},
 };
@@ -811,3 +853,269 @@ static void mlx90642testfunc(uint8_t* param)
     mlx90642_test(num);
   }
 }
+
+static void mlx90642benchfunc(uint8_t* param)
+{
+  char item[16];
+  uint32_t num;
+  uint32_t i = 0;
+  char* p =(char*)param;
+  while((*p != ' ') && (*p != 0)){  /* 跳过%*s部分 */
+    p++;
+  }
+  while(*p == ' '){
+    p++;
+  }
+  while((*p != ' ') && (*p != 0) && (i < sizeof(item)-1)){
+    item[i++] = *p++;
+  }
+  item[i] = 0;
+  long tmp = 1;
+  xatoi(&p, &tmp);
+  num = tmp;
+  mlx90642_bench(item, num);
+}
+
+static void mlx90642roifunc(uint8_t* param)
+{
+  MLX90642_RowBand_t bands[MLX90642_MAX_ROW_BANDS];
+  int num = 0;
+  long start;
+  long rows;
+  char* p =(char*)param;
+  while((*p != ' ') && (*p != 0)){  /* 跳过%*s部分 */
+    p++;
+  }
+  while(num < MLX90642_MAX_ROW_BANDS){
+    if(xatoi(&p, &start) == 0){
+      break;
+    }
+    if(xatoi(&p, &rows) == 0){
+      break;
+    }
+    bands[num].startRow = (uint8_t)start;
+    bands[num].numberOfRows = (uint8_t)rows;
+    num++;
+  }
+  if(mlx90642_disp_roi(bands, num) != 0){
+    xprintf("invalid band\r\n");
+  }
+}
+
+static void mlx90642streamfunc(uint8_t* param)
+{
+  long enable;
+  char* p =(char*)param;
+  while((*p != ' ') && (*p != 0)){  /* 跳过%*s部分 */
+    p++;
+  }
+  mlx90642_disp_lat_print();
+  if(xatoi(&p, &enable) != 0){
+    mlx90642_disp_set_stream(enable);
+  }
+}
+
+static void mlx90642addfunc(uint8_t* param)
+{
+  uint32_t addr;
+  if(1 == sscanf((const char*)param, "%*s %x", &addr))
+  {
+    if(mlx90642_disp_add((uint8_t)addr) < 0){
+      xprintf("add 0x%02X err\r\n", addr);
+    }
+  }
+}
+
+static void mlx90642busfunc(uint8_t* param)
+{
+  const MLX90642_I2CStat_t* stat = MLX90642_I2CGetStat();
+  char opt[8];
+  xprintf("xfer:%d nack:%d retry:%d recover:%d abort:%d\r\n", MLX90642_I2CGetXferCount(),
+    stat->nack, stat->retry, stat->recover, stat->abort);
+  if((1 == sscanf((const char*)param, "%*s %7s", opt)) && (strncmp(opt, "clr", 3) == 0)){
+    MLX90642_I2CClearStat();
+  }
+}
+
+/* 录制的场景先用rxmem传到内存, 每帧768个int16 */
+static void mlx90642simfunc(uint8_t* param)
+{
+  uint32_t addr;
+  uint32_t num;
+  if(2 == sscanf((const char*)param, "%*s %x %d", &addr, &num))
+  {
+    mlx90642_sim_scene((const int16_t*)addr, num);
+  }
+  else
+  {
+    mlx90642_sim_scene(0, 0);
+  }
+}
+
+static void mlx90642palfunc(uint8_t* param)
+{
+  char name[16];
+  int id;
+  if(1 == sscanf((const char*)param, "%*s %15s", name))
+  {
+    id = mlx90642_palette_find(name);
+    if(id < 0){
+      sscanf(name, "%d", &id);
+    }
+    if(mlx90642_palette_set(id) < 0){
+      xprintf("no palette %s\r\n", name);
+    }
+  }
+  mlx90642_palette_print();
+}
+
+static void mlx90642agcfunc(uint8_t* param)
+{
+  long enable;
+  char* p =(char*)param;
+  while((*p != ' ') && (*p != 0)){  /* 跳过%*s部分 */
+    p++;
+  }
+  if(xatoi(&p, &enable) != 0){
+    mlx90642_disp_agc(enable);
+  }
+  mlx90642_disp_agc_print();
+}
+
+static void mlx90642heqfunc(uint8_t* param)
+{
+  long enable;
+  char* p =(char*)param;
+  while((*p != ' ') && (*p != 0)){  /* 跳过%*s部分 */
+    p++;
+  }
+  if(xatoi(&p, &enable) != 0){
+    mlx90642_disp_heq(enable);
+  }
+  mlx90642_disp_heq_print();
+}
+
+static void mlx90642scalefunc(uint8_t* param)
+{
+  long enable;
+  char* p =(char*)param;
+  while((*p != ' ') && (*p != 0)){  /* 跳过%*s部分 */
+    p++;
+  }
+  if(xatoi(&p, &enable) != 0){
+    mlx90642_disp_scale(enable);
+  }
+  mlx90642_disp_scale_print();
+}
+
+static void mlx90642filterfunc(uint8_t* param)
+{
+  const mlx90642_filter_stat_st* stat = mlx90642_filter_stat();
+  int shift;
+  int slew = stat->slew;
+  if(sscanf((const char*)param, "%*s %d %d", &shift, &slew) >= 1)
+  {
+    if(mlx90642_filter_config((uint8_t)shift, (uint16_t)slew) < 0){
+      xprintf("shift 0~6\r\n");
+    }
+  }
+  xprintf("shift:%d slew:%d (1/50C) frames:%u resets:%u\r\n", stat->shift, stat->slew, stat->frames, stat->resets);
+}
+
+static void mlx90642badpixfunc(uint8_t* param)
+{
+  char cmd[8];
+  int id = 0;
+  int frames = 32;
+  int num = sscanf((const char*)param, "%*s %7s %d %d", cmd, &id, &frames);
+  if(num >= 1)
+  {
+    if(strncmp(cmd, "detect", 7) == 0){
+      if(mlx90642_badpix_detect(id, frames) < 0){
+        xprintf("id 0~3, frames 4~64\r\n");
+      }
+    }else if(strncmp(cmd, "clr", 4) == 0){
+      if(mlx90642_badpix_clear(id) < 0){
+        xprintf("id 0~3\r\n");
+      }
+    }else{
+      xprintf("unknown %s\r\n", cmd);
+    }
+  }
+  mlx90642_badpix_print();
+}
+
+static void mlx90642medianfunc(uint8_t* param)
+{
+  long enable;
+  char* p =(char*)param;
+  while((*p != ' ') && (*p != 0)){  /* 跳过%*s部分 */
+    p++;
+  }
+  if(xatoi(&p, &enable) != 0){
+    mlx90642_disp_median_set(enable);
+  }
+  mlx90642_disp_median_print();
+}
+
+static void mlx90642blobfunc(uint8_t* param)
+{
+  int overlay;
+  int min_area;
+  int gate;
+  int alarm_area;
+  int num = sscanf((const char*)param, "%*s %d %d %d %d", &overlay, &min_area, &gate, &alarm_area);
+  if(num >= 1)
+  {
+    mlx90642_disp_blob_overlay(overlay);
+  }
+  if(num >= 3)
+  {
+    if(mlx90642_blob_config((uint16_t)min_area, (uint8_t)gate) < 0){
+      xprintf("min_area 1~768, gate >=1\r\n");
+    }
+  }
+  if(num >= 4)
+  {
+    if(mlx90642_disp_blob_alarm(alarm_area) < 0){
+      xprintf("alarm_area 0~768\r\n");
+    }
+  }
+  mlx90642_disp_blob_print();
+}
+
+static void mlx90642bandfunc(uint8_t* param)
+{
+  long enable;
+  char* p =(char*)param;
+  while((*p != ' ') && (*p != 0)){  /* 跳过%*s部分 */
+    p++;
+  }
+  if(xatoi(&p, &enable) != 0){
+    mlx90642_disp_band(enable);
+  }
+  mlx90642_disp_band_print();
+}
+
+static void lcddmafunc(uint8_t* param)
+{
+  int dma;
+  int spi16;
+  int num = sscanf((const char*)param, "%*s %d %d", &dma, &spi16);
+  if(num >= 1){
+    lcd_itf_dma(dma);
+  }
+  if(num >= 2){
+    lcd_itf_spi16(spi16);
+  }
+  lcd_itf_dma_print();
+}
+
+static void lcddirtyfunc(uint8_t* param)
+{
+  int enable;
+  if(sscanf((const char*)param, "%*s %d", &enable) == 1){
+    lcd_itf_dirty(enable);
+  }
+  lcd_itf_sync_print();
+}
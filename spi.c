@@ -2,10 +2,38 @@
 #include "gpio.h"
 #include "clock.h"
 #include "spi.h"
+#include "dma.h"
 #include "xprintf.h"
 
 static uint32_t reg_base[6]={0x40013000,0x40003800,0x40003C00,0x40013400,0x40015000,0x40015400};
 
+#define SPI_CR1_SPE     (1u<<6)
+#define SPI_CR1_DFF     (1u<<11)
+#define SPI_CR2_TXDMAEN (1u<<1)
+#define SPI_SR_TXE      (1u<<1)
+#define SPI_SR_BSY      (1u<<7)
+
+#define SPI_DMA_BASE    0x40026400ul /* DMA2 */
+#define SPI5_DMA_STREAM 4            /* SPI5_TX: DMA2 Stream4 Channel2 */
+#define SPI5_DMA_CHSEL  2
+#define SPI5_DMA_IRQN   60           /* DMA2_Stream4_IRQn */
+
+/* SPI5 DMA发送状态, 剩余部分在传输完成中断中分段续传 */
+static struct{
+	volatile uint8_t busy;
+	uint8_t psize;       /* 0:8位帧 1:16位帧 */
+	uint32_t addr;       /* 下一段地址 */
+	uint32_t remain;     /* 本行剩余字节 */
+	uint32_t row;        /* 本行开始地址 */
+	uint32_t len;        /* 每行字节数 */
+	uint32_t stride;     /* 行开始地址间隔 */
+	uint32_t rows;       /* 本行之后还有的行数 */
+	spi_dma_cb_pf cb;
+	uint32_t xfers;
+	uint32_t chunks;
+	uint32_t errs;
+} s_spi5_dma;
+
 void spi_init(int id, spi_cfg_st* cfg){
 	
 	volatile uint16_t* cr1 = (uint16_t*)(reg_base[id-1] + 0x00);
@@ -43,6 +71,11 @@ void spi_init(int id, spi_cfg_st* cfg){
 			*RCC_AHB1ENR |= (1u<<2); /* GPIOC */
 			gpio_set((void*)GPIOA_BASE, 'C', 2, 0, GPIOx_MODER_MODERy_GPOUTPUT,GPIOx_OSPEEDR_OSPEEDRy_HIGH, GPIOx_PUPDR_PULLUP);
 			gpio_write((void*)GPIOA_BASE, 'C', 2, 1);
+
+			/* DMA2时钟, DMA2_Stream4中断 优先级最低 */
+			*RCC_AHB1ENR |= (1u<<22);
+			*(volatile uint8_t*)(0xE000E400ul + SPI5_DMA_IRQN) = 0xF0;   /* NVIC_IPR */
+			*(volatile uint32_t*)(0xE000E100ul + 4*(SPI5_DMA_IRQN/32)) = 1u<<(SPI5_DMA_IRQN%32);  /* NVIC_ISER */
 		break;
 	}
 
@@ -143,4 +176,230 @@ uint32_t spi_transfer(int id, uint8_t* tx, uint8_t* rx, uint32_t len, int flag)
     return len;
 }
 
+void spi_set_databits(int id, uint8_t databits)
+{
+	volatile uint16_t* cr1 = (uint16_t*)(reg_base[id-1] + 0x00);
+	volatile uint16_t* sr = (uint16_t*)(reg_base[id-1] + 0x08);
+	uint16_t dff = (databits == 16) ? SPI_CR1_DFF : 0;
+	if((*cr1 & SPI_CR1_DFF) == dff){
+		return;
+	}
+	while((*sr & SPI_SR_TXE) == 0);
+	while((*sr & SPI_SR_BSY) != 0);
+	*cr1 &= ~SPI_CR1_SPE;
+	*cr1 = (*cr1 & ~SPI_CR1_DFF) | dff;
+	*cr1 |= SPI_CR1_SPE;
+}
+
+uint32_t spi_transfer16(int id, const uint16_t* tx, uint32_t len, int flag)
+{
+	volatile uint16_t* sr = (uint16_t*)(reg_base[id-1] + 0x08);
+	volatile uint16_t* dr = (uint16_t*)(reg_base[id-1] + 0x0C);
+	/* CS拉低 */
+	switch(id){
+		case 1:
+		gpio_write((void*)GPIOA_BASE, 'A', 4, 0);
+		break;
+		case 5:
+		gpio_write((void*)GPIOA_BASE, 'C', 2, 0);
+		break;
+	}
+	for(uint32_t i=0; i<len; i++){
+		*dr = tx[i];
+		while((*sr & (uint16_t)0x01) == 0); /* wait RXNE */
+		(void)*dr;
+	}
+	if(flag){
+		/* CS拉高 */
+		switch(id){
+			case 1:
+			gpio_write((void*)GPIOA_BASE, 'A', 4, 1);
+			break;
+			case 5:
+			gpio_write((void*)GPIOA_BASE, 'C', 2, 1);
+			break;
+		}
+	}
+	return len;
+}
 
+uint32_t spi_dma_next(uint32_t addr, uint32_t len, uint8_t psize, spi_dma_chunk_st* chunk)
+{
+	uint32_t n;
+	uint32_t max;
+	len &= ~((1u << psize) - 1);
+	if(len == 0){
+		return 0;
+	}
+	chunk->mburst = DMA_MBURST_SINGLE;
+	if((len >= SPI_DMA_SPLIT_MIN) && ((addr & 0x0F) != 0)){
+		/* 长段先单拍发到16字节对齐, 后面按4拍突发 */
+		n = 16 - (addr & 0x0F);
+		max = n;
+		chunk->msize = ((addr & 0x03) == 0) ? DMA_MSZIE_WORD : psize;
+	}else if(((addr & 0x0F) == 0) && (len >= 16) && ((len >= SPI_DMA_SPLIT_MIN) || ((len & 0x0F) == 0))){
+		/*
+		 * 4拍字突发: 地址16字节对齐, 长度为16的倍数(NDTR为突发长度的整数倍),
+		 * 每次突发都在16字节内, 不会跨1KB边界; 零头留给后面的段
+		 */
+		n = len & ~0x0Fu;
+		max = (SPI_DMA_NDTR_MAX << psize) & ~0x0Fu;
+		chunk->msize = DMA_MSZIE_WORD;
+		chunk->mburst = DMA_MBURST_INCR4;
+	}else if(((addr & 0x03) == 0) && (len >= 4)){
+		/* 短段不值得多分一段(多一次中断), 按字单拍读, 零头留给最后一段 */
+		n = len & ~0x03u;
+		max = (SPI_DMA_NDTR_MAX << psize) & ~0x03u;
+		chunk->msize = DMA_MSZIE_WORD;
+	}else{
+		n = len;
+		max = SPI_DMA_NDTR_MAX << psize;
+		chunk->msize = psize;   /* 与外设侧相同 */
+	}
+	if(n > max){
+		n = max;
+	}
+	chunk->addr = addr;
+	chunk->cnt = (uint16_t)(n >> psize);
+	return n;
+}
+
+static void spi5_dma_chunk(void)
+{
+	spi_dma_chunk_st chunk;
+	uint32_t n = spi_dma_next(s_spi5_dma.addr, s_spi5_dma.remain, s_spi5_dma.psize, &chunk);
+
+	dma_int_flag_clr(SPI_DMA_BASE, SPI5_DMA_STREAM, DMA_INT_TC);
+	dma_int_flag_clr(SPI_DMA_BASE, SPI5_DMA_STREAM, DMA_INT_HT);
+	dma_int_flag_clr(SPI_DMA_BASE, SPI5_DMA_STREAM, DMA_INT_TE);
+	dma_int_flag_clr(SPI_DMA_BASE, SPI5_DMA_STREAM, DMA_INT_MDE);
+	dma_int_flag_clr(SPI_DMA_BASE, SPI5_DMA_STREAM, DMA_INT_FE);
+	/* FIFO模式: 存储器侧按段描述单拍或4拍突发读, 外设侧按帧宽度写DR */
+	dma_st dma = {
+		.cfg = {
+			.chsel = SPI5_DMA_CHSEL,
+			.mburst = (dma_mburst_e)chunk.mburst,
+			.pl = DMA_PL_MEDIUM,
+			.psize = (dma_psize_e)s_spi5_dma.psize,
+			.msize = (dma_msize_e)chunk.msize,
+			.minc = DMA_MINC_MSIZE,
+			.pinc = DMA_PINC_FIXED,
+			.dir = DMA_DIR_M2P,
+			.pfctrl = DMA_PFCTRL_DMA,
+			.tcie = 1,
+			.teie = 1,
+		},
+		.cnt = chunk.cnt,
+		.paddr = reg_base[5-1] + 0x0C,
+		.m0addr = chunk.addr,
+		.fifo_cfg = {
+			.dmdis = 1,
+			.fth = DMA_FIFO_FTH_FULL,
+		},
+	};
+	s_spi5_dma.addr += n;
+	s_spi5_dma.remain -= n;
+	s_spi5_dma.chunks++;
+	dma_cfg(SPI_DMA_BASE, SPI5_DMA_STREAM, &dma);
+}
+
+static void spi5_dma_finish(void)
+{
+	volatile uint16_t* cr2 = (uint16_t*)(reg_base[5-1] + 0x04);
+	volatile uint16_t* sr = (uint16_t*)(reg_base[5-1] + 0x08);
+	volatile uint16_t* dr = (uint16_t*)(reg_base[5-1] + 0x0C);
+	/* DMA完成时最后的数据还在移位, 等发送完再拉高CS */
+	while((*sr & SPI_SR_TXE) == 0);
+	while((*sr & SPI_SR_BSY) != 0);
+	*cr2 &= ~SPI_CR2_TXDMAEN;
+	/* 只发送期间RXNE/OVR置位, 读DR和SR清除, 之后spi_transfer的收发才能对齐 */
+	(void)*dr;
+	(void)*sr;
+	gpio_write((void*)GPIOA_BASE, 'C', 2, 1);
+	s_spi5_dma.busy = 0;
+	if(s_spi5_dma.cb != 0){
+		s_spi5_dma.cb(5);
+	}
+}
+
+void spi5_dma_irqhandler(void)
+{
+	if(dma_int_is_set(SPI_DMA_BASE, SPI5_DMA_STREAM, DMA_INT_TE)){
+		dma_int_flag_clr(SPI_DMA_BASE, SPI5_DMA_STREAM, DMA_INT_TE);
+		dma_dis(SPI_DMA_BASE, SPI5_DMA_STREAM);
+		s_spi5_dma.errs++;
+		s_spi5_dma.remain = 0;
+		s_spi5_dma.rows = 0;
+		spi5_dma_finish();
+	}else if(dma_int_is_set(SPI_DMA_BASE, SPI5_DMA_STREAM, DMA_INT_TC)){
+		dma_int_flag_clr(SPI_DMA_BASE, SPI5_DMA_STREAM, DMA_INT_TC);
+		if(s_spi5_dma.remain > 0){
+			spi5_dma_chunk();
+		}else if(s_spi5_dma.rows > 0){
+			/* 下一行 */
+			s_spi5_dma.rows--;
+			s_spi5_dma.row += s_spi5_dma.stride;
+			s_spi5_dma.addr = s_spi5_dma.row;
+			s_spi5_dma.remain = s_spi5_dma.len;
+			spi5_dma_chunk();
+		}else{
+			spi5_dma_finish();
+		}
+	}
+}
+
+int spi_transfer_dma(int id, const uint8_t* tx, uint32_t len, spi_dma_cb_pf cb)
+{
+	return spi_transfer_dma2d(id, tx, len, len, 1, cb);
+}
+
+int spi_transfer_dma2d(int id, const uint8_t* tx, uint32_t len, uint32_t stride, uint32_t rows, spi_dma_cb_pf cb)
+{
+	volatile uint16_t* cr1 = (uint16_t*)(reg_base[5-1] + 0x00);
+	volatile uint16_t* cr2 = (uint16_t*)(reg_base[5-1] + 0x04);
+	uint8_t psize = ((*cr1 & SPI_CR1_DFF) != 0) ? 1 : 0;
+	if((id != 5) || s_spi5_dma.busy){
+		return -1;
+	}
+	if((len == 0) || (rows == 0) || ((psize != 0) && ((((uint32_t)tx | len | stride) & 0x01) != 0))){
+		return -1;
+	}
+	if(stride == len){
+		/* 行首尾相接, 按一整块分段 */
+		len *= rows;
+		rows = 1;
+	}
+	s_spi5_dma.busy = 1;
+	s_spi5_dma.psize = psize;
+	s_spi5_dma.addr = (uint32_t)tx;
+	s_spi5_dma.remain = len;
+	s_spi5_dma.row = (uint32_t)tx;
+	s_spi5_dma.len = len;
+	s_spi5_dma.stride = stride;
+	s_spi5_dma.rows = rows - 1;
+	s_spi5_dma.cb = cb;
+	s_spi5_dma.xfers++;
+	/* CS拉低, 第一段配置好后再打开TXDMAEN, TXE立即产生请求 */
+	gpio_write((void*)GPIOA_BASE, 'C', 2, 0);
+	spi5_dma_chunk();
+	*cr2 |= SPI_CR2_TXDMAEN;
+	return 0;
+}
+
+int spi_dma_busy(int id)
+{
+	return (id == 5) ? s_spi5_dma.busy : 0;
+}
+
+void spi_dma_wait(int id)
+{
+	while(spi_dma_busy(id));
+}
+
+void spi_dma_stat(int id, uint32_t* xfers, uint32_t* chunks, uint32_t* errs)
+{
+	(void)id;
+	*xfers = s_spi5_dma.xfers;
+	*chunks = s_spi5_dma.chunks;
+	*errs = s_spi5_dma.errs;
+}
@@ -10,7 +10,65 @@ typedef struct{
 	uint32_t baud;    
 } spi_cfg_st;
 
+#define SPI_DMA_NDTR_MAX  65535u   /** DMA一次最多传输的数据项(NDTR 16位) */
+#define SPI_DMA_SPLIT_MIN 256u     /** 不少于此字节数才把未对齐的头尾分成单独的段 */
+
+/** DMA发送的一段, 长度不超过NDTR限制 */
+typedef struct{
+	uint32_t addr;    /** 存储器地址 */
+	uint16_t cnt;     /** 外设侧数据项数, 即NDTR */
+	uint8_t msize;    /** 存储器侧宽度 0:字节 1:半字 2:字(需4字节对齐且长度为4的倍数) */
+	uint8_t mburst;   /** 存储器侧突发 0:单拍 1:4拍(字, 需16字节对齐且长度为16的倍数) */
+} spi_dma_chunk_st;
+
+typedef void (*spi_dma_cb_pf)(int id);  /** DMA发送完成回调, 在中断中调用 */
+
 void spi_init(int id, spi_cfg_st* cfg);
 uint32_t spi_transfer(int id, uint8_t* tx, uint8_t* rx, uint32_t len, int flag);
 
+/**
+ * 切换8/16位帧, 与当前相同时不操作
+ * DFF只能在SPI禁止时修改, 先等待发送完成
+ */
+void spi_set_databits(int id, uint8_t databits);
+
+/**
+ * 16位帧只发送, len为16位数据个数, flag为1时完成后拉高CS
+ */
+uint32_t spi_transfer16(int id, const uint16_t* tx, uint32_t len, int flag);
+
+/**
+ * 从addr开始还有len字节待发送, 生成下一段
+ * psize为外设侧宽度 0:8位帧 1:16位帧(addr和len需为偶数)
+ * 对齐时按字读存储器(减少SDRAM访问次数), 16字节对齐的部分按4拍突发,
+ * 不少于SPI_DMA_SPLIT_MIN字节时未对齐的头尾单独成段, 每段不超过SPI_DMA_NDTR_MAX项
+ * 返回该段字节数, len为0时返回0
+ */
+uint32_t spi_dma_next(uint32_t addr, uint32_t len, uint8_t psize, spi_dma_chunk_st* chunk);
+
+/**
+ * DMA发送(只支持SPI5, DMA2 Stream4 Channel2), 启动后立即返回, len为字节数,
+ * 按当前帧宽度(spi_set_databits)写DR,
+ * 分段在中断中续传, 全部发完后拉高CS并调用cb
+ * 返回0启动成功, -1不支持或上次未完成
+ */
+int spi_transfer_dma(int id, const uint8_t* tx, uint32_t len, spi_dma_cb_pf cb);
+
+/**
+ * 同spi_transfer_dma, 发送rows行, 每行len字节, 行开始地址间隔stride字节,
+ * 用于发送显存中的矩形区域, 每行在中断中续传, CS在全部发完后才拉高
+ */
+int spi_transfer_dma2d(int id, const uint8_t* tx, uint32_t len, uint32_t stride, uint32_t rows, spi_dma_cb_pf cb);
+
+/** 返回1 DMA发送进行中 */
+int spi_dma_busy(int id);
+
+/** 等待DMA发送完成 */
+void spi_dma_wait(int id);
+
+/** DMA发送统计: 启动次数, 段数, 传输错误次数 */
+void spi_dma_stat(int id, uint32_t* xfers, uint32_t* chunks, uint32_t* errs);
+
+void spi5_dma_irqhandler(void);
+
 #endif 
@@ -13,6 +13,8 @@
 #include "lcd_test.h"
 #include "MLX90642_disp.h"
 #include "lcd_itf.h"
+#include "tim.h"
+#include "spi.h"
 
 #if defined(USE_IS42S16320F)
 	#define SDRAM_SIZE (64ul*1024ul*1024ul)
@@ -58,6 +60,7 @@ static int user_main(void)
 	uart_init(1, 1000000);
 
 	systick_init();
+	clock_cycle_init();
 	asm volatile ("cpsie i");
 	asm volatile ("cpsie f");
 
@@ -152,6 +155,8 @@ extern unsigned int _end_bss;
 extern unsigned int _data_load_addr;
 extern unsigned int _data_start;
 extern unsigned int _data_end;
+extern unsigned int _start_ccm;
+extern unsigned int _end_ccm;
 
 void reset(void)
 {
@@ -170,6 +175,11 @@ void reset(void)
 		*dst++ = 0;
 	}
 
+	dst = &_start_ccm;
+	while (dst < &_end_ccm) {
+		*dst++ = 0;
+	}
+
 	user_main();
 }
 
@@ -248,13 +258,13 @@ __attribute__((used)) static void (*vector_table[16 + 91])(void) = {
 	noop,
 	noop,
 	noop,
+	tim6_irqhandler,
+	tim7_irqhandler,
 	noop,
 	noop,
 	noop,
 	noop,
-	noop,
-	noop,
-	noop,
+	spi5_dma_irqhandler,
 	noop,
 	noop,
 	noop,
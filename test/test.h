@@ -0,0 +1,28 @@
+#ifndef TEST_H
+#define TEST_H
+
+/**
+ * 主机测试用的简单检查, 失败时打印位置并计数, main最后用TEST_END返回结果
+ */
+
+#include <stdio.h>
+
+extern int g_test_fail;
+
+#define TEST_CHECK(cond) do{ \
+        if(!(cond)){ \
+            g_test_fail++; \
+            if(g_test_fail <= 20){ \
+                printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            } \
+        } \
+    }while(0)
+
+#define TEST_DEFINE int g_test_fail = 0
+
+#define TEST_END(name) do{ \
+        printf("%s: %s (%d failed)\n", name, g_test_fail ? "FAIL" : "ok", g_test_fail); \
+        return g_test_fail ? 1 : 0; \
+    }while(0)
+
+#endif
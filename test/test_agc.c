@@ -0,0 +1,156 @@
+/**
+ * 一帧统计和自动增益映射的主机测试:
+ * mlx90642_frame_stat一次遍历的结果与分开的循环逐项相同(随机帧, 随机的有效行),
+ * temp2rgb_agc在[lo,lo+span)内按灰度单调查表, 范围外取两端颜色
+ */
+#include <stdint.h>
+#include <string.h>
+#include "test.h"
+#include "MLX90642_disp.h"
+#include "MLX90642_palette.h"
+
+TEST_DEFINE;
+
+#define N MLX90642_TOTAL_NUMBER_OF_PIXELS
+
+static int16_t s_temp[N];
+static uint16_t s_rgb[N];
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed*1103515245ul + 12345ul;
+    return s_seed >> 8;
+}
+
+/* 分开的循环, 只统计rows中的行 */
+static void stat_ref(const int16_t* temp, uint32_t rows, int16_t th, mlx90642_stat_st* st)
+{
+    int32_t sum = 0;
+    int first = 1;
+    memset(st, 0, sizeof(*st));
+    for(int i=0; i<N; i++){
+        if(rows & (1ul << (i/32))){
+            if(first || (temp[i] > st->max)){
+                st->max = temp[i];
+                st->hot_idx = (uint16_t)i;
+            }
+            if(first || (temp[i] < st->min)){
+                st->min = temp[i];
+            }
+            first = 0;
+        }
+    }
+    for(int i=0; i<N; i++){
+        if(rows & (1ul << (i/32))){
+            sum += temp[i];
+            st->num++;
+        }
+    }
+    for(int i=0; i<N; i++){
+        if((rows & (1ul << (i/32))) && (temp[i] >= th)){
+            st->over++;
+        }
+    }
+    if(st->num != 0){
+        st->mean = (int16_t)(sum / st->num);
+    }
+}
+
+static int stat_same(const mlx90642_stat_st* a, const mlx90642_stat_st* b)
+{
+    return (a->min == b->min) && (a->max == b->max) && (a->mean == b->mean) &&
+        (a->hot_idx == b->hot_idx) && (a->over == b->over) && (a->num == b->num);
+}
+
+int main(void)
+{
+    mlx90642_stat_st st;
+    mlx90642_stat_st ref;
+    mlx90642_agc_map_st map;
+    const uint16_t* lut;
+    uint32_t rows;
+    int16_t th;
+    int diff = 0;
+    int x;
+    int g;
+    int g_prev;
+
+    /* 随机帧: 室温背景, 热源, 整个int16范围, 相同的最大值(取第一个) */
+    for(int k=0; k<2000; k++){
+        for(int i=0; i<N; i++){
+            switch(k & 3){
+                case 0:  s_temp[i] = (int16_t)(25*50 + (int)(rnd() & 0x3F) - 32); break;
+                case 1:  s_temp[i] = (int16_t)rnd(); break;
+                case 2:  s_temp[i] = (int16_t)(rnd() & 0x07); break;
+                default: s_temp[i] = (int16_t)(20*50 + (i%32)*20 + (i/32)*35); break;
+            }
+        }
+        if((k & 3) == 3){
+            s_temp[rnd() % N] = 120*50;
+        }
+        rows = ((k % 5) == 0) ? 0xFFFFFF : (rnd() & 0xFFFFFF);
+        if((k % 97) == 0){
+            rows = 0;
+        }
+        th = (int16_t)(((k & 3) == 1) ? rnd() : 25*50 + (rnd() & 0x1F));
+        stat_ref(s_temp, rows, th, &ref);
+        memset(&st, 0x5A, sizeof(st));
+        mlx90642_frame_stat(s_temp, rows, th, &st);
+        if(!stat_same(&st, &ref)){
+            diff++;
+        }
+    }
+    TEST_CHECK(diff == 0);
+
+    /* 没有有效行时全部为0 */
+    mlx90642_frame_stat(s_temp, 0, 0, &st);
+    TEST_CHECK((st.num == 0) && (st.min == 0) && (st.max == 0) && (st.over == 0));
+
+    /* 自动增益映射: 25~35℃ */
+    mlx90642_palette_set(mlx90642_palette_find("classic"));
+    lut = mlx90642_palette_lut();
+    map.lo = 25*50;
+    map.span = 10*50;
+    map.scale = (255ul << 16) / map.span;
+    for(int i=0; i<N; i++){
+        s_temp[i] = (int16_t)(map.lo - 100 + i);
+    }
+    temp2rgb_agc(s_temp, s_rgb, 0, N, &map);
+    g_prev = 0;
+    diff = 0;
+    for(int i=0; i<N; i++){
+        x = s_temp[i] - map.lo;
+        if(x <= 0){
+            TEST_CHECK(s_rgb[i] == lut[0]);
+            continue;
+        }
+        if(x >= map.span){
+            TEST_CHECK(s_rgb[i] == lut[255]);
+            continue;
+        }
+        /* 灰度与255*x/span相差不超过1, 单调不减, 到范围上限前不会到255 */
+        g = (int)(((uint32_t)x*map.scale) >> 16);
+        TEST_CHECK((g <= 255*x/map.span) && (g + 1 >= 255*x/map.span));
+        TEST_CHECK((g >= g_prev) && (g < 255));
+        g_prev = g;
+        if(s_rgb[i] != lut[g]){
+            diff++;
+        }
+    }
+    TEST_CHECK(diff == 0);
+
+    /* 最小范围时整个调色板也都用到 */
+    map.lo = -10;
+    map.span = 2*50;
+    map.scale = (255ul << 16) / map.span;
+    for(int i=0; i<N; i++){
+        s_temp[i] = (int16_t)(map.lo + i*map.span/N);
+    }
+    temp2rgb_agc(s_temp, s_rgb, 0, N, &map);
+    TEST_CHECK(s_rgb[0] == lut[0]);
+    TEST_CHECK(s_rgb[N-1] == lut[((uint32_t)(s_temp[N-1] - map.lo)*map.scale) >> 16]);
+    TEST_CHECK((((uint32_t)(s_temp[N-1] - map.lo)*map.scale) >> 16) >= 252);
+
+    TEST_END("agc");
+}
@@ -0,0 +1,313 @@
+/**
+ * 热点检测和跟踪的主机测试:
+ * 游程+并查集的mlx90642_blob_label与逐点8邻接泛洪填充的结果相同(面积, 峰值及位置, 质心, 外接框,
+ * 排序和截断, 最大面积, 游程数), 随机帧包括U形, 对角相接和各种有效行;
+ * 跟踪时移动的目标沿用ID, 短暂丢失的目标找回原ID, 丢失太久或跳得太远的分配新ID
+ */
+#include <stdint.h>
+#include <string.h>
+#include "test.h"
+#include "MLX90642_blob.h"
+
+TEST_DEFINE;
+
+#define W 32
+#define H 24
+#define N (W*H)
+
+static int16_t s_temp[N];
+static uint16_t s_lab[N];
+static uint16_t s_stack[N];
+static mlx90642_blob_st s_ref[N];
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed*1103515245ul + 12345ul;
+    return s_seed >> 8;
+}
+
+static int hot(uint32_t rows, int16_t th, int i)
+{
+    return ((rows & (1ul << (i/W))) != 0) && (s_temp[i] >= th);
+}
+
+/* 按光栅顺序泛洪填充, 连通域按第一个点的顺序编号, 峰值取光栅顺序第一个最大点 */
+static int label_ref(uint32_t rows, int16_t th, int* runs)
+{
+    int n = 0;
+    int sp;
+    int i;
+    int x;
+    int y;
+    int j;
+    uint32_t sx;
+    uint32_t sy;
+    mlx90642_blob_st* b;
+
+    memset(s_lab, 0, sizeof(s_lab));
+    *runs = 0;
+    for(int k=0; k<N; k++){
+        if(hot(rows, th, k) && (((k % W) == 0) || !hot(rows, th, k-1))){
+            (*runs)++;
+        }
+        if(!hot(rows, th, k) || (s_lab[k] != 0)){
+            continue;
+        }
+        b = &s_ref[n++];
+        memset(b, 0, sizeof(*b));
+        b->peak = s_temp[k];
+        b->peak_idx = (uint16_t)k;
+        b->x0 = b->x1 = (uint8_t)(k % W);
+        b->y0 = b->y1 = (uint8_t)(k / W);
+        sx = 0;
+        sy = 0;
+        sp = 0;
+        s_lab[k] = (uint16_t)n;
+        s_stack[sp++] = (uint16_t)k;
+        while(sp > 0){
+            i = s_stack[--sp];
+            x = i % W;
+            y = i / W;
+            b->area++;
+            sx += x;
+            sy += y;
+            if((s_temp[i] > b->peak) || ((s_temp[i] == b->peak) && (i < b->peak_idx))){
+                b->peak = s_temp[i];
+                b->peak_idx = (uint16_t)i;
+            }
+            if(x < b->x0) b->x0 = (uint8_t)x;
+            if(x > b->x1) b->x1 = (uint8_t)x;
+            if(y < b->y0) b->y0 = (uint8_t)y;
+            if(y > b->y1) b->y1 = (uint8_t)y;
+            for(int dy=-1; dy<=1; dy++){
+                for(int dx=-1; dx<=1; dx++){
+                    if((x + dx < 0) || (x + dx >= W) || (y + dy < 0) || (y + dy >= H)){
+                        continue;
+                    }
+                    j = (y + dy)*W + x + dx;
+                    if(hot(rows, th, j) && (s_lab[j] == 0)){
+                        s_lab[j] = (uint16_t)n;
+                        s_stack[sp++] = (uint16_t)j;
+                    }
+                }
+            }
+        }
+        b->cx = (uint16_t)(((sx << MLX90642_BLOB_Q) + b->area/2) / b->area);
+        b->cy = (uint16_t)(((sy << MLX90642_BLOB_Q) + b->area/2) / b->area);
+    }
+    return n;
+}
+
+static int blob_same(const mlx90642_blob_st* a, const mlx90642_blob_st* b)
+{
+    return (a->area == b->area) && (a->peak == b->peak) && (a->peak_idx == b->peak_idx) &&
+        (a->cx == b->cx) && (a->cy == b->cy) &&
+        (a->x0 == b->x0) && (a->x1 == b->x1) && (a->y0 == b->y0) && (a->y1 == b->y1);
+}
+
+/* 与参考结果比较: 去掉小于min_area的, 按面积和峰值稳定排序, 保留前MLX90642_BLOB_MAX个 */
+static int check(uint32_t rows, int16_t th, uint16_t min_area)
+{
+    mlx90642_blob_list_st list;
+    mlx90642_blob_st sel[MLX90642_BLOB_MAX];
+    mlx90642_blob_st t;
+    int runs;
+    int n = label_ref(rows, th, &runs);
+    int m = 0;
+    uint16_t area_max = 0;
+    int j;
+
+    for(int k=0; k<n; k++){
+        if(s_ref[k].area > area_max){
+            area_max = s_ref[k].area;
+        }
+        if(s_ref[k].area < min_area){
+            continue;
+        }
+        t = s_ref[k];
+        for(j=m; j>0; j--){
+            if((sel[j-1].area > t.area) || ((sel[j-1].area == t.area) && (sel[j-1].peak >= t.peak))){
+                break;
+            }
+            if(j < MLX90642_BLOB_MAX){
+                sel[j] = sel[j-1];
+            }
+        }
+        if(j < MLX90642_BLOB_MAX){
+            sel[j] = t;
+            if(m < MLX90642_BLOB_MAX){
+                m++;
+            }
+        }
+    }
+
+    memset(&list, 0x5A, sizeof(list));
+    mlx90642_blob_label(s_temp, rows, th, min_area, &list);
+    if((list.num != m) || (list.area_max != area_max) || (list.runs != runs)){
+        return 0;
+    }
+    for(int k=0; k<m; k++){
+        if(!blob_same(&list.blob[k], &sel[k]) || (list.blob[k].id != 0)){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* 背景加若干方块热源 */
+static void scene(const int* pos, int num, int size)
+{
+    for(int i=0; i<N; i++){
+        s_temp[i] = 25*50;
+    }
+    for(int k=0; k<num; k++){
+        for(int y=pos[2*k+1]; y<pos[2*k+1]+size; y++){
+            for(int x=pos[2*k]; x<pos[2*k]+size; x++){
+                s_temp[y*W + x] = (int16_t)(40*50 + k);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    static const uint32_t masks[] = {0xFFFFFF, 0x555555, 0xFFF0FF, 0x000001, 0x800000, 0};
+    const mlx90642_blob_list_st* list;
+    int pos[4];
+    uint16_t id0;
+    uint16_t id1;
+    uint32_t rows;
+    int bad = 0;
+
+    /* 随机帧: 不同密度, 密度高时有U形, 对角相接和超过8个的连通域 */
+    for(int k=0; k<3000; k++){
+        uint32_t density = (uint32_t)(k % 7) + 1;
+        for(int i=0; i<N; i++){
+            s_temp[i] = (int16_t)(((rnd() & 15) < density*2) ? 30*50 + (int)(rnd() & 0x3F) : 25*50 + (int)(rnd() & 0x3F));
+        }
+        rows = (k < 60) ? masks[k % 6] : ((k & 1) ? 0xFFFFFF : (rnd() & 0xFFFFFF));
+        if(!check(rows, 30*50, (uint16_t)((k % 5) + 1))){
+            bad++;
+        }
+    }
+    TEST_CHECK(bad == 0);
+
+    /* 全部超过阈值: 一个连通域, 每行一个游程 */
+    for(int i=0; i<N; i++){
+        s_temp[i] = 30*50;
+    }
+    s_temp[7*W + 9] = 31*50;
+    TEST_CHECK(check(0xFFFFFF, 30*50, 1));
+
+    /* U形的两臂在底部相连, 棋盘格按8邻接连成一个 */
+    for(int i=0; i<N; i++){
+        s_temp[i] = 25*50;
+    }
+    for(int y=2; y<12; y++){
+        s_temp[y*W + 3] = 35*50;
+        s_temp[y*W + 12] = 35*50;
+    }
+    for(int x=3; x<=12; x++){
+        s_temp[12*W + x] = 35*50;
+    }
+    for(int y=14; y<20; y++){
+        for(int x=16; x<26; x++){
+            if(((x + y) & 1) == 0){
+                s_temp[y*W + x] = 36*50;
+            }
+        }
+    }
+    TEST_CHECK(check(0xFFFFFF, 30*50, 1));
+    {
+        mlx90642_blob_list_st l;
+        mlx90642_blob_label(s_temp, 0xFFFFFF, 30*50, 1, &l);
+        TEST_CHECK((l.num == 2) && (l.blob[0].area == 30) && (l.blob[1].area == 30));
+    }
+
+    /* 参数 */
+    TEST_CHECK(mlx90642_blob_config(0, 4) == -1);
+    TEST_CHECK(mlx90642_blob_config(2, 0) == -1);
+    TEST_CHECK(mlx90642_blob_config(N + 1, 4) == -1);
+    TEST_CHECK(mlx90642_blob_config(2, 4) == 0);
+    TEST_CHECK(mlx90642_blob_run(-1, s_temp, 0xFFFFFF, 30*50) == 0);
+    TEST_CHECK(mlx90642_blob_run(MLX90642_BLOB_SENSOR_MAX, s_temp, 0xFFFFFF, 30*50) == 0);
+    TEST_CHECK(mlx90642_blob_get(MLX90642_BLOB_SENSOR_MAX) == 0);
+
+    /* 两个目标每帧相向移动1点, ID不变, age递增 */
+    pos[0] = 2;  pos[1] = 4;
+    pos[2] = 26; pos[3] = 16;
+    scene(pos, 2, 3);
+    list = mlx90642_blob_run(1, s_temp, 0xFFFFFF, 30*50);
+    TEST_CHECK((list != 0) && (list->num == 2));
+    /* 面积相同, 峰值高的(第二个目标)排在前面 */
+    id0 = list->blob[1].id;
+    id1 = list->blob[0].id;
+    TEST_CHECK((id0 != 0) && (id1 != 0) && (id0 != id1));
+    bad = 0;
+    for(int k=1; k<=10; k++){
+        pos[0]++;
+        pos[2]--;
+        scene(pos, 2, 3);
+        list = mlx90642_blob_run(1, s_temp, 0xFFFFFF, 30*50);
+        for(int b=0; b<list->num; b++){
+            if(list->blob[b].id != ((list->blob[b].peak == 40*50) ? id0 : id1)){
+                bad++;
+            }
+            if(list->blob[b].age != k + 1){
+                bad++;
+            }
+        }
+        if((list->num != 2) || (list->lost != 0)){
+            bad++;
+        }
+    }
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(mlx90642_blob_get(1) == list);
+    TEST_CHECK(list->frames == 11);
+
+    /* 第二个目标消失3帧后在原处出现, 找回原ID */
+    for(int k=0; k<3; k++){
+        scene(pos, 1, 3);
+        list = mlx90642_blob_run(1, s_temp, 0xFFFFFF, 30*50);
+        TEST_CHECK((list->num == 1) && (list->lost == 1) && (list->blob[0].id == id0));
+    }
+    scene(pos, 2, 3);
+    list = mlx90642_blob_run(1, s_temp, 0xFFFFFF, 30*50);
+    TEST_CHECK((list->num == 2) && (list->lost == 0));
+    TEST_CHECK((list->blob[0].id == id1) && (list->blob[0].age == 12) && (list->blob[1].id == id0));
+
+    /* 消失4帧后删除, 再出现时分配新ID */
+    for(int k=0; k<4; k++){
+        scene(pos, 1, 3);
+        list = mlx90642_blob_run(1, s_temp, 0xFFFFFF, 30*50);
+    }
+    TEST_CHECK(list->lost == 0);
+    scene(pos, 2, 3);
+    list = mlx90642_blob_run(1, s_temp, 0xFFFFFF, 30*50);
+    TEST_CHECK((list->num == 2) && (list->blob[0].id != id1) && (list->blob[0].id != id0) && (list->blob[0].age == 1));
+    TEST_CHECK(list->blob[1].id == id0);
+
+    /* 跳得比gate远的是新目标, 旧目标计为丢失 */
+    id1 = list->blob[0].id;
+    pos[2] -= 8;
+    scene(pos, 2, 3);
+    list = mlx90642_blob_run(1, s_temp, 0xFFFFFF, 30*50);
+    TEST_CHECK((list->num == 2) && (list->lost == 1));
+    TEST_CHECK((list->blob[0].id != id1) && (list->blob[0].id != id0) && (list->blob[1].id == id0));
+
+    /* 各传感器的跟踪独立, config清除跟踪状态 */
+    list = mlx90642_blob_run(2, s_temp, 0xFFFFFF, 30*50);
+    TEST_CHECK((list->num == 2) && (list->frames == 1) && (list->blob[0].age == 1) && (list->blob[1].age == 1));
+    TEST_CHECK(mlx90642_blob_config(2, 4) == 0);
+    list = mlx90642_blob_run(1, s_temp, 0xFFFFFF, 30*50);
+    TEST_CHECK((list->num == 2) && (list->lost == 0) && (list->blob[0].age == 1));
+
+    /* min_area: 2x2的目标在min_area为5时丢弃 */
+    TEST_CHECK(mlx90642_blob_config(5, 4) == 0);
+    scene(pos, 2, 2);
+    list = mlx90642_blob_run(1, s_temp, 0xFFFFFF, 30*50);
+    TEST_CHECK((list->num == 0) && (list->area_max == 4));
+
+    TEST_END("blob");
+}
@@ -0,0 +1,256 @@
+/**
+ * LTDC+DMA2D显示后端的主机测试, 用-DLCD_ITF_LTDC=1 -DDMA2D_SIM=1 -DLTDC_SIM=1编译:
+ * lcd_itf_fill/lcd_itf_blit_l8/lcd_itf_blend/lcd_itf_band_end编程的DMA2D操作(仿真记录)和写入显存的结果,
+ * 换调色板时才重新加载CLUT; 多帧随机绘制时lcd_itf_frame_begin复制后的后缓存与调用者看到的画面相同,
+ * 用-DLCD_FB_NUM=1/2/3各编译一次.
+ * 不调用lcd_itf_init(面板初始化经过SPI), 直接初始化DMA2D
+ */
+#include <stdint.h>
+#include <string.h>
+#include "test.h"
+#include "lcd_itf.h"
+#include "dma2d.h"
+#include "ltdc.h"
+
+TEST_DEFINE;
+
+#ifndef LCD_FB_NUM
+#define LCD_FB_NUM 2
+#endif
+
+#define W LCD_HSIZE
+#define H LCD_VSIZE
+
+static uint16_t s_pic[W*H];           /* 调用者看到的画面 */
+static uint8_t s_l8[64*40];
+static uint16_t s_fg[64*40];
+static uint16_t s_lut0[256];
+static uint16_t s_lut1[256];
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed*1103515245ul + 12345ul;
+    return s_seed >> 8;
+}
+
+/* 取最近一次操作, 没有操作返回0 */
+static const dma2d_op_st* last_op(uint32_t* num)
+{
+    const dma2d_op_st* log = dma2d_sim_log(num);
+    return (*num > 0) ? &log[(*num - 1) % DMA2D_SIM_LOG_MAX] : 0;
+}
+
+/* 显存与调用者看到的画面逐点相同 */
+static int fb_same(const uint16_t* fb, const uint16_t* pic)
+{
+    return memcmp(fb, pic, sizeof(s_pic)) == 0;
+}
+
+static void pic_fill(int x, int w, int y, int h, uint16_t rgb)
+{
+    for(int i=y; i<y+h; i++){
+        for(int j=x; j<x+w; j++){
+            s_pic[i*W + j] = rgb;
+        }
+    }
+}
+
+static int mix_ok(uint32_t v, uint32_t f, uint32_t b, uint32_t a)
+{
+    uint32_t ref = (f*a + b*(255 - a)) / 255;
+    return (v + 1 >= ref) && (v <= ref + 1);
+}
+
+static int blend_ok(uint16_t v, uint16_t f, uint16_t b, uint8_t a)
+{
+    return mix_ok(v >> 11, f >> 11, b >> 11, a) &&
+        mix_ok((v >> 5) & 0x3F, (f >> 5) & 0x3F, (b >> 5) & 0x3F, a) &&
+        mix_ok(v & 0x1F, f & 0x1F, b & 0x1F, a);
+}
+
+int main(void)
+{
+    const dma2d_op_st* op;
+    uint16_t* fb;
+    uint16_t* band;
+    uint16_t* prev;
+    uint32_t num;
+    uint32_t reloads;
+    int bad;
+    int x;
+    int y;
+    int w;
+    int h;
+    uint16_t c;
+
+    dma2d_init();
+    fb = lcd_itf_buffer();
+    TEST_CHECK(fb_same(fb, s_pic));
+
+    /* 大的填充: 一次R2M */
+    dma2d_sim_clear();
+    lcd_itf_fill(13, 100, 7, 50, 0xF81F);
+    pic_fill(13, 100, 7, 50, 0xF81F);
+    op = last_op(&num);
+    TEST_CHECK((num == 1) && (op->mode == DMA2D_MODE_R2M) && (op->color == 0xF81F));
+    TEST_CHECK((op->w == 100) && (op->h == 50) && (op->out_off == W - 100));
+    TEST_CHECK(op->out == (uintptr_t)(fb + 7*W + 13));
+    fb = lcd_itf_buffer();
+    TEST_CHECK(fb_same(fb, s_pic));
+    /* 小的填充CPU直接写 */
+    dma2d_sim_clear();
+    lcd_itf_fill(200, 7, 100, 9, 0x07E0);
+    pic_fill(200, 7, 100, 9, 0x07E0);
+    dma2d_sim_log(&num);
+    TEST_CHECK(num == 0);
+    TEST_CHECK(fb_same(lcd_itf_buffer(), s_pic));
+
+    /* L8查表: 第一次加载CLUT, 同一调色板不重新加载, 换调色板时重新加载 */
+    for(int i=0; i<256; i++){
+        s_lut0[i] = (uint16_t)(i*0x0101u ^ 0x5A5A);
+        s_lut1[i] = (uint16_t)(0xFFFF - i*37u);
+    }
+    for(int i=0; i<(int)sizeof(s_l8); i++){
+        s_l8[i] = (uint8_t)rnd();
+    }
+    dma2d_sim_clear();
+    for(int k=0; k<3; k++){
+        const uint16_t* lut = (k < 2) ? s_lut0 : s_lut1;
+        x = 40 + k*70;
+        y = 120;
+        lcd_itf_blit_l8(x, 60, y, 40, s_l8, 64, lut);
+        op = last_op(&num);
+        TEST_CHECK((num == (uint32_t)k + 1) && (op->mode == DMA2D_MODE_M2M_PFC) && (op->fg_cm == DMA2D_CM_L8));
+        TEST_CHECK((op->w == 60) && (op->h == 40) && (op->fg_off == 64 - 60) && (op->out_off == W - 60));
+        TEST_CHECK(op->fg == (uintptr_t)s_l8);
+        TEST_CHECK(dma2d_sim_clut_loads() == ((k < 2) ? 1u : 2u));
+        for(int i=0; i<40; i++){
+            for(int j=0; j<60; j++){
+                s_pic[(y + i)*W + x + j] = lut[s_l8[i*64 + j]];
+            }
+        }
+        TEST_CHECK(fb_same(lcd_itf_buffer(), s_pic));
+    }
+
+    /* 恒定透明度叠加: 背景就是目的, 每个分量与按定义混合的结果相差不超过1 */
+    for(int i=0; i<(int)(sizeof(s_fg)/sizeof(s_fg[0])); i++){
+        s_fg[i] = (uint16_t)rnd();
+    }
+    for(int a=0; a<=255; a+=85){
+        x = 10 + a/5;
+        y = 150;
+        dma2d_sim_clear();
+        lcd_itf_blend(x, 50, y, 30, s_fg, 64, (uint8_t)a);
+        op = last_op(&num);
+        fb = lcd_itf_buffer();
+        TEST_CHECK((num == 1) && (op->mode == DMA2D_MODE_M2M_BLEND) && (op->alpha == a));
+        TEST_CHECK((op->bg == op->out) && (op->out == (uintptr_t)(fb + y*W + x)));
+        TEST_CHECK((op->fg_off == 64 - 50) && (op->bg_off == W - 50) && (op->out_off == W - 50));
+        bad = 0;
+        for(int i=0; i<30; i++){
+            for(int j=0; j<50; j++){
+                if(!blend_ok(fb[(y + i)*W + x + j], s_fg[i*64 + j], s_pic[(y + i)*W + x + j], (uint8_t)a)){
+                    bad++;
+                }
+                s_pic[(y + i)*W + x + j] = fb[(y + i)*W + x + j];
+            }
+        }
+        TEST_CHECK(bad == 0);
+        TEST_CHECK((a != 255) || (fb[y*W + x] == s_fg[0]));
+        TEST_CHECK(fb_same(fb, s_pic));
+    }
+
+    /* 行带: 两个缓存轮流用, 每个行带一次M2M复制到显存 */
+    prev = 0;
+    for(int k=0; k<4; k++){
+        x = 20*k;
+        y = 190 + 10*k;
+        if(y + 10 > H){
+            y = H - 10;
+        }
+        band = lcd_itf_band_begin(x, 96, y, 10);
+        TEST_CHECK((band != 0) && (band != prev) && (((uintptr_t)band & 3) == 0));
+        TEST_CHECK(lcd_itf_band_begin(x, 96, y, 10) == 0);    /* 没有结束时不能开始下一个 */
+        for(int i=0; i<96*10; i++){
+            band[i] = (uint16_t)(k*1000 + i);
+        }
+        dma2d_sim_clear();
+        TEST_CHECK(lcd_itf_band_end() == 0);
+        op = last_op(&num);
+        TEST_CHECK((num == 1) && (op->mode == DMA2D_MODE_M2M) && (op->fg == (uintptr_t)band));
+        TEST_CHECK((op->w == 96) && (op->h == 10) && (op->fg_off == 0) && (op->out_off == W - 96));
+        for(int i=0; i<10; i++){
+            for(int j=0; j<96; j++){
+                s_pic[(y + i)*W + x + j] = (uint16_t)(k*1000 + i*96 + j);
+            }
+        }
+        TEST_CHECK(fb_same(lcd_itf_buffer(), s_pic));
+        prev = band;
+    }
+    TEST_CHECK(lcd_itf_band_end() == -1);
+    TEST_CHECK(lcd_itf_band_begin(0, 95, 0, 10) == 0);         /* 宽度需为偶数 */
+    TEST_CHECK(lcd_itf_band_begin(0, 96, 0, 11) == 0);
+
+    /* 多帧: 帧内外随机绘制, 每帧开始时后缓存都是完整的画面, 复制只有整块的M2M */
+    reloads = ltdc_reloads();
+    bad = 0;
+    for(int f=0; f<300; f++){
+        dma2d_sim_clear();
+        fb = lcd_itf_frame_begin();
+        if(!fb_same(fb, s_pic)){
+            bad++;
+        }
+        {
+            const dma2d_op_st* log = dma2d_sim_log(&num);
+            if((LCD_FB_NUM == 1) && (num != 0)){
+                bad++;
+            }
+            for(uint32_t i=0; (i<num) && (i<DMA2D_SIM_LOG_MAX); i++){
+                if((log[i].mode != DMA2D_MODE_M2M) || (log[i].h != 10) || ((log[i].w % 10) != 0) ||
+                    (log[i].out < (uintptr_t)fb) || (log[i].out >= (uintptr_t)(fb + W*H))){
+                    bad++;
+                }
+            }
+        }
+        TEST_CHECK(lcd_itf_frame_begin() == fb);                /* 帧内再调用返回同一个 */
+        TEST_CHECK(lcd_itf_band_begin(0, 10, 0, 10) == 0);      /* 帧内不能用行带 */
+        for(int k=0; k<(int)(rnd() % 4); k++){
+            w = 1 + (int)(rnd() % 80);
+            h = 1 + (int)(rnd() % 60);
+            x = (int)(rnd() % (W - w));
+            y = (int)(rnd() % (H - h));
+            c = (uint16_t)rnd();
+            lcd_itf_fill(x, w, y, h, c);
+            pic_fill(x, w, y, h, c);
+        }
+        if((f % 7) == 3){
+            lcd_itf_blit_l8(250, 60, 5, 40, s_l8, 64, (f & 8) ? s_lut0 : s_lut1);
+            for(int i=0; i<40; i++){
+                for(int j=0; j<60; j++){
+                    s_pic[(5 + i)*W + 250 + j] = ((f & 8) ? s_lut0 : s_lut1)[s_l8[i*64 + j]];
+                }
+            }
+        }
+        TEST_CHECK(lcd_itf_frame_end() == 0);
+        if(!fb_same(fb, s_pic)){
+            bad++;
+        }
+        /* 帧外的绘制在前缓存上, 下一帧也要带上 */
+        if((f % 5) == 0){
+            x = (int)(rnd() % (W - 30));
+            y = (int)(rnd() % (H - 30));
+            lcd_itf_fill(x, 30, y, 30, (uint16_t)f);
+            pic_fill(x, 30, y, 30, (uint16_t)f);
+            if(lcd_itf_buffer() != fb){
+                bad++;
+            }
+        }
+    }
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(ltdc_reloads() - reloads == 300);
+    TEST_CHECK(lcd_itf_frame_end() == -1);
+    TEST_CHECK(fb_same(lcd_itf_buffer(), s_pic));
+
+    TEST_END((LCD_FB_NUM == 1) ? "dma2d fb1" : (LCD_FB_NUM == 2) ? "dma2d fb2" : "dma2d fb3");
+}
@@ -0,0 +1,193 @@
+/**
+ * 逐点时域滤波的主机测试:
+ * 合成噪声下的降噪比和无偏, 低于slew的阶跃按1/(1<<shift)收敛且不过冲,
+ * 超过slew的阶跃直接取输入, 以及有效行, 多传感器状态和参数检查
+ */
+#include <stdint.h>
+#include <string.h>
+#include "test.h"
+#include "MLX90642_filter.h"
+
+TEST_DEFINE;
+
+#define N 768
+
+static int16_t s_temp[N];
+static int16_t s_in[N];
+static uint32_t s_seed = 1;
+
+/* 4个均匀分布之和近似高斯噪声, 标准差约9(0.18℃) */
+static int noise(void)
+{
+    int v = 0;
+    for(int i=0; i<4; i++){
+        s_seed = s_seed*1103515245ul + 12345ul;
+        v += (int)((s_seed >> 16) & 0x0F);
+    }
+    return v - 30;
+}
+
+static void frame(int16_t level, int with_noise)
+{
+    for(int i=0; i<N; i++){
+        s_temp[i] = (int16_t)(level + (with_noise ? noise() : 0));
+    }
+    memcpy(s_in, s_temp, sizeof(s_in));
+}
+
+static uint32_t mse(const int16_t* temp, int16_t truth)
+{
+    uint32_t sum = 0;
+    int32_t d;
+    for(int i=0; i<N; i++){
+        d = temp[i] - truth;
+        sum += (uint32_t)(d*d);
+    }
+    return sum / N;
+}
+
+static int32_t mean(const int16_t* temp)
+{
+    int32_t sum = 0;
+    for(int i=0; i<N; i++){
+        sum += temp[i];
+    }
+    return sum / N;
+}
+
+int main(void)
+{
+    const mlx90642_filter_stat_st* stat = mlx90642_filter_stat();
+    int16_t base = 25*50;
+    uint32_t mse_in = 0;
+    uint32_t mse_out = 0;
+    int32_t m;
+    int32_t prev;
+    int frames;
+    int err;
+
+    /* 参数 */
+    TEST_CHECK(mlx90642_filter_config(7, 100) == -1);
+    TEST_CHECK(mlx90642_filter_config(0, 100) == 0);
+    frame(base, 1);
+    mlx90642_filter_run(0, s_temp, 0xFFFFFF);
+    TEST_CHECK(memcmp(s_temp, s_in, sizeof(s_in)) == 0);    /* shift为0不滤波 */
+    TEST_CHECK(stat->frames == 0);
+
+    /* 降噪: shift=2时方差理论上降为1/7, 留余量要求低于30%, 均值不偏 */
+    TEST_CHECK(mlx90642_filter_config(2, 2*50) == 0);
+    TEST_CHECK((stat->shift == 2) && (stat->slew == 100));
+    frame(base, 1);
+    mlx90642_filter_run(0, s_temp, 0xFFFFFF);
+    TEST_CHECK(memcmp(s_temp, s_in, sizeof(s_in)) == 0);    /* 第一帧没有状态, 直接取输入 */
+    for(int k=0; k<16+200; k++){
+        frame(base, 1);
+        if(k >= 16){
+            mse_in += mse(s_temp, base);
+        }
+        mlx90642_filter_run(0, s_temp, 0xFFFFFF);
+        if(k >= 16){
+            mse_out += mse(s_temp, base);
+            m = mean(s_temp) - base;
+            TEST_CHECK((m >= -2) && (m <= 2));
+        }
+    }
+    TEST_CHECK(mse_in > 0);
+    TEST_CHECK(mse_out*100 < mse_in*30);
+    TEST_CHECK(stat->resets == 0);
+
+    /* 恒定输入(包括负温度)输出不变 */
+    for(int16_t level=-40*50; level<=100*50; level+=1234){
+        TEST_CHECK(mlx90642_filter_config(3, 100) == 0);
+        err = 0;
+        for(int k=0; k<8; k++){
+            frame(level, 0);
+            mlx90642_filter_run(1, s_temp, 0xFFFFFF);
+            if(memcmp(s_temp, s_in, sizeof(s_in)) != 0){
+                err++;
+            }
+        }
+        TEST_CHECK(err == 0);
+    }
+
+    /* 小阶跃(1℃ < slew 2℃): 每帧剩余误差乘3/4, 单调, 不过冲, 8帧内到90%, 最后到达目标 */
+    TEST_CHECK(mlx90642_filter_config(2, 2*50) == 0);
+    frame(base, 0);
+    mlx90642_filter_run(0, s_temp, 0xFFFFFF);
+    prev = base;
+    err = 0;
+    for(frames=1; frames<=64; frames++){
+        frame((int16_t)(base + 50), 0);
+        mlx90642_filter_run(0, s_temp, 0xFFFFFF);
+        m = mean(s_temp);
+        if((m < prev) || (m > base + 50)){
+            err++;
+        }
+        if(frames == 1){
+            TEST_CHECK((m - base >= 50/4 - 1) && (m - base <= 50/4 + 1));
+        }
+        if(frames == 8){
+            TEST_CHECK(m - base >= 50*9/10);
+        }
+        prev = m;
+    }
+    TEST_CHECK(err == 0);
+    TEST_CHECK(prev == base + 50);
+    TEST_CHECK(stat->resets == 0);
+
+    /* 大阶跃(20℃ > slew): 直接取输入, 每点计一次 */
+    frame((int16_t)(base + 20*50), 1);
+    mlx90642_filter_run(0, s_temp, 0xFFFFFF);
+    TEST_CHECK(memcmp(s_temp, s_in, sizeof(s_in)) == 0);
+    TEST_CHECK(stat->resets == N);
+    /* 之后在新的温度上继续滤波 */
+    frame((int16_t)(base + 20*50 + 40), 0);
+    mlx90642_filter_run(0, s_temp, 0xFFFFFF);
+    m = mean(s_temp) - (base + 20*50);
+    TEST_CHECK((m > 0) && (m < 40));
+    /* 向下的大阶跃也一样 */
+    frame(base, 1);
+    mlx90642_filter_run(0, s_temp, 0xFFFFFF);
+    TEST_CHECK(memcmp(s_temp, s_in, sizeof(s_in)) == 0);
+    TEST_CHECK(stat->resets == 2*N);
+
+    /* 有效行: 其它行原样不动, 没有状态的行第一次直接取输入 */
+    TEST_CHECK(mlx90642_filter_config(2, 2*50) == 0);
+    frame(base, 0);
+    mlx90642_filter_run(2, s_temp, 0x0000FF);
+    frame((int16_t)(base + 40), 0);
+    mlx90642_filter_run(2, s_temp, 0x00FFFF);
+    TEST_CHECK((s_temp[0] > base) && (s_temp[0] < base + 40));           /* 第0行有状态, 滤波 */
+    TEST_CHECK(s_temp[8*32] == base + 40);                               /* 第8行第一次, 取输入 */
+    TEST_CHECK(s_temp[16*32] == base + 40);                              /* 第16行不在rows中 */
+    frame((int16_t)(base + 80), 0);
+    mlx90642_filter_run(2, s_temp, 0x00FFFF);
+    TEST_CHECK((s_temp[8*32] > base + 40) && (s_temp[8*32] < base + 80));
+    /* 第16行第一次也直接取输入, 不算突变 */
+    frame((int16_t)(base + 80), 0);
+    mlx90642_filter_run(2, s_temp, 0xFF0000);
+    TEST_CHECK(memcmp(s_temp, s_in, sizeof(s_in)) == 0);
+    TEST_CHECK(stat->resets == 0);
+    TEST_CHECK(stat->frames == 4);
+
+    /* 各传感器状态独立, reset后下一帧直接取输入 */
+    frame(base, 0);
+    mlx90642_filter_run(3, s_temp, 0xFFFFFF);
+    frame((int16_t)(base + 40), 0);
+    mlx90642_filter_run(1, s_temp, 0xFFFFFF);
+    TEST_CHECK(memcmp(s_temp, s_in, sizeof(s_in)) == 0);                 /* 传感器1没有状态 */
+    frame((int16_t)(base + 40), 0);
+    mlx90642_filter_run(3, s_temp, 0xFFFFFF);
+    TEST_CHECK(s_temp[0] < base + 40);
+    mlx90642_filter_reset(3);
+    frame((int16_t)(base + 40), 0);
+    mlx90642_filter_run(3, s_temp, 0xFFFFFF);
+    TEST_CHECK(memcmp(s_temp, s_in, sizeof(s_in)) == 0);
+    /* 无效的传感器不处理 */
+    frame(base, 1);
+    mlx90642_filter_run(-1, s_temp, 0xFFFFFF);
+    mlx90642_filter_run(MLX90642_FILTER_MAX, s_temp, 0xFFFFFF);
+    TEST_CHECK(memcmp(s_temp, s_in, sizeof(s_in)) == 0);
+
+    TEST_END("filter");
+}
@@ -0,0 +1,195 @@
+/**
+ * 平台直方图均衡的主机测试:
+ * 统计时增量维护的直方图与每帧重建的相同, mlx90642_heq_map与按定义计算的累计分布相差不超过1级灰度,
+ * 单调不减, 平台限制住大面积背景占用的灰度级, temp2rgb_heq按bin查表
+ */
+#include <stdint.h>
+#include <string.h>
+#include "test.h"
+#include "MLX90642_disp.h"
+
+TEST_DEFINE;
+
+#define N MLX90642_TOTAL_NUMBER_OF_PIXELS
+
+static int16_t s_temp[N];
+static uint16_t s_rgb[N];
+static mlx90642_hist_st s_inc;
+static mlx90642_hist_st s_new;
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed*1103515245ul + 12345ul;
+    return s_seed >> 8;
+}
+
+static int bin_of(const mlx90642_hist_st* hist, int16_t t)
+{
+    int32_t b = ((int32_t)t - hist->lo) >> hist->shift;
+    if(b < 0){
+        return 0;
+    }
+    if(b >= MLX90642_HIST_BINS){
+        return MLX90642_HIST_BINS-1;
+    }
+    return (int)b;
+}
+
+/* 按定义: 每个bin取中点的累计分布 */
+static void heq_ref(const mlx90642_hist_st* hist, uint16_t plateau, double* gray)
+{
+    double total = 0;
+    double cum = 0;
+    double c;
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        total += (hist->bin[i] > plateau) ? plateau : hist->bin[i];
+    }
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        c = (hist->bin[i] > plateau) ? plateau : hist->bin[i];
+        gray[i] = (total > 0) ? 255.0*(cum + c/2)/total : 0;
+        cum += c;
+    }
+}
+
+static void check_map(const mlx90642_hist_st* hist, uint16_t plateau)
+{
+    uint8_t gray[MLX90642_HIST_BINS];
+    double ref[MLX90642_HIST_BINS];
+    int err = 0;
+    mlx90642_heq_map(hist, plateau, gray);
+    heq_ref(hist, plateau, ref);
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        if((gray[i] > ref[i] + 1e-9) || (gray[i] + 1 < ref[i])){
+            err++;
+        }
+        if((i > 0) && (gray[i] < gray[i-1])){
+            err++;
+        }
+    }
+    TEST_CHECK(err == 0);
+}
+
+int main(void)
+{
+    mlx90642_stat_st st_inc;
+    mlx90642_stat_st st_new;
+    mlx90642_stat_st st;
+    uint8_t gray[MLX90642_HIST_BINS];
+    uint16_t lut[MLX90642_HIST_BINS];
+    uint32_t sum;
+    int diff = 0;
+    int moved = 0;
+    int bg;
+    int d;
+
+    /* 增量维护: 室温背景加噪声和移动的热源, 每帧与重建的直方图比较 */
+    s_inc.lo = 15*50;
+    s_inc.shift = 2;
+    s_inc.rebuild = 1;
+    for(int k=0; k<500; k++){
+        for(int i=0; i<N; i++){
+            s_temp[i] = (int16_t)(20*50 + (i%32)*10 + (i/32)*5 + (int)(rnd() & 0x0F));
+        }
+        for(int j=0; j<8; j++){
+            s_temp[(k*3 + j*37) % N] = (int16_t)(60*50 + (rnd() & 0x3FF));
+        }
+        mlx90642_frame_stat_hist(s_temp, 0xFFFFFF, 100*50, &st_inc, &s_inc);
+        if(k > 0){
+            moved += s_inc.moved;
+        }
+        s_new.lo = s_inc.lo;
+        s_new.shift = s_inc.shift;
+        s_new.rebuild = 1;
+        mlx90642_frame_stat_hist(s_temp, 0xFFFFFF, 100*50, &st_new, &s_new);
+        mlx90642_frame_stat(s_temp, 0xFFFFFF, 100*50, &st);
+        if(memcmp(s_inc.bin, s_new.bin, sizeof(s_inc.bin)) != 0){
+            diff++;
+        }
+        if(memcmp(s_inc.idx, s_new.idx, sizeof(s_inc.idx)) != 0){
+            diff++;
+        }
+        if((st_inc.min != st.min) || (st_inc.max != st.max) || (st_inc.mean != st.mean) ||
+            (st_inc.over != st.over) || (st_inc.hot_idx != st.hot_idx)){
+            diff++;
+        }
+        for(int i=0; i<N; i++){
+            if(s_inc.idx[i] != bin_of(&s_inc, s_temp[i])){
+                diff++;
+            }
+        }
+    }
+    TEST_CHECK(diff == 0);
+    TEST_CHECK((moved > 0) && (moved < 499*N));
+    TEST_CHECK((s_inc.num == N) && (s_inc.rebuild == 0) && (s_inc.rows == 0xFFFFFF));
+    sum = 0;
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        sum += s_inc.bin[i];
+    }
+    TEST_CHECK(sum == N);
+
+    /* 部分行重建, 两端bin包括范围外的点 */
+    s_new.lo = 30*50;
+    s_new.shift = 0;
+    s_new.rebuild = 1;
+    mlx90642_frame_stat_hist(s_temp, 0x0000FF, 100*50, &st, &s_new);
+    TEST_CHECK((s_new.num == 8*32) && (s_new.rows == 0x0000FF) && (s_new.moved == 8*32));
+    sum = 0;
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        sum += s_new.bin[i];
+    }
+    TEST_CHECK(sum == 8*32);
+
+    /* 映射与按定义的累计分布相差不超过1级, 单调不减 */
+    check_map(&s_inc, N);
+    check_map(&s_inc, N/64);
+    check_map(&s_inc, 1);
+    check_map(&s_new, 4);
+
+    /* 大面积背景: 一个bin占700点, 平台限制它占用的灰度级 */
+    memset(&s_new, 0, sizeof(s_new));
+    bg = 100;
+    s_new.bin[bg] = 700;
+    for(int i=0; i<68; i++){
+        s_new.bin[150 + i] = 1;
+    }
+    check_map(&s_new, 700);
+    check_map(&s_new, 12);
+    mlx90642_heq_map(&s_new, 700, gray);
+    d = gray[bg+1] - gray[bg-1];
+    TEST_CHECK(d >= 200);             /* 没有平台: 背景占去大部分灰度级 */
+    mlx90642_heq_map(&s_new, 12, gray);
+    d = gray[bg+1] - gray[bg-1];
+    TEST_CHECK(d <= 255*12/80 + 1);    /* 平台12: 背景只占12/80 */
+    TEST_CHECK(gray[255] >= 250);
+
+    /* 空直方图 */
+    memset(&s_new, 0, sizeof(s_new));
+    mlx90642_heq_map(&s_new, 12, gray);
+    diff = 0;
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        diff += gray[i];
+    }
+    TEST_CHECK(diff == 0);
+
+    /* temp2rgb_heq: 按bin查表, 范围外取两端 */
+    for(int i=0; i<MLX90642_HIST_BINS; i++){
+        lut[i] = (uint16_t)(0x8000 | i);
+    }
+    s_new.lo = 20*50;
+    s_new.shift = 1;
+    for(int i=0; i<N; i++){
+        s_temp[i] = (int16_t)(s_new.lo - 50 + i);
+    }
+    temp2rgb_heq(s_temp, s_rgb, 0, N, &s_new, lut);
+    diff = 0;
+    for(int i=0; i<N; i++){
+        if(s_rgb[i] != lut[bin_of(&s_new, s_temp[i])]){
+            diff++;
+        }
+    }
+    TEST_CHECK(diff == 0);
+    TEST_CHECK((s_rgb[0] == lut[0]) && (s_rgb[N-1] == lut[MLX90642_HIST_BINS-1]));
+
+    TEST_END("heq");
+}
@@ -0,0 +1,208 @@
+/**
+ * I2C3外设驱动和MLX90642_depends.c硬件I2C路径的主机测试:
+ * i2c.c/dma.c用I2C_SIM/DMA_SIM编译, 寄存器在内存中, 总线上挂仿真从机,
+ * 检查MLX90642_I2CRead/MLX90642_Config产生的START/地址/ACK/NACK/STOP顺序,
+ * 以及NACK和总线错误后恢复总线, 从断点重读的结果
+ */
+#include <stdint.h>
+#include <string.h>
+#include "test.h"
+#include "i2c.h"
+#include "MLX90642.h"
+#include "MLX90642_depends.h"
+
+TEST_DEFINE;
+
+#define SLAVE  0x66
+
+static uint8_t s_mem[0x10000];
+static uint16_t s_data[MLX90642_TOTAL_NUMBER_OF_PIXELS];
+
+/* 第i个事件 */
+static const i2c_sim_ev_st* ev(uint32_t i)
+{
+    static const i2c_sim_ev_st none = {0, 0, 0};
+    uint32_t num;
+    const i2c_sim_ev_st* log = i2c_sim_log(&num);
+    return (i < num) ? &log[i] : &none;
+}
+
+/**
+ * 检查总线事件的语法:
+ * START后是地址; 地址或发送数据被NACK后, 以及主机NACK最后一个接收字节后只能是STOP;
+ * STOP后只能是START或恢复总线; 总线错误后是STOP
+ */
+static void check_grammar(void)
+{
+    uint32_t num;
+    const i2c_sim_ev_st* log = i2c_sim_log(&num);
+    int busy = 0;
+    for(uint32_t i=0; i<num; i++){
+        const i2c_sim_ev_st* e = &log[i];
+        const i2c_sim_ev_st* n = ev(i+1);
+        switch(e->type){
+            case I2C_SIM_START:
+                TEST_CHECK(e->data == busy);   /* 总线占用时是重复START */
+                TEST_CHECK(n->type == I2C_SIM_ADDR);
+                busy = 1;
+            break;
+            case I2C_SIM_ADDR:
+            case I2C_SIM_TX:
+            case I2C_SIM_RX:
+                TEST_CHECK(busy);
+                if(e->ack == 0){
+                    TEST_CHECK(n->type == I2C_SIM_STOP);
+                }
+                if(e->type == I2C_SIM_RX){
+                    TEST_CHECK((n->type == I2C_SIM_RX) || (n->type == I2C_SIM_STOP) || (n->type == I2C_SIM_BERR));
+                }
+            break;
+            case I2C_SIM_BERR:
+                TEST_CHECK(n->type == I2C_SIM_STOP);
+            break;
+            case I2C_SIM_STOP:
+                TEST_CHECK(busy);
+                TEST_CHECK((i+1 == num) || (n->type == I2C_SIM_START) || (n->type == I2C_SIM_RECOVER));
+                busy = 0;
+            break;
+            case I2C_SIM_RECOVER:
+                TEST_CHECK(busy == 0);
+            break;
+            default:
+                TEST_CHECK(0);
+            break;
+        }
+    }
+    TEST_CHECK(busy == 0);
+}
+
+/* 检查从pos开始的一次读寄存器: 写地址, 重复START, 读n字节, 最后NACK, STOP; 返回下一个事件位置 */
+static uint32_t check_read(uint32_t pos, uint16_t addr, uint32_t n)
+{
+    TEST_CHECK((ev(pos)->type == I2C_SIM_START) && (ev(pos)->data == 0));
+    TEST_CHECK((ev(pos+1)->type == I2C_SIM_ADDR) && (ev(pos+1)->data == (SLAVE << 1)) && ev(pos+1)->ack);
+    TEST_CHECK((ev(pos+2)->type == I2C_SIM_TX) && (ev(pos+2)->data == (addr >> 8)) && ev(pos+2)->ack);
+    TEST_CHECK((ev(pos+3)->type == I2C_SIM_TX) && (ev(pos+3)->data == (addr & 0xFF)) && ev(pos+3)->ack);
+    TEST_CHECK((ev(pos+4)->type == I2C_SIM_START) && (ev(pos+4)->data == 1));
+    TEST_CHECK((ev(pos+5)->type == I2C_SIM_ADDR) && (ev(pos+5)->data == ((SLAVE << 1) | 1)) && ev(pos+5)->ack);
+    pos += 6;
+    for(uint32_t i=0; i<n; i++){
+        TEST_CHECK((ev(pos)->type == I2C_SIM_RX) && (ev(pos)->data == s_mem[addr + i]));
+        TEST_CHECK(ev(pos)->ack == ((i+1 < n) ? 1 : 0));
+        pos++;
+    }
+    TEST_CHECK(ev(pos)->type == I2C_SIM_STOP);
+    return pos + 1;
+}
+
+static void check_data(uint16_t addr, uint32_t words)
+{
+    int err = 0;
+    for(uint32_t i=0; i<words; i++){
+        if(s_data[i] != (uint16_t)((s_mem[addr + 2*i] << 8) | s_mem[addr + 2*i + 1])){
+            err++;
+        }
+    }
+    TEST_CHECK(err == 0);
+}
+
+int main(void)
+{
+    const MLX90642_I2CStat_t* stat = MLX90642_I2CGetStat();
+    uint32_t num;
+    uint32_t pos;
+    uint8_t addr[2];
+    uint8_t byte;
+
+    for(uint32_t i=0; i<sizeof(s_mem); i++){
+        s_mem[i] = (uint8_t)(i*7 + (i >> 8) + 3);
+    }
+    i2c_sim_slave(SLAVE, s_mem, sizeof(s_mem));
+
+    /* 正常读: START 地址W ACK 寄存器地址 重复START 地址R ACK 数据...ACK 最后NACK STOP */
+    i2c_sim_clear();
+    TEST_CHECK(MLX90642_I2CRead(SLAVE, 0x2400, 64, s_data) == 0);
+    check_data(0x2400, 64);
+    i2c_sim_log(&num);
+    TEST_CHECK(check_read(0, 0x2400, 128) == num);
+    check_grammar();
+    TEST_CHECK(i2c_sim_errs() == 0);
+
+    /* 整帧 */
+    i2c_sim_clear();
+    TEST_CHECK(MLX90642_I2CRead(SLAVE, 0x342C, MLX90642_TOTAL_NUMBER_OF_PIXELS, s_data) == 0);
+    check_data(0x342C, MLX90642_TOTAL_NUMBER_OF_PIXELS);
+    check_grammar();
+    TEST_CHECK(i2c_sim_errs() == 0);
+
+    /* 地址NACK: NACK后立即STOP, 恢复总线后整体重试 */
+    i2c_sim_clear();
+    MLX90642_I2CClearStat();
+    i2c_sim_fault(1, -1);
+    TEST_CHECK(MLX90642_I2CRead(SLAVE, 0x2400, 16, s_data) == 0);
+    check_data(0x2400, 16);
+    TEST_CHECK((ev(0)->type == I2C_SIM_START) && (ev(1)->type == I2C_SIM_ADDR) && (ev(1)->ack == 0));
+    TEST_CHECK(ev(2)->type == I2C_SIM_STOP);
+    TEST_CHECK(ev(3)->type == I2C_SIM_RECOVER);
+    i2c_sim_log(&num);
+    TEST_CHECK(check_read(4, 0x2400, 32) == num);
+    TEST_CHECK((stat->nack == 1) && (stat->recover == 1) && (stat->retry == 1) && (stat->abort == 0));
+    check_grammar();
+    TEST_CHECK(i2c_sim_errs() == 0);
+
+    /* 一直NACK: 重试用完后放弃 */
+    i2c_sim_clear();
+    MLX90642_I2CClearStat();
+    i2c_sim_fault(100, -1);
+    TEST_CHECK(MLX90642_I2CRead(SLAVE, 0x2400, 16, s_data) == -2);
+    TEST_CHECK(stat->abort == 1);
+    i2c_sim_fault(0, -1);
+    check_grammar();
+    TEST_CHECK(i2c_sim_errs() == 0);
+
+    /* 接收第37个字节时总线错误: 已收完18个字, 恢复后从第18个字的地址重读剩余的字 */
+    i2c_sim_clear();
+    MLX90642_I2CClearStat();
+    memset(s_data, 0, sizeof(s_data));
+    i2c_sim_fault(0, 37);
+    TEST_CHECK(MLX90642_I2CRead(SLAVE, 0x2400, 64, s_data) == 0);
+    check_data(0x2400, 64);
+    pos = 6 + 37;
+    TEST_CHECK(ev(pos)->type == I2C_SIM_BERR);
+    TEST_CHECK(ev(pos+1)->type == I2C_SIM_STOP);
+    TEST_CHECK(ev(pos+2)->type == I2C_SIM_RECOVER);
+    i2c_sim_log(&num);
+    TEST_CHECK(check_read(pos+3, 0x2400 + 2*18, 2*(64-18)) == num);
+    TEST_CHECK((stat->recover == 1) && (stat->retry == 1) && (stat->nack == 0));
+    check_grammar();
+    TEST_CHECK(i2c_sim_errs() == 0);
+
+    /* 写寄存器: START 地址W 4字节 STOP */
+    i2c_sim_clear();
+    TEST_CHECK(MLX90642_Config(SLAVE, 0x11F0, 0xA55A) == 0);
+    TEST_CHECK((s_mem[0x11F0] == 0xA5) && (s_mem[0x11F1] == 0x5A));
+    TEST_CHECK((ev(0)->type == I2C_SIM_START) && (ev(1)->type == I2C_SIM_ADDR) && (ev(1)->data == (SLAVE << 1)));
+    TEST_CHECK((ev(2)->type == I2C_SIM_TX) && (ev(2)->data == 0x11));
+    TEST_CHECK((ev(5)->type == I2C_SIM_TX) && (ev(5)->data == 0x5A));
+    TEST_CHECK(ev(6)->type == I2C_SIM_STOP);
+    i2c_sim_log(&num);
+    TEST_CHECK(num == 7);
+    check_grammar();
+    TEST_CHECK(i2c_sim_errs() == 0);
+
+    /* 单字节读不用DMA: 清ADDR前关ACK, 唯一的字节回NACK后STOP */
+    i2c_sim_clear();
+    addr[0] = 0x11;
+    addr[1] = 0xF1;
+    TEST_CHECK(i2c_write(3, SLAVE, addr, 2, 0) == 0);
+    TEST_CHECK(i2c_read_dma(3, SLAVE, &byte, 1) == 0);
+    TEST_CHECK(i2c_read_dma_poll(3) == 0);
+    TEST_CHECK(byte == 0x5A);
+    TEST_CHECK((ev(5)->type == I2C_SIM_ADDR) && (ev(5)->data == ((SLAVE << 1) | 1)));
+    TEST_CHECK((ev(6)->type == I2C_SIM_RX) && (ev(6)->ack == 0));
+    TEST_CHECK(ev(7)->type == I2C_SIM_STOP);
+    check_grammar();
+    TEST_CHECK(i2c_sim_errs() == 0);
+
+    TEST_END("i2c");
+}
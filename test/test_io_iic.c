@@ -0,0 +1,183 @@
+/**
+ * io_iic按周期计数定时的主机测试:
+ * io_iic_hz_to_half_cycles的取整和边界,
+ * 以及用假的周期计数器记录SCL/SDA翻转时刻, 检查总线空闲后START和总线恢复的第一个半周期
+ * 和字节传输中每个SCL高低电平都不短于半周期
+ */
+#include <stdint.h>
+#include "test.h"
+#include "io_iic.h"
+
+TEST_DEFINE;
+
+#define PLLCLK     180000000ul
+#define GPIO_COST  3            /* 每次GPIO操作花掉的周期数 */
+#define EDGE_MAX   256
+
+typedef struct{
+    uint32_t t;
+    uint8_t scl;
+    uint8_t sda;
+} edge_st;
+
+static uint32_t s_now;
+static uint8_t s_scl = 1;
+static uint8_t s_sda = 1;
+static uint8_t s_slave_sda;   /* 从机输出的SDA, 0为应答/数据0 */
+static edge_st s_edge[EDGE_MAX];
+static uint32_t s_edges;
+
+static uint32_t get_cycles(void)
+{
+    return s_now++;
+}
+
+static void record(void)
+{
+    if(s_edges < EDGE_MAX){
+        s_edge[s_edges].t = s_now;
+        s_edge[s_edges].scl = s_scl;
+        s_edge[s_edges].sda = s_sda;
+        s_edges++;
+    }
+}
+
+static void scl_write(uint8_t val)
+{
+    s_now += GPIO_COST;
+    if(val != s_scl){
+        s_scl = val;
+        record();
+    }
+}
+
+static void sda_write(uint8_t val)
+{
+    s_now += GPIO_COST;
+    if(val != s_sda){
+        s_sda = val;
+        record();
+    }
+}
+
+static void sda_2read(void)
+{
+    sda_write(1);
+}
+
+static uint8_t sda_read(void)
+{
+    s_now += GPIO_COST;
+    return s_sda & s_slave_sda;
+}
+
+static io_iic_dev_st s_dev = {
+    .scl_write = scl_write,
+    .sda_write = sda_write,
+    .sda_2read = sda_2read,
+    .sda_read = sda_read,
+    .get_cycles = get_cycles,
+    .cycles_hz = PLLCLK,
+};
+
+/* 检查第from个翻转之后每段SCL电平都不短于半周期, SCL周期不超过一个周期加上GPIO的开销 */
+static void check_scl(uint32_t from, uint32_t half)
+{
+    uint32_t last = 0;
+    uint32_t rise = 0;
+    int have = 0;
+    for(uint32_t i=from; i<s_edges; i++){
+        if((i > 0) && (s_edge[i].scl == s_edge[i-1].scl)){
+            continue;   /* SDA翻转 */
+        }
+        if(have){
+            TEST_CHECK(s_edge[i].t - last >= half);
+        }
+        if(s_edge[i].scl){
+            if(rise != 0){
+                TEST_CHECK(s_edge[i].t - rise <= 2*half + 8*GPIO_COST);
+            }
+            rise = s_edge[i].t;
+        }
+        last = s_edge[i].t;
+        have = 1;
+    }
+}
+
+int main(void)
+{
+    static const uint32_t hz[] = {100000, 400000, 1000000, 333333, 3000000};
+    uint32_t half;
+    uint32_t t0;
+    uint8_t val;
+
+    /* 180MHz: 100K/400K/1M正好整除 */
+    TEST_CHECK(io_iic_hz_to_half_cycles(PLLCLK, 100000) == 900);
+    TEST_CHECK(io_iic_hz_to_half_cycles(PLLCLK, 400000) == 225);
+    TEST_CHECK(io_iic_hz_to_half_cycles(PLLCLK, 1000000) == 90);
+    /* 不整除时向上取整, 实际频率不超过目标频率 */
+    TEST_CHECK(io_iic_hz_to_half_cycles(PLLCLK, 333333) == 271);
+    TEST_CHECK(io_iic_hz_to_half_cycles(PLLCLK, 700000) == 129);
+    for(uint32_t h=1000; h<=4000000; h=h*3+7){
+        half = io_iic_hz_to_half_cycles(PLLCLK, h);
+        TEST_CHECK(PLLCLK / (2*half) <= h);
+        TEST_CHECK((half == 1) || (PLLCLK / (2*(half - 1)) >= h));
+    }
+    /* hz为0 */
+    TEST_CHECK(io_iic_hz_to_half_cycles(PLLCLK, 0) == 0);
+    TEST_CHECK(io_iic_hz_to_half_cycles(0, 0) == 0);
+    TEST_CHECK(io_iic_hz_to_half_cycles(0, 100000) == 0);
+    /* 溢出: cycles_hz接近32位上限, 2*hz超过32位 */
+    TEST_CHECK(io_iic_hz_to_half_cycles(0xFFFFFFFFu, 1) == 0x80000000u);
+    TEST_CHECK(io_iic_hz_to_half_cycles(0xFFFFFFFFu, 1000000) == 2148);
+    TEST_CHECK(io_iic_hz_to_half_cycles(0xFFFFFFFEu, 0x7FFFFFFFu) == 1);
+    TEST_CHECK(io_iic_hz_to_half_cycles(PLLCLK, 0x80000000u) == 1);
+    TEST_CHECK(io_iic_hz_to_half_cycles(PLLCLK, 0xFFFFFFFFu) == 1);
+    TEST_CHECK(io_iic_hz_to_half_cycles(PLLCLK, PLLCLK) == 1);
+
+    TEST_CHECK(io_iic_set_clock_hz(0, 100000) == -1);
+    for(uint32_t i=0; i<sizeof(hz)/sizeof(hz[0]); i++){
+        TEST_CHECK(io_iic_set_clock_hz(&s_dev, hz[i]) == 0);
+        half = s_dev.half_cycles;
+        TEST_CHECK(half == io_iic_hz_to_half_cycles(PLLCLK, hz[i]));
+
+        /* 总线空闲很久后START: SDA下降沿前后SCL高都要保持半周期 */
+        s_now += 1000000;
+        s_edges = 0;
+        t0 = s_now;
+        io_iic_start(&s_dev);
+        TEST_CHECK(s_edges == 2);
+        TEST_CHECK((s_edge[0].scl == 1) && (s_edge[0].sda == 0));
+        TEST_CHECK((s_edge[1].scl == 0) && (s_edge[1].sda == 0));
+        /* 空闲时SCL/SDA已经是高, 从进入io_iic_start算起 */
+        TEST_CHECK(s_edge[0].t - t0 >= half);
+        TEST_CHECK(s_edge[1].t - s_edge[0].t >= half);
+
+        /* 写一个字节, 读一个字节, 每个SCL电平都不短于半周期 */
+        s_slave_sda = 0;
+        TEST_CHECK(io_iic_write(&s_dev, 0xA5) == 0);
+        TEST_CHECK(io_iic_read(&s_dev, &val, 1) == 0);
+        check_scl(0, half);
+        io_iic_stop(&s_dev);
+        TEST_CHECK((s_scl == 1) && (s_sda == 1));
+
+        /* 总线空闲很久后恢复总线: 第一个SCL低电平和高电平也要保持半周期 */
+        s_now += 1000000;
+        s_edges = 0;
+        s_scl = 0;
+        s_slave_sda = 1;
+        t0 = s_now;
+        TEST_CHECK(io_iic_recover(&s_dev) == 0);
+        TEST_CHECK(s_edges >= 2);
+        TEST_CHECK(s_edge[0].scl == 1);
+        TEST_CHECK(s_edge[0].t - t0 >= half);
+        TEST_CHECK(s_edge[1].scl == 0);
+        TEST_CHECK(s_edge[1].t - s_edge[0].t >= half);
+    }
+
+    /* hz为0恢复使用delay_pf */
+    TEST_CHECK(io_iic_set_clock_hz(&s_dev, 0) == 0);
+    TEST_CHECK(s_dev.half_cycles == 0);
+
+    TEST_END("io_iic");
+}
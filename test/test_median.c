@@ -0,0 +1,115 @@
+/**
+ * 3x3中值滤波的主机测试:
+ * 列排序网络mlx90642_median_run与每点插入排序的mlx90642_median_ref, 以及这里用qsort按定义
+ * 计算的结果逐点相同(随机帧包括int16两端的值, 各种有效行), 单点噪声被去掉, 台阶边缘不移动.
+ * 主机上编译的是med_max2/med_min2的C实现, 与M4上的SSUB16/SEL结果相同
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "MLX90642_filter.h"
+
+TEST_DEFINE;
+
+#define N 768
+
+static int16_t s_in[N] __attribute__((aligned(4)));
+static int16_t s_out[N] __attribute__((aligned(4)));
+static int16_t s_ref[N];
+static int16_t s_naive[N];
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed*1103515245ul + 12345ul;
+    return s_seed >> 8;
+}
+
+static int cmp16(const void* a, const void* b)
+{
+    return (int)*(const int16_t*)a - (int)*(const int16_t*)b;
+}
+
+/* 按定义: 3x3邻域排序取第5个, 不在rows中的行用中心行代替, 左右边缘复制 */
+static void median_naive(const int16_t* in, int16_t* out, uint32_t rows)
+{
+    int16_t v[9];
+    int n;
+    int yy;
+    int xx;
+    for(int r=0; r<24; r++){
+        for(int x=0; x<32; x++){
+            if((rows & (1ul << r)) == 0){
+                out[r*32 + x] = in[r*32 + x];
+                continue;
+            }
+            n = 0;
+            for(int dy=-1; dy<=1; dy++){
+                yy = r + dy;
+                if((yy < 0) || (yy > 23) || ((rows & (1ul << yy)) == 0)){
+                    yy = r;
+                }
+                for(int dx=-1; dx<=1; dx++){
+                    xx = (x + dx < 0) ? 0 : (x + dx > 31) ? 31 : x + dx;
+                    v[n++] = in[yy*32 + xx];
+                }
+            }
+            qsort(v, 9, sizeof(v[0]), cmp16);
+            out[r*32 + x] = v[4];
+        }
+    }
+}
+
+static int check(uint32_t rows)
+{
+    memset(s_out, 0x55, sizeof(s_out));
+    mlx90642_median_run(s_in, s_out, rows);
+    mlx90642_median_ref(s_in, s_ref, rows);
+    median_naive(s_in, s_naive, rows);
+    return (memcmp(s_out, s_naive, sizeof(s_out)) == 0) && (memcmp(s_ref, s_naive, sizeof(s_ref)) == 0);
+}
+
+int main(void)
+{
+    static const uint32_t masks[] = {
+        0xFFFFFF, 0, 0x000001, 0x800000, 0x555555, 0xAAAAAA, 0xFFF000, 0x000FFF, 0x7FFFFE, 0xF0F0F0,
+    };
+    int bad = 0;
+
+    /* 随机帧: 全范围, 小范围(大量相等值), 只有两端的值 */
+    for(int k=0; k<3000; k++){
+        for(int i=0; i<N; i++){
+            switch(k % 3){
+                case 0:  s_in[i] = (int16_t)rnd(); break;
+                case 1:  s_in[i] = (int16_t)(25*50 + (int)(rnd() & 0x07) - 4); break;
+                default: s_in[i] = (rnd() & 1) ? INT16_MAX : INT16_MIN; break;
+            }
+        }
+        if(!check((k < (int)(sizeof(masks)/sizeof(masks[0]))*10) ? masks[k % (sizeof(masks)/sizeof(masks[0]))] : (rnd() & 0xFFFFFF))){
+            bad++;
+        }
+    }
+    TEST_CHECK(bad == 0);
+
+    /* 单点热源和冷点被去掉 */
+    for(int i=0; i<N; i++){
+        s_in[i] = 25*50;
+    }
+    s_in[5*32 + 7] = 120*50;
+    s_in[0] = -40*50;
+    s_in[23*32 + 31] = 200*50;
+    TEST_CHECK(check(0xFFFFFF));
+    for(int i=0; i<N; i++){
+        TEST_CHECK(s_out[i] == 25*50);
+    }
+
+    /* 竖直台阶: 边缘不移动 */
+    for(int i=0; i<N; i++){
+        s_in[i] = (int16_t)(((i % 32) < 13) ? 20*50 : 40*50);
+    }
+    TEST_CHECK(check(0xFFFFFF));
+    TEST_CHECK(memcmp(s_out, s_in, sizeof(s_in)) == 0);
+
+    TEST_END("median");
+}
@@ -0,0 +1,139 @@
+/**
+ * 温度->RGB565查表的主机测试:
+ * classic调色板下temp2rgb与原来逐点除法的temp2rgb_ref对全部int16温度逐位相同,
+ * 每个调色板下temp2rgb都按固定范围的灰度查当前的表;
+ * 调色板是本机字节序的RGB565(R在D15~D11): classic与原来按字节发送时的已交换字节颜色逐项互为字节交换,
+ * grey三个分量相等且递增, 各调色板两端为黑/白
+ */
+#include <stdint.h>
+#include "test.h"
+#include "MLX90642_disp.h"
+#include "MLX90642_palette.h"
+#include "MLX90642_scale.h"
+
+TEST_DEFINE;
+
+#define N MLX90642_TOTAL_NUMBER_OF_PIXELS
+
+static int16_t s_temp[N];
+static uint16_t s_ref[N];
+static uint16_t s_rgb[N];
+static int16_t s_gray[N];
+
+/* 原来按字节发送时的RGB()宏, 已交换字节 */
+#define RGB_SWAPPED(r,g,b) ((uint16_t)(((uint16_t)(r)&0xF8) | ((uint16_t)(g)>>5) | ((((uint16_t)(g)&0xE0) | ((uint16_t)(b)&0x1F))<<8)))
+
+/* 原来temp2rgb的四段渐变, 分量按uint8回绕 */
+static uint16_t classic_swapped(int i)
+{
+    uint8_t r = (uint8_t)((i<=95) ? 0 : (i<=159) ? ((i-128)*255)/64 : 255);
+    uint8_t g = (uint8_t)((i<=31) ? 0 : (i<=95) ? ((i-64)*255)/64 : (i<=159) ? 255 : ((255-i)*255)/64);
+    uint8_t b = (uint8_t)((i<=31) ? (i*255)/64 : (i<=95) ? ((127-i)*255)/64 : 0);
+    return RGB_SWAPPED(r, g, b);
+}
+
+#define R5(v) (((v) >> 11) & 0x1F)
+#define G6(v) (((v) >> 5) & 0x3F)
+#define B5(v) ((v) & 0x1F)
+
+int main(void)
+{
+    int32_t v = -32768;
+    int diff = 0;
+    int classic = mlx90642_palette_find("classic");
+    const uint16_t* lut;
+
+    TEST_CHECK(classic >= 0);
+    TEST_CHECK(mlx90642_palette_set(classic) == 0);
+    TEST_CHECK(mlx90642_palette_lut() == mlx90642_palette_get(classic)->lut);
+    while(v <= 32767){
+        for(int i=0; i<N; i++){
+            s_temp[i] = (int16_t)((v <= 32767) ? v : 32767);
+            v++;
+        }
+        temp2rgb_ref(s_temp, s_ref, 0, N);
+        temp2rgb(s_temp, s_rgb, 0, N);
+        for(int i=0; i<N; i++){
+            if(s_rgb[i] != s_ref[i]){
+                diff++;
+            }
+        }
+    }
+    TEST_CHECK(diff == 0);
+
+    /* 只转换[start,end) */
+    for(int i=0; i<N; i++){
+        s_temp[i] = (int16_t)(20*50 + i*10);
+        s_rgb[i] = 0x1234;
+    }
+    temp2rgb(s_temp, s_rgb, 32, 64);
+    temp2rgb_ref(s_temp, s_ref, 32, 64);
+    TEST_CHECK((s_rgb[31] == 0x1234) && (s_rgb[64] == 0x1234));
+    for(int i=32; i<64; i++){
+        TEST_CHECK(s_rgb[i] == s_ref[i]);
+    }
+
+    /* 每个调色板: 与mlx90642_disp_gray(未开自动增益时为固定范围)的灰度查同一张表 */
+    for(int i=0; i<N; i++){
+        s_temp[i] = (int16_t)(-45*50 + i*(320*50/N));
+    }
+    mlx90642_disp_gray(0, s_temp, s_gray, 0, N);
+    TEST_CHECK(mlx90642_palette_num() >= 2);
+    for(int p=0; p<mlx90642_palette_num(); p++){
+        TEST_CHECK(mlx90642_palette_set(p) == 0);
+        TEST_CHECK(mlx90642_palette_id() == p);
+        lut = mlx90642_palette_lut();
+        TEST_CHECK(lut == mlx90642_palette_get(p)->lut);
+        TEST_CHECK(mlx90642_palette_find(mlx90642_palette_get(p)->name) == p);
+        temp2rgb(s_temp, s_rgb, 0, N);
+        diff = 0;
+        for(int i=0; i<N; i++){
+            if(s_rgb[i] != lut[s_gray[i] >> MLX90642_SCALE_Q]){
+                diff++;
+            }
+        }
+        TEST_CHECK(diff == 0);
+    }
+
+    /* 本机字节序: classic逐项是原来颜色的字节交换 */
+    lut = mlx90642_palette_get(classic)->lut;
+    diff = 0;
+    for(int i=0; i<256; i++){
+        if(lut[i] != (uint16_t)((classic_swapped(i) >> 8) | (classic_swapped(i) << 8))){
+            diff++;
+        }
+    }
+    TEST_CHECK(diff == 0);
+    TEST_CHECK(lut[0] == 0);
+    TEST_CHECK(lut[255] == 0xF800);   /* 最热为纯红 */
+
+    /* grey: R,G,B相等且递增, 字节交换后不满足 */
+    lut = mlx90642_palette_get(mlx90642_palette_find("grey"))->lut;
+    diff = 0;
+    for(int i=0; i<256; i++){
+        if((R5(lut[i]) != B5(lut[i])) || ((G6(lut[i]) >> 1) != R5(lut[i]))){
+            diff++;
+        }
+        if((i > 0) && (lut[i] < lut[i-1])){
+            diff++;
+        }
+    }
+    TEST_CHECK(diff == 0);
+    TEST_CHECK(lut[128] > 0x8000);    /* gamma 0.45提亮暗部 */
+
+    /* 两端: 黑到白的调色板 */
+    for(int p=0; p<4; p++){
+        static const char* const name[] = {"ironbow", "rainbow", "grey", "hotmetal"};
+        TEST_CHECK(mlx90642_palette_find(name[p]) >= 0);
+        lut = mlx90642_palette_get(mlx90642_palette_find(name[p]))->lut;
+        TEST_CHECK(lut[255] == 0xFFFF);
+        TEST_CHECK((R5(lut[0]) == 0) && (G6(lut[0]) == 0));
+    }
+
+    TEST_CHECK(mlx90642_palette_set(-1) == -1);
+    TEST_CHECK(mlx90642_palette_set(mlx90642_palette_num()) == -1);
+    TEST_CHECK(mlx90642_palette_find("none") == -1);
+    mlx90642_palette_set(classic);
+
+    TEST_END("palette");
+}
@@ -0,0 +1,172 @@
+/**
+ * 定点双线性放大的主机测试:
+ * 2~10倍下与浮点双线性(像素中心对齐, 位置截断为Q8, 边缘复制)相比只有取整误差,
+ * 奇数倍时源像素中心处与源值相同, 常数不变, 斜坡单调, L8版本与查表版本索引相同;
+ * 按行带显示时第r行的k个输出行只读源行r-1~r+1(行带只计算这几行的灰度)
+ */
+#include <stdint.h>
+#include "test.h"
+#include "MLX90642_scale.h"
+
+TEST_DEFINE;
+
+#define W MLX90642_SCALE_SRC_W
+#define H MLX90642_SCALE_SRC_H
+
+static int16_t s_gray[W*H] __attribute__((aligned(4)));
+static uint16_t s_lut[256];
+static uint32_t s_line[W*MLX90642_SCALE_MAX/2];
+static uint32_t s_l8[W*MLX90642_SCALE_MAX/4];
+static mlx90642_scale_st s_scale;
+static uint32_t s_seed = 1;
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed*1103515245ul + 12345ul;
+    return s_seed >> 8;
+}
+
+/* 输出第i个点中心在源网格上的位置, 截断为Q8, 边缘复制 */
+static double src_pos(int i, int k, int n)
+{
+    double p = (((2*i + 1)*128)/k - 128)/256.0;   /* (i+0.5)/k-0.5 向下取整到1/256 */
+    if(p < 0){
+        p = 0;
+    }
+    if(p > n - 1){
+        p = n - 1;
+    }
+    return p;
+}
+
+/* 浮点双线性, 权重与定点实现相同(Q8), 结果为灰度(去掉Q4) */
+static double bilinear(int x, int y, int k)
+{
+    double u = src_pos(x, k, W);
+    double v = src_pos(y, k, H);
+    int c = (int)u;
+    int r = (int)v;
+    int c1 = (c + 1 < W) ? c + 1 : c;
+    int r1 = (r + 1 < H) ? r + 1 : r;
+    double fu = u - c;
+    double fv = v - r;
+    double top = s_gray[r*W + c]*(1 - fu) + s_gray[r*W + c1]*fu;
+    double bot = s_gray[r1*W + c]*(1 - fu) + s_gray[r1*W + c1]*fu;
+    return (top*(1 - fv) + bot*fv) / (1 << MLX90642_SCALE_Q);
+}
+
+/* 放大一帧, 与浮点结果比较, 只允许纵向取整到Q4和最后取整的误差, 返回超差点数 */
+static int check_frame(int k, int exact)
+{
+    int err = 0;
+    int r0;
+    int v;
+    int l8;
+    double ref;
+    double tol = 0.5 + 0.5/(1 << MLX90642_SCALE_Q) + 1e-9;
+    for(int y=0; y<s_scale.h; y++){
+        r0 = s_scale.row[y];
+        mlx90642_scale_line(&s_scale, s_gray + r0*W, s_gray + (r0+1)*W, s_scale.roww[y], s_lut, s_line);
+        mlx90642_scale_line_l8(&s_scale, s_gray + r0*W, s_gray + (r0+1)*W, s_scale.roww[y], s_l8);
+        for(int x=0; x<s_scale.w; x++){
+            v = (int)((s_line[x/2] >> (16*(x & 1))) & 0xFFFF);
+            l8 = (int)((s_l8[x/4] >> (8*(x & 3))) & 0xFF);
+            ref = bilinear(x, y, k);
+            if((v > ref + tol) || (v < ref - tol) || (v != l8)){
+                err++;
+            }
+            /* 奇数倍时每个源像素中心正好落在一个输出点上 */
+            if(exact && ((k & 1) != 0) && ((x % k) == k/2) && ((y % k) == k/2)){
+                if(v != (s_gray[(y/k)*W + x/k] >> MLX90642_SCALE_Q)){
+                    err++;
+                }
+            }
+        }
+    }
+    return err;
+}
+
+int main(void)
+{
+    int err;
+    int prev;
+    int v;
+
+    for(int i=0; i<256; i++){
+        s_lut[i] = (uint16_t)i;
+    }
+    TEST_CHECK(mlx90642_scale_init(&s_scale, 1) == -1);
+    TEST_CHECK(mlx90642_scale_init(&s_scale, MLX90642_SCALE_MAX + 1) == -1);
+
+    for(int k=2; k<=MLX90642_SCALE_MAX; k++){
+        TEST_CHECK(mlx90642_scale_init(&s_scale, k) == 0);
+        TEST_CHECK((s_scale.w == W*k) && (s_scale.h == H*k));
+
+        /* 随机灰度, 包括0和255的相邻点 */
+        for(int i=0; i<W*H; i++){
+            s_gray[i] = (int16_t)((rnd() & 1) ? ((rnd() & 0xFF) << MLX90642_SCALE_Q) : ((rnd() & 1) ? 255 << MLX90642_SCALE_Q : 0));
+        }
+        TEST_CHECK(check_frame(k, 1) == 0);
+
+        /* 平滑场景, 带Q4小数 */
+        for(int i=0; i<W*H; i++){
+            s_gray[i] = (int16_t)(((i%W)*4 + (i/W)*5)*16 + (int)(rnd() & 0x0F));
+        }
+        TEST_CHECK(check_frame(k, 0) == 0);
+
+        /* 常数 */
+        for(int i=0; i<W*H; i++){
+            s_gray[i] = 123 << MLX90642_SCALE_Q;
+        }
+        err = 0;
+        for(int y=0; y<s_scale.h; y++){
+            mlx90642_scale_line(&s_scale, s_gray, s_gray + W, s_scale.roww[y], s_lut, s_line);
+            for(int x=0; x<s_scale.w/2; x++){
+                if(s_line[x] != ((123u << 16) | 123u)){
+                    err++;
+                }
+            }
+        }
+        TEST_CHECK(err == 0);
+
+        /* 横向斜坡: 每行单调不减 */
+        for(int i=0; i<W*H; i++){
+            s_gray[i] = (int16_t)((i%W)*8 << MLX90642_SCALE_Q);
+        }
+        err = 0;
+        mlx90642_scale_line(&s_scale, s_gray, s_gray + W, s_scale.roww[0], s_lut, s_line);
+        prev = 0;
+        for(int x=0; x<s_scale.w; x++){
+            v = (int)((s_line[x/2] >> (16*(x & 1))) & 0xFFFF);
+            if(v < prev){
+                err++;
+            }
+            prev = v;
+        }
+        TEST_CHECK(err == 0);
+        TEST_CHECK(prev == (W-1)*8);
+
+        /* 行带: 输出行y=r*k+j读源行row[y]和row[y]+1, 都在[r-1,r+1]内且不越界 */
+        err = 0;
+        for(int y=0; y<s_scale.h; y++){
+            int r = y / k;
+            if((s_scale.row[y] + 1 < r) || (s_scale.row[y] > r) || (s_scale.row[y] + 1 > H - 1)){
+                err++;
+            }
+            /* 上端复制边缘: 第0行的输出行只读第0,1行 */
+            if((r == 0) && (s_scale.row[y] != 0)){
+                err++;
+            }
+        }
+        TEST_CHECK(err == 0);
+    }
+
+    /* 成对填充 */
+    for(int i=0; i<W*MLX90642_SCALE_MAX/2; i++){
+        s_line[i] = 0;
+    }
+    mlx90642_scale_fill(s_line, 20, 0xA55A);
+    TEST_CHECK((s_line[0] == 0xA55AA55Au) && (s_line[9] == 0xA55AA55Au) && (s_line[10] == 0));
+
+    TEST_END("scale");
+}
@@ -0,0 +1,172 @@
+/**
+ * MLX90642仿真器的主机测试, 用-DMLX90642_IIC_SIM=1编译:
+ * 通过MLX90642_depends.c(IO模拟IIC)+MLX90642.c读图像, 读出的每个像素与合成场景/录制场景相同,
+ * MLX90642_GetImage每帧的SCL时钟数为(4+768*2)*9, MLX90642_Config为5*9,
+ * 以及刷新周期到达时产生新帧和数据就绪标志, 地址不匹配时NACK.
+ * 不链接clock.c, 毫秒时基和周期计数由本文件提供
+ */
+#include <stdint.h>
+#include <string.h>
+#include "test.h"
+#include "MLX90642.h"
+#include "MLX90642_depends.h"
+#include "MLX90642_sim.h"
+
+TEST_DEFINE;
+
+#define SA            SA_90642_DEFAULT
+#define PIX           MLX90642_TOTAL_NUMBER_OF_PIXELS
+#define IMAGE_BITS    ((4 + PIX*2)*9)   /* 写地址,寄存器地址2字节,读地址, 每字节加ACK */
+#define CONFIG_BITS   (5*9)
+#define SCENE_NUM     3
+
+static uint32_t s_ms;
+static uint32_t s_cycles;
+static uint16_t s_img[PIX];
+static int16_t s_ref[PIX];
+static int16_t s_scene[SCENE_NUM][PIX];
+static uint32_t s_seed = 1;
+
+/* clock.c的替身 */
+uint32_t get_ticks(void)
+{
+    return s_ms;
+}
+
+uint32_t clock_get_cycles(void)
+{
+    return s_cycles++;
+}
+
+uint32_t clock_get_ahb(void)
+{
+    return 180000000ul;
+}
+
+uint32_t clock_get_apb1(void)
+{
+    return 45000000ul;
+}
+
+void clock_delay(uint32_t ms)
+{
+    s_ms += ms;
+}
+
+static uint32_t rnd(void)
+{
+    s_seed = s_seed*1103515245ul + 12345ul;
+    return s_seed >> 8;
+}
+
+/* 与仿真器的合成场景按同样的定义计算: 上下温度梯度的背景, 热点随帧号移动 */
+static void synth(uint32_t frame)
+{
+    int cx = (int)(frame % MLX90642_NUMBER_OF_COLUMNS);
+    int cy = 8 + (int)((frame / 4) % 8);
+    for(int y=0; y<MLX90642_NUMBER_OF_ROWS; y++){
+        for(int x=0; x<MLX90642_NUMBER_OF_COLUMNS; x++){
+            int d2 = (x-cx)*(x-cx) + (y-cy)*(y-cy);
+            s_ref[y*MLX90642_NUMBER_OF_COLUMNS + x] = (int16_t)((d2 <= 9) ? (1850 - d2*40) : (1250 + y*4));
+        }
+    }
+}
+
+static int img_same(const int16_t* ref)
+{
+    for(int i=0; i<PIX; i++){
+        if((int16_t)s_img[i] != ref[i]){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void)
+{
+    const mlx90642_sim_stat_st* stat = mlx90642_sim_stat();
+    uint32_t bits;
+    uint32_t to_reads;
+    uint32_t frames;
+    uint32_t nacks;
+    uint32_t period;
+    uint16_t reg;
+    int bad;
+
+    /* 不做位延时, 仿真器只看边沿 */
+    MLX90642_Set_Delay(0);
+
+    /* 上电后的第一帧 */
+    bits = stat->bits;
+    TEST_CHECK(MLX90642_GetImage(SA, s_img) == 0);
+    TEST_CHECK(stat->bits - bits == IMAGE_BITS);
+    TEST_CHECK(stat->to_reads == PIX);
+    synth(0);
+    TEST_CHECK(img_same(s_ref));
+    TEST_CHECK(stat->frames == 0);
+
+    /* 写寄存器: 一次写事务, 读回相同 */
+    bits = stat->bits;
+    TEST_CHECK(MLX90642_Config(SA, MLX90642_REFRESH_RATE_ADDRESS, MLX90642_REF_RATE_8HZ) == 0);
+    TEST_CHECK(stat->bits - bits == CONFIG_BITS);
+    TEST_CHECK(MLX90642_I2CRead(SA, MLX90642_REFRESH_RATE_ADDRESS, 1, &reg) == 0);
+    TEST_CHECK(reg == MLX90642_REF_RATE_8HZ);
+    period = MLX90642_REF_TIME >> MLX90642_REF_RATE_8HZ;
+
+    /* 合成场景: 每个刷新周期一帧, 读TO数据清除就绪标志 */
+    bad = 0;
+    for(uint32_t f=1; f<=40; f++){
+        s_ms += period;
+        TEST_CHECK(MLX90642_IsDataReady(SA) == 1);
+        TEST_CHECK(stat->frames == f);
+        bits = stat->bits;
+        to_reads = stat->to_reads;
+        TEST_CHECK(MLX90642_GetImage(SA, s_img) == 0);
+        if((stat->bits - bits != IMAGE_BITS) || (stat->to_reads - to_reads != PIX)){
+            bad++;
+        }
+        synth(f - 1);
+        if(!img_same(s_ref)){
+            bad++;
+        }
+        TEST_CHECK(MLX90642_IsDataReady(SA) == 0);
+    }
+    TEST_CHECK(bad == 0);
+
+    /* 周期未到没有新帧, 跨过多个周期只产生一帧 */
+    frames = stat->frames;
+    s_ms += period - 1;
+    TEST_CHECK(MLX90642_IsDataReady(SA) == 0);
+    TEST_CHECK(stat->frames == frames);
+    s_ms += 3*period;
+    TEST_CHECK(MLX90642_IsDataReady(SA) == 1);
+    TEST_CHECK(stat->frames == frames + 1);
+
+    /* 录制场景: 按顺序循环 */
+    for(int k=0; k<SCENE_NUM; k++){
+        for(int i=0; i<PIX; i++){
+            s_scene[k][i] = (int16_t)(rnd() & 0xFFFF);
+        }
+    }
+    mlx90642_sim_scene(&s_scene[0][0], SCENE_NUM);
+    bad = 0;
+    for(int f=0; f<2*SCENE_NUM; f++){
+        s_ms += period;
+        bits = stat->bits;
+        TEST_CHECK(MLX90642_GetImage(SA, s_img) == 0);
+        if((stat->bits - bits != IMAGE_BITS) || !img_same(s_scene[f % SCENE_NUM])){
+            bad++;
+        }
+    }
+    TEST_CHECK(bad == 0);
+    mlx90642_sim_scene(0, 0);
+
+    /* 地址不匹配: 每次尝试都NACK, 重试用完后返回错误 */
+    nacks = stat->nacks;
+    TEST_CHECK(MLX90642_GetImage(SA + 1, s_img) < 0);
+    TEST_CHECK(stat->nacks - nacks == 4);
+    TEST_CHECK(MLX90642_I2CGetStat()->abort == 1);
+    TEST_CHECK(MLX90642_GetImage(SA, s_img) == 0);
+
+    TEST_END("sim");
+}
@@ -0,0 +1,131 @@
+/**
+ * spi_dma_next分段描述的主机测试:
+ * 按spi_transfer_dma2d的方式逐行逐段生成描述, 检查每段满足DMA的约束
+ * (NDTR上限, 存储器宽度对齐, 4拍突发16字节对齐且为突发长度整数倍, 突发不跨1KB),
+ * 各段首尾相接且总长正确
+ */
+#include <stdint.h>
+#include "test.h"
+#include "spi.h"
+
+TEST_DEFINE;
+
+#define SDRAM_BASE  0xD0000000u
+#define FB_STRIDE   (240*2)       /* 一行240点RGB565 */
+
+static uint32_t s_chunks;
+static uint32_t s_bursts;
+
+/* 检查一段描述, 返回该段字节数 */
+static uint32_t check_chunk(uint32_t addr, uint32_t len, uint8_t psize)
+{
+    spi_dma_chunk_st chunk;
+    uint32_t n = spi_dma_next(addr, len, psize, &chunk);
+    if(n == 0){
+        return 0;
+    }
+    s_chunks++;
+    TEST_CHECK(n <= len);
+    TEST_CHECK(chunk.addr == addr);
+    TEST_CHECK(chunk.cnt != 0);
+    TEST_CHECK(chunk.cnt <= SPI_DMA_NDTR_MAX);
+    TEST_CHECK(((uint32_t)chunk.cnt << psize) == n);
+    TEST_CHECK(chunk.msize >= psize);
+    TEST_CHECK(chunk.msize <= 2);
+    /* 存储器侧地址和长度都是存储器宽度的整数倍, NDTR为MSIZE/PSIZE的整数倍 */
+    TEST_CHECK((addr & ((1u << chunk.msize) - 1)) == 0);
+    TEST_CHECK((n & ((1u << chunk.msize) - 1)) == 0);
+    if(chunk.mburst != 0){
+        s_bursts++;
+        TEST_CHECK(chunk.mburst == 1);
+        TEST_CHECK(chunk.msize == 2);
+        TEST_CHECK((addr & 0x0F) == 0);
+        TEST_CHECK((n & 0x0F) == 0);
+        /* NDTR为 突发拍数x MSIZE/PSIZE 的整数倍 */
+        TEST_CHECK((chunk.cnt % ((4*4) >> psize)) == 0);
+        for(uint32_t a=addr; a<addr+n; a+=16){
+            TEST_CHECK((a & ~0x3FFu) == ((a + 15) & ~0x3FFu));
+        }
+    }
+    return n;
+}
+
+/* 按spi_transfer_dma2d的方式发送rows行, 返回段数 */
+static uint32_t check_xfer(uint32_t addr, uint32_t len, uint32_t stride, uint32_t rows, uint8_t psize)
+{
+    uint32_t chunks = s_chunks;
+    uint32_t sum;
+    uint32_t n;
+    if(stride == len){
+        len *= rows;
+        rows = 1;
+    }
+    for(uint32_t r=0; r<rows; r++){
+        sum = 0;
+        while((n = check_chunk(addr + r*stride + sum, len - sum, psize)) != 0){
+            sum += n;
+        }
+        TEST_CHECK(sum == (len & ~((1u << psize) - 1)));
+    }
+    return s_chunks - chunks;
+}
+
+int main(void)
+{
+    static const uint32_t lens[] = {
+        1, 2, 3, 4, 14, 15, 16, 17, 20, 30, 63, 64, 255, 256, 257, 1000, 1024, 4096,
+        65520, 65532, 65535, 65536, 131056, 131070, 131071, 131072, 240*320*2,
+    };
+    uint32_t chunks;
+
+    /* 各种长度和对齐, 包括跨1KB边界和跨NDTR上限 */
+    for(uint8_t psize=0; psize<2; psize++){
+        for(uint32_t i=0; i<sizeof(lens)/sizeof(lens[0]); i++){
+            for(uint32_t off=0; off<64; off+=(1u << psize)){
+                check_xfer(SDRAM_BASE + off, lens[i], lens[i], 1, psize);
+                check_xfer(SDRAM_BASE + 0x400 - 32 + off, lens[i], lens[i], 1, psize);
+            }
+        }
+    }
+
+    /*
+     * 16位帧的矩形窗口: 每行n个10x10小块(n*20字节), 从第a块开始(偏移a*20),
+     * 只有a为4的倍数时行首16字节对齐, 这时n*20也只有n为4的倍数时才是16的倍数
+     */
+    for(uint32_t n=1; n<=24; n++){
+        for(uint32_t a=0; a+n<=24; a++){
+            for(uint32_t y=0; y<4; y++){
+                check_xfer(SDRAM_BASE + (y*10)*FB_STRIDE + a*20, n*20, FB_STRIDE, 10, 1);
+                check_xfer(0x20000000u + (y*10)*FB_STRIDE + a*20, n*20, FB_STRIDE, 10, 1);
+            }
+        }
+    }
+
+    /* 一个小块宽的行: 不对齐时只有1段(按字单拍), 不应为了突发多分段 */
+    s_bursts = 0;
+    chunks = check_xfer(SDRAM_BASE + 20, 20, FB_STRIDE, 10, 1);
+    TEST_CHECK(chunks == 10);
+    TEST_CHECK(s_bursts == 0);
+    /* 16字节对齐但长度不是16的倍数: 也不能用突发 */
+    s_bursts = 0;
+    chunks = check_xfer(SDRAM_BASE + 80, 20, FB_STRIDE, 10, 1);
+    TEST_CHECK(chunks == 10);
+    TEST_CHECK(s_bursts == 0);
+    /* 4个小块, 16字节对齐, 80字节: 整行突发 */
+    s_bursts = 0;
+    chunks = check_xfer(SDRAM_BASE + 80, 80, FB_STRIDE, 10, 1);
+    TEST_CHECK(chunks == 10);
+    TEST_CHECK(s_bursts == 10);
+    /* 整屏: 对齐时全部突发, 只按NDTR上限分段 */
+    s_bursts = 0;
+    chunks = check_xfer(SDRAM_BASE, 240*320*2, 240*320*2, 1, 1);
+    TEST_CHECK(chunks == 2);
+    TEST_CHECK(s_bursts == 2);
+    /* 整屏不对齐: 头尾单独成段, 中间突发 */
+    s_bursts = 0;
+    chunks = check_xfer(SDRAM_BASE + 4, 240*320*2 - 8, 240*320*2 - 8, 1, 1);
+    TEST_CHECK(chunks == 4);
+    TEST_CHECK(s_bursts == 2);
+
+    TEST_END("spi_dma");
+}
@@ -0,0 +1,75 @@
+#include <stdint.h>
+#include "stm32f429xx.h"
+#include "clock.h"
+#include "tim.h"
+
+static uint32_t reg_base[2]={0x40001000,0x40001400};  /* TIM6 TIM7 */
+static tim_cb_pf s_tim_cb[2];
+
+static void tim_irqhandler(int id)
+{
+	volatile uint32_t *TIM_SR = (uint32_t*)(reg_base[id-6] + 0x10);
+	if(*TIM_SR & 0x01){
+		*TIM_SR = 0;  /* 写0清除UIF */
+		if(s_tim_cb[id-6] != 0){
+			s_tim_cb[id-6]();
+		}
+	}
+}
+
+void tim6_irqhandler(void)
+{
+	tim_irqhandler(6);
+}
+
+void tim7_irqhandler(void)
+{
+	tim_irqhandler(7);
+}
+
+void tim_init(int id, uint32_t hz, tim_cb_pf cb)
+{
+	volatile uint32_t *TIM_CR1  = (uint32_t*)(reg_base[id-6] + 0x00);
+	volatile uint32_t *TIM_DIER = (uint32_t*)(reg_base[id-6] + 0x0C);
+	volatile uint32_t *TIM_SR   = (uint32_t*)(reg_base[id-6] + 0x10);
+	volatile uint32_t *TIM_PSC  = (uint32_t*)(reg_base[id-6] + 0x28);
+	volatile uint32_t *TIM_ARR  = (uint32_t*)(reg_base[id-6] + 0x2C);
+	volatile uint32_t *RCC_CFGR = (void *)(RCC_BASE + 0x08);
+	volatile uint32_t *RCC_APB1ENR = (void *)(RCC_BASE + 0x40);
+	uint32_t clk = clock_get_apb1();
+
+	/* APB1分频不为1时定时器时钟为PCLK1*2 */
+	if(((*RCC_CFGR >> 10) & 0x04) != 0){
+		clk *= 2;
+	}
+	*RCC_APB1ENR |= (1u<<(id-2)); /* TIM6 bit4 TIM7 bit5 */
+
+	s_tim_cb[id-6] = cb;
+	*TIM_CR1 = 0;
+	*TIM_PSC = clk/1000000 - 1;   /* 1MHz计数 */
+	*TIM_ARR = 1000000/hz - 1;
+	*TIM_SR = 0;
+	*TIM_DIER = 0x01;             /* UIE */
+	*TIM_CR1 = (1u<<7);           /* ARPE */
+
+	/* 优先级最低,不阻塞串口等中断 */
+	if(id == 6){
+		NVIC_SetPriority(TIM6_DAC_IRQn, 0x0F);
+		NVIC_EnableIRQ(TIM6_DAC_IRQn);
+	}else{
+		NVIC_SetPriority(TIM7_IRQn, 0x0F);
+		NVIC_EnableIRQ(TIM7_IRQn);
+	}
+}
+
+void tim_start(int id)
+{
+	volatile uint32_t *TIM_CR1  = (uint32_t*)(reg_base[id-6] + 0x00);
+	*TIM_CR1 |= 0x01;  /* CEN */
+}
+
+void tim_stop(int id)
+{
+	volatile uint32_t *TIM_CR1  = (uint32_t*)(reg_base[id-6] + 0x00);
+	*TIM_CR1 &= ~0x01u;
+}
@@ -0,0 +1,34 @@
+#ifndef TIM_H
+#define TIM_H
+
+#include <stdint.h>
+
+typedef void (*tim_cb_pf)(void);   /**< 更新中断回调,在中断中执行 */
+
+/**
+ * \fn tim_init
+ * 初始化基本定时器(TIM6/TIM7)周期更新中断,初始化后不启动
+ * \param[in] id 6或7
+ * \param[in] hz 中断频率
+ * \param[in] cb \ref tim_cb_pf
+*/
+void tim_init(int id, uint32_t hz, tim_cb_pf cb);
+
+/**
+ * \fn tim_start
+ * 启动定时器
+ * \param[in] id 6或7
+*/
+void tim_start(int id);
+
+/**
+ * \fn tim_stop
+ * 停止定时器
+ * \param[in] id 6或7
+*/
+void tim_stop(int id);
+
+void tim6_irqhandler(void);
+void tim7_irqhandler(void);
+
+#endif